@@ -0,0 +1,302 @@
+#pragma once
+
+// Shared helpers for the benchmark executables: an epoll load generator that drives a server over loopback,
+// cpu accounting and a way to keep the server's logging out of the results. Linux only.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Benchmark
+{
+    struct LoadResult
+    {
+        uint64_t Completed = 0;
+        uint64_t Failed = 0;
+        double Seconds = 0;
+
+        double RequestsPerSecond() const { return Seconds > 0 ? Completed / Seconds : 0; }
+    };
+
+    // The server logs every request to stdout, send that to /dev/null and hand back a stream for the report
+    inline FILE* SilenceServerLogging()
+    {
+        fflush(stdout);
+        FILE* Report = fdopen(dup(STDOUT_FILENO), "w");
+        if(freopen("/dev/null", "w", stdout) == nullptr)
+        {
+            return stderr;
+        }
+        setvbuf(Report, nullptr, _IOLBF, 0);
+        return Report;
+    }
+
+    // Raises the open file limit as far as allowed, returns the usable number of descriptors
+    inline int RaiseFileLimit()
+    {
+        rlimit Limit{};
+        getrlimit(RLIMIT_NOFILE, &Limit);
+        Limit.rlim_cur = Limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &Limit);
+        getrlimit(RLIMIT_NOFILE, &Limit);
+        return (int) Limit.rlim_cur;
+    }
+
+    // Both ends of a loopback connection live in this process
+    inline int ClampConnections(int Connections, int FileLimit)
+    {
+        int MaxConnections = (FileLimit - 256) / 2;
+        return Connections < MaxConnections ? Connections : MaxConnections;
+    }
+
+    inline double ProcessCpuSeconds()
+    {
+        rusage Usage{};
+        getrusage(RUSAGE_SELF, &Usage);
+        return Usage.ru_utime.tv_sec + Usage.ru_stime.tv_sec + (Usage.ru_utime.tv_usec + Usage.ru_stime.tv_usec) / 1e6;
+    }
+
+    inline int ConnectNonBlocking(uint16_t Port)
+    {
+        int Socket = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if(Socket == -1)
+        {
+            return -1;
+        }
+
+        sockaddr_in Address{};
+        Address.sin_family = AF_INET;
+        Address.sin_port = htons(Port);
+        Address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        if(connect(Socket, (sockaddr*) &Address, sizeof(Address)) == -1 && errno != EINPROGRESS)
+        {
+            close(Socket);
+            return -1;
+        }
+        return Socket;
+    }
+
+    // Holds connections open without sending anything
+    class IdleConnections
+    {
+    public:
+        ~IdleConnections() { CloseAll(); }
+
+        int Open(uint16_t Port, int Count)
+        {
+            for(int i = 0; i < Count; i++)
+            {
+                int Socket = ConnectNonBlocking(Port);
+                if(Socket == -1)
+                {
+                    break;
+                }
+                mSockets.push_back(Socket);
+            }
+            return (int) mSockets.size();
+        }
+
+        void CloseAll()
+        {
+            for(int Socket : mSockets)
+            {
+                close(Socket);
+            }
+            mSockets.clear();
+        }
+
+    private:
+        std::vector<int> mSockets;
+    };
+
+    // Process cpu used per wall second while the given connections sit idle, 1.0 is a full core
+    inline double MeasureIdleCpu(uint16_t Port, int Connections, double Seconds)
+    {
+        IdleConnections Idle;
+        Idle.Open(Port, Connections);
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+        double CpuStart = ProcessCpuSeconds();
+        auto WallStart = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(std::chrono::duration<double>(Seconds));
+        double Wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - WallStart).count();
+
+        return (ProcessCpuSeconds() - CpuStart) / Wall;
+    }
+
+    // Closed loop load: every connection sends Request, reads one full response (Content-Length framed) per
+    // pipelined request in it, then either sends the next batch on the same connection (KeepAlive) or reconnects
+    inline LoadResult RunHttpLoad(uint16_t Port, const std::string& Request, int Connections, double Seconds, bool KeepAlive, int PipelineDepth = 1)
+    {
+        struct ClientConnection
+        {
+            int Socket = -1;
+            size_t BytesSent = 0;
+            std::string Response;
+        };
+
+        LoadResult Result;
+        int Epoll = epoll_create1(0);
+        std::vector<ClientConnection> Clients(Connections);
+
+        auto Connect = [&] (int Index)
+            {
+                ClientConnection& Client = Clients[Index];
+                Client.Socket = ConnectNonBlocking(Port);
+                Client.BytesSent = 0;
+                Client.Response.clear();
+                if(Client.Socket == -1)
+                {
+                    Result.Failed++;
+                    return;
+                }
+
+                epoll_event Event{};
+                Event.events = EPOLLIN | EPOLLOUT | EPOLLET;
+                Event.data.u32 = Index;
+                epoll_ctl(Epoll, EPOLL_CTL_ADD, Client.Socket, &Event);
+            };
+
+        auto Reconnect = [&] (int Index)
+            {
+                close(Clients[Index].Socket);
+                Connect(Index);
+            };
+
+        auto TrySend = [&] (ClientConnection& Client)
+            {
+                while(Client.BytesSent < Request.size())
+                {
+                    ssize_t Sent = send(Client.Socket, Request.data() + Client.BytesSent, Request.size() - Client.BytesSent, MSG_NOSIGNAL);
+                    if(Sent <= 0)
+                    {
+                        return Sent == -1 && errno == EAGAIN;
+                    }
+                    Client.BytesSent += Sent;
+                }
+                return true;
+            };
+
+        // Returns true once every pipelined response is buffered
+        auto ResponseComplete = [PipelineDepth] (const std::string& Response)
+            {
+                size_t ResponseStart = 0;
+                for(int i = 0; i < PipelineDepth; i++)
+                {
+                    size_t HeaderEnd = Response.find("\r\n\r\n", ResponseStart);
+                    if(HeaderEnd == std::string::npos)
+                    {
+                        return false;
+                    }
+
+                    size_t ContentLength = 0;
+                    size_t LengthHeader = Response.find("Content-Length: ", ResponseStart);
+                    if(LengthHeader != std::string::npos && LengthHeader < HeaderEnd)
+                    {
+                        ContentLength = strtoul(Response.c_str() + LengthHeader + 16, nullptr, 10);
+                    }
+
+                    ResponseStart = HeaderEnd + 4 + ContentLength;
+                    if(Response.size() < ResponseStart)
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            };
+
+        for(int i = 0; i < Connections; i++)
+        {
+            Connect(i);
+        }
+
+        std::vector<epoll_event> Events(1024);
+        char ReadBuffer[16 * 1024];
+
+        auto Start = std::chrono::steady_clock::now();
+        auto End = Start + std::chrono::duration<double>(Seconds);
+
+        while(std::chrono::steady_clock::now() < End)
+        {
+            int NumEvents = epoll_wait(Epoll, Events.data(), (int) Events.size(), 10);
+            for(int e = 0; e < NumEvents; e++)
+            {
+                int Index = (int) Events[e].data.u32;
+                ClientConnection& Client = Clients[Index];
+                if(Client.Socket == -1)
+                {
+                    continue;
+                }
+
+                if(TrySend(Client) == false)
+                {
+                    Result.Failed++;
+                    Reconnect(Index);
+                    continue;
+                }
+
+                while(true)
+                {
+                    ssize_t Received = recv(Client.Socket, ReadBuffer, sizeof(ReadBuffer), 0);
+                    if(Received > 0)
+                    {
+                        Client.Response.append(ReadBuffer, Received);
+                        if(ResponseComplete(Client.Response) == false)
+                        {
+                            continue;
+                        }
+
+                        Result.Completed += PipelineDepth;
+                        if(KeepAlive)
+                        {
+                            Client.Response.clear();
+                            Client.BytesSent = 0;
+                            TrySend(Client);
+                            continue;
+                        }
+
+                        Reconnect(Index);
+                        break;
+                    }
+
+                    if(Received == 0 || errno != EAGAIN)
+                    {
+                        // A persistent connection the server retired before answering the next request isn't a failure
+                        bool bServerRetiredConnection = KeepAlive && Received == 0 && Client.Response.empty();
+                        Result.Failed += bServerRetiredConnection ? 0 : 1;
+                        Reconnect(Index);
+                    }
+                    break;
+                }
+            }
+        }
+
+        Result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+
+        for(ClientConnection& Client : Clients)
+        {
+            if(Client.Socket != -1) { close(Client.Socket); }
+        }
+        close(Epoll);
+
+        return Result;
+    }
+
+    inline std::string BuildGetRequest(const std::string& Url, bool KeepAlive)
+    {
+        return "GET " + Url + " HTTP/1.1\r\nHost: localhost\r\n" + (KeepAlive ? "Connection: keep-alive\r\n" : "") + "\r\n";
+    }
+}
@@ -0,0 +1,108 @@
+#include "RequestBodySpool.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Spools a large body into SpooledRequestBody a socket read (16 KB) at a time with a range of memory budgets, against
+// writing each read straight to a temp file as it arrives. Throughput counts everything up to the body being readable
+// (Finish), the file is synced afterwards so one run's dirty pages don't slow the next.
+namespace
+{
+    using namespace WebServer;
+
+    typedef std::chrono::steady_clock Clock;
+
+    constexpr int ReadSize = 16 * 1024;
+
+    double SecondsSince(Clock::time_point Start)
+    {
+        return std::chrono::duration<double>(Clock::now() - Start).count();
+    }
+
+    double SpoolMegabytesPerSecond(const std::vector<char>& Read, int64_t TotalBytes, size_t MemoryBudget, const std::string& Directory)
+    {
+        SpooledRequestBody Body;
+        Body.Start(MemoryBudget, TotalBytes, Directory);
+
+        auto Start = Clock::now();
+        for(int64_t Spooled = 0; Spooled < TotalBytes; Spooled += ReadSize)
+        {
+            if(Body.Append(Read.data(), ReadSize) == false)
+            {
+                printf("spool failed\n");
+                return 0;
+            }
+        }
+        bool bFinished = Body.Finish();
+        double Seconds = SecondsSince(Start);
+
+        if(bFinished == false || Body.GetSize() != TotalBytes)
+        {
+            printf("spool failed\n");
+            return 0;
+        }
+        if(Body.IsInMemory() == false)
+        {
+            fsync(Body.GetFileHandle());
+        }
+        return (double) TotalBytes / (1024 * 1024) / Seconds;
+    }
+
+    // What the body would cost written as it arrives, one write per read
+    double DirectWriteMegabytesPerSecond(const std::vector<char>& Read, int64_t TotalBytes, const std::string& Directory)
+    {
+        std::string FileName = Directory + "/webserver-bench-XXXXXX";
+        int File = mkstemp(&FileName[0]);
+        if(File == -1)
+        {
+            printf("temp file failed\n");
+            return 0;
+        }
+        unlink(FileName.c_str());
+
+        auto Start = Clock::now();
+        for(int64_t Written = 0; Written < TotalBytes; Written += ReadSize)
+        {
+            if(write(File, Read.data(), ReadSize) != ReadSize)
+            {
+                printf("write failed\n");
+                break;
+            }
+        }
+        double Seconds = SecondsSince(Start);
+
+        fsync(File);
+        close(File);
+        return (double) TotalBytes / (1024 * 1024) / Seconds;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int64_t TotalBytes = (int64_t) ((argc > 1) ? atoi(argv[1]) : 512) * 1024 * 1024;
+    const char* TempDirectory = getenv("TMPDIR");
+    const std::string Directory = (argc > 2) ? argv[2] : ((TempDirectory != nullptr) ? TempDirectory : "/tmp");
+
+    std::vector<char> Read(ReadSize);
+    for(int i = 0; i < ReadSize; i++)
+    {
+        Read[i] = (char) (i * 31);
+    }
+
+    printf("%lld MB body in %d KB reads, spooled to %s\n\n", (long long) (TotalBytes >> 20), ReadSize / 1024, Directory.c_str());
+    printf("%-28s %10s\n", "sink", "MB/s");
+    printf("%-28s %10.0f\n", "write per read", DirectWriteMegabytesPerSecond(Read, TotalBytes, Directory));
+
+    for(size_t MemoryBudget : { 64 * 1024, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024 })
+    {
+        std::string Name = "spool, " + std::to_string(MemoryBudget / 1024) + " KB budget";
+        printf("%-28s %10.0f\n", Name.c_str(), SpoolMegabytesPerSecond(Read, TotalBytes, MemoryBudget, Directory));
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include "WebServer.h"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Resident memory the content store needs for an uploaded asset set (default 1 GB of 4 MB assets).
+namespace
+{
+    size_t ResidentBytes()
+    {
+        size_t TotalPages = 0, ResidentPages = 0;
+        FILE* Statm = fopen("/proc/self/statm", "r");
+        if(Statm == nullptr || fscanf(Statm, "%zu %zu", &TotalPages, &ResidentPages) != 2)
+        {
+            ResidentPages = 0;
+        }
+        if(Statm != nullptr) { fclose(Statm); }
+        return ResidentPages * (size_t) sysconf(_SC_PAGESIZE);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t TotalMB = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 1024;
+    const size_t AssetKB = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 4096;
+    const size_t NumAssets = (TotalMB * 1024) / AssetKB;
+
+    // Keep the per-upload logging out of the report
+    fflush(stdout);
+    FILE* Report = fdopen(dup(STDOUT_FILENO), "w");
+    if(freopen("/dev/null", "w", stdout) == nullptr)
+    {
+        Report = stderr;
+    }
+
+    WebServer::ListenServer Server;
+    size_t ResidentBefore = ResidentBytes();
+
+    for(size_t i = 0; i < NumAssets; i++)
+    {
+        std::vector<char> Asset(AssetKB * 1024, (char) ('a' + i % 26));
+        Server.UploadData("/asset/" + std::to_string(i), std::move(Asset), "application/octet-stream", {});
+    }
+
+    size_t ResidentAfter = ResidentBytes();
+    double AssetBytes = (double) NumAssets * AssetKB * 1024;
+    double StoreBytes = (double) (ResidentAfter - ResidentBefore);
+
+    fprintf(Report, "assets: %zu x %zu KB (%.0f MB)\n", NumAssets, AssetKB, AssetBytes / (1024 * 1024));
+    fprintf(Report, "content store resident: %.0f MB (%.2fx the asset bytes)\n", StoreBytes / (1024 * 1024), StoreBytes / AssetBytes);
+    fclose(Report);
+    return 0;
+}
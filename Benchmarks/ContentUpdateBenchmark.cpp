@@ -0,0 +1,260 @@
+#include "BenchmarkCommon.h"
+
+#include "WebServer.h"
+
+#include <atomic>
+#include <map>
+#include <shared_mutex>
+
+// Serving pages while another thread keeps changing them. First the content store alone: reader threads look urls up
+// (reporting their generation every so often, as a worker does once a loop) while a writer commits, against the same
+// map behind a reader-writer lock. Then a running server's req/sec with a thread committing page updates flat out.
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    std::shared_ptr<const WebServer::ServerResponseMessage> BuildPage(char Fill)
+    {
+        std::shared_ptr<WebServer::ServerResponseMessage> Page = std::make_shared<WebServer::ServerResponseMessage>(WebServer::ServerResponseStatusCode::ServerResponseStatusCode_200);
+        Page->AddContent(std::vector<char>(1024, Fill), "text/plain");
+        Page->BuildMessage();
+        return Page;
+    }
+
+    std::string PageUrl(int Index)
+    {
+        return "/page/" + std::to_string(Index);
+    }
+
+    struct StoreResult
+    {
+        double LookupsPerSecond = 0;
+        double CommitsPerSecond = 0;
+        size_t PeakRetired = 0;
+        bool bAllFound = true;
+    };
+
+    StoreResult RunSnapshotStore(int NumPages, int NumReaders, int BatchSize, double Seconds)
+    {
+        WebServer::ContentStore Store;
+        WebServer::ContentBatch Initial;
+        for(int i = 0; i < NumPages; i++)
+        {
+            Initial.Upload(PageUrl(i), BuildPage('a'));
+        }
+        Store.Commit(std::move(Initial));
+
+        // Hashed up front, as the server's requests are while they're parsed
+        std::vector<std::string> Urls;
+        std::vector<uint64_t> UrlHashes;
+        for(int i = 0; i < NumPages; i++)
+        {
+            Urls.push_back(PageUrl(i));
+            UrlHashes.push_back(WebServer::ContentSnapshot::HashUrl(Urls.back()));
+        }
+
+        StoreResult Result;
+        std::atomic<bool> bRunning = true;
+        std::atomic<uint64_t> NumLookups = 0;
+        std::atomic<bool> bAllFound = true;
+        std::vector<std::thread> Readers;
+        for(int r = 0; r < NumReaders; r++)
+        {
+            Readers.emplace_back([&, r] () {
+                std::atomic<uint64_t>* Slot = Store.RegisterReader();
+                Slot->store(Store.GetGeneration());
+                uint64_t Lookups = 0;
+                size_t Next = (size_t) r * 7919;
+                WebServer::RouteParams Params;
+                while(bRunning.load(std::memory_order_relaxed))
+                {
+                    const WebServer::ContentSnapshot& Snapshot = Store.GetSnapshot();
+                    for(int i = 0; i < 64; i++, Next += 31)
+                    {
+                        if(Snapshot.Find(Urls[Next % Urls.size()], UrlHashes[Next % Urls.size()], Params) == nullptr)
+                        {
+                            bAllFound = false;
+                        }
+                    }
+                    Lookups += 64;
+                    Slot->store(Store.GetGeneration());
+                }
+                Slot->store(WebServer::ContentStore::ReaderIdle);
+                NumLookups += Lookups;
+                });
+        }
+
+        uint64_t NumCommits = 0;
+        const auto Start = Clock::now();
+        while(std::chrono::duration<double>(Clock::now() - Start).count() < Seconds)
+        {
+            WebServer::ContentBatch Batch;
+            for(int i = 0; i < BatchSize; i++)
+            {
+                Batch.Upload(Urls[(NumCommits * BatchSize + i) % Urls.size()], BuildPage((char) ('a' + NumCommits % 26)));
+            }
+            Store.Commit(std::move(Batch));
+            Result.PeakRetired = std::max(Result.PeakRetired, Store.GetNumRetired());
+            NumCommits++;
+        }
+        const double Elapsed = std::chrono::duration<double>(Clock::now() - Start).count();
+        bRunning = false;
+        for(std::thread& Reader : Readers)
+        {
+            Reader.join();
+        }
+
+        Result.LookupsPerSecond = NumLookups / Elapsed;
+        Result.CommitsPerSecond = NumCommits / Elapsed;
+        Result.bAllFound = bAllFound;
+        return Result;
+    }
+
+    // What guarding the old map would have looked like
+    StoreResult RunLockedMap(int NumPages, int NumReaders, int BatchSize, double Seconds)
+    {
+        std::map<std::string, std::shared_ptr<const WebServer::ServerResponseMessage>, std::less<>> Pages;
+        std::shared_mutex PagesMutex;
+        std::vector<std::string> Urls;
+        for(int i = 0; i < NumPages; i++)
+        {
+            Urls.push_back(PageUrl(i));
+            Pages.emplace(Urls.back(), BuildPage('a'));
+        }
+
+        StoreResult Result;
+        std::atomic<bool> bRunning = true;
+        std::atomic<uint64_t> NumLookups = 0;
+        std::atomic<bool> bAllFound = true;
+        std::vector<std::thread> Readers;
+        for(int r = 0; r < NumReaders; r++)
+        {
+            Readers.emplace_back([&, r] () {
+                uint64_t Lookups = 0;
+                size_t Next = (size_t) r * 7919;
+                while(bRunning.load(std::memory_order_relaxed))
+                {
+                    for(int i = 0; i < 64; i++, Next += 31)
+                    {
+                        std::shared_lock<std::shared_mutex> ReadLock(PagesMutex);
+                        if(Pages.find(Urls[Next % Urls.size()]) == Pages.end())
+                        {
+                            bAllFound = false;
+                        }
+                    }
+                    Lookups += 64;
+                }
+                NumLookups += Lookups;
+                });
+        }
+
+        uint64_t NumCommits = 0;
+        const auto Start = Clock::now();
+        while(std::chrono::duration<double>(Clock::now() - Start).count() < Seconds)
+        {
+            std::vector<std::pair<size_t, std::shared_ptr<const WebServer::ServerResponseMessage>>> Batch;
+            for(int i = 0; i < BatchSize; i++)
+            {
+                Batch.emplace_back((NumCommits * BatchSize + i) % Urls.size(), BuildPage((char) ('a' + NumCommits % 26)));
+            }
+            {
+                std::unique_lock<std::shared_mutex> WriteLock(PagesMutex);
+                for(auto& Update : Batch)
+                {
+                    Pages.insert_or_assign(Urls[Update.first], std::move(Update.second));
+                }
+            }
+            NumCommits++;
+        }
+        const double Elapsed = std::chrono::duration<double>(Clock::now() - Start).count();
+        bRunning = false;
+        for(std::thread& Reader : Readers)
+        {
+            Reader.join();
+        }
+
+        Result.LookupsPerSecond = NumLookups / Elapsed;
+        Result.CommitsPerSecond = NumCommits / Elapsed;
+        Result.bAllFound = bAllFound;
+        return Result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int BasePort = (argc > 1) ? atoi(argv[1]) : 28060;
+    const double Seconds = (argc > 2) ? atof(argv[2]) : 2.0;
+    const int NumPages = (argc > 3) ? atoi(argv[3]) : 1000;
+    const int NumReaders = std::max(1, std::min(4, (int) std::thread::hardware_concurrency() - 1));
+
+    FILE* Report = Benchmark::SilenceServerLogging();
+    if(WebServer::SocketGlobalInit() != 0)
+    {
+        fprintf(Report, "Socket init failed\n");
+        return 1;
+    }
+
+    fprintf(Report, "%d pages, %d reader threads looking them up while one thread commits\n", NumPages, NumReaders);
+    fprintf(Report, "%-28s %-8s %-16s %-14s %-12s\n", "store", "batch", "lookups/sec", "commits/sec", "peak retired");
+    bool bRight = true;
+    for(int BatchSize : { 1, 64 })
+    {
+        StoreResult Snapshot = RunSnapshotStore(NumPages, NumReaders, BatchSize, Seconds);
+        StoreResult Locked = RunLockedMap(NumPages, NumReaders, BatchSize, Seconds);
+        fprintf(Report, "%-28s %-8d %-16.0f %-14.0f %-12zu\n", "snapshot (lock-free reads)", BatchSize, Snapshot.LookupsPerSecond, Snapshot.CommitsPerSecond, Snapshot.PeakRetired);
+        fprintf(Report, "%-28s %-8d %-16.0f %-14.0f %-12s\n", "std::map + shared_mutex", BatchSize, Locked.LookupsPerSecond, Locked.CommitsPerSecond, "-");
+        bRight = bRight && Snapshot.bAllFound && Locked.bAllFound;
+    }
+
+    fprintf(Report, "\nserver, one worker, 32 connections on one page while a thread commits page updates\n");
+    fprintf(Report, "%-20s %-12s %-14s %-10s\n", "updates", "req/sec", "commits/sec", "failed");
+    const char* UpdateNames[] = { "none", "1 page a commit", "64 pages a commit" };
+    const int UpdateBatchSizes[] = { 0, 1, 64 };
+    for(int Run = 0; Run < 3; Run++)
+    {
+        const std::string Port = std::to_string(BasePort + Run);
+
+        WebServer::ListenServer Server;
+        if(Server.Initialise(Port.c_str()) != 0)
+        {
+            fprintf(Report, "server start failed\n");
+            continue;
+        }
+        WebServer::ContentBatch Initial;
+        for(int i = 0; i < NumPages; i++)
+        {
+            Server.UploadData(Initial, PageUrl(i), std::vector<char>(1024, 'a'), "text/plain", {});
+        }
+        Server.CommitContent(std::move(Initial));
+        Server.AsyncStart();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        std::atomic<bool> bUpdating = true;
+        uint64_t NumCommits = 0;
+        std::thread Updater([&] () {
+            const int BatchSize = UpdateBatchSizes[Run];
+            while(BatchSize > 0 && bUpdating)
+            {
+                WebServer::ContentBatch Batch;
+                for(int i = 0; i < BatchSize; i++)
+                {
+                    Server.UploadData(Batch, PageUrl((int) ((NumCommits * BatchSize + i) % NumPages)), std::vector<char>(1024, (char) ('a' + NumCommits % 26)), "text/plain", {});
+                }
+                Server.CommitContent(std::move(Batch));
+                NumCommits++;
+            }
+            });
+
+        Benchmark::LoadResult Load = Benchmark::RunHttpLoad((uint16_t) std::stoi(Port), Benchmark::BuildGetRequest(PageUrl(NumPages / 2), true), 32, Seconds, true);
+        bUpdating = false;
+        Updater.join();
+
+        fprintf(Report, "%-20s %-12.0f %-14.0f %-10llu\n", UpdateNames[Run], Load.RequestsPerSecond(), NumCommits / Load.Seconds, (unsigned long long) Load.Failed);
+
+        Server.CloseServer();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+
+    fflush(Report);
+    _exit(bRight ? 0 : 1);
+}
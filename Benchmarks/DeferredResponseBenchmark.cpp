@@ -0,0 +1,182 @@
+#include "BenchmarkCommon.h"
+
+#include "WebServer.h"
+
+#include <condition_variable>
+#include <map>
+
+// Thousands of connections each waiting on a request that takes WaitMs to answer (a backend call, say), on one worker.
+// A dynamic handler holds a pool thread for the whole wait, a deferred handler hands its token to one backend thread
+// that completes it when it's due, and a coroutine handler sleeps on the loop's own timers. Requests/sec against what
+// the wait allows (connections / WaitMs) and the threads the process needed for it
+namespace
+{
+    // Stands in for the backend, completes tokens once their time's up from a thread of its own
+    class DelayedCompleter
+    {
+    public:
+        DelayedCompleter() : mThread([this] () { Run(); }) {}
+
+        ~DelayedCompleter()
+        {
+            {
+                std::lock_guard<std::mutex> Lock(mMutex);
+                bStopping = true;
+            }
+            mChanged.notify_one();
+            mThread.join();
+        }
+
+        void CompleteAfter(WebServer::ResponseToken Token, int DelayMs)
+        {
+            {
+                std::lock_guard<std::mutex> Lock(mMutex);
+                mPending.emplace(std::chrono::steady_clock::now() + std::chrono::milliseconds(DelayMs), std::move(Token));
+            }
+            mChanged.notify_one();
+        }
+
+    private:
+        void Run()
+        {
+            std::unique_lock<std::mutex> Lock(mMutex);
+            while(bStopping == false)
+            {
+                if(mPending.empty())
+                {
+                    mChanged.wait(Lock);
+                    continue;
+                }
+                if(mPending.begin()->first > std::chrono::steady_clock::now())
+                {
+                    mChanged.wait_until(Lock, mPending.begin()->first);
+                    continue;
+                }
+
+                WebServer::ResponseToken Token = std::move(mPending.begin()->second);
+                mPending.erase(mPending.begin());
+                Lock.unlock();
+                Token.Complete(BuildResponse());
+                Lock.lock();
+            }
+        }
+
+    public:
+        static WebServer::ServerResponseMessage BuildResponse()
+        {
+            WebServer::ServerResponseMessage Response(WebServer::ServerResponseStatusCode::ServerResponseStatusCode_200);
+            Response.AddContent(std::vector<char>(64, 'x'), "text/plain");
+            return Response;
+        }
+
+    private:
+        std::mutex mMutex;
+        std::condition_variable mChanged;
+        std::multimap<std::chrono::steady_clock::time_point, WebServer::ResponseToken> mPending;
+        bool bStopping = false;
+        std::thread mThread;
+    };
+
+    int CountProcessThreads()
+    {
+        FILE* Status = fopen("/proc/self/status", "r");
+        int Threads = 0;
+        char Line[256];
+        while(Status != nullptr && fgets(Line, sizeof(Line), Status) != nullptr)
+        {
+            if(sscanf(Line, "Threads: %d", &Threads) == 1)
+            {
+                break;
+            }
+        }
+        if(Status != nullptr)
+        {
+            fclose(Status);
+        }
+        return Threads;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int BasePort = (argc > 1) ? atoi(argv[1]) : 28050;
+    const double Seconds = (argc > 2) ? atof(argv[2]) : 2.0;
+    const int WaitMs = (argc > 3) ? atoi(argv[3]) : 50;
+    const int Connections = Benchmark::ClampConnections((argc > 4) ? atoi(argv[4]) : 4096, Benchmark::RaiseFileLimit());
+
+    FILE* Report = Benchmark::SilenceServerLogging();
+    if(WebServer::SocketGlobalInit() != 0)
+    {
+        fprintf(Report, "Socket init failed\n");
+        return 1;
+    }
+
+    fprintf(Report, "%d connections, each request waits %dms, at most %.0f req/sec\n", Connections, WaitMs, Connections * 1000.0 / WaitMs);
+    fprintf(Report, "%-26s %-12s %-10s %-10s %-10s\n", "handler", "req/sec", "failed", "threads", "cpu sec");
+
+    const char* HandlerNames[] = { "dynamic (16 pool threads)", "deferred token", "coroutine" };
+    for(int HandlerKind = 0; HandlerKind < 3; HandlerKind++)
+    {
+        const std::string Port = std::to_string(BasePort + HandlerKind);
+
+        WebServer::ListenServer Server;
+        WebServer::ListenServerConfig Config;
+        Config.NumHandlerThreads = 16;
+        if(Server.Initialise(Port.c_str(), Config) != 0)
+        {
+            fprintf(Report, "server start failed\n");
+            continue;
+        }
+
+        std::unique_ptr<DelayedCompleter> Backend;
+        const WebServer::ServerRequestType GET = WebServer::ServerRequestType::ServerRequestType_GET;
+        if(HandlerKind == 0)
+        {
+            Server.CreateDynamicHandler(GET, "/wait", [WaitMs] (WebServer::HandlerRequest&) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(WaitMs));
+                return DelayedCompleter::BuildResponse();
+                });
+        }
+        else if(HandlerKind == 1)
+        {
+            Backend = std::make_unique<DelayedCompleter>();
+            Server.CreateDeferredHandler(GET, "/wait", [WaitMs, &Backend] (WebServer::HandlerRequest&, WebServer::ResponseToken Token) {
+                Backend->CompleteAfter(std::move(Token), WaitMs);
+                });
+        }
+        else
+        {
+            Server.CreateCoroutineHandler(GET, "/wait", [WaitMs] (WebServer::RequestContext& Context) -> WebServer::RequestTask {
+                co_await Context.Sleep(WaitMs);
+                Context.Respond(DelayedCompleter::BuildResponse());
+                });
+        }
+        Server.AsyncStart();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        int PeakThreads = 0;
+        std::atomic<bool> bLoadRunning = true;
+        std::thread ThreadCounter([&] () {
+            while(bLoadRunning)
+            {
+                PeakThreads = std::max(PeakThreads, CountProcessThreads());
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            }
+            });
+
+        const double CpuStart = Benchmark::ProcessCpuSeconds();
+        Benchmark::LoadResult Load = Benchmark::RunHttpLoad((uint16_t) std::stoi(Port), Benchmark::BuildGetRequest("/wait", true), Connections, Seconds, true);
+        const double CpuSeconds = Benchmark::ProcessCpuSeconds() - CpuStart;
+        bLoadRunning = false;
+        ThreadCounter.join();
+
+        // The load generator and the thread counter are two of the threads
+        fprintf(Report, "%-26s %-12.0f %-10llu %-10d %-10.2f\n", HandlerNames[HandlerKind], Load.RequestsPerSecond(), (unsigned long long) Load.Failed, PeakThreads - 2, CpuSeconds);
+
+        Server.CloseServer();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+
+    fflush(Report);
+    _exit(0);
+}
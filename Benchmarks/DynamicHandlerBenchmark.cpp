@@ -0,0 +1,75 @@
+#include "BenchmarkCommon.h"
+
+#include "WebServer.h"
+
+// Requests/sec for a static page while other clients keep a slow endpoint busy (each request to it takes WorkMs),
+// with the slow work done by a request handler on the listen loop against a dynamic handler on the handler pool.
+// One worker, so anything run on the loop holds up every connection it serves.
+int main(int argc, char** argv)
+{
+    const int BasePort = (argc > 1) ? atoi(argv[1]) : 28040;
+    const double Seconds = (argc > 2) ? atof(argv[2]) : 2.0;
+    const int WorkMs = (argc > 3) ? atoi(argv[3]) : 5;
+
+    FILE* Report = Benchmark::SilenceServerLogging();
+    if(WebServer::SocketGlobalInit() != 0)
+    {
+        fprintf(Report, "Socket init failed\n");
+        return 1;
+    }
+
+    auto DoSlowWork = [WorkMs] () {
+        std::this_thread::sleep_for(std::chrono::milliseconds(WorkMs));
+        WebServer::ServerResponseMessage Response(WebServer::ServerResponseStatusCode::ServerResponseStatusCode_200);
+        Response.AddContent(std::vector<char>(64, 'x'), "text/plain");
+        return Response;
+    };
+
+    fprintf(Report, "slow requests take %dms, 16 connections on them, 16 on the static page\n", WorkMs);
+    fprintf(Report, "%-22s %-16s %-16s %-10s\n", "slow work runs on", "static req/sec", "slow req/sec", "failed");
+
+    for(bool bOnPool : { false, true })
+    {
+        const std::string Port = std::to_string(BasePort + (bOnPool ? 1 : 0));
+
+        WebServer::ListenServer Server;
+        WebServer::ListenServerConfig Config;
+        Config.NumHandlerThreads = 16;
+        if(Server.Initialise(Port.c_str(), Config) != 0)
+        {
+            fprintf(Report, "server start failed\n");
+            continue;
+        }
+        Server.UploadData("/", WebServer::GenerateHtmlPage("benchmark"), "text/html", {});
+
+        // Both answer a body-less POST, the request handler from the loop once its (empty) body's been read
+        if(bOnPool)
+        {
+            Server.CreateDynamicHandler(WebServer::ServerRequestType::ServerRequestType_POST, "/slow", [DoSlowWork] (WebServer::HandlerRequest&) { return DoSlowWork(); });
+        }
+        else
+        {
+            WebServer::RequestHandler Handler;
+            Handler.OnRequestComplete = [DoSlowWork] (uint64_t) { return DoSlowWork(); };
+            Server.CreateRequestHandler("/slow", Handler);
+        }
+        Server.AsyncStart();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        const uint16_t PortNumber = (uint16_t) std::stoi(Port);
+        const std::string SlowRequest = "POST /slow HTTP/1.1\r\nHost: localhost\r\nContent-Length: 0\r\n\r\n";
+        Benchmark::LoadResult SlowLoad;
+        std::thread SlowClients([&] () { SlowLoad = Benchmark::RunHttpLoad(PortNumber, SlowRequest, 16, Seconds, true); });
+        Benchmark::LoadResult StaticLoad = Benchmark::RunHttpLoad(PortNumber, Benchmark::BuildGetRequest("/", true), 16, Seconds, true);
+        SlowClients.join();
+
+        fprintf(Report, "%-22s %-16.0f %-16.0f %-10llu\n", bOnPool ? "handler pool" : "listen loop", StaticLoad.RequestsPerSecond(), SlowLoad.RequestsPerSecond(),
+            (unsigned long long) (StaticLoad.Failed + SlowLoad.Failed));
+
+        Server.CloseServer();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+
+    fflush(Report);
+    _exit(0);
+}
@@ -0,0 +1,57 @@
+#include "BenchmarkCommon.h"
+
+#include "WebServerAPI.h"
+
+// Idle cpu and requests/sec (new connection per request, keep-alive, and keep-alive with 8 pipelined requests) of the
+// listen loop at 10, 1k and 10k open connections.
+// Only uses the public API so the same source can be built against an older revision for comparison.
+int main(int argc, char** argv)
+{
+    const std::string Port = (argc > 1) ? argv[1] : "28015";
+    const double Seconds = (argc > 2) ? atof(argv[2]) : 2.0;
+
+    FILE* Report = Benchmark::SilenceServerLogging();
+    int FileLimit = Benchmark::RaiseFileLimit();
+
+    if(WebServerAPI::WebServerGlobalInit() == false || WebServerAPI::StartSever(Port) == -1)
+    {
+        fprintf(Report, "Server start failed\n");
+        return 1;
+    }
+
+    int ServerID = std::stoi(Port);
+    WebServerAPI::UploadData(ServerID, { "/", WebServer::GenerateHtmlPage("benchmark"), "text/html", {} });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    fprintf(Report, "%-12s %-12s %-14s %-14s %-14s %-10s\n", "connections", "idle-cpu", "requests/sec", "keep-alive", "pipelined", "failed");
+
+    const std::string Request = Benchmark::BuildGetRequest("/", false);
+    const std::string KeepAliveRequest = Benchmark::BuildGetRequest("/", true);
+
+    constexpr int PipelineDepth = 8;
+    std::string PipelinedRequest;
+    for(int i = 0; i < PipelineDepth; i++)
+    {
+        PipelinedRequest += KeepAliveRequest;
+    }
+    for(int Connections : { 10, 1000, 10000 })
+    {
+        int ClampedConnections = Benchmark::ClampConnections(Connections, FileLimit);
+
+        double IdleCpu = Benchmark::MeasureIdleCpu((uint16_t) ServerID, ClampedConnections, Seconds);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        Benchmark::LoadResult Load = Benchmark::RunHttpLoad((uint16_t) ServerID, Request, ClampedConnections, Seconds, false);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        Benchmark::LoadResult KeepAliveLoad = Benchmark::RunHttpLoad((uint16_t) ServerID, KeepAliveRequest, ClampedConnections, Seconds, true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        Benchmark::LoadResult PipelinedLoad = Benchmark::RunHttpLoad((uint16_t) ServerID, PipelinedRequest, ClampedConnections, Seconds, true, PipelineDepth);
+
+        fprintf(Report, "%-12d %-12.3f %-14.0f %-14.0f %-14.0f %-10llu\n", ClampedConnections, IdleCpu, Load.RequestsPerSecond(), KeepAliveLoad.RequestsPerSecond(),
+            PipelinedLoad.RequestsPerSecond(), (unsigned long long) (Load.Failed + KeepAliveLoad.Failed + PipelinedLoad.Failed));
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
+
+    // No stop in the API, the listen thread goes down with the process
+    fflush(Report);
+    _exit(0);
+}
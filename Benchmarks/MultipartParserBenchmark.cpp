@@ -0,0 +1,247 @@
+#include "MultipartParser.h"
+#include "HttpLineScanner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+// Streams a 1 GB multipart/form-data body (four large binary file parts between a few small fields) through the parser
+// a socket read at a time with each boundary search the cpu supports, generating the body as it goes so it's never
+// held whole. Every search is first checked on small bodies full of near-miss delimiters, fed in random splits.
+namespace
+{
+    using namespace WebServer;
+
+    typedef std::chrono::steady_clock Clock;
+
+    const std::string Boundary = "----WebKitFormBoundary7MA4YWxkTrZu0gW";
+
+    struct BodySegment
+    {
+        std::string Text;           // sent as it is
+        int64_t NumDataBytes = 0;   // or this many bytes cycled from the data block
+    };
+
+    struct ParseTotals
+    {
+        int NumParts = 0;
+        int NumEnded = 0;
+        int64_t NumDataBytes = 0;
+        uint64_t Checksum = 0;
+        bool bComplete = false;
+    };
+
+    std::string BuildPartHead(const std::string& Name, const std::string& FileName, bool bFirst)
+    {
+        std::string Head = bFirst ? "--" + Boundary + "\r\n" : "\r\n--" + Boundary + "\r\n";
+        Head += "Content-Disposition: form-data; name=\"" + Name + "\"";
+        if(FileName.empty() == false)
+        {
+            Head += "; filename=\"" + FileName + "\"\r\nContent-Type: application/octet-stream";
+        }
+        return Head + "\r\n\r\n";
+    }
+
+    std::vector<BodySegment> BuildBodySegments(int64_t TotalBytes)
+    {
+        std::vector<BodySegment> Segments;
+        Segments.push_back({ BuildPartHead("title", "", true) + "Holiday photos", 0 });
+        Segments.push_back({ BuildPartHead("description", "", false) + "Four raw files from the trip", 0 });
+        for(int i = 0; i < 4; i++)
+        {
+            Segments.push_back({ BuildPartHead("file" + std::to_string(i), "IMG_" + std::to_string(1000 + i) + ".CR3", false), 0 });
+            Segments.push_back({ "", TotalBytes / 4 });
+        }
+        Segments.push_back({ "\r\n--" + Boundary + "--\r\n", 0 });
+        return Segments;
+    }
+
+    // Hands out the body a read at a time, data bytes cycled from a block of random bytes
+    class BodyGenerator
+    {
+    public:
+        BodyGenerator(const std::vector<BodySegment>& Segments, const std::vector<char>& DataBlock)
+            : mSegments(Segments), mDataBlock(DataBlock)
+        {
+        }
+
+        int Read(char* Out, int MaxLen)
+        {
+            int ReadLen = 0;
+            while(ReadLen < MaxLen && mSegment < mSegments.size())
+            {
+                const BodySegment& Segment = mSegments[mSegment];
+                const int64_t SegmentLen = Segment.Text.empty() ? Segment.NumDataBytes : (int64_t) Segment.Text.size();
+                int CopyLen = (int) std::min<int64_t>(MaxLen - ReadLen, SegmentLen - mOffset);
+                if(Segment.Text.empty())
+                {
+                    const size_t BlockOffset = (size_t) (mOffset % (int64_t) mDataBlock.size());
+                    CopyLen = std::min<int>(CopyLen, (int) (mDataBlock.size() - BlockOffset));
+                    memcpy(Out + ReadLen, mDataBlock.data() + BlockOffset, CopyLen);
+                }
+                else
+                {
+                    memcpy(Out + ReadLen, Segment.Text.data() + mOffset, CopyLen);
+                }
+
+                ReadLen += CopyLen;
+                mOffset += CopyLen;
+                if(mOffset == SegmentLen)
+                {
+                    mSegment++;
+                    mOffset = 0;
+                }
+            }
+            return ReadLen;
+        }
+
+    private:
+        const std::vector<BodySegment>& mSegments;
+        const std::vector<char>& mDataBlock;
+        size_t mSegment = 0;
+        int64_t mOffset = 0;
+    };
+
+    void StartParser(MultipartParser& Parser, ParseTotals& Totals)
+    {
+        Parser.Start(Boundary,
+            [&Totals] (const MultipartPart&) { Totals.NumParts++; return true; },
+            [&Totals] (const char* Data, int DataLen) {
+                Totals.NumDataBytes += DataLen;
+                Totals.Checksum += (unsigned char) Data[0] + (unsigned char) Data[DataLen - 1];
+                return true;
+            },
+            [&Totals] () { Totals.NumEnded++; return true; });
+    }
+
+    double ParseGigabytesPerSecond(const std::vector<BodySegment>& Segments, const std::vector<char>& DataBlock, int ReadSize, ParseTotals& OutTotals)
+    {
+        BodyGenerator Generator(Segments, DataBlock);
+        MultipartParser Parser;
+        StartParser(Parser, OutTotals);
+
+        std::vector<char> Read(ReadSize);
+        int64_t NumBytes = 0;
+        double ParseSeconds = 0;
+        while(true)
+        {
+            int ReadLen = Generator.Read(Read.data(), ReadSize);
+            if(ReadLen == 0)
+            {
+                break;
+            }
+
+            // Only the parser's time counts, not generating the body
+            auto Start = Clock::now();
+            bool bParsed = Parser.Feed(Read.data(), ReadLen);
+            ParseSeconds += std::chrono::duration<double>(Clock::now() - Start).count();
+            NumBytes += ReadLen;
+            if(bParsed == false)
+            {
+                break;
+            }
+        }
+        OutTotals.bComplete = Parser.IsComplete();
+        return (double) NumBytes / (1024.0 * 1024 * 1024) / ParseSeconds;
+    }
+
+    // Parts whose data is full of delimiter prefixes and near misses, checked byte for byte after random splits
+    int CountMismatches(int NumBodies)
+    {
+        std::mt19937 Random(7);
+        const std::string Delimiter = "\r\n--" + Boundary;
+        int NumMismatches = 0;
+
+        for(int n = 0; n < NumBodies; n++)
+        {
+            std::vector<std::string> Parts(1 + Random() % 4);
+            std::string Body = "preamble\r\n";
+            for(size_t p = 0; p < Parts.size(); p++)
+            {
+                for(int Piece = Random() % 40; Piece > 0; Piece--)
+                {
+                    switch(Random() % 4)
+                    {
+                        case 0: Parts[p] += Delimiter.substr(0, Random() % Delimiter.size()); break;
+                        case 1: Parts[p] += "\r\n--" + Boundary.substr(0, Boundary.size() - 1) + "x"; break;
+                        case 2: Parts[p] += "\r"; break;
+                        default: Parts[p] += std::string(Random() % 70, (char) ('a' + Random() % 26)); break;
+                    }
+                }
+                Body += BuildPartHead("part" + std::to_string(p), "", p == 0) + Parts[p];
+            }
+            Body += "\r\n--" + Boundary + "--\r\nepilogue";
+
+            std::vector<std::string> Parsed;
+            MultipartParser Parser;
+            Parser.Start(Boundary,
+                [&Parsed] (const MultipartPart&) { Parsed.emplace_back(); return true; },
+                [&Parsed] (const char* Data, int DataLen) { Parsed.back().append(Data, DataLen); return true; },
+                nullptr);
+
+            size_t Offset = 0;
+            while(Offset < Body.size())
+            {
+                size_t SplitLen = std::min(Body.size() - Offset, (size_t) (1 + Random() % 64));
+                Parser.Feed(Body.data() + Offset, (int) SplitLen);
+                Offset += SplitLen;
+            }
+            NumMismatches += (Parser.IsComplete() && Parsed == Parts) ? 0 : 1;
+        }
+        return NumMismatches;
+    }
+
+    const char* GetImplementationName(HttpScanImplementation Implementation)
+    {
+        switch(Implementation)
+        {
+            case HttpScanImplementation::HttpScanImplementation_Avx2:
+                return "avx2";
+            case HttpScanImplementation::HttpScanImplementation_Sse42:
+                return "sse2";
+            default:
+                return "scalar (memchr)";
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int64_t TotalBytes = (int64_t) ((argc > 1) ? atoi(argv[1]) : 1024) * 1024 * 1024;
+    const int ReadSize = 16 * 1024;
+    const HttpScanImplementation DefaultImplementation = GetHttpScanImplementation();
+
+    std::vector<char> DataBlock(1024 * 1024 + 7);
+    std::mt19937 Random(1);
+    for(char& c : DataBlock)
+    {
+        c = (char) Random();
+    }
+    const std::vector<BodySegment> Segments = BuildBodySegments(TotalBytes);
+
+    int NumMismatches = 0;
+    printf("%-18s %12s %8s\n", "boundary search", "GB/s", "check");
+    for(HttpScanImplementation Implementation : { HttpScanImplementation::HttpScanImplementation_Scalar, HttpScanImplementation::HttpScanImplementation_Sse42, HttpScanImplementation::HttpScanImplementation_Avx2 })
+    {
+        if(SetHttpScanImplementation(Implementation) == false)
+        {
+            continue;
+        }
+
+        const int Mismatches = CountMismatches(2000);
+        ParseTotals Totals;
+        const double GigabytesPerSecond = ParseGigabytesPerSecond(Segments, DataBlock, ReadSize, Totals);
+        const bool bTotalsRight = Totals.bComplete && Totals.NumParts == 6 && Totals.NumEnded == 6 && Totals.NumDataBytes >= TotalBytes;
+        NumMismatches += Mismatches + (bTotalsRight ? 0 : 1);
+        printf("%-18s %12.2f %8s\n", GetImplementationName(Implementation), GigabytesPerSecond, (Mismatches == 0 && bTotalsRight) ? "ok" : "FAILED");
+    }
+    printf("\n%lld MB multipart body in %d KB reads, 6 parts\n", (long long) (TotalBytes >> 20), ReadSize / 1024);
+
+    SetHttpScanImplementation(DefaultImplementation);
+    return (NumMismatches == 0) ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+#include "WebServer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+// Feeds a typical browser request to ServerRequestMessage whole, in random splits and a byte at a time, the way it
+// trickles off the socket. The last run re-parses everything received so far with a fresh message on every byte, which
+// is what the receive callback did before parsing was resumable. Also checks a parse makes no heap allocations.
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    size_t NumHeapAllocations = 0;
+
+    const std::string Request =
+        "GET /images/banner.webp?size=large&theme=dark HTTP/1.1\r\n"
+        "Host: localhost:8080\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:120.0) Gecko/20100101 Firefox/120.0\r\n"
+        "Accept: image/avif,image/webp,*/*\r\n"
+        "Accept-Language: en-GB,en;q=0.5\r\n"
+        "Accept-Encoding: gzip, deflate, br\r\n"
+        "Connection: keep-alive\r\n"
+        "Referer: http://localhost:8080/index.html\r\n"
+        "Cookie: session=4f1c2a9be07d4d0c8a1e5b6f3c2d1e0f; theme=dark\r\n"
+        "Sec-Fetch-Dest: image\r\n"
+        "Sec-Fetch-Mode: no-cors\r\n"
+        "Sec-Fetch-Site: same-origin\r\n"
+        "\r\n";
+
+    double NsPerRequest(Clock::time_point Start, int NumRequests)
+    {
+        return std::chrono::duration<double, std::nano>(Clock::now() - Start).count() / NumRequests;
+    }
+
+    // Hands the parser the request a split at a time, each call sees everything received so far
+    bool ParseInSplits(const std::vector<int>& SplitEnds)
+    {
+        WebServer::ServerRequestMessage Message;
+        int RequestLength = 0;
+        for(int SplitEnd : SplitEnds)
+        {
+            RequestLength = Message.ParseData(Request.data(), SplitEnd);
+        }
+        return RequestLength == (int) Request.size() && Message.mHeaders.GetNum() == 11;
+    }
+
+    bool ReparseEachByte()
+    {
+        int RequestLength = 0;
+        for(int Received = 1; Received <= (int) Request.size(); Received++)
+        {
+            WebServer::ServerRequestMessage Message;
+            RequestLength = Message.ParseData(Request.data(), Received);
+        }
+        return RequestLength == (int) Request.size();
+    }
+}
+
+// Counts every allocation so the parse itself can be checked for them
+void* operator new(size_t Size)
+{
+    NumHeapAllocations++;
+    void* Memory = malloc(Size);
+    if(Memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return Memory;
+}
+
+void operator delete(void* Memory) noexcept
+{
+    free(Memory);
+}
+
+void operator delete(void* Memory, size_t) noexcept
+{
+    free(Memory);
+}
+
+int main(int argc, char** argv)
+{
+    const int NumRequests = (argc > 1) ? atoi(argv[1]) : 100000;
+    const int RequestSize = (int) Request.size();
+
+    std::vector<int> WholeRequest = { RequestSize };
+
+    std::vector<int> ByteAtATime;
+    for(int i = 1; i <= RequestSize; i++)
+    {
+        ByteAtATime.push_back(i);
+    }
+
+    // A spread of split points per run, like segments arriving at whatever sizes the network likes
+    constexpr int NumSplitPatterns = 64;
+    std::mt19937 Random(1234);
+    std::vector<std::vector<int>> RandomSplits(NumSplitPatterns);
+    for(std::vector<int>& Splits : RandomSplits)
+    {
+        int SplitEnd = 0;
+        while(SplitEnd < RequestSize)
+        {
+            SplitEnd = std::min(RequestSize, SplitEnd + 1 + (int) (Random() % 64));
+            Splits.push_back(SplitEnd);
+        }
+    }
+
+    int NumFailed = 0;
+    printf("request of %d bytes, %d requests per run\n\n", RequestSize, NumRequests);
+    printf("%-40s %12s\n", "feed", "ns/request");
+
+    auto Start = Clock::now();
+    for(int i = 0; i < NumRequests; i++)
+    {
+        NumFailed += ParseInSplits(WholeRequest) ? 0 : 1;
+    }
+    printf("%-40s %12.1f\n", "whole request", NsPerRequest(Start, NumRequests));
+
+    Start = Clock::now();
+    for(int i = 0; i < NumRequests; i++)
+    {
+        NumFailed += ParseInSplits(RandomSplits[i % NumSplitPatterns]) ? 0 : 1;
+    }
+    printf("%-40s %12.1f\n", "random splits (1-64 bytes)", NsPerRequest(Start, NumRequests));
+
+    Start = Clock::now();
+    for(int i = 0; i < NumRequests; i++)
+    {
+        NumFailed += ParseInSplits(ByteAtATime) ? 0 : 1;
+    }
+    printf("%-40s %12.1f\n", "byte at a time, resumed", NsPerRequest(Start, NumRequests));
+
+    // Quadratic, a tenth of the runs keeps it quick
+    const int NumReparseRequests = std::max(1, NumRequests / 10);
+    Start = Clock::now();
+    for(int i = 0; i < NumReparseRequests; i++)
+    {
+        NumFailed += ReparseEachByte() ? 0 : 1;
+    }
+    printf("%-40s %12.1f\n", "byte at a time, re-parsed (previous)", NsPerRequest(Start, NumReparseRequests));
+
+    size_t AllocationsBefore = NumHeapAllocations;
+    NumFailed += ParseInSplits(RandomSplits[0]) ? 0 : 1;
+    printf("\nheap allocations per request: %zu\n", NumHeapAllocations - AllocationsBefore);
+
+    if(NumFailed > 0)
+    {
+        printf("\n%d runs failed to parse the request\n", NumFailed);
+        return 1;
+    }
+    return 0;
+}
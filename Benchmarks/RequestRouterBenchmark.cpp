@@ -0,0 +1,118 @@
+#include "WebServer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+// Looks up request urls among 50k registered routes, the radix router against the exact std::map lookup it replaced.
+// Static routes are looked up in both, the router then does the same with every fifth route declared with parameters
+// (which the map can't express at all). Lookups are shuffled so neither gets to walk its routes in order.
+namespace
+{
+    using namespace WebServer;
+
+    typedef std::chrono::steady_clock Clock;
+
+    const char* Resources[] = { "users", "orders", "products", "invoices", "sessions", "reports", "teams", "projects", "files", "events" };
+    const char* Actions[] = { "", "/profile", "/settings", "/history", "/items", "/comments", "/audit" };
+
+    std::string BuildUrl(int i, const std::string& Id)
+    {
+        return "/api/v" + std::to_string(1 + i % 3) + "/" + Resources[(i / 3) % 10] + "/" + Id + Actions[(i / 30) % 7];
+    }
+
+    template<typename LookupFunc>
+    double NanosecondsPerLookup(const std::vector<std::string>& Urls, int NumLookups, const LookupFunc& Lookup, int& OutNumFound)
+    {
+        OutNumFound = 0;
+        auto Start = Clock::now();
+        for(int i = 0; i < NumLookups; i++)
+        {
+            OutNumFound += Lookup(Urls[i % Urls.size()]) ? 1 : 0;
+        }
+        return std::chrono::duration<double, std::nano>(Clock::now() - Start).count() / NumLookups;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int NumRoutes = (argc > 1) ? atoi(argv[1]) : 50000;
+    const int NumLookups = 2000000;
+    std::mt19937 Random(1);
+
+    // Concrete urls for every route, plus as many that aren't registered but differ only in the last digit of the id
+    std::vector<std::string> StaticUrls;
+    std::vector<std::string> MissUrls;
+    for(int i = 0; i < NumRoutes; i++)
+    {
+        StaticUrls.push_back(BuildUrl(i, std::to_string(100000 + 2 * i)));
+        MissUrls.push_back(BuildUrl(i, std::to_string(100000 + 2 * i + 1)));
+    }
+
+    ServerUrlDataMap UrlData;
+    RequestRouter StaticRouter;
+    for(int i = 0; i < NumRoutes; i++)
+    {
+        UrlData.emplace(StaticUrls[i], ServerResponseMessage(ServerResponseStatusCode::ServerResponseStatusCode_200));
+        StaticRouter.AddRoute(ServerRequestType::ServerRequestType_GET, StaticUrls[i], (uint32_t) i);
+    }
+
+    // The same routes with every fifth one's id a parameter, so one route stands in for any id
+    RequestRouter ParamRouter;
+    std::vector<std::string> ParamUrls;
+    for(int i = 0; i < NumRoutes; i++)
+    {
+        const bool bParam = i % 5 == 0;
+        ParamRouter.AddRoute(ServerRequestType::ServerRequestType_GET, bParam ? BuildUrl(i, std::to_string(i) + "/:id") : StaticUrls[i], (uint32_t) i);
+        ParamUrls.push_back(bParam ? BuildUrl(i, std::to_string(i) + "/" + std::to_string(Random() % 1000000)) : StaticUrls[i]);
+    }
+
+    std::shuffle(StaticUrls.begin(), StaticUrls.end(), Random);
+    std::shuffle(MissUrls.begin(), MissUrls.end(), Random);
+    std::shuffle(ParamUrls.begin(), ParamUrls.end(), Random);
+
+    auto MapLookup = [&UrlData] (const std::string& Url) { return UrlData.find(std::string_view(Url)) != UrlData.end(); };
+    auto StaticRouterLookup = [&StaticRouter] (const std::string& Url) {
+        RouteParams Params;
+        return StaticRouter.Match(ServerRequestType::ServerRequestType_GET, Url, Params) != RequestRouter::NoRoute;
+    };
+    auto ParamRouterLookup = [&ParamRouter] (const std::string& Url) {
+        RouteParams Params;
+        return ParamRouter.Match(ServerRequestType::ServerRequestType_GET, Url, Params) != RequestRouter::NoRoute;
+    };
+
+    struct LookupRun
+    {
+        const char* Name;
+        double Nanoseconds;
+        int NumFound;
+        int NumExpected;
+    };
+    std::vector<LookupRun> Runs;
+    int NumFound = 0;
+    double Nanoseconds = NanosecondsPerLookup(StaticUrls, NumLookups, MapLookup, NumFound);
+    Runs.push_back({ "std::map, hits", Nanoseconds, NumFound, NumLookups });
+    Nanoseconds = NanosecondsPerLookup(StaticUrls, NumLookups, StaticRouterLookup, NumFound);
+    Runs.push_back({ "router, hits", Nanoseconds, NumFound, NumLookups });
+    Nanoseconds = NanosecondsPerLookup(MissUrls, NumLookups, MapLookup, NumFound);
+    Runs.push_back({ "std::map, misses", Nanoseconds, NumFound, 0 });
+    Nanoseconds = NanosecondsPerLookup(MissUrls, NumLookups, StaticRouterLookup, NumFound);
+    Runs.push_back({ "router, misses", Nanoseconds, NumFound, 0 });
+    Nanoseconds = NanosecondsPerLookup(ParamUrls, NumLookups, ParamRouterLookup, NumFound);
+    Runs.push_back({ "router, 1 in 5 with :id", Nanoseconds, NumFound, NumLookups });
+
+    bool bAllFound = true;
+    printf("%d routes, %d lookups each, router has %zu nodes\n\n", NumRoutes, NumLookups, StaticRouter.GetNumNodes());
+    printf("%-26s %12s\n", "lookup", "ns/lookup");
+    for(const LookupRun& Run : Runs)
+    {
+        const bool bRight = Run.NumFound == Run.NumExpected;
+        bAllFound = bAllFound && bRight;
+        printf("%-26s %12.1f%s\n", Run.Name, Run.Nanoseconds, bRight ? "" : "  WRONG RESULTS");
+    }
+    return bAllFound ? 0 : 1;
+}
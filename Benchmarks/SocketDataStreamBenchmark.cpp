@@ -0,0 +1,106 @@
+#include "Common.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Streams a large payload into a SocketDataStream a read at a time, against the previous stream's growth of one
+// calloc + copy per extra 1 KB, then times the small request cycle (append, linear view, consume) a keep-alive
+// connection goes through.
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    double SecondsSince(Clock::time_point Start)
+    {
+        return std::chrono::duration<double>(Clock::now() - Start).count();
+    }
+
+    // What IncreaseBufferAllocated used to do every time the data outgrew the buffer
+    double FixedGrowthAppendSeconds(const std::vector<char>& Read, size_t TotalBytes)
+    {
+        constexpr int GrowthSize = 1024;
+        char* Buffer = nullptr;
+        size_t BufferSize = 0;
+        size_t DataLen = 0;
+
+        auto Start = Clock::now();
+        while(DataLen < TotalBytes)
+        {
+            while(DataLen + Read.size() > BufferSize)
+            {
+                char* NewBuffer = (char*) calloc(BufferSize + GrowthSize, 1);
+                memcpy(NewBuffer, Buffer, DataLen);
+                free(Buffer);
+                Buffer = NewBuffer;
+                BufferSize += GrowthSize;
+            }
+            memcpy(&Buffer[DataLen], Read.data(), Read.size());
+            DataLen += Read.size();
+        }
+        double Seconds = SecondsSince(Start);
+
+        free(Buffer);
+        return Seconds;
+    }
+
+    double ChainedAppendSeconds(const std::vector<char>& Read, size_t TotalBytes, bool bLinearise)
+    {
+        WebServer::SocketDataStream Stream;
+
+        auto Start = Clock::now();
+        while((size_t) Stream.GetDataLen() < TotalBytes)
+        {
+            Stream.StreamRequestData(Read.data(), (int) Read.size());
+        }
+        if(bLinearise && Stream.GetLinearData() == nullptr)
+        {
+            return 0.0;
+        }
+        return SecondsSince(Start);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t LargeMB = (argc > 1) ? (size_t) atoi(argv[1]) : 256;
+    const size_t ComparisonMB = 4;
+    const int NumRequestCycles = 1000000;
+
+    std::vector<char> Read(WebServer::SocketChunkPool::ChunkSize, 'x');
+
+    double FixedSeconds = FixedGrowthAppendSeconds(Read, ComparisonMB << 20);
+    double ChainedSeconds = ChainedAppendSeconds(Read, ComparisonMB << 20, false);
+    printf("%-34s %10s %12s\n", "append", "MB", "MB/s");
+    printf("%-34s %10zu %12.1f\n", "fixed 1 KB growth (previous)", ComparisonMB, ComparisonMB / FixedSeconds);
+    printf("%-34s %10zu %12.1f\n", "chained chunks", ComparisonMB, ComparisonMB / ChainedSeconds);
+
+    ChainedSeconds = ChainedAppendSeconds(Read, LargeMB << 20, false);
+    printf("%-34s %10zu %12.1f\n", "chained chunks", LargeMB, LargeMB / ChainedSeconds);
+
+    ChainedSeconds = ChainedAppendSeconds(Read, LargeMB << 20, true);
+    printf("%-34s %10zu %12.1f\n", "chained chunks + linear view", LargeMB, LargeMB / ChainedSeconds);
+
+    // A keep-alive connection's stream, one small request in and answered per read
+    const char Request[] = "GET /index.html HTTP/1.1\r\nHost: localhost\r\nUser-Agent: bench\r\nAccept: */*\r\n\r\n";
+    WebServer::SocketDataStream Stream;
+    size_t Checksum = 0;
+
+    auto Start = Clock::now();
+    for(int i = 0; i < NumRequestCycles; i++)
+    {
+        int WriteLength = (int) sizeof(Request) - 1;
+        char* WriteData = Stream.PrepareWrite(WriteLength);
+        memcpy(WriteData, Request, WriteLength);
+        Stream.CommitWrite(WriteLength);
+
+        Checksum += (size_t) Stream.GetLinearData()[i % WriteLength];
+        Stream.Consume(Stream.GetDataLen());
+    }
+    double CycleNs = SecondsSince(Start) * 1e9 / NumRequestCycles;
+
+    printf("\nrequest cycle (append, view, consume): %.1f ns (checksum %zu)\n", CycleNs, Checksum);
+    return 0;
+}
@@ -0,0 +1,182 @@
+#include "WebServer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+// Looks up urls among routes declared at compile time, the generated perfect hash table against the std::map lookup
+// the server used to do and the radix router. A small site's worth of hand written routes, then 1024 generated ones.
+// Lookups are shuffled, misses are urls one character off a route.
+namespace
+{
+    using namespace WebServer;
+
+    typedef std::chrono::steady_clock Clock;
+
+    constexpr ServerRequestType GET = ServerRequestType::ServerRequestType_GET;
+    constexpr ServerRequestType POST = ServerRequestType::ServerRequestType_POST;
+
+    constexpr StaticRoute SiteRoutes[] =
+    {
+        { GET, "/" }, { GET, "/index.html" }, { GET, "/about" }, { GET, "/contact" }, { GET, "/pricing" }, { GET, "/blog" },
+        { GET, "/login" }, { GET, "/logout" }, { GET, "/signup" }, { GET, "/account" }, { GET, "/account/settings" },
+        { GET, "/account/billing" }, { GET, "/account/security" }, { GET, "/account/notifications" }, { GET, "/docs" },
+        { GET, "/docs/getting-started" }, { GET, "/docs/configuration" }, { GET, "/docs/api" }, { GET, "/docs/faq" },
+        { GET, "/favicon.ico" }, { GET, "/robots.txt" }, { GET, "/sitemap.xml" }, { GET, "/css/site.css" },
+        { GET, "/css/docs.css" }, { GET, "/js/site.js" }, { GET, "/js/docs.js" }, { GET, "/js/vendor.js" },
+        { GET, "/img/logo.svg" }, { GET, "/img/hero.webp" }, { GET, "/img/og-card.png" }, { GET, "/fonts/inter.woff2" },
+        { GET, "/api/v1/status" }, { GET, "/api/v1/health" }, { GET, "/api/v1/users" }, { GET, "/api/v1/teams" },
+        { GET, "/api/v1/projects" }, { GET, "/api/v1/invoices" }, { GET, "/api/v1/events" }, { GET, "/api/v1/search" },
+        { POST, "/api/v1/users" }, { POST, "/api/v1/teams" }, { POST, "/api/v1/projects" }, { POST, "/api/v1/login" },
+        { POST, "/api/v1/logout" }, { POST, "/api/v1/upload" }, { POST, "/api/v1/events" }, { GET, "/ws/chat" },
+        { GET, "/ws/notifications" }, { GET, "/terms" }, { GET, "/privacy" }, { GET, "/careers" }, { GET, "/press" },
+        { GET, "/status" }, { GET, "/changelog" }, { GET, "/security.txt" }, { GET, "/.well-known/security.txt" },
+        { GET, "/manifest.json" }, { GET, "/service-worker.js" }, { GET, "/offline.html" }, { GET, "/404.html" },
+        { GET, "/500.html" }, { GET, "/feed.xml" }, { GET, "/search" }, { GET, "/help" },
+    };
+
+    constexpr auto SiteRouteTable = MakeStaticRouteTable(SiteRoutes);
+
+    // What a server would do with the index, the case labels are worked out by the compiler
+    int DispatchSiteRoute(std::string_view Url)
+    {
+        switch(SiteRouteTable.Find(GET, Url))
+        {
+            case SiteRouteTable.IndexOf(GET, "/"):
+            case SiteRouteTable.IndexOf(GET, "/index.html"):
+                return 1;
+            case SiteRouteTable.IndexOf(GET, "/api/v1/status"):
+                return 2;
+            case -1:
+                return 0;
+            default:
+                return 3;
+        }
+    }
+
+    static_assert(SiteRouteTable.Find(GET, "/docs/api") == 17 && SiteRouteTable.Find(POST, "/docs/api") == -1, "table is built at compile time");
+
+    // "/catalog/item-0000/view" and on, generated at compile time into one block of bytes
+    constexpr size_t NumGeneratedRoutes = 1024;
+    constexpr size_t GeneratedUrlLength = 23;
+
+    constexpr std::array<char, NumGeneratedRoutes * GeneratedUrlLength> GeneratedUrlBytes = []
+    {
+        std::array<char, NumGeneratedRoutes * GeneratedUrlLength> Bytes = {};
+        constexpr std::string_view Prefix = "/catalog/item-";
+        constexpr std::string_view Suffix = "/view";
+        for(size_t i = 0; i < NumGeneratedRoutes; i++)
+        {
+            char* Url = Bytes.data() + i * GeneratedUrlLength;
+            for(size_t c = 0; c < Prefix.size(); c++)
+            {
+                Url[c] = Prefix[c];
+            }
+            for(size_t Digit = 0, Value = i; Digit < 4; Digit++, Value /= 10)
+            {
+                Url[Prefix.size() + 3 - Digit] = (char) ('0' + Value % 10);
+            }
+            for(size_t c = 0; c < Suffix.size(); c++)
+            {
+                Url[Prefix.size() + 4 + c] = Suffix[c];
+            }
+        }
+        return Bytes;
+    }();
+
+    constexpr std::array<StaticRoute, NumGeneratedRoutes> GeneratedRoutes = []
+    {
+        std::array<StaticRoute, NumGeneratedRoutes> Routes = {};
+        for(size_t i = 0; i < NumGeneratedRoutes; i++)
+        {
+            Routes[i] = { GET, std::string_view(GeneratedUrlBytes.data() + i * GeneratedUrlLength, GeneratedUrlLength) };
+        }
+        return Routes;
+    }();
+
+    constexpr auto GeneratedRouteTable = MakeStaticRouteTable(GeneratedRoutes);
+
+    template<typename LookupFunc>
+    double NanosecondsPerLookup(const std::vector<std::pair<ServerRequestType, std::string>>& Urls, int NumLookups, const LookupFunc& Lookup, int& OutNumFound)
+    {
+        OutNumFound = 0;
+        auto Start = Clock::now();
+        for(int i = 0; i < NumLookups; i++)
+        {
+            const auto& Url = Urls[i % Urls.size()];
+            OutNumFound += Lookup(Url.first, Url.second) ? 1 : 0;
+        }
+        return std::chrono::duration<double, std::nano>(Clock::now() - Start).count() / NumLookups;
+    }
+
+    // Returns false if any lookup found the wrong thing
+    template<size_t NumRoutes>
+    bool RunTable(const char* Name, const StaticRouteTable<NumRoutes>& Table, int NumLookups)
+    {
+        // The server's map is keyed by url alone, so POST routes get their own prefix in it
+        ServerUrlDataMap UrlData;
+        RequestRouter Router;
+        std::vector<std::pair<ServerRequestType, std::string>> HitUrls;
+        std::vector<std::pair<ServerRequestType, std::string>> MissUrls;
+        for(size_t i = 0; i < Table.Size(); i++)
+        {
+            const StaticRoute& Route = Table.GetRoute((int) i);
+            std::string MapKey = ((Route.Method == POST) ? "POST " : "") + std::string(Route.Url);
+            UrlData.emplace(MapKey, ServerResponseMessage(ServerResponseStatusCode::ServerResponseStatusCode_200));
+            Router.AddRoute(Route.Method, Route.Url, (uint32_t) i);
+
+            HitUrls.emplace_back(Route.Method, std::string(Route.Url));
+            std::string MissUrl(Route.Url);
+            MissUrl.back() = (MissUrl.back() == 'x') ? 'y' : 'x';
+            MissUrls.emplace_back(Route.Method, MissUrl);
+        }
+
+        std::mt19937 Random(1);
+        std::shuffle(HitUrls.begin(), HitUrls.end(), Random);
+        std::shuffle(MissUrls.begin(), MissUrls.end(), Random);
+
+        auto TableLookup = [&Table] (ServerRequestType Method, const std::string& Url) { return Table.Find(Method, Url) >= 0; };
+        StaticRouteLookup Lookup = Table.GetLookup();
+        auto ServerLookup = [&Lookup] (ServerRequestType Method, const std::string& Url) { return Lookup.Find(Method, Url) >= 0; };
+        auto MapLookup = [&UrlData] (ServerRequestType Method, const std::string& Url) {
+            return (Method == POST) ? UrlData.find("POST " + Url) != UrlData.end() : UrlData.find(std::string_view(Url)) != UrlData.end();
+        };
+        auto RouterLookup = [&Router] (ServerRequestType Method, const std::string& Url) {
+            RouteParams Params;
+            return Router.Match(Method, Url, Params) != RequestRouter::NoRoute;
+        };
+
+        printf("%s, %zu routes, %u slots\n", Name, Table.Size(), StaticRouteTable<NumRoutes>::NumSlots);
+        printf("%-32s %14s %14s\n", "lookup", "hit ns", "miss ns");
+
+        bool bRight = true;
+        auto Run = [&] (const char* LookupName, const auto& LookupFunction) {
+            int NumHits = 0;
+            int NumMisses = 0;
+            const double HitNanoseconds = NanosecondsPerLookup(HitUrls, NumLookups, LookupFunction, NumHits);
+            const double MissNanoseconds = NanosecondsPerLookup(MissUrls, NumLookups, LookupFunction, NumMisses);
+            const bool bRunRight = NumHits == NumLookups && NumMisses == 0;
+            bRight = bRight && bRunRight;
+            printf("%-32s %14.1f %14.1f%s\n", LookupName, HitNanoseconds, MissNanoseconds, bRunRight ? "" : "  WRONG RESULTS");
+        };
+        Run("static table (template)", TableLookup);
+        Run("static table (server's lookup)", ServerLookup);
+        Run("std::map", MapLookup);
+        Run("radix router", RouterLookup);
+        printf("\n");
+        return bRight;
+    }
+}
+
+int main()
+{
+    const int NumLookups = 4000000;
+
+    bool bRight = RunTable("site routes", SiteRouteTable, NumLookups);
+    bRight = RunTable("generated routes", GeneratedRouteTable, NumLookups) && bRight;
+    bRight = bRight && DispatchSiteRoute("/index.html") == 1 && DispatchSiteRoute("/api/v1/status") == 2 && DispatchSiteRoute("/nope") == 0;
+    return bRight ? 0 : 1;
+}
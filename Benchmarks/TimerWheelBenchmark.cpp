@@ -0,0 +1,105 @@
+#include "TimerWheel.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// Arm, re-arm, cancel and idle tick costs with 100k armed timers, against checking a deadline per timer every
+// loop the way the per-connection stopwatches did. Runs on a virtual clock so the fire pass doesn't need real waits.
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    double NsPerOp(Clock::time_point Start, size_t NumOps)
+    {
+        return std::chrono::duration<double, std::nano>(Clock::now() - Start).count() / NumOps;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int NumTimers = (argc > 1) ? atoi(argv[1]) : 100000;
+    const int NumIdleTicks = 1000;
+
+    std::mt19937 Random(42);
+    std::uniform_int_distribution<int> DelayMs(1000, 60000);
+
+    WebServer::TimerWheel Wheel(10);
+    std::vector<WebServer::TimerHandle> Handles(NumTimers);
+    uint64_t NumFired = 0;
+
+    for(auto& Handle : Handles)
+    {
+        Handle = Wheel.AddTimer([&NumFired] () { NumFired++; });
+    }
+
+    auto Start = Clock::now();
+    for(auto& Handle : Handles)
+    {
+        Wheel.Arm(Handle, DelayMs(Random));
+    }
+    double ArmNs = NsPerOp(Start, NumTimers);
+
+    // Receive timeouts are pushed back on every read
+    Start = Clock::now();
+    for(auto& Handle : Handles)
+    {
+        Wheel.Arm(Handle, DelayMs(Random));
+    }
+    double RearmNs = NsPerOp(Start, NumTimers);
+
+    // A loop iteration where nothing is due, 1ms apart so the wheel crosses a tick every tenth call
+    auto VirtualNow = Clock::now();
+    Start = Clock::now();
+    for(int i = 0; i < NumIdleTicks; i++)
+    {
+        VirtualNow += std::chrono::milliseconds(1);
+        Wheel.Advance(VirtualNow);
+    }
+    double IdleAdvanceNs = NsPerOp(Start, NumIdleTicks);
+
+    // The same iteration when every connection checks its own deadline
+    std::vector<Clock::time_point> Deadlines(NumTimers);
+    for(auto& Deadline : Deadlines)
+    {
+        Deadline = VirtualNow + std::chrono::milliseconds(DelayMs(Random));
+    }
+    uint64_t NumDue = 0;
+    Start = Clock::now();
+    for(int i = 0; i < NumIdleTicks; i++)
+    {
+        auto Now = Clock::now();
+        for(const auto& Deadline : Deadlines)
+        {
+            NumDue += Now >= Deadline;
+        }
+    }
+    double PollingNs = NsPerOp(Start, NumIdleTicks);
+
+    // Let everything expire
+    Start = Clock::now();
+    Wheel.Advance(VirtualNow + std::chrono::seconds(61));
+    double FireNs = NsPerOp(Start, NumTimers);
+
+    for(int i = 0; i < NumTimers; i += 2)
+    {
+        Wheel.Arm(Handles[i], DelayMs(Random));
+    }
+    Start = Clock::now();
+    for(int i = 0; i < NumTimers; i += 2)
+    {
+        Wheel.Cancel(Handles[i]);
+    }
+    double CancelNs = NsPerOp(Start, NumTimers / 2);
+
+    printf("timers: %d (fired %llu, armed after cancel %zu)\n", NumTimers, (unsigned long long) NumFired, Wheel.NumArmed());
+    printf("%-34s %10.1f ns\n", "arm", ArmNs);
+    printf("%-34s %10.1f ns\n", "re-arm", RearmNs);
+    printf("%-34s %10.1f ns\n", "cancel", CancelNs);
+    printf("%-34s %10.1f ns\n", "fire (per timer)", FireNs);
+    printf("%-34s %10.1f ns\n", "idle loop, wheel advance", IdleAdvanceNs);
+    printf("%-34s %10.1f ns (due %llu)\n", "idle loop, per-timer deadline scan", PollingNs, (unsigned long long) NumDue);
+    return 0;
+}
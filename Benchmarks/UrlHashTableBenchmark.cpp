@@ -0,0 +1,132 @@
+#include "WebServer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Exact url lookups among 1k, 100k and 1M pages: the std::map the server used to keep its pages in, std::unordered_map,
+// the open addressing table hashing the url at lookup and with the hash worked out beforehand (as a parsed request's
+// is), and the content store's sharded snapshot that the server looks pages up in. Lookups are shuffled, misses are
+// urls one character off a page's.
+namespace
+{
+    using namespace WebServer;
+
+    typedef std::chrono::steady_clock Clock;
+
+    struct BenchmarkPage
+    {
+        std::string Url;
+        const ServerResponseMessage* Page = nullptr;
+    };
+
+    // A mix of the shapes a site's urls come in
+    std::string BuildUrl(size_t Index)
+    {
+        const std::string Number = std::to_string(Index);
+        switch(Index % 4)
+        {
+            case 0: return "/catalog/item-" + Number + "/view";
+            case 1: return "/assets/js/chunk-" + Number + ".js";
+            case 2: return "/blog/2024/post-" + Number;
+            default: return "/u/" + Number;
+        }
+    }
+
+    struct LookupUrl
+    {
+        std::string Url;
+        uint64_t UrlHash = 0;
+    };
+
+    template<typename LookupFunc>
+    double NanosecondsPerLookup(const std::vector<LookupUrl>& Urls, size_t NumLookups, const LookupFunc& Lookup, size_t& OutNumFound)
+    {
+        OutNumFound = 0;
+        auto Start = Clock::now();
+        for(size_t i = 0; i < NumLookups; i++)
+        {
+            OutNumFound += Lookup(Urls[i % Urls.size()]) ? 1 : 0;
+        }
+        return std::chrono::duration<double, std::nano>(Clock::now() - Start).count() / NumLookups;
+    }
+
+    // Returns false if any lookup found the wrong thing
+    bool RunRoutes(size_t NumRoutes, size_t NumLookups)
+    {
+        const ServerResponseMessage Page(ServerResponseStatusCode::ServerResponseStatusCode_200);
+
+        std::map<std::string, const ServerResponseMessage*, std::less<>> OrderedMap;
+        std::unordered_map<std::string, const ServerResponseMessage*> UnorderedMap;
+        UrlHashTable<BenchmarkPage> Table;
+        ContentStore Store;
+        ContentBatch Batch;
+        std::vector<LookupUrl> HitUrls;
+        std::vector<LookupUrl> MissUrls;
+        std::shared_ptr<const ServerResponseMessage> SharedPage(&Page, [] (const ServerResponseMessage*) {});
+        for(size_t i = 0; i < NumRoutes; i++)
+        {
+            std::string Url = BuildUrl(i);
+            const uint64_t UrlHash = ContentSnapshot::HashUrl(Url);
+            OrderedMap.emplace(Url, &Page);
+            UnorderedMap.emplace(Url, &Page);
+            Table.Insert(std::make_shared<const BenchmarkPage>(BenchmarkPage{ Url, &Page }), UrlHash);
+            Batch.Upload(Url, SharedPage);
+
+            std::string MissUrl = Url;
+            MissUrl.back() = (MissUrl.back() == 'x') ? 'y' : 'x';
+            MissUrls.push_back({ MissUrl, ContentSnapshot::HashUrl(MissUrl) });
+            HitUrls.push_back({ std::move(Url), UrlHash });
+        }
+        Store.Commit(std::move(Batch));
+        const ContentSnapshot& Snapshot = Store.GetSnapshot();
+
+        std::mt19937 Random(1);
+        std::shuffle(HitUrls.begin(), HitUrls.end(), Random);
+        std::shuffle(MissUrls.begin(), MissUrls.end(), Random);
+
+        auto OrderedLookup = [&OrderedMap] (const LookupUrl& Url) { return OrderedMap.find(std::string_view(Url.Url)) != OrderedMap.end(); };
+        auto UnorderedLookup = [&UnorderedMap] (const LookupUrl& Url) { return UnorderedMap.find(Url.Url) != UnorderedMap.end(); };
+        auto TableHashingLookup = [&Table] (const LookupUrl& Url) { return Table.Find(Url.Url, ContentSnapshot::HashUrl(Url.Url)) != nullptr; };
+        auto TableLookup = [&Table] (const LookupUrl& Url) { return Table.Find(Url.Url, Url.UrlHash) != nullptr; };
+        RouteParams Params;
+        auto SnapshotLookup = [&Snapshot, &Params] (const LookupUrl& Url) { return Snapshot.Find(Url.Url, Url.UrlHash, Params) != nullptr; };
+
+        printf("%zu routes, %zu table slots\n", NumRoutes, Table.GetNumSlots());
+        printf("%-36s %14s %14s\n", "lookup", "hit ns", "miss ns");
+
+        bool bRight = true;
+        auto Run = [&] (const char* LookupName, const auto& LookupFunction) {
+            size_t NumHits = 0;
+            size_t NumMisses = 0;
+            const double HitNanoseconds = NanosecondsPerLookup(HitUrls, NumLookups, LookupFunction, NumHits);
+            const double MissNanoseconds = NanosecondsPerLookup(MissUrls, NumLookups, LookupFunction, NumMisses);
+            const bool bRunRight = NumHits == NumLookups && NumMisses == 0;
+            bRight = bRight && bRunRight;
+            printf("%-36s %14.1f %14.1f%s\n", LookupName, HitNanoseconds, MissNanoseconds, bRunRight ? "" : "  WRONG RESULTS");
+        };
+        Run("std::map", OrderedLookup);
+        Run("std::unordered_map", UnorderedLookup);
+        Run("open addressing (hashed at lookup)", TableHashingLookup);
+        Run("open addressing (hash precomputed)", TableLookup);
+        Run("content snapshot (hash precomputed)", SnapshotLookup);
+        printf("\n");
+        return bRight;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t NumLookups = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 4000000;
+
+    bool bRight = true;
+    for(size_t NumRoutes : { (size_t) 1000, (size_t) 100000, (size_t) 1000000 })
+    {
+        bRight = RunRoutes(NumRoutes, NumLookups) && bRight;
+    }
+    return bRight ? 0 : 1;
+}
@@ -0,0 +1,52 @@
+#include "BenchmarkCommon.h"
+
+#include "WebServer.h"
+
+// Requests/sec with 1, 2, 4 and 8 SO_REUSEPORT listen workers on one port.
+// Each worker count gets its own port so lingering TIME_WAIT sockets from the previous run don't skew the next.
+int main(int argc, char** argv)
+{
+    const int BasePort = (argc > 1) ? atoi(argv[1]) : 28020;
+    const double Seconds = (argc > 2) ? atof(argv[2]) : 2.0;
+    const int Connections = (argc > 3) ? atoi(argv[3]) : 256;
+
+    FILE* Report = Benchmark::SilenceServerLogging();
+    int FileLimit = Benchmark::RaiseFileLimit();
+    int ClampedConnections = Benchmark::ClampConnections(Connections, FileLimit);
+
+    if(WebServer::SocketGlobalInit() != 0)
+    {
+        fprintf(Report, "Socket init failed\n");
+        return 1;
+    }
+
+    fprintf(Report, "cores: %u, connections: %d\n", std::thread::hardware_concurrency(), ClampedConnections);
+    fprintf(Report, "%-10s %-14s %-10s\n", "workers", "requests/sec", "failed");
+
+    for(int NumWorkers : { 1, 2, 4, 8 })
+    {
+        const std::string Port = std::to_string(BasePort + NumWorkers);
+
+        WebServer::ListenServer Server;
+        WebServer::ListenServerConfig Config;
+        Config.NumWorkers = NumWorkers;
+
+        if(Server.Initialise(Port.c_str(), Config) != 0)
+        {
+            fprintf(Report, "%-10d server start failed\n", NumWorkers);
+            continue;
+        }
+        Server.UploadData("/", WebServer::GenerateHtmlPage("benchmark"), "text/html", {});
+        Server.AsyncStart();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        Benchmark::LoadResult Load = Benchmark::RunHttpLoad((uint16_t) std::stoi(Port), Benchmark::BuildGetRequest("/", false), ClampedConnections, Seconds, false);
+        fprintf(Report, "%-10d %-14.0f %-10llu\n", NumWorkers, Load.RequestsPerSecond(), (unsigned long long) Load.Failed);
+
+        Server.CloseServer();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+
+    fflush(Report);
+    _exit(0);
+}
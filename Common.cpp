@@ -2,114 +2,203 @@
 
 namespace WebServer
 {
-    SocketDataStream::SocketDataStream()
+    // Trivially destructible, so still readable while (and after) the thread's pool is torn down
+    thread_local bool bThreadChunkPoolDestroyed = false;
+
+    SocketChunkPool::~SocketChunkPool()
     {
-        IncreaseBufferAllocated(mStreamChunkSize);
+        for(char* Chunk : mFreeChunks)
+        {
+            free(Chunk);
+        }
+        bThreadChunkPoolDestroyed = true;
     }
 
-    SocketDataStream::~SocketDataStream()
+    SocketChunkPool* SocketChunkPool::GetThreadPool()
     {
-        if(mData)
+        thread_local SocketChunkPool ThreadPool;
+        return bThreadChunkPoolDestroyed ? nullptr : &ThreadPool;
+    }
+
+    char* SocketChunkPool::AcquireChunk()
+    {
+        SocketChunkPool* Pool = GetThreadPool();
+        if(Pool == nullptr || Pool->mFreeChunks.empty())
         {
-            free(mData);
+            return (char*) malloc(ChunkSize);
         }
+
+        char* Chunk = Pool->mFreeChunks.back();
+        Pool->mFreeChunks.pop_back();
+        return Chunk;
+    }
+
+    void SocketChunkPool::ReleaseChunk(char* Chunk)
+    {
+        SocketChunkPool* Pool = GetThreadPool();
+        if(Pool == nullptr || Pool->mFreeChunks.size() >= MaxFreeChunks)
+        {
+            free(Chunk);
+            return;
+        }
+        Pool->mFreeChunks.push_back(Chunk);
+    }
+
+    SocketDataStream::~SocketDataStream()
+    {
+        Reset();
     }
 
     SocketDataStream::SocketDataStream(const SocketDataStream& Other)
-        : mDataBufferSize(Other.mDataBufferSize), mCurrentDataIndex(Other.mCurrentDataIndex)
     {
-        if(mCurrentDataIndex > 0)
+        if(Other.mDataLen > 0)
         {
-            mData = (char*) calloc(mDataBufferSize, sizeof(char));
-            memcpy(mData, Other.mData, mCurrentDataIndex);
+            StreamRequestData(Other.GetLinearData(), Other.mDataLen);
         }
     }
 
     SocketDataStream::SocketDataStream(SocketDataStream&& Other) noexcept
-        : mData(Other.mData), mDataBufferSize(Other.mDataBufferSize), mCurrentDataIndex(Other.mCurrentDataIndex)
+        : mChunks(std::move(Other.mChunks)), mDataLen(Other.mDataLen)
     {
-        Other.mData = nullptr;
-        Other.mDataBufferSize = 0;
-        Other.mCurrentDataIndex = 0;
+        Other.mChunks.clear();
+        Other.mDataLen = 0;
     }
 
     SocketDataStream& SocketDataStream::operator=(SocketDataStream&& Other) noexcept
     {
-        mDataBufferSize = std::move(Other.mDataBufferSize);
-        mCurrentDataIndex = std::move(Other.mCurrentDataIndex);
-        mData = Other.mData;
+        Reset();
 
-        Other.mData = nullptr;
-        Other.mDataBufferSize = 0;
-        Other.mCurrentDataIndex = 0;
+        mChunks = std::move(Other.mChunks);
+        mDataLen = Other.mDataLen;
+
+        Other.mChunks.clear();
+        Other.mDataLen = 0;
         return *this;
     }
 
-    void SocketDataStream::Reset()
+    void SocketDataStream::ReleaseChunk(Chunk& ReleasedChunk)
     {
-        if(mData)
+        if(ReleasedChunk.bPooled)
         {
-            memset(mData, '\0', mDataBufferSize);
+            SocketChunkPool::ReleaseChunk(ReleasedChunk.Data);
+        }
+        else
+        {
+            free(ReleasedChunk.Data);
         }
-        mCurrentDataIndex = 0;
     }
 
-    void SocketDataStream::StreamRequestData(const char* InData, int InDataLen)
+    void SocketDataStream::Reset()
     {
-        std::cout << OutputServerTime_GetTime() << "Streaming request data" << "\n";
+        for(Chunk& StreamChunk : mChunks)
+        {
+            ReleaseChunk(StreamChunk);
+        }
+        mChunks.clear();
+        mDataLen = 0;
+    }
 
-        int InDataIndex = 0;
-        int ClampedStreamingChunkSize = std::min(InDataLen, mStreamChunkSize);
-        int NumStreamChunks = std::ceil((float) InDataLen / mStreamChunkSize);
+    void SocketDataStream::Consume(int NumBytes)
+    {
+        if(NumBytes >= mDataLen)
+        {
+            Reset();
+            return;
+        }
 
-        for(int i = 0; i < NumStreamChunks; i++)
+        size_t NumEmptied = 0;
+        while(NumBytes > 0)
         {
-            if(mCurrentDataIndex + ClampedStreamingChunkSize > mDataBufferSize)
+            Chunk& FrontChunk = mChunks[NumEmptied];
+            int ChunkBytes = std::min(NumBytes, FrontChunk.WriteOffset - FrontChunk.ReadOffset);
+            FrontChunk.ReadOffset += ChunkBytes;
+            NumBytes -= ChunkBytes;
+            mDataLen -= ChunkBytes;
+
+            if(FrontChunk.ReadOffset == FrontChunk.WriteOffset)
             {
-                IncreaseBufferAllocated(mStreamChunkSize);
+                ReleaseChunk(FrontChunk);
+                NumEmptied++;
             }
+        }
+        mChunks.erase(mChunks.begin(), mChunks.begin() + NumEmptied);
+    }
 
-            int BytesToStream = (InDataIndex + ClampedStreamingChunkSize > InDataLen) ? InDataLen - InDataIndex : ClampedStreamingChunkSize;
-            memcpy(&mData[mCurrentDataIndex], &InData[InDataIndex], BytesToStream);
+    void SocketDataStream::StreamRequestData(const char* InData, int InDataLen)
+    {
+        while(InDataLen > 0)
+        {
+            int WriteLen = InDataLen;
+            char* WriteData = PrepareWrite(WriteLen);
+            memcpy(WriteData, InData, WriteLen);
+            CommitWrite(WriteLen);
 
-            InDataIndex += BytesToStream;
-            mCurrentDataIndex += BytesToStream;
+            InData += WriteLen;
+            InDataLen -= WriteLen;
         }
     }
 
-    void SocketDataStream::IncreaseBufferAllocated(int IncreaseSize)
+    char* SocketDataStream::PrepareWrite(int& InOutNumBytes)
     {
-        mDataBufferSize = mDataBufferSize + mStreamChunkSize;
-        char* NewRequestDataBuffer = (char*) calloc(mDataBufferSize, sizeof(char));
-
-        if(mCurrentDataIndex > 0)
+        if(mChunks.empty() || mChunks.back().WriteOffset == mChunks.back().Capacity)
         {
-            memcpy(NewRequestDataBuffer, mData, mCurrentDataIndex);
-            free(mData);
+            Chunk& NewChunk = mChunks.emplace_back();
+            NewChunk.Data = SocketChunkPool::AcquireChunk();
+            NewChunk.Capacity = SocketChunkPool::ChunkSize;
         }
 
-        mData = NewRequestDataBuffer;
+        Chunk& LastChunk = mChunks.back();
+        InOutNumBytes = std::min(InOutNumBytes, LastChunk.Capacity - LastChunk.WriteOffset);
+        return &LastChunk.Data[LastChunk.WriteOffset];
     }
 
-    MilliSecStopwatch::MilliSecStopwatch(const std::chrono::system_clock::time_point& TimeNow, double InDurationThresholdMs)
+    void SocketDataStream::CommitWrite(int NumBytes)
     {
-        ResetClock(TimeNow);
-        DurationThreshold = InDurationThresholdMs;
+        mChunks.back().WriteOffset += NumBytes;
+        mDataLen += NumBytes;
     }
 
-    void MilliSecStopwatch::ResetClock(const std::chrono::system_clock::time_point& TimeNow) const
+    const char* SocketDataStream::GetLinearData() const
     {
-        PreviousCheckTime = TimeNow;
+        if(mChunks.empty())
+        {
+            return nullptr;
+        }
+
+        if(mChunks.size() > 1)
+        {
+            // Join into one block with room to spare, data still arriving carries on in place rather than rejoining
+            Chunk JoinedChunk;
+            JoinedChunk.Capacity = std::max(mDataLen * 2, SocketChunkPool::ChunkSize);
+            JoinedChunk.Data = (char*) malloc(JoinedChunk.Capacity);
+            JoinedChunk.bPooled = false;
+
+            for(Chunk& StreamChunk : mChunks)
+            {
+                int ChunkBytes = StreamChunk.WriteOffset - StreamChunk.ReadOffset;
+                memcpy(&JoinedChunk.Data[JoinedChunk.WriteOffset], &StreamChunk.Data[StreamChunk.ReadOffset], ChunkBytes);
+                JoinedChunk.WriteOffset += ChunkBytes;
+                ReleaseChunk(StreamChunk);
+            }
+
+            mChunks.clear();
+            mChunks.push_back(JoinedChunk);
+        }
+
+        return &mChunks.front().Data[mChunks.front().ReadOffset];
     }
 
-    bool MilliSecStopwatch::DurationReached(const std::chrono::system_clock::time_point& TimeNow) const
+    int SocketDataStream::GetFrontData(const char*& OutData) const
     {
-        bool DurationReached = std::chrono::duration_cast<std::chrono::milliseconds>(TimeNow - PreviousCheckTime).count() > DurationThreshold;
-        if(DurationReached)
+        if(mChunks.empty())
         {
-            ResetClock(TimeNow);
+            OutData = nullptr;
+            return 0;
         }
-        return DurationReached;
+
+        const Chunk& FrontChunk = mChunks.front();
+        OutData = &FrontChunk.Data[FrontChunk.ReadOffset];
+        return FrontChunk.WriteOffset - FrontChunk.ReadOffset;
     }
 
     std::vector<char> GenerateHtmlPage(std::string Message)
@@ -128,7 +217,12 @@ namespace WebServer
     std::tm GetLocalTime()
     {
         std::time_t CurrentTimeStamp; time(&CurrentTimeStamp);
-        std::tm LocalTime; localtime_s(&LocalTime, &CurrentTimeStamp);
+        std::tm LocalTime;
+#ifdef _WIN32
+        localtime_s(&LocalTime, &CurrentTimeStamp);
+#else
+        localtime_r(&CurrentTimeStamp, &LocalTime);
+#endif
         return LocalTime;
     }
 
@@ -139,32 +233,6 @@ namespace WebServer
         std::strftime(buffer, 64, "%a, %d %b %Y %H:%M:%S %Z", &LocalTime);
         return std::string(buffer);
     }
-
-    bool GetStrLine(const char* InData, char* OutDataBuffer, int BufferSize, const char*& OutLineEndPtr)
-    {
-        assert(InData);
-
-        OutLineEndPtr = (strchr(InData, '\n') != NULL) ? strchr(InData, '\n') : strchr(InData, '\0');
-        int LineLength = (OutLineEndPtr - InData);
-
-        if(OutLineEndPtr == NULL || *OutLineEndPtr == '\0' || LineLength > BufferSize)
-        {
-            assert(LineLength < BufferSize);
-            return false;
-        }
-
-        memcpy(OutDataBuffer, InData, LineLength);
-        OutDataBuffer[LineLength] = '\0';
-        OutLineEndPtr++;
-        return true;
-    }
-
-    int FindCharIndex(const char* InCharArray, const char c)
-    {
-        const char* CharLocation;
-        CharLocation = strchr(InCharArray, c);
-        return (CharLocation != nullptr) ? (int) (CharLocation - InCharArray) : -1;
-    }
 }
 
 namespace WSHelpers
@@ -1,33 +1,43 @@
 #pragma once
-#define NOMINMAX
+
+#include "Socket.h"
 
 #include "External-Headers/date.h"
 #include "External-Headers/TinySHA1.hpp"
 
-#include <winsock2.h>
-#include <ws2tcpip.h>
 #include <stdio.h>
+#include <cassert>
+#include <cmath>
+#include <cstring>
 
 #include <iostream>
 #include <thread>
 #include <future>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <atomic>
 #include <map>
 #include <string>
+#include <string_view>
+#include <coroutine>
 #include <array>
 #include <queue>
+#include <deque>
 #include <vector>
 #include <fstream>
 
+#ifdef _WIN32
 #ifdef MATHLIBRARY_EXPORTS
 #define WEBSERVERLIBRARY_API __declspec(dllexport)
 #else
 #define WEBSERVERLIBRARY_API __declspec(dllimport)
 #endif
-
-#pragma comment(lib, "Ws2_32.lib")
+#else
+#define WEBSERVERLIBRARY_API
+#endif
 
 #define DEFAULT_PORT "27015"
-#define DEFAULT_BUFLEN 512
 
 //#define DECLARE_NO_COPY(ClassName)\
 //        ClassName(const ClassName&) = delete;\
@@ -37,14 +47,34 @@ namespace WebServer
 {
 #define OutputServerTime(ServerTime) "| " << date::format("%H:%M:%S", ServerTime) << " | "
 #define OutputServerTime_GetTime() OutputServerTime(std::chrono::system_clock::now())
-#define OutputServerStatus() OutputServerTime(std::chrono::system_clock::now()) << "Error-code: " <<  WSAGetLastError() << " | "
+#define OutputServerStatus() OutputServerTime(std::chrono::system_clock::now()) << "Error-code: " <<  GetSocketError() << " | "
 
-    class SocketDataStream
+    // Fixed size chunks for SocketDataStream, recycled per thread so an event loop stops allocating once it's warmed up.
+    // Chunks can be released on any thread, they go to that thread's pool (or back to the heap once it has plenty).
+    class SocketChunkPool
     {
-        const int mStreamChunkSize = 1024;
+    public:
+        static constexpr int ChunkSize = 16 * 1024;
+        static constexpr size_t MaxFreeChunks = 256;
+
+        static char* AcquireChunk();
+        static void ReleaseChunk(char* Chunk);
+
+        ~SocketChunkPool();
+
+    private:
+        static SocketChunkPool* GetThreadPool();
+
+        std::vector<char*> mFreeChunks;
+    };
 
+    // Byte stream for socket data held as a chain of pooled chunks. Appending never moves what's already there and
+    // consuming from the front just hands emptied chunks back to the pool. Parsers wanting contiguous bytes ask for a
+    // linear view, which joins the chain into one block only when the data actually spans chunks.
+    class SocketDataStream
+    {
     public:
-        SocketDataStream();
+        SocketDataStream() = default;
         ~SocketDataStream();
 
         //copy and move
@@ -52,30 +82,42 @@ namespace WebServer
         SocketDataStream(SocketDataStream&& Other) noexcept;
         SocketDataStream& operator=(SocketDataStream&& Other) noexcept;
 
+        // Empties the stream, chunks go back to the pool
         void Reset();
 
-        void StreamRequestData(const char* InRequestData, int InDataLen);
-        int GetDataLen() const { return mCurrentDataIndex; }
-
-        char* mData = nullptr;
+        // Drops the first NumBytes (eg a request that's been answered), keeping whatever follows
+        void Consume(int NumBytes);
 
-    private:
-        void IncreaseBufferAllocated(int IncreaseSize);
+        void StreamRequestData(const char* InRequestData, int InDataLen);
+        int GetDataLen() const { return mDataLen; }
 
-        int mDataBufferSize = 0;
-        int mCurrentDataIndex = 0;
-    };
+        // Free space at the end of the stream for recv to write straight into, at most InOutNumBytes (less when the
+        // last chunk is nearly full). Commit what was actually written
+        char* PrepareWrite(int& InOutNumBytes);
+        void CommitWrite(int NumBytes);
 
-    struct MilliSecStopwatch
-    {
-        MilliSecStopwatch() = default;
+        // All of the stream's bytes in one contiguous block, valid until the stream is next changed
+        const char* GetLinearData() const;
 
-        MilliSecStopwatch(const std::chrono::system_clock::time_point& TimeNow, double InDurationThresholdMs);
-        void ResetClock(const std::chrono::system_clock::time_point& TimeNow) const;
-        bool DurationReached(const std::chrono::system_clock::time_point& TimeNow) const;
+        // Just the first contiguous run of the stream's bytes, for working through it a piece at a time without joining.
+        // Returns its length, 0 when the stream's empty
+        int GetFrontData(const char*& OutData) const;
 
-        mutable std::chrono::system_clock::time_point PreviousCheckTime;
-        double DurationThreshold;
+    private:
+        struct Chunk
+        {
+            char* Data = nullptr;
+            int Capacity = 0;
+            int ReadOffset = 0;
+            int WriteOffset = 0;
+            bool bPooled = true;      // from SocketChunkPool, otherwise a joined block off the heap
+        };
+
+        static void ReleaseChunk(Chunk& ReleasedChunk);
+
+        // Joining for a linear view doesn't change the bytes, only how they're laid out
+        mutable std::vector<Chunk> mChunks;
+        int mDataLen = 0;
     };
 
     template<typename T>
@@ -101,10 +143,6 @@ namespace WebServer
     std::tm GetLocalTime();
     std::string ConvertToWebServerTimeFormat(std::tm LocalTime);
 
-    // string helpers
-    bool GetStrLine(const char* InData, char* OutDataBuffer, int BufferSize, const char*& OutLineEndPtr);
-    int FindCharIndex(const char* InCharArray, const char c);
-
 }
 
 namespace WSHelpers
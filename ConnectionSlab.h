@@ -0,0 +1,161 @@
+#pragma once
+
+#include "Socket.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace WebServer
+{
+    // A socket plus the generation of its slot when it was handed out, goes stale once the socket is removed
+    // (and the descriptor possibly reused for a new connection)
+    struct ConnectionId
+    {
+        SOCKET Socket = INVALID_SOCKET;
+        uint32_t Generation = 0;
+    };
+
+    // Per connection records indexed directly by socket descriptor. Records live in fixed size pages that are never
+    // freed or moved, so references stay valid while a connection is active and reused slots don't allocate.
+    // A dense list of the active sockets keeps iteration to the live set only.
+    template<typename RecordType>
+    class ConnectionSlab
+    {
+    public:
+        // Record for the socket, activating (and resetting) the slot if it isn't already active
+        RecordType& Acquire(SOCKET Socket);
+
+        RecordType* Find(SOCKET Socket);
+        RecordType* Find(ConnectionId Id);
+        ConnectionId GetId(SOCKET Socket) const;
+
+        // False when the id is stale or the socket isn't active
+        bool Remove(ConnectionId Id);
+
+        // Function(SOCKET, RecordType&), the set mustn't change while iterating
+        template<typename FunctionType>
+        void ForEach(const FunctionType& Function);
+
+        size_t Size() const { return mActiveSockets.size(); }
+
+    private:
+        static constexpr size_t PageSize = 256;
+
+        struct Slot
+        {
+            RecordType Record;
+            uint32_t Generation = 0;
+            int32_t ActiveIndex = -1;
+        };
+
+        typedef std::array<Slot, PageSize> Page;
+
+        static size_t SocketToIndex(SOCKET Socket);
+        Slot* FindSlot(SOCKET Socket) const;
+
+        std::vector<std::unique_ptr<Page>> mPages;
+        std::vector<SOCKET> mActiveSockets;
+    };
+
+    template<typename RecordType>
+    inline size_t ConnectionSlab<RecordType>::SocketToIndex(SOCKET Socket)
+    {
+#ifdef _WIN32
+        return (size_t) Socket >> 2;    // winsock handles are multiples of four
+#else
+        return (size_t) Socket;
+#endif
+    }
+
+    template<typename RecordType>
+    typename ConnectionSlab<RecordType>::Slot* ConnectionSlab<RecordType>::FindSlot(SOCKET Socket) const
+    {
+        size_t Index = SocketToIndex(Socket);
+        size_t PageIndex = Index / PageSize;
+        if(Socket == INVALID_SOCKET || PageIndex >= mPages.size() || mPages[PageIndex] == nullptr)
+        {
+            return nullptr;
+        }
+        return &(*mPages[PageIndex])[Index % PageSize];
+    }
+
+    template<typename RecordType>
+    RecordType& ConnectionSlab<RecordType>::Acquire(SOCKET Socket)
+    {
+        size_t Index = SocketToIndex(Socket);
+        size_t PageIndex = Index / PageSize;
+        if(PageIndex >= mPages.size())
+        {
+            mPages.resize(PageIndex + 1);
+        }
+        if(mPages[PageIndex] == nullptr)
+        {
+            mPages[PageIndex] = std::make_unique<Page>();
+        }
+
+        Slot& ConnectionSlot = (*mPages[PageIndex])[Index % PageSize];
+        if(ConnectionSlot.ActiveIndex == -1)
+        {
+            ConnectionSlot.Record = RecordType{};
+            ConnectionSlot.ActiveIndex = (int32_t) mActiveSockets.size();
+            mActiveSockets.push_back(Socket);
+        }
+        return ConnectionSlot.Record;
+    }
+
+    template<typename RecordType>
+    RecordType* ConnectionSlab<RecordType>::Find(SOCKET Socket)
+    {
+        Slot* ConnectionSlot = FindSlot(Socket);
+        return (ConnectionSlot != nullptr && ConnectionSlot->ActiveIndex != -1) ? &ConnectionSlot->Record : nullptr;
+    }
+
+    template<typename RecordType>
+    RecordType* ConnectionSlab<RecordType>::Find(ConnectionId Id)
+    {
+        Slot* ConnectionSlot = FindSlot(Id.Socket);
+        bool bValid = ConnectionSlot != nullptr && ConnectionSlot->ActiveIndex != -1 && ConnectionSlot->Generation == Id.Generation;
+        return bValid ? &ConnectionSlot->Record : nullptr;
+    }
+
+    template<typename RecordType>
+    ConnectionId ConnectionSlab<RecordType>::GetId(SOCKET Socket) const
+    {
+        Slot* ConnectionSlot = FindSlot(Socket);
+        return ConnectionId{ Socket, ConnectionSlot != nullptr ? ConnectionSlot->Generation : 0 };
+    }
+
+    template<typename RecordType>
+    bool ConnectionSlab<RecordType>::Remove(ConnectionId Id)
+    {
+        Slot* ConnectionSlot = FindSlot(Id.Socket);
+        if(ConnectionSlot == nullptr || ConnectionSlot->ActiveIndex == -1 || ConnectionSlot->Generation != Id.Generation)
+        {
+            return false;
+        }
+
+        // Swap the last active socket into the hole to keep the list dense
+        SOCKET LastSocket = mActiveSockets.back();
+        mActiveSockets[ConnectionSlot->ActiveIndex] = LastSocket;
+        FindSlot(LastSocket)->ActiveIndex = ConnectionSlot->ActiveIndex;
+        mActiveSockets.pop_back();
+
+        // Release whatever the record holds (callbacks, buffers) now rather than when the descriptor is reused
+        ConnectionSlot->Record = RecordType{};
+        ConnectionSlot->ActiveIndex = -1;
+        ConnectionSlot->Generation++;
+        return true;
+    }
+
+    template<typename RecordType>
+    template<typename FunctionType>
+    void ConnectionSlab<RecordType>::ForEach(const FunctionType& Function)
+    {
+        for(SOCKET Socket : mActiveSockets)
+        {
+            Function(Socket, FindSlot(Socket)->Record);
+        }
+    }
+}
@@ -0,0 +1,180 @@
+#include "ContentStore.h"
+
+#include "WebServer.h"
+
+#include <algorithm>
+
+namespace
+{
+    // A segment starting ':' or '*' makes it a pattern for the router
+    bool IsPatternUrl(std::string_view Url)
+    {
+        return Url.find("/:") != std::string_view::npos || Url.find("/*") != std::string_view::npos;
+    }
+}
+
+namespace WebServer
+{
+#pragma region ContentSnapshot
+
+    uint64_t ContentSnapshot::HashUrl(std::string_view Url)
+    {
+        return StaticRouteHash::HashUrl(ServerRequestType::ServerRequestType_GET, Url);
+    }
+
+    const ContentEntry* ContentSnapshot::Find(std::string_view Url, uint64_t UrlHash, RouteParams& OutParams) const
+    {
+        const ContentEntry* Entry = FindExact(Url, UrlHash);
+        if(Entry != nullptr || mPatterns == nullptr)
+        {
+            OutParams.NumParams = 0;
+            return Entry;
+        }
+
+        const uint32_t PatternIndex = mPatterns->Router.Match(ServerRequestType::ServerRequestType_GET, Url, OutParams);
+        return (PatternIndex != RequestRouter::NoRoute) ? FindExact(mPatterns->Urls[PatternIndex], mPatterns->UrlHashes[PatternIndex]) : nullptr;
+    }
+
+    void ContentSnapshot::RebuildPatterns()
+    {
+        std::shared_ptr<ContentPatterns> Patterns = std::make_shared<ContentPatterns>();
+        for(const std::shared_ptr<const ContentShard>& Shard : mShards)
+        {
+            Shard->ForEach([&Patterns] (const ContentEntry& Entry) {
+                // A bad pattern (or one clashing with another's parameter names) is only served on its exact url
+                if(IsPatternUrl(Entry.Url) && Patterns->Router.AddRoute(ServerRequestType::ServerRequestType_GET, Entry.Url, (uint32_t) Patterns->Urls.size()))
+                {
+                    Patterns->Urls.push_back(Entry.Url);
+                    Patterns->UrlHashes.push_back(HashUrl(Entry.Url));
+                }
+                });
+        }
+        mPatterns = Patterns->Urls.empty() ? nullptr : std::move(Patterns);
+    }
+
+#pragma endregion   //ContentSnapshot
+
+#pragma region ContentBatch
+
+    void ContentBatch::Upload(const std::string& Url, std::shared_ptr<const ServerResponseMessage> Page)
+    {
+        mUpdates.push_back({ ContentEntry{ Url, std::move(Page), false }, false });
+    }
+
+    void ContentBatch::AddWebSocket(const std::string& Url)
+    {
+        mUpdates.push_back({ ContentEntry{ Url, nullptr, true }, false });
+    }
+
+    void ContentBatch::Remove(const std::string& Url)
+    {
+        mUpdates.push_back({ ContentEntry{ Url, nullptr, false }, true });
+    }
+
+#pragma endregion   //ContentBatch
+
+#pragma region ContentStore
+
+    ContentStore::ContentStore()
+    {
+        ContentSnapshot* First = new ContentSnapshot();
+        First->mGeneration = 1;
+        std::shared_ptr<const ContentSnapshot::ContentShard> EmptyShard = std::make_shared<ContentSnapshot::ContentShard>();
+        First->mShards.fill(EmptyShard);
+
+        mCurrent.store(First);
+        mGeneration.store(First->mGeneration);
+    }
+
+    ContentStore::~ContentStore()
+    {
+        delete mCurrent.load();
+    }
+
+    void ContentStore::Commit(ContentBatch Batch)
+    {
+        if(Batch.IsEmpty())
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> WriterLock(mWriterMutex);
+        const ContentSnapshot* Current = mCurrent.load(std::memory_order_relaxed);
+
+        std::unique_ptr<ContentSnapshot> Next = std::make_unique<ContentSnapshot>(*Current);
+        Next->mGeneration = Current->mGeneration + 1;
+
+        // Shards are copied the first time the batch touches them, the rest stay shared
+        std::array<ContentSnapshot::ContentShard*, ContentSnapshot::NumShards> CopiedShards = {};
+        bool bPatternsChanged = false;
+        for(ContentBatch::ContentUpdate& Update : Batch.mUpdates)
+        {
+            const uint64_t UrlHash = ContentSnapshot::HashUrl(Update.Entry.Url);
+            const size_t ShardIndex = ContentSnapshot::GetShardIndex(UrlHash);
+            const bool bPatternUrl = IsPatternUrl(Update.Entry.Url);
+            if(CopiedShards[ShardIndex] == nullptr)
+            {
+                std::shared_ptr<ContentSnapshot::ContentShard> Copy = std::make_shared<ContentSnapshot::ContentShard>(*Next->mShards[ShardIndex]);
+                CopiedShards[ShardIndex] = Copy.get();
+                Next->mShards[ShardIndex] = std::move(Copy);
+            }
+            ContentSnapshot::ContentShard& Shard = *CopiedShards[ShardIndex];
+
+            bool bAddedOrRemoved;
+            if(Update.bRemove)
+            {
+                bAddedOrRemoved = Shard.Erase(Update.Entry.Url, UrlHash);
+                Next->mNumEntries -= bAddedOrRemoved ? 1 : 0;
+            }
+            else
+            {
+                bAddedOrRemoved = Shard.Insert(std::make_shared<const ContentEntry>(std::move(Update.Entry)), UrlHash);
+                Next->mNumEntries += bAddedOrRemoved ? 1 : 0;
+            }
+            bPatternsChanged |= bAddedOrRemoved && bPatternUrl;
+        }
+
+        if(bPatternsChanged)
+        {
+            Next->RebuildPatterns();
+        }
+
+        // Pointer first, a reader that sees the new generation can't then load the old snapshot
+        const uint64_t Generation = Next->mGeneration;
+        mCurrent.store(Next.release(), std::memory_order_seq_cst);
+        mGeneration.store(Generation, std::memory_order_seq_cst);
+
+        mRetired.emplace_back(Current);
+        mNumRetired.store(mRetired.size(), std::memory_order_relaxed);
+        Reclaim();
+    }
+
+    std::atomic<uint64_t>* ContentStore::RegisterReader()
+    {
+        std::lock_guard<std::mutex> WriterLock(mWriterMutex);
+        return &mReaders.emplace_back(ReaderIdle);
+    }
+
+    void ContentStore::TryReclaim()
+    {
+        std::unique_lock<std::mutex> WriterLock(mWriterMutex, std::try_to_lock);
+        if(WriterLock.owns_lock())
+        {
+            Reclaim();
+        }
+    }
+
+    void ContentStore::Reclaim()
+    {
+        uint64_t OldestInUse = mGeneration.load(std::memory_order_seq_cst);
+        for(const std::atomic<uint64_t>& Reader : mReaders)
+        {
+            OldestInUse = std::min(OldestInUse, Reader.load(std::memory_order_seq_cst));
+        }
+
+        std::erase_if(mRetired, [OldestInUse] (const std::unique_ptr<const ContentSnapshot>& Snapshot) { return Snapshot->GetGeneration() < OldestInUse; });
+        mNumRetired.store(mRetired.size(), std::memory_order_relaxed);
+    }
+
+#pragma endregion   //ContentStore
+}
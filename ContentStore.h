@@ -0,0 +1,134 @@
+#pragma once
+
+#include "RequestRouter.h"
+#include "UrlHashTable.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace WebServer
+{
+    class ServerResponseMessage;
+
+    // What a GET on an uploaded url gets, its page or a web socket
+    struct ContentEntry
+    {
+        std::string Url;                                        // as uploaded, parameters and all
+        std::shared_ptr<const ServerResponseMessage> Page;      // shared with the snapshots after this one, null for a web socket
+        bool bWebSocket = false;
+    };
+
+    // The pages being served at one point in time, never changed once it's been published. Urls are spread over shards
+    // by the top of their hash, a commit copies the shards it touches and shares the rest with the snapshot before
+    class ContentSnapshot
+    {
+    public:
+        static constexpr int ShardBits = 6;
+        static constexpr size_t NumShards = (size_t) 1 << ShardBits;
+
+        // The hash urls are stored under, what a GET's mUrlHash already is
+        static uint64_t HashUrl(std::string_view Url);
+
+        // Exact urls first, then the ones with path parameters. Null if there's nothing on Url
+        const ContentEntry* Find(std::string_view Url, uint64_t UrlHash, RouteParams& OutParams) const;
+
+        uint64_t GetGeneration() const { return mGeneration; }
+        size_t Size() const { return mNumEntries; }
+
+    private:
+        friend class ContentStore;
+
+        typedef UrlHashTable<ContentEntry> ContentShard;
+
+        // Only rebuilt when a pattern's added or removed
+        struct ContentPatterns
+        {
+            RequestRouter Router;               // GET patterns to an index into Urls
+            std::vector<std::string> Urls;
+            std::vector<uint64_t> UrlHashes;
+        };
+
+        static size_t GetShardIndex(uint64_t UrlHash) { return (size_t) (UrlHash >> (64 - ShardBits)); }
+        const ContentEntry* FindExact(std::string_view Url, uint64_t UrlHash) const { return mShards[GetShardIndex(UrlHash)]->Find(Url, UrlHash); }
+        void RebuildPatterns();
+
+        uint64_t mGeneration = 0;
+        size_t mNumEntries = 0;
+        std::array<std::shared_ptr<const ContentShard>, NumShards> mShards;    // everything, patterns included
+        std::shared_ptr<const ContentPatterns> mPatterns;                      // null without any
+    };
+
+    // Page changes published together, built up on whatever thread's making them
+    class ContentBatch
+    {
+    public:
+        void Upload(const std::string& Url, std::shared_ptr<const ServerResponseMessage> Page);
+        void AddWebSocket(const std::string& Url);
+        void Remove(const std::string& Url);
+
+        bool IsEmpty() const { return mUpdates.empty(); }
+
+    private:
+        friend class ContentStore;
+
+        struct ContentUpdate
+        {
+            ContentEntry Entry;
+            bool bRemove = false;
+        };
+
+        std::vector<ContentUpdate> mUpdates;    // applied in order, the last change to a url wins
+    };
+
+    // Url to page for GETs, read by the workers without locks while other threads change it (read-copy-update).
+    // A commit builds the next snapshot from the current one with its batch applied and publishes it with one atomic store, so a
+    // request sees all of a batch or none of it. The old snapshot is retired rather than freed, readers each have a slot
+    // where they say the oldest generation they could still be using (a send referencing its page, say) and it goes
+    // once they've all moved past it. A commit costs a copy of each shard it touches
+    class ContentStore
+    {
+    public:
+        // A reader that isn't running, it holds nothing
+        static constexpr uint64_t ReaderIdle = UINT64_MAX;
+
+        ContentStore();
+        ContentStore(const ContentStore& Other) = delete;
+        ContentStore& operator=(const ContentStore& Other) = delete;
+        ~ContentStore();
+
+        // Lock-free. The snapshot lasts until the reader's slot says it's past its generation
+        const ContentSnapshot& GetSnapshot() const { return *mCurrent.load(std::memory_order_seq_cst); }
+
+        // Never ahead of GetSnapshot's, a reader stores this in its slot before it looks at anything newer
+        uint64_t GetGeneration() const { return mGeneration.load(std::memory_order_seq_cst); }
+
+        // Any thread, commits take turns with each other but never wait on a reader
+        void Commit(ContentBatch Batch);
+
+        // A slot for a reader's oldest generation in use, starting idle. Slots last as long as the store
+        std::atomic<uint64_t>* RegisterReader();
+
+        // Frees what no reader can be using any more, unless a commit's busy (it'll do it)
+        void TryReclaim();
+        bool HasRetired() const { return mNumRetired.load(std::memory_order_relaxed) > 0; }
+        size_t GetNumRetired() const { return mNumRetired.load(std::memory_order_relaxed); }
+
+    private:
+        void Reclaim();     // mWriterMutex held
+
+        std::atomic<const ContentSnapshot*> mCurrent;
+        std::atomic<uint64_t> mGeneration;
+
+        std::mutex mWriterMutex;
+        std::vector<std::unique_ptr<const ContentSnapshot>> mRetired;
+        std::atomic<size_t> mNumRetired = 0;
+        std::deque<std::atomic<uint64_t>> mReaders;     // a deque so slots stay put as more are added
+    };
+}
@@ -0,0 +1,34 @@
+#include "WebServerAPI.h"
+
+#include <chrono>
+#include <thread>
+
+// Serves a single html page on the given port (default 27015) until killed
+int main(int argc, char** argv)
+{
+    std::string Port = (argc > 1) ? argv[1] : DEFAULT_PORT;
+
+    if(WebServerAPI::WebServerGlobalInit() == false)
+    {
+        return 1;
+    }
+
+    int ServerID = WebServerAPI::StartSever(Port);
+    if(ServerID == -1)
+    {
+        return 1;
+    }
+
+    WebServerAPI::DataUploadParams IndexPage;
+    IndexPage.Url = "/";
+    IndexPage.Data = WebServer::GenerateHtmlPage("Hello from the demo server");
+    IndexPage.ContentType = "text/html";
+    WebServerAPI::UploadData(ServerID, IndexPage);
+
+    while(true)
+    {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+
+    return 0;
+}
@@ -0,0 +1,170 @@
+#include "HttpHeaders.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    // Lower cases the ASCII letters in 8 bytes at once, anything 0x80 and up is left as it is
+    inline uint64_t ToLowerAsciiWord(uint64_t Word)
+    {
+        constexpr uint64_t HighBits = 0x8080808080808080ull;
+        const uint64_t Heptets = Word & ~HighBits;
+        const uint64_t AboveZ = Heptets + 0x2525252525252525ull;       // 0x7F - 'Z', the top bit set past 'Z'
+        const uint64_t FromA = Heptets + 0x3F3F3F3F3F3F3F3Full;        // 0x80 - 'A', the top bit set from 'A'
+        const uint64_t IsUpper = FromA & ~AboveZ & ~Word & HighBits;
+        return Word | (IsUpper >> 2);
+    }
+}
+
+namespace WebServer
+{
+    HttpHeader FindHttpHeader(std::string_view Name)
+    {
+        const uint32_t Slot = HttpHeaderHash::HashName(Name, HttpHeaderHash::Seed);
+        const HttpHeader Candidate = HttpHeaderHash::Table.Slots[Slot];
+        if(Candidate == HttpHeader::HttpHeader_Unknown || GetHttpHeaderName(Candidate).size() != Name.size())
+        {
+            return HttpHeader::HttpHeader_Unknown;
+        }
+
+        // A word at a time against the slot's lower cased name, which is zero padded past its end
+        const char* LowerName = HttpHeaderHash::Table.LowerNames[Slot];
+        for(size_t i = 0; i < Name.size(); i += 8)
+        {
+            uint64_t NameWord = 0;
+            uint64_t LowerWord;
+            memcpy(&NameWord, Name.data() + i, std::min<size_t>(8, Name.size() - i));
+            memcpy(&LowerWord, LowerName + i, 8);
+            if(ToLowerAsciiWord(NameWord) != LowerWord)
+            {
+                return HttpHeader::HttpHeader_Unknown;
+            }
+        }
+        return Candidate;
+    }
+
+#pragma region RequestHeaderList
+
+    void RequestHeaderList::Add(HttpHeader Header, int KeyOffset, int KeyLength, int ValueOffset, int ValueLength)
+    {
+        HeaderSpan Span = { KeyOffset, KeyLength, ValueOffset, ValueLength };
+        if(Header != HttpHeader::HttpHeader_Unknown && mKnownHeaders[(size_t) Header].KeyLength == 0)
+        {
+            mKnownHeaders[(size_t) Header] = Span;
+            mNumKnownHeaders++;
+            return;
+        }
+
+        if(mNumOtherHeaders < InlineCapacity)
+        {
+            mInlineHeaders[mNumOtherHeaders] = Span;
+        }
+        else
+        {
+            mOverflowHeaders.push_back(Span);
+        }
+        mNumOtherHeaders++;
+    }
+
+    bool RequestHeaderList::Find(HttpHeader Header, std::string_view& OutValue) const
+    {
+        if(Header == HttpHeader::HttpHeader_Unknown || mKnownHeaders[(size_t) Header].KeyLength == 0)
+        {
+            return false;
+        }
+
+        OutValue = GetValue(mKnownHeaders[(size_t) Header]);
+        return true;
+    }
+
+    bool RequestHeaderList::Find(std::string_view Key, std::string_view& OutValue) const
+    {
+        HttpHeader Header = FindHttpHeader(Key);
+        if(Header != HttpHeader::HttpHeader_Unknown)
+        {
+            return Find(Header, OutValue);
+        }
+
+        for(int i = 0; i < mNumOtherHeaders; i++)
+        {
+            const HeaderSpan& Span = GetOtherSpan(i);
+            if(EqualsIgnoreCase(GetKey(Span), Key))
+            {
+                OutValue = GetValue(Span);
+                return true;
+            }
+        }
+        return false;
+    }
+
+#pragma endregion //RequestHeaderList
+
+#pragma region ResponseHeaderList
+
+    void ResponseHeaderList::Add(std::string_view Key, std::string_view Value)
+    {
+        Store(Key, Value, false);
+    }
+
+    void ResponseHeaderList::Set(std::string_view Key, std::string_view Value)
+    {
+        Store(Key, Value, true);
+    }
+
+    const std::string* ResponseHeaderList::Find(HttpHeader Header) const
+    {
+        if(Header == HttpHeader::HttpHeader_Unknown || mKnownPresent[(size_t) Header] == false)
+        {
+            return nullptr;
+        }
+        return &mKnownValues[(size_t) Header];
+    }
+
+    const std::string* ResponseHeaderList::Find(std::string_view Key) const
+    {
+        HttpHeader Header = FindHttpHeader(Key);
+        if(Header != HttpHeader::HttpHeader_Unknown)
+        {
+            return Find(Header);
+        }
+
+        for(const auto& OtherHeader : mOtherHeaders)
+        {
+            if(EqualsIgnoreCase(OtherHeader.first, Key))
+            {
+                return &OtherHeader.second;
+            }
+        }
+        return nullptr;
+    }
+
+    void ResponseHeaderList::Store(std::string_view Key, std::string_view Value, bool bReplace)
+    {
+        HttpHeader Header = FindHttpHeader(Key);
+        if(Header != HttpHeader::HttpHeader_Unknown)
+        {
+            if(bReplace || mKnownPresent[(size_t) Header] == false)
+            {
+                mKnownValues[(size_t) Header].assign(Value.data(), Value.size());
+                mKnownPresent[(size_t) Header] = true;
+            }
+            return;
+        }
+
+        for(auto& OtherHeader : mOtherHeaders)
+        {
+            if(EqualsIgnoreCase(OtherHeader.first, Key))
+            {
+                if(bReplace)
+                {
+                    OtherHeader.second.assign(Value.data(), Value.size());
+                }
+                return;
+            }
+        }
+        mOtherHeaders.emplace_back(std::string(Key), std::string(Value));
+    }
+
+#pragma endregion //ResponseHeaderList
+}
@@ -0,0 +1,266 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace WebServer
+{
+    // Header names common enough to get a fixed slot, anything else is kept by name
+    enum class HttpHeader : uint8_t
+    {
+        HttpHeader_Accept,
+        HttpHeader_AcceptEncoding,
+        HttpHeader_AcceptLanguage,
+        HttpHeader_Authorization,
+        HttpHeader_CacheControl,
+        HttpHeader_Connection,
+        HttpHeader_ContentEncoding,
+        HttpHeader_ContentLength,
+        HttpHeader_ContentType,
+        HttpHeader_Cookie,
+        HttpHeader_Date,
+        HttpHeader_ETag,
+        HttpHeader_Expect,
+        HttpHeader_Host,
+        HttpHeader_IfModifiedSince,
+        HttpHeader_IfNoneMatch,
+        HttpHeader_LastModified,
+        HttpHeader_Origin,
+        HttpHeader_Range,
+        HttpHeader_Referer,
+        HttpHeader_SecWebSocketAccept,
+        HttpHeader_SecWebSocketKey,
+        HttpHeader_SecWebSocketProtocol,
+        HttpHeader_SecWebSocketVersion,
+        HttpHeader_Server,
+        HttpHeader_SetCookie,
+        HttpHeader_TransferEncoding,
+        HttpHeader_Upgrade,
+        HttpHeader_UserAgent,
+
+        HttpHeader_Count,
+        HttpHeader_Unknown = HttpHeader_Count,
+    };
+
+    constexpr int NumKnownHttpHeaders = (int) HttpHeader::HttpHeader_Count;
+
+    // Canonical spelling, in HttpHeader order
+    constexpr std::array<std::string_view, NumKnownHttpHeaders> HttpHeaderNames =
+    {
+        "Accept", "Accept-Encoding", "Accept-Language", "Authorization", "Cache-Control", "Connection", "Content-Encoding",
+        "Content-Length", "Content-Type", "Cookie", "Date", "ETag", "Expect", "Host", "If-Modified-Since", "If-None-Match",
+        "Last-Modified", "Origin", "Range", "Referer", "Sec-WebSocket-Accept", "Sec-WebSocket-Key", "Sec-WebSocket-Protocol",
+        "Sec-WebSocket-Version", "Server", "Set-Cookie", "Transfer-Encoding", "Upgrade", "User-Agent",
+    };
+
+    constexpr std::string_view GetHttpHeaderName(HttpHeader Header) { return HttpHeaderNames[(size_t) Header]; }
+
+    constexpr char ToLowerAscii(char c) { return (char) (c | ((unsigned) (c - 'A') < 26u ? 0x20 : 0)); }
+
+    // ASCII only, which header names and tokens are
+    constexpr bool EqualsIgnoreCase(std::string_view A, std::string_view B)
+    {
+        if(A.size() != B.size())
+        {
+            return false;
+        }
+        for(size_t i = 0; i < A.size(); i++)
+        {
+            if(ToLowerAscii(A[i]) != ToLowerAscii(B[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    namespace HttpHeaderHash
+    {
+        constexpr int TableBits = 7;
+        constexpr uint32_t TableSize = 1u << TableBits;
+
+        // Length plus the first, middle and last characters (lower cased) is enough to tell the known names apart,
+        // and cheap enough that hashing a name costs about as much as reading it from the table
+        constexpr uint32_t HashName(std::string_view Name, uint32_t Seed)
+        {
+            if(Name.empty())
+            {
+                return 0;
+            }
+
+            uint32_t Key = (uint32_t) Name.size() & 0xFF;
+            Key |= (uint32_t) (uint8_t) ToLowerAscii(Name[0]) << 8;
+            Key |= (uint32_t) (uint8_t) ToLowerAscii(Name[Name.size() / 2]) << 16;
+            Key |= (uint32_t) (uint8_t) ToLowerAscii(Name[Name.size() - 1]) << 24;
+            return (Key * Seed) >> (32 - TableBits);
+        }
+
+        constexpr bool IsCollisionFree(uint32_t Seed)
+        {
+            bool SlotsTaken[TableSize] = {};
+            for(std::string_view Name : HttpHeaderNames)
+            {
+                uint32_t Slot = HashName(Name, Seed);
+                if(SlotsTaken[Slot])
+                {
+                    return false;
+                }
+                SlotsTaken[Slot] = true;
+            }
+            return true;
+        }
+
+        // First seed that gives every known name its own slot, searched for at compile time
+        constexpr uint32_t FindSeed()
+        {
+            uint32_t Seed = 2654435761u;
+            while(IsCollisionFree(Seed) == false)
+            {
+                Seed += 2;
+            }
+            return Seed;
+        }
+
+        constexpr uint32_t Seed = FindSeed();
+
+        constexpr size_t MaxNameLength = 32;
+
+        // Each slot's header with its name already lower cased, so a lookup only has to lower the name it's given
+        struct SlotTable
+        {
+            HttpHeader Slots[TableSize] = {};
+            alignas(8) char LowerNames[TableSize][MaxNameLength] = {};
+
+            constexpr SlotTable()
+            {
+                for(uint32_t i = 0; i < TableSize; i++)
+                {
+                    Slots[i] = HttpHeader::HttpHeader_Unknown;
+                }
+                for(int i = 0; i < NumKnownHttpHeaders; i++)
+                {
+                    uint32_t Slot = HashName(HttpHeaderNames[i], Seed);
+                    Slots[Slot] = (HttpHeader) i;
+                    for(size_t c = 0; c < HttpHeaderNames[i].size(); c++)
+                    {
+                        LowerNames[Slot][c] = ToLowerAscii(HttpHeaderNames[i][c]);
+                    }
+                }
+            }
+        };
+
+        constexpr SlotTable Table;
+    }
+
+    // Case-insensitive, one hash and one compare against the only name that could match
+    HttpHeader FindHttpHeader(std::string_view Name);
+
+    static_assert(HttpHeaderHash::Table.Slots[HttpHeaderHash::HashName("sec-websocket-key", HttpHeaderHash::Seed)] == HttpHeader::HttpHeader_SecWebSocketKey,
+        "known header names must hash to their own slot");
+
+    // A request's headers held as offsets into its bytes and viewed against wherever they currently sit. Known
+    // headers go in their HttpHeader slot (a repeat of one joins the rest), the rest are in arrival order with the first
+    // InlineCapacity inline, so a typical request doesn't allocate.
+    class RequestHeaderList
+    {
+    public:
+        static constexpr int InlineCapacity = 24;
+
+        void Add(HttpHeader Header, int KeyOffset, int KeyLength, int ValueOffset, int ValueLength);
+
+        // Views are taken against Data until it's bound again
+        void Bind(const char* Data) { mData = Data; }
+
+        int GetNum() const { return mNumKnownHeaders + mNumOtherHeaders; }
+
+        // Value of the first header of that name, false if there isn't one
+        bool Find(HttpHeader Header, std::string_view& OutValue) const;
+        bool Find(std::string_view Key, std::string_view& OutValue) const;
+
+        // Function(std::string_view Key, std::string_view Value), known headers first
+        template<typename FunctionType>
+        void ForEach(const FunctionType& Function) const;
+
+    private:
+        struct HeaderSpan
+        {
+            int KeyOffset;
+            int KeyLength;      // 0 for an empty known slot
+            int ValueOffset;
+            int ValueLength;
+        };
+
+        std::string_view GetKey(const HeaderSpan& Span) const { return std::string_view(mData + Span.KeyOffset, Span.KeyLength); }
+        std::string_view GetValue(const HeaderSpan& Span) const { return std::string_view(mData + Span.ValueOffset, Span.ValueLength); }
+        const HeaderSpan& GetOtherSpan(int Index) const { return (Index < InlineCapacity) ? mInlineHeaders[Index] : mOverflowHeaders[Index - InlineCapacity]; }
+
+        std::array<HeaderSpan, NumKnownHttpHeaders> mKnownHeaders = {};
+        int mNumKnownHeaders = 0;
+
+        std::array<HeaderSpan, InlineCapacity> mInlineHeaders;
+        std::vector<HeaderSpan> mOverflowHeaders;
+        int mNumOtherHeaders = 0;
+
+        const char* mData = nullptr;
+    };
+
+    // A response's headers, known ones in their HttpHeader slot and the rest by name in the order they were added
+    class ResponseHeaderList
+    {
+    public:
+        // Leaves a header that's already set alone
+        void Add(std::string_view Key, std::string_view Value);
+        void Set(std::string_view Key, std::string_view Value);
+
+        const std::string* Find(HttpHeader Header) const;
+        const std::string* Find(std::string_view Key) const;
+
+        // Function(std::string_view Key, const std::string& Value), known headers first
+        template<typename FunctionType>
+        void ForEach(const FunctionType& Function) const;
+
+    private:
+        void Store(std::string_view Key, std::string_view Value, bool bReplace);
+
+        std::array<std::string, NumKnownHttpHeaders> mKnownValues;
+        std::bitset<NumKnownHttpHeaders> mKnownPresent;
+        std::vector<std::pair<std::string, std::string>> mOtherHeaders;
+    };
+
+    template<typename FunctionType>
+    void RequestHeaderList::ForEach(const FunctionType& Function) const
+    {
+        for(const HeaderSpan& Span : mKnownHeaders)
+        {
+            if(Span.KeyLength > 0)
+            {
+                Function(GetKey(Span), GetValue(Span));
+            }
+        }
+        for(int i = 0; i < mNumOtherHeaders; i++)
+        {
+            Function(GetKey(GetOtherSpan(i)), GetValue(GetOtherSpan(i)));
+        }
+    }
+
+    template<typename FunctionType>
+    void ResponseHeaderList::ForEach(const FunctionType& Function) const
+    {
+        for(int i = 0; i < NumKnownHttpHeaders; i++)
+        {
+            if(mKnownPresent[i])
+            {
+                Function(HttpHeaderNames[i], mKnownValues[i]);
+            }
+        }
+        for(const auto& Header : mOtherHeaders)
+        {
+            Function(std::string_view(Header.first), Header.second);
+        }
+    }
+}
@@ -0,0 +1,358 @@
+#include "HttpLineScanner.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define WEBSERVER_HTTP_SCAN_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#else
+#define WEBSERVER_HTTP_SCAN_X86 0
+#endif
+
+// MSVC compiles intrinsics for any target, gcc and clang need the functions using them marked
+#if WEBSERVER_HTTP_SCAN_X86 && !defined(_MSC_VER)
+#define HTTP_SCAN_TARGET_SSE42 __attribute__((target("sse4.2")))
+#define HTTP_SCAN_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define HTTP_SCAN_TARGET_SSE42
+#define HTTP_SCAN_TARGET_AVX2
+#endif
+
+namespace
+{
+    using namespace WebServer;
+
+    typedef void (*HttpLineScanFunc)(const char*, int, HttpLineScan&);
+
+    // tchar from RFC 9110: ALPHA / DIGIT / "!" / "#" / "$" / "%" / "&" / "'" / "*" / "+" / "-" / "." / "^" / "_" / "`" / "|" / "~"
+    constexpr bool IsTokenChar(unsigned char c)
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+            || c == '!' || c == '#' || c == '$' || c == '%' || c == '&' || c == '\'' || c == '*' || c == '+'
+            || c == '-' || c == '.' || c == '^' || c == '_' || c == '`' || c == '|' || c == '~';
+    }
+
+    constexpr bool IsControlChar(unsigned char c)
+    {
+        return (c < 0x20 && c != '\t') || c == 0x7F;
+    }
+
+    // One byte a step, the tail of the vector paths and the whole line on anything else
+    void ScanHttpLineScalar(const char* Line, int LineDataLen, HttpLineScan& Scan)
+    {
+        for(int i = Scan.ScannedLength; i < LineDataLen; i++)
+        {
+            const unsigned char c = (unsigned char) Line[i];
+            if(c == '\n')
+            {
+                Scan.LineLength = i;
+                Scan.ScannedLength = i + 1;
+                return;
+            }
+
+            if(c == ':' && Scan.FirstColon == -1)
+            {
+                Scan.FirstColon = i;
+            }
+            if(c == ' ')
+            {
+                Scan.FirstSpace = (Scan.FirstSpace == -1) ? i : Scan.FirstSpace;
+                Scan.LastSpace = i;
+            }
+            if(Scan.FirstNonToken == -1 && IsTokenChar(c) == false)
+            {
+                Scan.FirstNonToken = i;
+            }
+            if(Scan.FirstControl == -1 && IsControlChar(c))
+            {
+                Scan.FirstControl = i;
+            }
+        }
+        Scan.ScannedLength = LineDataLen;
+    }
+
+#if WEBSERVER_HTTP_SCAN_X86
+
+    inline int CountTrailingZeros(uint32_t Mask)
+    {
+#ifdef _MSC_VER
+        unsigned long Index;
+        _BitScanForward(&Index, Mask);
+        return (int) Index;
+#else
+        return __builtin_ctz(Mask);
+#endif
+    }
+
+    inline int FindLastSetBit(uint32_t Mask)
+    {
+#ifdef _MSC_VER
+        unsigned long Index;
+        _BitScanReverse(&Index, Mask);
+        return (int) Index;
+#else
+        return 31 - __builtin_clz(Mask);
+#endif
+    }
+
+    // Nibble tables for classifying tokens with a byte shuffle: a byte is a tchar when the bit for its high nibble
+    // is set in the low nibble's entry. High nibbles 8-F map to no bit, so nothing outside ASCII is a token
+    struct TokenNibbleTables
+    {
+        alignas(32) uint8_t LowNibble[32] = {};
+        alignas(32) uint8_t HighNibble[32] = {};
+
+        constexpr TokenNibbleTables()
+        {
+            for(int c = 0; c < 128; c++)
+            {
+                if(IsTokenChar((unsigned char) c))
+                {
+                    LowNibble[c & 0x0F] |= (uint8_t) (1 << (c >> 4));
+                    LowNibble[16 + (c & 0x0F)] |= (uint8_t) (1 << (c >> 4));
+                }
+            }
+            for(int h = 0; h < 8; h++)
+            {
+                HighNibble[h] = (uint8_t) (1 << h);
+                HighNibble[16 + h] = (uint8_t) (1 << h);
+            }
+        }
+    };
+
+    constexpr TokenNibbleTables TokenTables;
+
+    // Folds one block's match masks into the scan, returns true once the line's '\n' is in it
+    inline bool ApplyBlockMasks(HttpLineScan& Scan, int BlockStart, uint32_t NewLineMask, uint32_t ColonMask, uint32_t SpaceMask, uint32_t NonTokenMask, uint32_t ControlMask)
+    {
+        bool bLineEnds = NewLineMask != 0;
+        if(bLineEnds)
+        {
+            // Only what's before the '\n' belongs to the line
+            int NewLineIndex = CountTrailingZeros(NewLineMask);
+            uint32_t LineMask = (uint32_t) ((1ull << NewLineIndex) - 1);
+            ColonMask &= LineMask;
+            SpaceMask &= LineMask;
+            NonTokenMask &= LineMask;
+            ControlMask &= LineMask;
+
+            Scan.LineLength = BlockStart + NewLineIndex;
+            Scan.ScannedLength = Scan.LineLength + 1;
+        }
+
+        if(ColonMask != 0 && Scan.FirstColon == -1)
+        {
+            Scan.FirstColon = BlockStart + CountTrailingZeros(ColonMask);
+        }
+        if(SpaceMask != 0)
+        {
+            Scan.FirstSpace = (Scan.FirstSpace == -1) ? BlockStart + CountTrailingZeros(SpaceMask) : Scan.FirstSpace;
+            Scan.LastSpace = BlockStart + FindLastSetBit(SpaceMask);
+        }
+        if(NonTokenMask != 0 && Scan.FirstNonToken == -1)
+        {
+            Scan.FirstNonToken = BlockStart + CountTrailingZeros(NonTokenMask);
+        }
+        if(ControlMask != 0 && Scan.FirstControl == -1)
+        {
+            Scan.FirstControl = BlockStart + CountTrailingZeros(ControlMask);
+        }
+        return bLineEnds;
+    }
+
+    HTTP_SCAN_TARGET_SSE42 void ScanHttpLineSse42(const char* Line, int LineDataLen, HttpLineScan& Scan)
+    {
+        const __m128i NewLine = _mm_set1_epi8('\n');
+        const __m128i Colon = _mm_set1_epi8(':');
+        const __m128i Space = _mm_set1_epi8(' ');
+        const __m128i Tab = _mm_set1_epi8('\t');
+        const __m128i Delete = _mm_set1_epi8(0x7F);
+        const __m128i LastControl = _mm_set1_epi8(0x1F);
+        const __m128i NibbleMask = _mm_set1_epi8(0x0F);
+        const __m128i LowTable = _mm_load_si128((const __m128i*) TokenTables.LowNibble);
+        const __m128i HighTable = _mm_load_si128((const __m128i*) TokenTables.HighNibble);
+
+        int i = Scan.ScannedLength;
+        for(; i + 16 <= LineDataLen; i += 16)
+        {
+            const __m128i Block = _mm_loadu_si128((const __m128i*) (Line + i));
+
+            // Unsigned c <= 0x1F, bar HTAB, or DEL
+            const __m128i IsLowControl = _mm_andnot_si128(_mm_cmpeq_epi8(Block, Tab), _mm_cmpeq_epi8(_mm_min_epu8(Block, LastControl), Block));
+            const __m128i IsControl = _mm_or_si128(IsLowControl, _mm_cmpeq_epi8(Block, Delete));
+
+            // Bytes 0x80 and up land on the high nibble table's empty entries
+            const __m128i LowBits = _mm_shuffle_epi8(LowTable, _mm_and_si128(Block, NibbleMask));
+            const __m128i HighBits = _mm_shuffle_epi8(HighTable, _mm_and_si128(_mm_srli_epi16(Block, 4), NibbleMask));
+            const __m128i IsNonToken = _mm_cmpeq_epi8(_mm_and_si128(LowBits, HighBits), _mm_setzero_si128());
+
+            const uint32_t NewLineMask = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(Block, NewLine));
+            const uint32_t ColonMask = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(Block, Colon));
+            const uint32_t SpaceMask = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(Block, Space));
+            const uint32_t NonTokenMask = (uint32_t) _mm_movemask_epi8(IsNonToken);
+            const uint32_t ControlMask = (uint32_t) _mm_movemask_epi8(IsControl);
+
+            if(ApplyBlockMasks(Scan, i, NewLineMask, ColonMask, SpaceMask, NonTokenMask, ControlMask))
+            {
+                return;
+            }
+        }
+
+        // Without the '\n' the tail can wait, it's scanned a whole block at a time once more of the line arrives
+        Scan.ScannedLength = i;
+        if(memchr(Line + i, '\n', LineDataLen - i) != nullptr)
+        {
+            ScanHttpLineScalar(Line, LineDataLen, Scan);
+        }
+    }
+
+    HTTP_SCAN_TARGET_AVX2 void ScanHttpLineAvx2(const char* Line, int LineDataLen, HttpLineScan& Scan)
+    {
+        const __m256i NewLine = _mm256_set1_epi8('\n');
+        const __m256i Colon = _mm256_set1_epi8(':');
+        const __m256i Space = _mm256_set1_epi8(' ');
+        const __m256i Tab = _mm256_set1_epi8('\t');
+        const __m256i Delete = _mm256_set1_epi8(0x7F);
+        const __m256i LastControl = _mm256_set1_epi8(0x1F);
+        const __m256i NibbleMask = _mm256_set1_epi8(0x0F);
+        const __m256i LowTable = _mm256_load_si256((const __m256i*) TokenTables.LowNibble);
+        const __m256i HighTable = _mm256_load_si256((const __m256i*) TokenTables.HighNibble);
+
+        int i = Scan.ScannedLength;
+        for(; i + 32 <= LineDataLen; i += 32)
+        {
+            const __m256i Block = _mm256_loadu_si256((const __m256i*) (Line + i));
+
+            const __m256i IsLowControl = _mm256_andnot_si256(_mm256_cmpeq_epi8(Block, Tab), _mm256_cmpeq_epi8(_mm256_min_epu8(Block, LastControl), Block));
+            const __m256i IsControl = _mm256_or_si256(IsLowControl, _mm256_cmpeq_epi8(Block, Delete));
+
+            const __m256i LowBits = _mm256_shuffle_epi8(LowTable, _mm256_and_si256(Block, NibbleMask));
+            const __m256i HighBits = _mm256_shuffle_epi8(HighTable, _mm256_and_si256(_mm256_srli_epi16(Block, 4), NibbleMask));
+            const __m256i IsNonToken = _mm256_cmpeq_epi8(_mm256_and_si256(LowBits, HighBits), _mm256_setzero_si256());
+
+            const uint32_t NewLineMask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(Block, NewLine));
+            const uint32_t ColonMask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(Block, Colon));
+            const uint32_t SpaceMask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(Block, Space));
+            const uint32_t NonTokenMask = (uint32_t) _mm256_movemask_epi8(IsNonToken);
+            const uint32_t ControlMask = (uint32_t) _mm256_movemask_epi8(IsControl);
+
+            if(ApplyBlockMasks(Scan, i, NewLineMask, ColonMask, SpaceMask, NonTokenMask, ControlMask))
+            {
+                return;
+            }
+        }
+
+        // A 16 byte step before dropping to scalar for what's left
+        Scan.ScannedLength = i;
+        ScanHttpLineSse42(Line, LineDataLen, Scan);
+    }
+
+    bool IsCpuFeatureSupported(HttpScanImplementation Implementation)
+    {
+#ifdef _MSC_VER
+        int CpuInfo[4];
+        __cpuid(CpuInfo, 0);
+        const int MaxLeaf = CpuInfo[0];
+
+        __cpuid(CpuInfo, 1);
+        const bool bSse42 = (CpuInfo[2] & (1 << 20)) != 0;
+        const bool bOsSavesYmm = (CpuInfo[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+        if(Implementation == HttpScanImplementation::HttpScanImplementation_Sse42)
+        {
+            return bSse42;
+        }
+
+        if(MaxLeaf < 7 || bOsSavesYmm == false)
+        {
+            return false;
+        }
+        __cpuidex(CpuInfo, 7, 0);
+        return (CpuInfo[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return (Implementation == HttpScanImplementation::HttpScanImplementation_Sse42) ? __builtin_cpu_supports("sse4.2") : __builtin_cpu_supports("avx2");
+#endif
+    }
+
+#endif  // WEBSERVER_HTTP_SCAN_X86
+
+    HttpLineScanFunc GetScanFunc(HttpScanImplementation Implementation)
+    {
+#if WEBSERVER_HTTP_SCAN_X86
+        switch(Implementation)
+        {
+            case HttpScanImplementation::HttpScanImplementation_Avx2:
+                return &ScanHttpLineAvx2;
+            case HttpScanImplementation::HttpScanImplementation_Sse42:
+                return &ScanHttpLineSse42;
+            default:
+                break;
+        }
+#endif
+        return &ScanHttpLineScalar;
+    }
+
+    HttpScanImplementation DetectBestImplementation()
+    {
+        if(IsHttpScanImplementationSupported(HttpScanImplementation::HttpScanImplementation_Avx2))
+        {
+            return HttpScanImplementation::HttpScanImplementation_Avx2;
+        }
+        if(IsHttpScanImplementationSupported(HttpScanImplementation::HttpScanImplementation_Sse42))
+        {
+            return HttpScanImplementation::HttpScanImplementation_Sse42;
+        }
+        return HttpScanImplementation::HttpScanImplementation_Scalar;
+    }
+
+    std::atomic<HttpScanImplementation> ActiveImplementation{ DetectBestImplementation() };
+    std::atomic<HttpLineScanFunc> ActiveScanFunc{ GetScanFunc(ActiveImplementation.load()) };
+}
+
+namespace WebServer
+{
+    void ContinueHttpLineScan(const char* Line, int LineDataLen, HttpLineScan& InOutScan)
+    {
+        if(InOutScan.IsComplete() || InOutScan.ScannedLength >= LineDataLen)
+        {
+            return;
+        }
+        ActiveScanFunc.load(std::memory_order_relaxed)(Line, LineDataLen, InOutScan);
+    }
+
+    HttpScanImplementation GetHttpScanImplementation()
+    {
+        return ActiveImplementation.load();
+    }
+
+    bool IsHttpScanImplementationSupported(HttpScanImplementation Implementation)
+    {
+        if(Implementation == HttpScanImplementation::HttpScanImplementation_Scalar)
+        {
+            return true;
+        }
+#if WEBSERVER_HTTP_SCAN_X86
+        return IsCpuFeatureSupported(Implementation);
+#else
+        return false;
+#endif
+    }
+
+    bool SetHttpScanImplementation(HttpScanImplementation Implementation)
+    {
+        if(IsHttpScanImplementationSupported(Implementation) == false)
+        {
+            return false;
+        }
+
+        ActiveImplementation = Implementation;
+        ActiveScanFunc = GetScanFunc(Implementation);
+        return true;
+    }
+}
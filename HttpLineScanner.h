@@ -0,0 +1,38 @@
+#pragma once
+
+namespace WebServer
+{
+    // What a single pass over one line of a request head finds. Positions are from the start of the line, -1 until
+    // seen, and only bytes before the line's '\n' count
+    struct HttpLineScan
+    {
+        int ScannedLength = 0;      // how far the scan got, it resumes from here when more of the line arrives
+                                    // (a vector scan may leave a partial block at the end for then)
+        int LineLength = -1;        // bytes before the '\n', -1 while it hasn't arrived
+        int FirstColon = -1;
+        int FirstSpace = -1;
+        int LastSpace = -1;
+        int FirstNonToken = -1;     // first byte that can't be in a token (method, header name)
+        int FirstControl = -1;      // first control byte other than HTAB, the line's own trailing CR included
+
+        bool IsComplete() const { return LineLength != -1; }
+    };
+
+    enum class HttpScanImplementation
+    {
+        HttpScanImplementation_Scalar,
+        HttpScanImplementation_Sse42,      // 16 bytes a step
+        HttpScanImplementation_Avx2,       // 32 bytes a step
+    };
+
+    // Carries InOutScan on over Line[ScannedLength, LineDataLen), stopping at the line's '\n'.
+    // Line needn't be NUL terminated, nothing past LineDataLen is read
+    void ContinueHttpLineScan(const char* Line, int LineDataLen, HttpLineScan& InOutScan);
+
+    // Best the cpu supports, picked at startup
+    HttpScanImplementation GetHttpScanImplementation();
+    bool IsHttpScanImplementationSupported(HttpScanImplementation Implementation);
+
+    // For benchmarking the paths against each other, false if the cpu can't run it
+    bool SetHttpScanImplementation(HttpScanImplementation Implementation);
+}
@@ -0,0 +1,653 @@
+#include "IoUringEngine.h"
+
+#ifdef __linux__
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    using namespace WebServer;
+
+    constexpr unsigned SubmissionQueueDepth = 1024;
+    constexpr unsigned CompletionQueueDepth = 4 * SubmissionQueueDepth;
+
+    constexpr uint16_t ProvidedBufferGroup = 0;
+    constexpr unsigned NumProvidedBuffers = 1024;   // power of two
+    constexpr unsigned ProvidedBufferSize = 4096;
+
+    enum class UringOperation : uint8_t
+    {
+        UringOperation_Accept = 1,
+        UringOperation_Receive,
+        UringOperation_Send,
+        UringOperation_Shutdown,
+        UringOperation_Close,
+        UringOperation_Cancel,
+        UringOperation_Wake,
+    };
+
+    // user_data: operation in the top byte, 24 bit socket generation, socket (or send slot) in the low 32 bits
+    uint64_t PackUserData(UringOperation Operation, uint32_t Generation, uint32_t Index)
+    {
+        return ((uint64_t) Operation << 56) | ((uint64_t) (Generation & 0xFFFFFF) << 32) | Index;
+    }
+
+    UringOperation UnpackOperation(uint64_t UserData) { return (UringOperation) (UserData >> 56); }
+    uint32_t UnpackGeneration(uint64_t UserData) { return (uint32_t) (UserData >> 32) & 0xFFFFFF; }
+    uint32_t UnpackIndex(uint64_t UserData) { return (uint32_t) UserData; }
+
+    int UringSetup(unsigned Entries, io_uring_params* Params)
+    {
+        return (int) syscall(__NR_io_uring_setup, Entries, Params);
+    }
+
+    int UringEnter(int RingHandle, unsigned ToSubmit, unsigned MinComplete, unsigned Flags, void* Arg, size_t ArgSize)
+    {
+        return (int) syscall(__NR_io_uring_enter, RingHandle, ToSubmit, MinComplete, Flags, Arg, ArgSize);
+    }
+
+    int UringRegister(int RingHandle, unsigned Opcode, void* Arg, unsigned NumArgs)
+    {
+        return (int) syscall(__NR_io_uring_register, RingHandle, Opcode, Arg, NumArgs);
+    }
+
+    unsigned LoadAcquire(const unsigned* Value) { return __atomic_load_n(Value, __ATOMIC_ACQUIRE); }
+    void StoreRelease(unsigned* Target, unsigned Value) { __atomic_store_n(Target, Value, __ATOMIC_RELEASE); }
+}
+
+namespace WebServer
+{
+    IoUringEngine::~IoUringEngine()
+    {
+        if(mSqes) { munmap(mSqes, mSqesSize); }
+        if(mSqRingMemory) { munmap(mSqRingMemory, mSqRingSize); }
+        if(mBufferRing) { munmap(mBufferRing, mBufferRingSize); }
+        if(mRingHandle != -1) { close(mRingHandle); }
+        if(mWakeHandle != -1) { close(mWakeHandle); }
+    }
+
+    bool IoUringEngine::IsSupported()
+    {
+        // Multishot recv and provided buffer rings arrived in 6.0
+        utsname KernelName{};
+        int Major = 0, Minor = 0;
+        if(uname(&KernelName) != 0 || sscanf(KernelName.release, "%d.%d", &Major, &Minor) != 2 || Major < 6)
+        {
+            return false;
+        }
+
+        // io_uring can still be disabled by sysctl or a seccomp filter
+        io_uring_params Params{};
+        int RingHandle = UringSetup(4, &Params);
+        if(RingHandle < 0)
+        {
+            return false;
+        }
+
+        close(RingHandle);
+        return (Params.features & IORING_FEAT_EXT_ARG) && (Params.features & IORING_FEAT_SINGLE_MMAP);
+    }
+
+    bool IoUringEngine::Initialise(SOCKET ListenSocket)
+    {
+        mListenSocket = ListenSocket;
+
+        io_uring_params Params{};
+        Params.flags = IORING_SETUP_CQSIZE;
+        Params.cq_entries = CompletionQueueDepth;
+
+        mRingHandle = UringSetup(SubmissionQueueDepth, &Params);
+        if(mRingHandle < 0)
+        {
+            return false;
+        }
+
+        // Submission and completion rings share one mapping (IORING_FEAT_SINGLE_MMAP)
+        mSqRingSize = std::max(Params.sq_off.array + Params.sq_entries * sizeof(unsigned), Params.cq_off.cqes + Params.cq_entries * sizeof(io_uring_cqe));
+        mSqRingMemory = mmap(nullptr, mSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRingHandle, IORING_OFF_SQ_RING);
+        if(mSqRingMemory == MAP_FAILED)
+        {
+            mSqRingMemory = nullptr;
+            return false;
+        }
+
+        mSqesSize = Params.sq_entries * sizeof(io_uring_sqe);
+        mSqes = (io_uring_sqe*) mmap(nullptr, mSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRingHandle, IORING_OFF_SQES);
+        if(mSqes == MAP_FAILED)
+        {
+            mSqes = nullptr;
+            return false;
+        }
+
+        char* RingMemory = (char*) mSqRingMemory;
+        mSqHead = (unsigned*) (RingMemory + Params.sq_off.head);
+        mSqTail = (unsigned*) (RingMemory + Params.sq_off.tail);
+        mSqMask = *(unsigned*) (RingMemory + Params.sq_off.ring_mask);
+        mSqEntries = Params.sq_entries;
+        mSqArray = (unsigned*) (RingMemory + Params.sq_off.array);
+        mSqLocalTail = mSqSubmittedTail = *mSqTail;
+
+        mCqHead = (unsigned*) (RingMemory + Params.cq_off.head);
+        mCqTail = (unsigned*) (RingMemory + Params.cq_off.tail);
+        mCqMask = *(unsigned*) (RingMemory + Params.cq_off.ring_mask);
+        mCqes = (io_uring_cqe*) (RingMemory + Params.cq_off.cqes);
+
+        // Provided buffer ring, recv completions pick a buffer from here so nothing is pinned per idle connection
+        mBufferRingSize = NumProvidedBuffers * sizeof(io_uring_buf);
+        void* BufferRingMemory = mmap(nullptr, mBufferRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(BufferRingMemory == MAP_FAILED)
+        {
+            return false;
+        }
+        mBufferRing = (io_uring_buf_ring*) BufferRingMemory;
+
+        io_uring_buf_reg BufferRegistration{};
+        BufferRegistration.ring_addr = (uint64_t) mBufferRing;
+        BufferRegistration.ring_entries = NumProvidedBuffers;
+        BufferRegistration.bgid = ProvidedBufferGroup;
+        if(UringRegister(mRingHandle, IORING_REGISTER_PBUF_RING, &BufferRegistration, 1) != 0)
+        {
+            return false;
+        }
+
+        mBufferMemory.resize((size_t) NumProvidedBuffers * ProvidedBufferSize);
+        for(uint16_t BufferId = 0; BufferId < NumProvidedBuffers; BufferId++)
+        {
+            mBuffersToRecycle.push_back(BufferId);
+        }
+        PublishProvidedBuffers();
+
+        mWakeHandle = eventfd(0, EFD_CLOEXEC);
+        if(mWakeHandle == -1)
+        {
+            return false;
+        }
+
+        PrepareAccept();
+        PrepareWakeRead();
+        return true;
+    }
+
+    void IoUringEngine::ArmReceive(SOCKET Socket)
+    {
+        SocketState& State = GetSocketState(Socket);
+        State.bReceiving = true;
+        State.bClosePending = false;
+        PrepareReceive(Socket);
+    }
+
+    void IoUringEngine::QueueSend(SOCKET Socket, const char* Data, int DataLen, bool bPersistentData)
+    {
+        SocketSendBuffer Buffer{ Data, DataLen, bPersistentData };
+        QueueSend(Socket, &Buffer, 1);
+    }
+
+    void IoUringEngine::QueueSend(SOCKET Socket, const SocketSendBuffer* Buffers, int NumBuffers)
+    {
+        if(NumBuffers <= 0)
+        {
+            return;
+        }
+
+        uint32_t SendSlot;
+        if(mFreeSendSlots.empty())
+        {
+            SendSlot = (uint32_t) mPendingSends.size();
+            mPendingSends.emplace_back();
+        }
+        else
+        {
+            SendSlot = mFreeSendSlots.back();
+            mFreeSendSlots.pop_back();
+        }
+
+        PendingSend& Send = mPendingSends[SendSlot];
+        Send.Socket = Socket;
+        Send.Generation = GetSocketState(Socket).Generation;
+        Send.FirstBuffer = 0;
+        Send.NextWaitingSend = NoSendSlot;
+
+        // Copy everything that won't outlive the send into one owned block
+        size_t OwnedLength = 0;
+        for(int i = 0; i < NumBuffers; i++)
+        {
+            OwnedLength += Buffers[i].bPersistentData ? 0 : Buffers[i].DataLen;
+        }
+        Send.OwnedData.resize(OwnedLength);
+
+        size_t OwnedOffset = 0;
+        Send.TotalBytes = 0;
+        Send.Buffers.resize(NumBuffers);
+        for(int i = 0; i < NumBuffers; i++)
+        {
+            const char* Data = Buffers[i].Data;
+            if(Buffers[i].bPersistentData == false)
+            {
+                memcpy(&Send.OwnedData[OwnedOffset], Data, Buffers[i].DataLen);
+                Data = &Send.OwnedData[OwnedOffset];
+                OwnedOffset += Buffers[i].DataLen;
+            }
+            Send.Buffers[i] = iovec{ (void*) Data, (size_t) Buffers[i].DataLen };
+            Send.TotalBytes += (size_t) Buffers[i].DataLen;
+        }
+
+        SocketState& State = GetSocketState(Socket);
+        State.InflightSends++;
+        State.PendingSendBytes += Send.TotalBytes;
+
+        // Behind the socket's send in flight until it's gone out in full
+        if(State.bSendInFlight)
+        {
+            if(State.LastWaitingSend == NoSendSlot)
+            {
+                State.FirstWaitingSend = SendSlot;
+            }
+            else
+            {
+                mPendingSends[State.LastWaitingSend].NextWaitingSend = SendSlot;
+            }
+            State.LastWaitingSend = SendSlot;
+            return;
+        }
+
+        State.bSendInFlight = true;
+        PrepareSend(SendSlot);
+    }
+
+    size_t IoUringEngine::GetPendingSendBytes(SOCKET Socket)
+    {
+        return GetSocketState(Socket).PendingSendBytes;
+    }
+
+    void IoUringEngine::QueueClose(SOCKET Socket)
+    {
+        SocketState& State = GetSocketState(Socket);
+        State.Generation++;
+        State.bReceiving = false;
+
+        // Not linked to the last send, a short one would be cut off. The send completing in full queues the close
+        if(State.InflightSends == 0)
+        {
+            PrepareClose(Socket);
+        }
+        else
+        {
+            State.bClosePending = true;
+        }
+    }
+
+    void IoUringEngine::StopReceive(SOCKET Socket)
+    {
+        SocketState& State = GetSocketState(Socket);
+        if(State.bReceiving == false)
+        {
+            return;
+        }
+
+        io_uring_sqe* Sqe = GetSqe();
+        Sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        Sqe->fd = -1;
+        Sqe->addr = PackUserData(UringOperation::UringOperation_Receive, State.Generation, (uint32_t) Socket);
+        Sqe->user_data = PackUserData(UringOperation::UringOperation_Cancel, 0, (uint32_t) Socket);
+
+        State.Generation++;
+        State.bReceiving = false;
+
+        // Get the cancel in now so the multishot recv stops taking data the new owner expects
+        SubmitPending(0, 0);
+    }
+
+    int IoUringEngine::SubmitAndWait(std::vector<IoUringCompletion>& OutCompletions, int TimeoutMs)
+    {
+        OutCompletions.clear();
+
+        // Buffers handed out with the last batch have been consumed
+        PublishProvidedBuffers();
+
+        if(bAcceptArmed == false)
+        {
+            PrepareAccept();
+        }
+
+        SubmitPending(1, TimeoutMs);
+
+        unsigned CqHead = *mCqHead;
+        unsigned CqTail = LoadAcquire(mCqTail);
+        for(; CqHead != CqTail; CqHead++)
+        {
+            HandleCompletion(mCqes[CqHead & mCqMask], OutCompletions);
+        }
+        StoreRelease(mCqHead, CqHead);
+
+        return (int) OutCompletions.size();
+    }
+
+    void IoUringEngine::Wake()
+    {
+        uint64_t WakeCount = 1;
+        (void) !write(mWakeHandle, &WakeCount, sizeof(WakeCount));
+    }
+
+    io_uring_sqe* IoUringEngine::GetSqe()
+    {
+        if(mSqLocalTail - LoadAcquire(mSqHead) >= mSqEntries)
+        {
+            SubmitPending(0, 0);
+        }
+
+        unsigned Index = mSqLocalTail & mSqMask;
+        io_uring_sqe* Sqe = &mSqes[Index];
+        memset(Sqe, 0, sizeof(io_uring_sqe));
+        mSqArray[Index] = Index;
+        mSqLocalTail++;
+        return Sqe;
+    }
+
+    void IoUringEngine::SubmitPending(unsigned MinComplete, int TimeoutMs)
+    {
+        StoreRelease(mSqTail, mSqLocalTail);
+        unsigned ToSubmit = mSqLocalTail - mSqSubmittedTail;
+
+        int Submitted;
+        if(MinComplete > 0)
+        {
+            timespec Timeout{ TimeoutMs / 1000, (TimeoutMs % 1000) * 1000000L };
+            io_uring_getevents_arg WaitArgs{};
+            WaitArgs.sigmask_sz = _NSIG / 8;
+            WaitArgs.ts = (uint64_t) &Timeout;
+
+            Submitted = UringEnter(mRingHandle, ToSubmit, MinComplete, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &WaitArgs, sizeof(WaitArgs));
+        }
+        else
+        {
+            Submitted = (ToSubmit > 0) ? UringEnter(mRingHandle, ToSubmit, 0, 0, nullptr, 0) : 0;
+        }
+
+        // Anything the kernel didn't take stays in the ring for the next enter
+        if(Submitted > 0)
+        {
+            mSqSubmittedTail += Submitted;
+        }
+    }
+
+    void IoUringEngine::PrepareAccept()
+    {
+        io_uring_sqe* Sqe = GetSqe();
+        Sqe->opcode = IORING_OP_ACCEPT;
+        Sqe->fd = mListenSocket;
+        Sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        Sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+        Sqe->user_data = PackUserData(UringOperation::UringOperation_Accept, 0, 0);
+        bAcceptArmed = true;
+    }
+
+    void IoUringEngine::PrepareReceive(SOCKET Socket)
+    {
+        io_uring_sqe* Sqe = GetSqe();
+        Sqe->opcode = IORING_OP_RECV;
+        Sqe->fd = Socket;
+        Sqe->ioprio = IORING_RECV_MULTISHOT;
+        Sqe->flags = IOSQE_BUFFER_SELECT;
+        Sqe->buf_group = ProvidedBufferGroup;
+        Sqe->user_data = PackUserData(UringOperation::UringOperation_Receive, GetSocketState(Socket).Generation, (uint32_t) Socket);
+    }
+
+    void IoUringEngine::PrepareSend(uint32_t SendSlot)
+    {
+        PendingSend& Send = mPendingSends[SendSlot];
+        size_t NumBuffers = Send.Buffers.size() - Send.FirstBuffer;
+
+        io_uring_sqe* Sqe = GetSqe();
+        Sqe->fd = Send.Socket;
+        Sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+        if(NumBuffers == 1)
+        {
+            Sqe->opcode = IORING_OP_SEND;
+            Sqe->addr = (uint64_t) Send.Buffers[Send.FirstBuffer].iov_base;
+            Sqe->len = (uint32_t) Send.Buffers[Send.FirstBuffer].iov_len;
+        }
+        else
+        {
+            Send.Message = msghdr{};
+            Send.Message.msg_iov = &Send.Buffers[Send.FirstBuffer];
+            Send.Message.msg_iovlen = NumBuffers;
+
+            Sqe->opcode = IORING_OP_SENDMSG;
+            Sqe->addr = (uint64_t) &Send.Message;
+            Sqe->len = 1;
+        }
+        Sqe->user_data = PackUserData(UringOperation::UringOperation_Send, 0, SendSlot);
+    }
+
+    void IoUringEngine::PrepareClose(SOCKET Socket)
+    {
+        io_uring_sqe* ShutdownSqe = GetSqe();
+        ShutdownSqe->opcode = IORING_OP_SHUTDOWN;
+        ShutdownSqe->fd = Socket;
+        ShutdownSqe->len = SHUT_RDWR;
+        ShutdownSqe->flags = IOSQE_IO_LINK;
+        ShutdownSqe->user_data = PackUserData(UringOperation::UringOperation_Shutdown, 0, (uint32_t) Socket);
+
+        io_uring_sqe* CloseSqe = GetSqe();
+        CloseSqe->opcode = IORING_OP_CLOSE;
+        CloseSqe->fd = Socket;
+        CloseSqe->user_data = PackUserData(UringOperation::UringOperation_Close, 0, (uint32_t) Socket);
+
+        GetSocketState(Socket).bClosePending = false;
+    }
+
+    void IoUringEngine::PrepareWakeRead()
+    {
+        // Reading resets the eventfd's count, however many wakes came in since the last one
+        io_uring_sqe* Sqe = GetSqe();
+        Sqe->opcode = IORING_OP_READ;
+        Sqe->fd = mWakeHandle;
+        Sqe->addr = (uint64_t) &mWakeCount;
+        Sqe->len = sizeof(mWakeCount);
+        Sqe->user_data = PackUserData(UringOperation::UringOperation_Wake, 0, 0);
+    }
+
+    void IoUringEngine::HandleCompletion(const io_uring_cqe& Cqe, std::vector<IoUringCompletion>& OutCompletions)
+    {
+        const bool bMore = (Cqe.flags & IORING_CQE_F_MORE) != 0;
+
+        switch(UnpackOperation(Cqe.user_data))
+        {
+            case UringOperation::UringOperation_Accept:
+            {
+                bAcceptArmed = bMore;
+                OutCompletions.push_back({ IoUringCompletionType::IoUringCompletionType_Accept, (Cqe.res >= 0) ? (SOCKET) Cqe.res : INVALID_SOCKET, Cqe.res });
+                break;
+            }
+            case UringOperation::UringOperation_Receive:
+            {
+                SOCKET Socket = (SOCKET) UnpackIndex(Cqe.user_data);
+                SocketState& State = GetSocketState(Socket);
+
+                const char* Data = nullptr;
+                if(Cqe.flags & IORING_CQE_F_BUFFER)
+                {
+                    uint16_t BufferId = (uint16_t) (Cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+                    Data = &mBufferMemory[(size_t) BufferId * ProvidedBufferSize];
+                    mBuffersToRecycle.push_back(BufferId);
+                }
+
+                // From a connection that has since been closed or handed off, the descriptor may already be reused
+                if(UnpackGeneration(Cqe.user_data) != (State.Generation & 0xFFFFFF) || State.bReceiving == false)
+                {
+                    break;
+                }
+
+                // Out of provided buffers or the kernel ended the multishot, just go again
+                bool bRearm = bMore == false && (Cqe.res > 0 || Cqe.res == -ENOBUFS);
+                if(bRearm)
+                {
+                    PrepareReceive(Socket);
+                }
+
+                if(Cqe.res != -ENOBUFS)
+                {
+                    State.bReceiving = bMore || bRearm;
+                    OutCompletions.push_back({ IoUringCompletionType::IoUringCompletionType_Receive, Socket, Cqe.res, Data });
+                }
+                break;
+            }
+            case UringOperation::UringOperation_Send:
+            {
+                OnSendComplete(UnpackIndex(Cqe.user_data), Cqe.res);
+                break;
+            }
+            case UringOperation::UringOperation_Close:
+            {
+                // The link was broken by a failed shutdown, close it ourselves
+                if(Cqe.res < 0)
+                {
+                    CloseSocket((SOCKET) UnpackIndex(Cqe.user_data));
+                }
+                break;
+            }
+            case UringOperation::UringOperation_Wake:
+            {
+                // Only there to end the wait, ready for the next one
+                PrepareWakeRead();
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    void IoUringEngine::OnSendComplete(uint32_t SendSlot, int Result)
+    {
+        PendingSend& Send = mPendingSends[SendSlot];
+        const SOCKET Socket = Send.Socket;
+        SocketState& State = GetSocketState(Socket);
+
+        // Step over what was sent
+        size_t BytesLeft = (Result > 0) ? (size_t) Result : 0;
+        while(BytesLeft > 0 && Send.FirstBuffer < Send.Buffers.size())
+        {
+            iovec& Buffer = Send.Buffers[Send.FirstBuffer];
+            size_t BufferBytes = std::min(BytesLeft, Buffer.iov_len);
+            Buffer.iov_base = (char*) Buffer.iov_base + BufferBytes;
+            Buffer.iov_len -= BufferBytes;
+            BytesLeft -= BufferBytes;
+            Send.FirstBuffer += (Buffer.iov_len == 0) ? 1 : 0;
+        }
+        while(Send.FirstBuffer < Send.Buffers.size() && Send.Buffers[Send.FirstBuffer].iov_len == 0)
+        {
+            Send.FirstBuffer++;
+        }
+
+        // Short send, the rest goes before anything queued behind it. Nothing can close the socket while it's in flight
+        if(Result > 0 && Send.FirstBuffer < Send.Buffers.size())
+        {
+            PrepareSend(SendSlot);
+            return;
+        }
+
+        // A failed send fails the ones waiting behind it too, the connection's done
+        const bool bFailed = Send.FirstBuffer < Send.Buffers.size();
+        ReleaseSend(SendSlot);
+        State.bSendInFlight = false;
+        while(State.FirstWaitingSend != NoSendSlot && State.bSendInFlight == false)
+        {
+            const uint32_t NextSlot = State.FirstWaitingSend;
+            State.FirstWaitingSend = mPendingSends[NextSlot].NextWaitingSend;
+            if(State.FirstWaitingSend == NoSendSlot)
+            {
+                State.LastWaitingSend = NoSendSlot;
+            }
+
+            if(bFailed)
+            {
+                ReleaseSend(NextSlot);
+                continue;
+            }
+            State.bSendInFlight = true;
+            PrepareSend(NextSlot);
+        }
+
+        if(State.InflightSends == 0 && State.bClosePending)
+        {
+            PrepareClose(Socket);
+        }
+    }
+
+    void IoUringEngine::ReleaseSend(uint32_t SendSlot)
+    {
+        PendingSend& Send = mPendingSends[SendSlot];
+        SocketState& State = GetSocketState(Send.Socket);
+        State.InflightSends--;
+        State.PendingSendBytes -= Send.TotalBytes;
+
+        Send = PendingSend{};
+        mFreeSendSlots.push_back(SendSlot);
+    }
+
+    IoUringEngine::SocketState& IoUringEngine::GetSocketState(SOCKET Socket)
+    {
+        if((size_t) Socket >= mSocketStates.size())
+        {
+            mSocketStates.resize((size_t) Socket + 1);
+        }
+        return mSocketStates[Socket];
+    }
+
+    void IoUringEngine::ProvideBuffer(uint16_t BufferId)
+    {
+        // Index the ring directly, the header's flex array sits behind an empty struct that takes up space in C++
+        io_uring_buf* Buffers = reinterpret_cast<io_uring_buf*>(mBufferRing);
+        io_uring_buf& Buffer = Buffers[mBufferRingTail & (NumProvidedBuffers - 1)];
+        Buffer.addr = (uint64_t) &mBufferMemory[(size_t) BufferId * ProvidedBufferSize];
+        Buffer.len = ProvidedBufferSize;
+        Buffer.bid = BufferId;
+        mBufferRingTail++;
+    }
+
+    void IoUringEngine::PublishProvidedBuffers()
+    {
+        if(mBuffersToRecycle.empty())
+        {
+            return;
+        }
+
+        for(uint16_t BufferId : mBuffersToRecycle)
+        {
+            ProvideBuffer(BufferId);
+        }
+        mBuffersToRecycle.clear();
+
+        __atomic_store_n(&mBufferRing->tail, mBufferRingTail, __ATOMIC_RELEASE);
+    }
+}
+
+#else
+
+namespace WebServer
+{
+    IoUringEngine::~IoUringEngine() = default;
+
+    bool IoUringEngine::IsSupported() { return false; }
+    bool IoUringEngine::Initialise(SOCKET ListenSocket) { return false; }
+
+    void IoUringEngine::ArmReceive(SOCKET Socket) {}
+    void IoUringEngine::QueueSend(SOCKET Socket, const char* Data, int DataLen, bool bPersistentData) {}
+    void IoUringEngine::QueueSend(SOCKET Socket, const SocketSendBuffer* Buffers, int NumBuffers) {}
+    size_t IoUringEngine::GetPendingSendBytes(SOCKET Socket) { return 0; }
+    void IoUringEngine::QueueClose(SOCKET Socket) {}
+    void IoUringEngine::StopReceive(SOCKET Socket) {}
+
+    int IoUringEngine::SubmitAndWait(std::vector<IoUringCompletion>& OutCompletions, int TimeoutMs) { return 0; }
+    void IoUringEngine::Wake() {}
+}
+
+#endif
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "Socket.h"
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#endif
+
+namespace WebServer
+{
+    enum class IoUringCompletionType : uint8_t
+    {
+        IoUringCompletionType_Accept,
+        IoUringCompletionType_Receive,
+    };
+
+    struct IoUringCompletion
+    {
+        IoUringCompletionType Type;
+        SOCKET Socket;
+        int Result;                     // accept: errno on failure, receive: bytes (0 when the peer closed) or -errno
+        const char* Data = nullptr;     // receive data, valid until the next SubmitAndWait
+    };
+
+    // Completion based socket engine on io_uring. One io_uring_enter per loop submits every queued accept/recv/send/close
+    // and reaps the completions: a multishot accept on the listen socket, a multishot recv per client drawing from a
+    // provided buffer ring, and a linked shutdown/close for sockets that are finishing. Each socket has one send in flight
+    // at a time, the ring doesn't keep separate sends to a socket in order (a short one would be finished after the next).
+    // Drives raw syscalls so there's no liburing dependency, IsSupported decides at runtime whether the kernel can run it.
+    class IoUringEngine
+    {
+    public:
+        IoUringEngine() = default;
+        IoUringEngine(const IoUringEngine& Other) = delete;
+        IoUringEngine& operator=(const IoUringEngine& Other) = delete;
+        ~IoUringEngine();
+
+        static bool IsSupported();
+
+        bool Initialise(SOCKET ListenSocket);
+
+        void ArmReceive(SOCKET Socket);
+
+        // Sends to a socket go out in the order they're queued. Data must stay alive until the send completes unless
+        // bPersistentData is false, in which case it's copied
+        void QueueSend(SOCKET Socket, const char* Data, int DataLen, bool bPersistentData);
+
+        // Several buffers for one socket in a single sendmsg, same lifetime rules per buffer
+        void QueueSend(SOCKET Socket, const SocketSendBuffer* Buffers, int NumBuffers);
+
+        // Bytes handed to QueueSend for the socket whose sends haven't completed yet
+        size_t GetPendingSendBytes(SOCKET Socket);
+
+        // Shuts down and closes the socket once its queued sends have all gone out in full
+        void QueueClose(SOCKET Socket);
+
+        // Stops receiving on a socket that's being handed elsewhere (eg a web socket thread), leaves it open
+        void StopReceive(SOCKET Socket);
+
+        // Submits everything queued, waits up to TimeoutMs for at least one completion
+        int SubmitAndWait(std::vector<IoUringCompletion>& OutCompletions, int TimeoutMs);
+
+        // Any thread, cuts the SubmitAndWait in progress (or the next one) short. Nothing's reported for it
+        void Wake();
+
+#ifdef __linux__
+    private:
+        static constexpr uint32_t NoSendSlot = UINT32_MAX;
+
+        struct SocketState
+        {
+            uint32_t Generation = 0;
+            uint32_t InflightSends = 0;             // submitted or waiting their turn
+            uint32_t FirstWaitingSend = NoSendSlot; // sends queued behind the one in flight, linked through NextWaitingSend
+            uint32_t LastWaitingSend = NoSendSlot;
+            size_t PendingSendBytes = 0;
+            bool bSendInFlight = false;
+            bool bReceiving = false;
+            bool bClosePending = false;
+        };
+
+        struct PendingSend
+        {
+            SOCKET Socket = INVALID_SOCKET;
+            uint32_t Generation = 0;
+            std::vector<iovec> Buffers;     // advanced past on short sends
+            size_t FirstBuffer = 0;
+            size_t TotalBytes = 0;
+            msghdr Message{};
+            uint32_t NextWaitingSend = NoSendSlot;
+            std::vector<char> OwnedData;
+        };
+
+        io_uring_sqe* GetSqe();
+        void SubmitPending(unsigned MinComplete, int TimeoutMs);
+
+        void PrepareAccept();
+        void PrepareReceive(SOCKET Socket);
+        void PrepareSend(uint32_t SendSlot);
+        void PrepareClose(SOCKET Socket);
+        void PrepareWakeRead();
+
+        void HandleCompletion(const io_uring_cqe& Cqe, std::vector<IoUringCompletion>& OutCompletions);
+        void OnSendComplete(uint32_t SendSlot, int Result);
+        void ReleaseSend(uint32_t SendSlot);
+
+        SocketState& GetSocketState(SOCKET Socket);
+        void ProvideBuffer(uint16_t BufferId);
+        void PublishProvidedBuffers();
+
+        int mRingHandle = -1;
+        SOCKET mListenSocket = INVALID_SOCKET;
+
+        // An eventfd always with a read in flight on the ring, written to from other threads to wake the loop
+        int mWakeHandle = -1;
+        uint64_t mWakeCount = 0;
+
+        // submission queue
+        void* mSqRingMemory = nullptr;
+        size_t mSqRingSize = 0;
+        unsigned* mSqHead = nullptr;
+        unsigned* mSqTail = nullptr;
+        unsigned mSqMask = 0;
+        unsigned mSqEntries = 0;
+        unsigned* mSqArray = nullptr;
+        io_uring_sqe* mSqes = nullptr;
+        size_t mSqesSize = 0;
+        unsigned mSqLocalTail = 0;
+        unsigned mSqSubmittedTail = 0;
+
+        // completion queue, shares the submission ring mapping
+        unsigned* mCqHead = nullptr;
+        unsigned* mCqTail = nullptr;
+        unsigned mCqMask = 0;
+        io_uring_cqe* mCqes = nullptr;
+
+        // provided receive buffers
+        io_uring_buf_ring* mBufferRing = nullptr;
+        size_t mBufferRingSize = 0;
+        std::vector<char> mBufferMemory;
+        uint16_t mBufferRingTail = 0;
+        std::vector<uint16_t> mBuffersToRecycle;
+
+        std::vector<SocketState> mSocketStates;
+        std::deque<PendingSend> mPendingSends;     // a deque so queued sendmsg headers don't move before submission
+        std::vector<uint32_t> mFreeSendSlots;
+
+        bool bAcceptArmed = false;
+#endif
+    };
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+namespace WebServer
+{
+    // Unbounded queue any number of threads push to and one thread pops from, without locks. A push is an exchange and a
+    // store so producers never wait on each other or on the consumer (Vyukov's intrusive queue, a stub node keeps the
+    // two ends apart when it's empty). A push caught part way through hides whatever's behind it until it lands, Pop
+    // says empty in the meantime
+    template<typename T>
+    class MpscQueue
+    {
+    public:
+        MpscQueue() = default;
+        MpscQueue(const MpscQueue& Other) = delete;
+        MpscQueue& operator=(const MpscQueue& Other) = delete;
+
+        ~MpscQueue()
+        {
+            NodeLink* Link = mTail;
+            while(Link != nullptr)
+            {
+                NodeLink* Next = Link->Next.load(std::memory_order_relaxed);
+                if(Link != &mStub)
+                {
+                    delete static_cast<Node*>(Link);
+                }
+                Link = Next;
+            }
+        }
+
+        // Any thread
+        void Push(T Value)
+        {
+            PushLink(new Node(std::move(Value)));
+        }
+
+        // Consumer thread only, false when there's nothing (yet) to take
+        bool Pop(T& OutValue)
+        {
+            NodeLink* Tail = mTail;
+            NodeLink* Next = Tail->Next.load(std::memory_order_acquire);
+            if(Tail == &mStub)
+            {
+                if(Next == nullptr)
+                {
+                    return false;
+                }
+                mTail = Next;
+                Tail = Next;
+                Next = Next->Next.load(std::memory_order_acquire);
+            }
+
+            // The last node can't be taken without something behind it, put the stub back there first
+            if(Next == nullptr)
+            {
+                if(Tail != mHead.load(std::memory_order_acquire))
+                {
+                    return false;
+                }
+                PushLink(&mStub);
+                Next = Tail->Next.load(std::memory_order_acquire);
+                if(Next == nullptr)
+                {
+                    return false;
+                }
+            }
+
+            mTail = Next;
+            Node* Popped = static_cast<Node*>(Tail);
+            OutValue = std::move(Popped->Value);
+            delete Popped;
+            return true;
+        }
+
+    private:
+        struct NodeLink
+        {
+            std::atomic<NodeLink*> Next{ nullptr };
+        };
+
+        struct Node : NodeLink
+        {
+            explicit Node(T&& InValue) : Value(std::move(InValue)) {}
+            T Value;
+        };
+
+        void PushLink(NodeLink* Link)
+        {
+            Link->Next.store(nullptr, std::memory_order_relaxed);
+            NodeLink* Previous = mHead.exchange(Link, std::memory_order_acq_rel);
+            Previous->Next.store(Link, std::memory_order_release);
+        }
+
+        NodeLink mStub;
+        std::atomic<NodeLink*> mHead{ &mStub };     // pushed onto by producers
+        NodeLink* mTail = &mStub;                   // popped from by the consumer
+    };
+}
@@ -0,0 +1,477 @@
+#include "MultipartParser.h"
+#include "HttpLineScanner.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define WEBSERVER_MULTIPART_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#else
+#define WEBSERVER_MULTIPART_X86 0
+#endif
+
+// MSVC compiles intrinsics for any target, gcc and clang need the functions using them marked
+#if WEBSERVER_MULTIPART_X86 && !defined(_MSC_VER)
+#define MULTIPART_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define MULTIPART_TARGET_AVX2
+#endif
+
+namespace
+{
+    using namespace WebServer;
+
+    // Part headers are a few short lines, anything like this size isn't a form post
+    constexpr size_t MaxPartHeadersLength = 16 * 1024;
+    constexpr size_t MaxBoundaryLength = 70;
+
+    std::string_view TrimWhitespace(std::string_view Value)
+    {
+        while(Value.empty() == false && (Value.front() == ' ' || Value.front() == '\t'))
+        {
+            Value.remove_prefix(1);
+        }
+        while(Value.empty() == false && (Value.back() == ' ' || Value.back() == '\t'))
+        {
+            Value.remove_suffix(1);
+        }
+        return Value;
+    }
+
+    // The ';' ending the first parameter, skipping any inside a quoted value
+    size_t FindParameterEnd(std::string_view Parameters)
+    {
+        bool bInQuotes = false;
+        for(size_t i = 0; i < Parameters.size(); i++)
+        {
+            if(Parameters[i] == '"')
+            {
+                bInQuotes = !bInQuotes;
+            }
+            else if(Parameters[i] == ';' && bInQuotes == false)
+            {
+                return i;
+            }
+        }
+        return std::string_view::npos;
+    }
+
+    // Value of Key in a "; key=value; key="value"" parameter list (quotes dropped), false if it isn't there
+    bool FindHeaderParameter(std::string_view Parameters, std::string_view Key, std::string_view& OutValue)
+    {
+        while(Parameters.empty() == false)
+        {
+            size_t ParameterEnd = FindParameterEnd(Parameters);
+            std::string_view Parameter = TrimWhitespace(Parameters.substr(0, ParameterEnd));
+            Parameters = (ParameterEnd == std::string_view::npos) ? std::string_view() : Parameters.substr(ParameterEnd + 1);
+
+            size_t Equals = Parameter.find('=');
+            if(Equals == std::string_view::npos || EqualsIgnoreCase(TrimWhitespace(Parameter.substr(0, Equals)), Key) == false)
+            {
+                continue;
+            }
+
+            OutValue = TrimWhitespace(Parameter.substr(Equals + 1));
+            if(OutValue.size() >= 2 && OutValue.front() == '"' && OutValue.back() == '"')
+            {
+                OutValue = OutValue.substr(1, OutValue.size() - 2);
+            }
+            return true;
+        }
+        return false;
+    }
+
+    int FindDelimiterScalar(const char* Data, int DataLen, const char* Delimiter, int DelimiterLen)
+    {
+        const char* Search = Data;
+        const char* SearchEnd = Data + DataLen - DelimiterLen + 1;
+        while(Search < SearchEnd)
+        {
+            Search = (const char*) memchr(Search, Delimiter[0], SearchEnd - Search);
+            if(Search == nullptr)
+            {
+                return -1;
+            }
+            if(memcmp(Search + 1, Delimiter + 1, DelimiterLen - 1) == 0)
+            {
+                return (int) (Search - Data);
+            }
+            Search++;
+        }
+        return -1;
+    }
+
+#if WEBSERVER_MULTIPART_X86
+
+    inline int CountTrailingZeros(uint32_t Mask)
+    {
+#ifdef _MSC_VER
+        unsigned long Index;
+        _BitScanForward(&Index, Mask);
+        return (int) Index;
+#else
+        return __builtin_ctz(Mask);
+#endif
+    }
+
+    inline int CountTrailingZeros64(uint64_t Mask)
+    {
+#ifdef _MSC_VER
+        unsigned long Index;
+        _BitScanForward64(&Index, Mask);
+        return (int) Index;
+#else
+        return __builtin_ctzll(Mask);
+#endif
+    }
+
+    // A block's worth of candidate starts at a time, a start only counts when the delimiter's first byte is there and its
+    // last byte is where it should be. Data is almost never both, so the full compare rarely runs
+    int FindDelimiterSse2(const char* Data, int DataLen, const char* Delimiter, int DelimiterLen)
+    {
+        const __m128i FirstByte = _mm_set1_epi8(Delimiter[0]);
+        const __m128i LastByte = _mm_set1_epi8(Delimiter[DelimiterLen - 1]);
+
+        int i = 0;
+        for(; i + DelimiterLen - 1 + 16 <= DataLen; i += 16)
+        {
+            const __m128i BlockFirst = _mm_loadu_si128((const __m128i*) (Data + i));
+            const __m128i BlockLast = _mm_loadu_si128((const __m128i*) (Data + i + DelimiterLen - 1));
+            uint32_t Candidates = (uint32_t) _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(BlockFirst, FirstByte), _mm_cmpeq_epi8(BlockLast, LastByte)));
+            while(Candidates != 0)
+            {
+                const int Start = i + CountTrailingZeros(Candidates);
+                if(memcmp(Data + Start + 1, Delimiter + 1, DelimiterLen - 2) == 0)
+                {
+                    return Start;
+                }
+                Candidates &= Candidates - 1;
+            }
+        }
+
+        const int Found = FindDelimiterScalar(Data + i, DataLen - i, Delimiter, DelimiterLen);
+        return (Found >= 0) ? i + Found : -1;
+    }
+
+    MULTIPART_TARGET_AVX2 int FindDelimiterAvx2(const char* Data, int DataLen, const char* Delimiter, int DelimiterLen)
+    {
+        const __m256i FirstByte = _mm256_set1_epi8(Delimiter[0]);
+        const __m256i LastByte = _mm256_set1_epi8(Delimiter[DelimiterLen - 1]);
+
+        int i = 0;
+        for(; i + DelimiterLen - 1 + 64 <= DataLen; i += 64)
+        {
+            // Two blocks a step, checked together since neither has a candidate nearly always
+            const __m256i First0 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) (Data + i)), FirstByte);
+            const __m256i Last0 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) (Data + i + DelimiterLen - 1)), LastByte);
+            const __m256i First1 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) (Data + i + 32)), FirstByte);
+            const __m256i Last1 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) (Data + i + 32 + DelimiterLen - 1)), LastByte);
+            const __m256i Matches0 = _mm256_and_si256(First0, Last0);
+            const __m256i Matches1 = _mm256_and_si256(First1, Last1);
+            if(_mm256_testz_si256(_mm256_or_si256(Matches0, Matches1), _mm256_or_si256(Matches0, Matches1)))
+            {
+                continue;
+            }
+
+            uint64_t Candidates = (uint32_t) _mm256_movemask_epi8(Matches0) | ((uint64_t) (uint32_t) _mm256_movemask_epi8(Matches1) << 32);
+            while(Candidates != 0)
+            {
+                const int Start = i + CountTrailingZeros64(Candidates);
+                if(memcmp(Data + Start + 1, Delimiter + 1, DelimiterLen - 2) == 0)
+                {
+                    return Start;
+                }
+                Candidates &= Candidates - 1;
+            }
+        }
+        for(; i + DelimiterLen - 1 + 32 <= DataLen; i += 32)
+        {
+            const __m256i BlockFirst = _mm256_loadu_si256((const __m256i*) (Data + i));
+            const __m256i BlockLast = _mm256_loadu_si256((const __m256i*) (Data + i + DelimiterLen - 1));
+            uint32_t Candidates = (uint32_t) _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(BlockFirst, FirstByte), _mm256_cmpeq_epi8(BlockLast, LastByte)));
+            while(Candidates != 0)
+            {
+                const int Start = i + CountTrailingZeros(Candidates);
+                if(memcmp(Data + Start + 1, Delimiter + 1, DelimiterLen - 2) == 0)
+                {
+                    return Start;
+                }
+                Candidates &= Candidates - 1;
+            }
+        }
+
+        const int Found = FindDelimiterSse2(Data + i, DataLen - i, Delimiter, DelimiterLen);
+        return (Found >= 0) ? i + Found : -1;
+    }
+
+#endif  // WEBSERVER_MULTIPART_X86
+}
+
+namespace WebServer
+{
+    bool MultipartParser::FindBoundary(std::string_view ContentType, std::string_view& OutBoundary)
+    {
+        constexpr std::string_view MultipartPrefix = "multipart/";
+        if(ContentType.size() < MultipartPrefix.size() || EqualsIgnoreCase(ContentType.substr(0, MultipartPrefix.size()), MultipartPrefix) == false)
+        {
+            return false;
+        }
+
+        // No CR or LF can be in one, the delimiter search relies on its CR being the only one
+        size_t ParametersStart = ContentType.find(';');
+        return ParametersStart != std::string_view::npos && FindHeaderParameter(ContentType.substr(ParametersStart + 1), "boundary", OutBoundary)
+            && OutBoundary.empty() == false && OutBoundary.size() <= MaxBoundaryLength && OutBoundary.find_first_of("\r\n") == std::string_view::npos;
+    }
+
+    void MultipartParser::Start(std::string_view Boundary, PartStartFunc OnPartStart, PartDataFunc OnPartData, PartEndFunc OnPartEnd)
+    {
+        mDelimiter = "\r\n--";
+        mDelimiter.append(Boundary.data(), Boundary.size());
+
+        // Shares the request line scanner's pick of what the cpu can do
+#if WEBSERVER_MULTIPART_X86
+        switch(GetHttpScanImplementation())
+        {
+            case HttpScanImplementation::HttpScanImplementation_Avx2:
+                mSearch = &FindDelimiterAvx2;
+                break;
+            case HttpScanImplementation::HttpScanImplementation_Sse42:
+                mSearch = &FindDelimiterSse2;
+                break;
+            default:
+                mSearch = &FindDelimiterScalar;
+                break;
+        }
+#else
+        mSearch = &FindDelimiterScalar;
+#endif
+
+        mOnPartStart = std::move(OnPartStart);
+        mOnPartData = std::move(OnPartData);
+        mOnPartEnd = std::move(OnPartEnd);
+
+        // The first boundary needn't follow a line break, start as though one had just been read
+        mPhase = MultipartParsePhase::MultipartParsePhase_Preamble;
+        mMatchedLength = 2;
+        mHeaderData.clear();
+    }
+
+    bool MultipartParser::Feed(const char* Data, int DataLen)
+    {
+        int Offset = 0;
+        while(Offset < DataLen)
+        {
+            int Used = 0;
+            switch(mPhase)
+            {
+                case MultipartParsePhase::MultipartParsePhase_Preamble:
+                case MultipartParsePhase::MultipartParsePhase_Data:
+                    Used = FeedData(Data + Offset, DataLen - Offset);
+                    break;
+
+                case MultipartParsePhase::MultipartParsePhase_Headers:
+                    Used = FeedHeaders(Data + Offset, DataLen - Offset);
+                    break;
+
+                case MultipartParsePhase::MultipartParsePhase_AfterBoundary:
+                {
+                    const char c = Data[Offset];
+                    Used = 1;
+                    if(c == '-')
+                    {
+                        mPhase = MultipartParsePhase::MultipartParsePhase_CloseBoundary;
+                    }
+                    else if(c == '\n')
+                    {
+                        mHeaderData.clear();
+                        mPhase = MultipartParsePhase::MultipartParsePhase_Headers;
+                    }
+                    else if(c != ' ' && c != '\t' && c != '\r')
+                    {
+                        mPhase = MultipartParsePhase::MultipartParsePhase_Malformed;
+                    }
+                    break;
+                }
+
+                case MultipartParsePhase::MultipartParsePhase_CloseBoundary:
+                    mPhase = (Data[Offset] == '-') ? MultipartParsePhase::MultipartParsePhase_Epilogue : MultipartParsePhase::MultipartParsePhase_Malformed;
+                    Used = 1;
+                    break;
+
+                case MultipartParsePhase::MultipartParsePhase_Epilogue:
+                    return true;
+
+                case MultipartParsePhase::MultipartParsePhase_Malformed:
+                    return false;
+            }
+
+            if(Used < 0)
+            {
+                mPhase = MultipartParsePhase::MultipartParsePhase_Malformed;
+                return false;
+            }
+            Offset += Used;
+        }
+        return mPhase != MultipartParsePhase::MultipartParsePhase_Malformed;
+    }
+
+    int MultipartParser::FeedData(const char* Data, int DataLen)
+    {
+        const int DelimiterLen = (int) mDelimiter.size();
+        int Offset = 0;
+
+        // Finish off a delimiter that began at the end of the last call
+        if(mMatchedLength > 0)
+        {
+            while(Offset < DataLen && mMatchedLength < DelimiterLen && Data[Offset] == mDelimiter[mMatchedLength])
+            {
+                Offset++;
+                mMatchedLength++;
+            }
+
+            if(mMatchedLength < DelimiterLen && Offset == DataLen)
+            {
+                return Offset;
+            }
+
+            const int HeldLength = mMatchedLength;
+            mMatchedLength = 0;
+            if(HeldLength == DelimiterLen)
+            {
+                if(mPhase == MultipartParsePhase::MultipartParsePhase_Data && mOnPartEnd && mOnPartEnd() == false)
+                {
+                    return -1;
+                }
+                mPhase = MultipartParsePhase::MultipartParsePhase_AfterBoundary;
+                return Offset;
+            }
+
+            // It wasn't one, what was held back is data. The delimiter's only CR is its first byte, so none of it can
+            // start another
+            if(EmitData(mDelimiter.data(), HeldLength) == false)
+            {
+                return -1;
+            }
+        }
+
+        const int Found = mSearch(Data + Offset, DataLen - Offset, mDelimiter.data(), DelimiterLen);
+        if(Found >= 0)
+        {
+            if(EmitData(Data + Offset, Found) == false || (mPhase == MultipartParsePhase::MultipartParsePhase_Data && mOnPartEnd && mOnPartEnd() == false))
+            {
+                return -1;
+            }
+            mPhase = MultipartParsePhase::MultipartParsePhase_AfterBoundary;
+            return Offset + Found + DelimiterLen;
+        }
+
+        // The end might be the start of a delimiter, which would begin at the last CR. Held back until the next call says
+        int DataEnd = DataLen;
+        for(int i = DataLen - 1; i >= std::max(Offset, DataLen - DelimiterLen + 1); i--)
+        {
+            if(Data[i] == '\r')
+            {
+                if(memcmp(Data + i, mDelimiter.data(), DataLen - i) == 0)
+                {
+                    DataEnd = i;
+                    mMatchedLength = DataLen - i;
+                }
+                break;
+            }
+        }
+
+        return EmitData(Data + Offset, DataEnd - Offset) ? DataLen : -1;
+    }
+
+    int MultipartParser::FeedHeaders(const char* Data, int DataLen)
+    {
+        // A line at a time until a blank one, the part's data follows it
+        int Offset = 0;
+        while(Offset < DataLen)
+        {
+            const char* LineEnd = (const char*) memchr(Data + Offset, '\n', DataLen - Offset);
+            const int Used = (int) (((LineEnd != nullptr) ? LineEnd + 1 : Data + DataLen) - (Data + Offset));
+            mHeaderData.append(Data + Offset, Used);
+            Offset += Used;
+
+            if(mHeaderData.size() > MaxPartHeadersLength)
+            {
+                return -1;
+            }
+            if(LineEnd == nullptr)
+            {
+                break;
+            }
+
+            const size_t LineStart = (mHeaderData.size() >= 2) ? mHeaderData.rfind('\n', mHeaderData.size() - 2) : std::string::npos;
+            const std::string_view Line = std::string_view(mHeaderData).substr((LineStart == std::string::npos) ? 0 : LineStart + 1);
+            if(Line == "\n" || Line == "\r\n")
+            {
+                if(ParsePartHeaders() == false)
+                {
+                    return -1;
+                }
+                mPhase = MultipartParsePhase::MultipartParsePhase_Data;
+                return Offset;
+            }
+        }
+        return Offset;
+    }
+
+    bool MultipartParser::ParsePartHeaders()
+    {
+        mPart = MultipartPart{};
+
+        size_t LineStart = 0;
+        while(LineStart < mHeaderData.size())
+        {
+            size_t LineEnd = mHeaderData.find('\n', LineStart);
+            std::string_view Line = std::string_view(mHeaderData).substr(LineStart, LineEnd - LineStart);
+            if(Line.empty() == false && Line.back() == '\r')
+            {
+                Line.remove_suffix(1);
+            }
+
+            if(Line.empty() == false)
+            {
+                const size_t Colon = Line.find(':');
+                if(Colon == 0 || Colon == std::string_view::npos)
+                {
+                    return false;
+                }
+
+                const std::string_view Key = Line.substr(0, Colon);
+                const std::string_view Value = TrimWhitespace(Line.substr(Colon + 1));
+                mPart.Headers.Add(FindHttpHeader(Key), (int) (Key.data() - mHeaderData.data()), (int) Key.size(), (int) (Value.data() - mHeaderData.data()), (int) Value.size());
+            }
+            LineStart = LineEnd + 1;
+        }
+        mPart.Headers.Bind(mHeaderData.data());
+
+        mPart.Headers.Find(HttpHeader::HttpHeader_ContentType, mPart.ContentType);
+
+        std::string_view Disposition;
+        if(mPart.Headers.Find("Content-Disposition", Disposition))
+        {
+            FindHeaderParameter(Disposition, "name", mPart.Name);
+            FindHeaderParameter(Disposition, "filename", mPart.FileName);
+        }
+
+        return mOnPartStart == nullptr || mOnPartStart(mPart);
+    }
+
+    bool MultipartParser::EmitData(const char* Data, int DataLen)
+    {
+        // The preamble's only there for mail readers, it's dropped
+        if(mPhase != MultipartParsePhase::MultipartParsePhase_Data || DataLen <= 0 || mOnPartData == nullptr)
+        {
+            return true;
+        }
+        return mOnPartData(Data, DataLen);
+    }
+}
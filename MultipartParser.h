@@ -0,0 +1,73 @@
+#pragma once
+
+#include "HttpHeaders.h"
+
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace WebServer
+{
+    // One part of a multipart/form-data body as its headers arrive, views valid for the call
+    struct MultipartPart
+    {
+        std::string_view Name;          // Content-Disposition's name
+        std::string_view FileName;      // and filename, empty unless the part's a file
+        std::string_view ContentType;   // empty if not given (text/plain)
+        RequestHeaderList Headers;
+    };
+
+    enum class MultipartParsePhase
+    {
+        MultipartParsePhase_Preamble,
+        MultipartParsePhase_AfterBoundary,     // transport padding and CRLF, or "--" for the last one
+        MultipartParsePhase_CloseBoundary,
+        MultipartParsePhase_Headers,
+        MultipartParsePhase_Data,
+        MultipartParsePhase_Epilogue,          // after the last boundary, ignored
+        MultipartParsePhase_Malformed,
+    };
+
+    // Splits a multipart body into parts as it streams in, each part's data is handed on as it's found and nothing but a
+    // part's headers (and a delimiter's worth of bytes that might be the start of one) is held across calls.
+    // Delimiters are found with a vector search for their first and last bytes, checked in full only where both match
+    class MultipartParser
+    {
+    public:
+        // False from any of them stops the parse
+        typedef std::function<bool(const MultipartPart&)> PartStartFunc;
+        typedef std::function<bool(const char*, int)> PartDataFunc;
+        typedef std::function<bool()> PartEndFunc;
+
+        // The boundary parameter of a multipart Content-Type, false if there isn't a usable one
+        static bool FindBoundary(std::string_view ContentType, std::string_view& OutBoundary);
+
+        // Copies the boundary, the view can go once this returns
+        void Start(std::string_view Boundary, PartStartFunc OnPartStart, PartDataFunc OnPartData, PartEndFunc OnPartEnd);
+
+        // False once the body's malformed or a callback's stopped it, true otherwise (even past the last part)
+        bool Feed(const char* Data, int DataLen);
+
+        MultipartParsePhase GetPhase() const { return mPhase; }
+        bool IsComplete() const { return mPhase == MultipartParsePhase::MultipartParsePhase_Epilogue; }
+
+    private:
+        typedef int (*DelimiterSearchFunc)(const char* Data, int DataLen, const char* Delimiter, int DelimiterLen);
+
+        int FeedData(const char* Data, int DataLen);
+        int FeedHeaders(const char* Data, int DataLen);
+        bool ParsePartHeaders();
+        bool EmitData(const char* Data, int DataLen);
+
+        std::string mDelimiter;         // CRLF "--" boundary
+        DelimiterSearchFunc mSearch = nullptr;
+        PartStartFunc mOnPartStart;
+        PartDataFunc mOnPartData;
+        PartEndFunc mOnPartEnd;
+
+        MultipartParsePhase mPhase = MultipartParsePhase::MultipartParsePhase_Preamble;
+        int mMatchedLength = 0;         // of a delimiter that began at the end of the last call, held back until it's known
+        std::string mHeaderData;        // the current part's headers so far
+        MultipartPart mPart;
+    };
+}
@@ -0,0 +1,170 @@
+#include "RequestBodyDecoder.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    // A chunk size past 15 hex digits could overflow, and nothing legitimate needs lines this long
+    constexpr int MaxChunkSizeDigits = 15;
+    constexpr int MaxChunkSizeLineLength = 4 * 1024;
+    constexpr int MaxTrailersLength = 64 * 1024;
+
+    int GetHexDigitValue(char c)
+    {
+        if(c >= '0' && c <= '9') { return c - '0'; }
+        if(c >= 'a' && c <= 'f') { return c - 'a' + 10; }
+        if(c >= 'A' && c <= 'F') { return c - 'A' + 10; }
+        return -1;
+    }
+}
+
+namespace WebServer
+{
+    void RequestBodyDecoder::Start(bool bInChunked, int64_t ContentLength)
+    {
+        *this = RequestBodyDecoder{};
+        bChunked = bInChunked;
+        mRemaining = bChunked ? 0 : ContentLength;
+        mState = (bChunked || ContentLength > 0) ? RequestBodyState::RequestBodyState_Reading : RequestBodyState::RequestBodyState_Complete;
+    }
+
+    int RequestBodyDecoder::Decode(const char* Data, int DataLen, const BodyDataFunc& OnBodyData)
+    {
+        if(mState != RequestBodyState::RequestBodyState_Reading || DataLen <= 0)
+        {
+            return 0;
+        }
+
+        if(bChunked)
+        {
+            return DecodeChunked(Data, DataLen, OnBodyData);
+        }
+
+        const int BodyBytes = (int) std::min<int64_t>(mRemaining, DataLen);
+        if(OnBodyData && OnBodyData(Data, BodyBytes) == false)
+        {
+            mState = RequestBodyState::RequestBodyState_Refused;
+        }
+        mRemaining -= BodyBytes;
+        mNumBodyBytes += BodyBytes;
+        if(mRemaining == 0 && mState == RequestBodyState::RequestBodyState_Reading)
+        {
+            mState = RequestBodyState::RequestBodyState_Complete;
+        }
+        return BodyBytes;
+    }
+
+    int RequestBodyDecoder::DecodeChunked(const char* Data, int DataLen, const BodyDataFunc& OnBodyData)
+    {
+        int Offset = 0;
+        while(Offset < DataLen && mState == RequestBodyState::RequestBodyState_Reading)
+        {
+            switch(mChunkPhase)
+            {
+                case ChunkPhase::ChunkPhase_Size:
+                {
+                    const char c = Data[Offset++];
+                    const int DigitValue = GetHexDigitValue(c);
+                    if(DigitValue >= 0)
+                    {
+                        // Refused before the digit's added, a 16th could overflow mRemaining
+                        if(++mNumSizeDigits > MaxChunkSizeDigits)
+                        {
+                            mState = RequestBodyState::RequestBodyState_Malformed;
+                            break;
+                        }
+                        mRemaining = mRemaining * 16 + DigitValue;
+                        mLineLength++;
+                    }
+                    else if(mNumSizeDigits == 0 || (c != ';' && c != ' ' && c != '\t' && c != '\r' && c != '\n'))
+                    {
+                        mState = RequestBodyState::RequestBodyState_Malformed;
+                    }
+                    else
+                    {
+                        // Extensions aren't used for anything, the rest of the line is skipped
+                        Offset--;
+                        mChunkPhase = ChunkPhase::ChunkPhase_SizeLine;
+                    }
+                    break;
+                }
+                case ChunkPhase::ChunkPhase_SizeLine:
+                {
+                    const char* LineEnd = (const char*) memchr(Data + Offset, '\n', DataLen - Offset);
+                    const int LineBytes = (int) (((LineEnd != nullptr) ? LineEnd : Data + DataLen) - (Data + Offset));
+                    mLineLength += LineBytes;
+                    Offset += LineBytes;
+                    if(mLineLength > MaxChunkSizeLineLength)
+                    {
+                        mState = RequestBodyState::RequestBodyState_Malformed;
+                    }
+                    else if(LineEnd != nullptr)
+                    {
+                        Offset++;
+                        mLineLength = 0;
+                        mNumSizeDigits = 0;
+                        mChunkPhase = (mRemaining > 0) ? ChunkPhase::ChunkPhase_Data : ChunkPhase::ChunkPhase_Trailers;
+                    }
+                    break;
+                }
+                case ChunkPhase::ChunkPhase_Data:
+                {
+                    const int BodyBytes = (int) std::min<int64_t>(mRemaining, DataLen - Offset);
+                    if(OnBodyData && OnBodyData(Data + Offset, BodyBytes) == false)
+                    {
+                        mState = RequestBodyState::RequestBodyState_Refused;
+                    }
+                    Offset += BodyBytes;
+                    mRemaining -= BodyBytes;
+                    mNumBodyBytes += BodyBytes;
+                    if(mRemaining == 0)
+                    {
+                        bSawCarriageReturn = false;
+                        mChunkPhase = ChunkPhase::ChunkPhase_DataEnd;
+                    }
+                    break;
+                }
+                case ChunkPhase::ChunkPhase_DataEnd:
+                {
+                    const char c = Data[Offset++];
+                    if(c == '\r' && bSawCarriageReturn == false)
+                    {
+                        bSawCarriageReturn = true;
+                    }
+                    else if(c == '\n')
+                    {
+                        mChunkPhase = ChunkPhase::ChunkPhase_Size;
+                    }
+                    else
+                    {
+                        mState = RequestBodyState::RequestBodyState_Malformed;
+                    }
+                    break;
+                }
+                case ChunkPhase::ChunkPhase_Trailers:
+                {
+                    // Trailer fields are read past rather than kept, a blank line ends the body
+                    const char c = Data[Offset++];
+                    if(++mTrailerBytes > MaxTrailersLength)
+                    {
+                        mState = RequestBodyState::RequestBodyState_Malformed;
+                    }
+                    else if(c == '\n')
+                    {
+                        const bool bBlankLine = mLineLength == 0 || (mLineLength == 1 && bSawCarriageReturn);
+                        mState = bBlankLine ? RequestBodyState::RequestBodyState_Complete : mState;
+                        mLineLength = 0;
+                    }
+                    else
+                    {
+                        mLineLength++;
+                    }
+                    bSawCarriageReturn = c == '\r';
+                    break;
+                }
+            }
+        }
+        return Offset;
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+namespace WebServer
+{
+    enum class RequestBodyState
+    {
+        RequestBodyState_Reading,
+        RequestBodyState_Complete,
+        RequestBodyState_Malformed,
+        RequestBodyState_Refused,       // whatever it was handed to wanted no more of it
+    };
+
+    // Takes a request body's framing (a Content-Length or chunked transfer coding) off as its bytes arrive, handing the
+    // body on a piece at a time. Works through whatever it's given and remembers where it got to, the caller can drop
+    // the bytes as soon as they've been decoded so nothing is held however long the body is.
+    class RequestBodyDecoder
+    {
+    public:
+        // Body bytes, only valid for the call. False stops the body there
+        typedef std::function<bool(const char*, int)> BodyDataFunc;
+
+        // Length is ignored for a chunked body
+        void Start(bool bChunked, int64_t ContentLength);
+
+        // Returns how many of Data's bytes belong to the body, all of them unless it finishes part way through.
+        // OnBodyData can be empty, the body's then just skipped over
+        int Decode(const char* Data, int DataLen, const BodyDataFunc& OnBodyData);
+
+        RequestBodyState GetState() const { return mState; }
+        bool IsFinished() const { return mState != RequestBodyState::RequestBodyState_Reading; }
+
+        // Body bytes handed on so far, framing not included
+        int64_t GetNumBodyBytes() const { return mNumBodyBytes; }
+
+    private:
+        enum class ChunkPhase
+        {
+            ChunkPhase_Size,            // hex digits
+            ChunkPhase_SizeLine,        // extensions up to the size line's '\n'
+            ChunkPhase_Data,
+            ChunkPhase_DataEnd,         // the CRLF after a chunk's data
+            ChunkPhase_Trailers,        // header lines after the last chunk, up to a blank one
+        };
+
+        int DecodeChunked(const char* Data, int DataLen, const BodyDataFunc& OnBodyData);
+
+        RequestBodyState mState = RequestBodyState::RequestBodyState_Complete;
+        bool bChunked = false;
+        int64_t mRemaining = 0;         // of the body, or of the current chunk's data
+        int64_t mNumBodyBytes = 0;
+
+        ChunkPhase mChunkPhase = ChunkPhase::ChunkPhase_Size;
+        int mNumSizeDigits = 0;
+        int mLineLength = 0;            // of the size or trailer line so far
+        bool bSawCarriageReturn = false;
+        int mTrailerBytes = 0;
+    };
+}
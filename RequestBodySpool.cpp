@@ -0,0 +1,272 @@
+#include "RequestBodySpool.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifndef _WIN32
+    // Every byte or an error, write() can stop short
+    bool WriteAll(int File, const char* Data, size_t DataLen)
+    {
+        while(DataLen > 0)
+        {
+            ssize_t Written = write(File, Data, DataLen);
+            if(Written < 0)
+            {
+                if(errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            Data += Written;
+            DataLen -= (size_t) Written;
+        }
+        return true;
+    }
+#endif
+}
+
+namespace WebServer
+{
+    SpooledRequestBody::SpooledRequestBody(SpooledRequestBody&& Other) noexcept
+    {
+        *this = std::move(Other);
+    }
+
+    SpooledRequestBody& SpooledRequestBody::operator=(SpooledRequestBody&& Other) noexcept
+    {
+        Release();
+
+        mBuffer = std::move(Other.mBuffer);
+        mMemoryBudget = Other.mMemoryBudget;
+        mMaxBodyBytes = Other.mMaxBodyBytes;
+        mSize = Other.mSize;
+        mDirectory = std::move(Other.mDirectory);
+        bHasFile = std::exchange(Other.bHasFile, false);
+        mFile = Other.mFile;
+        mMappedData = std::exchange(Other.mMappedData, nullptr);
+#ifdef _WIN32
+        mFileMapping = std::exchange(Other.mFileMapping, nullptr);
+#endif
+        bFailed = Other.bFailed;
+        bOverLimit = Other.bOverLimit;
+
+        Other.mSize = 0;
+        return *this;
+    }
+
+    SpooledRequestBody::~SpooledRequestBody()
+    {
+        Release();
+    }
+
+    void SpooledRequestBody::Start(size_t MemoryBudget, int64_t MaxBodyBytes, const std::string& Directory)
+    {
+        Release();
+        mBuffer.clear();
+        mMemoryBudget = std::max<size_t>(MemoryBudget, 4 * 1024);
+        mMaxBodyBytes = MaxBodyBytes;
+        mSize = 0;
+        mDirectory = Directory;
+        bFailed = false;
+        bOverLimit = false;
+    }
+
+    bool SpooledRequestBody::Append(const char* Data, int DataLen)
+    {
+        if(bFailed)
+        {
+            return false;
+        }
+
+        if(mSize + DataLen > mMaxBodyBytes)
+        {
+            bOverLimit = true;
+            bFailed = true;
+            return false;
+        }
+
+        while(DataLen > 0)
+        {
+            // A full buffer goes to the file in one write, the body never has more than the budget in memory
+            if(mBuffer.size() == mMemoryBudget && FlushBuffer() == false)
+            {
+                bFailed = true;
+                return false;
+            }
+
+            // Grown as the body arrives rather than up front, most bodies are small
+            const size_t CopyLen = std::min((size_t) DataLen, mMemoryBudget - mBuffer.size());
+            if(mBuffer.capacity() < mBuffer.size() + CopyLen)
+            {
+                mBuffer.reserve(std::min(std::max(mBuffer.capacity() * 2, mBuffer.size() + CopyLen), mMemoryBudget));
+            }
+            mBuffer.insert(mBuffer.end(), Data, Data + CopyLen);
+
+            Data += CopyLen;
+            DataLen -= (int) CopyLen;
+            mSize += (int64_t) CopyLen;
+        }
+        return true;
+    }
+
+    bool SpooledRequestBody::Finish()
+    {
+        if(bFailed)
+        {
+            return false;
+        }
+
+        if(bHasFile)
+        {
+            if(FlushBuffer() == false)
+            {
+                bFailed = true;
+                return false;
+            }
+            std::vector<char>().swap(mBuffer);
+        }
+        return true;
+    }
+
+    const char* SpooledRequestBody::GetData()
+    {
+        if(mSize == 0)
+        {
+            return nullptr;
+        }
+        if(bHasFile == false)
+        {
+            return mBuffer.data();
+        }
+        if(mMappedData != nullptr)
+        {
+            return mMappedData;
+        }
+
+#ifdef _WIN32
+        mFileMapping = CreateFileMappingA(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        if(mFileMapping != nullptr)
+        {
+            mMappedData = (const char*) MapViewOfFile(mFileMapping, FILE_MAP_READ, 0, 0, 0);
+        }
+#else
+        void* MappedData = mmap(nullptr, (size_t) mSize, PROT_READ, MAP_PRIVATE, mFile, 0);
+        mMappedData = (MappedData != MAP_FAILED) ? (const char*) MappedData : nullptr;
+#endif
+        return mMappedData;
+    }
+
+    bool SpooledRequestBody::OpenFile()
+    {
+#ifdef _WIN32
+        char TempDirectory[MAX_PATH];
+        if(mDirectory.empty() == false)
+        {
+            strncpy_s(TempDirectory, mDirectory.c_str(), _TRUNCATE);
+        }
+        else if(GetTempPathA(MAX_PATH, TempDirectory) == 0)
+        {
+            return false;
+        }
+
+        char TempFileName[MAX_PATH];
+        if(GetTempFileNameA(TempDirectory, "wsb", 0, TempFileName) == 0)
+        {
+            return false;
+        }
+
+        // Deleted by the system once the last handle to it closes
+        HANDLE File = CreateFileA(TempFileName, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+            FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if(File == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+        mFile = File;
+#else
+        std::string Directory = mDirectory;
+        if(Directory.empty())
+        {
+            const char* TempDirectory = getenv("TMPDIR");
+            Directory = (TempDirectory != nullptr && TempDirectory[0] != '\0') ? TempDirectory : "/tmp";
+        }
+
+        int File = -1;
+#ifdef O_TMPFILE
+        // Never has a name, nothing to clean up if the process dies part way
+        File = open(Directory.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+#endif
+        if(File == -1)
+        {
+            std::string TempFileName = Directory + "/webserver-body-XXXXXX";
+            File = mkstemp(&TempFileName[0]);
+            if(File == -1)
+            {
+                return false;
+            }
+            unlink(TempFileName.c_str());
+        }
+        mFile = File;
+#endif
+        bHasFile = true;
+        return true;
+    }
+
+    bool SpooledRequestBody::FlushBuffer()
+    {
+        if(bHasFile == false && OpenFile() == false)
+        {
+            return false;
+        }
+        if(mBuffer.empty())
+        {
+            return true;
+        }
+
+#ifdef _WIN32
+        DWORD Written = 0;
+        bool bWritten = WriteFile(mFile, mBuffer.data(), (DWORD) mBuffer.size(), &Written, NULL) && Written == mBuffer.size();
+#else
+        bool bWritten = WriteAll(mFile, mBuffer.data(), mBuffer.size());
+#endif
+        mBuffer.clear();
+        return bWritten;
+    }
+
+    void SpooledRequestBody::Release()
+    {
+        if(bHasFile == false)
+        {
+            return;
+        }
+
+#ifdef _WIN32
+        if(mMappedData != nullptr) { UnmapViewOfFile(mMappedData); }
+        if(mFileMapping != nullptr) { CloseHandle(mFileMapping); }
+        mFileMapping = nullptr;
+        CloseHandle(mFile);
+#else
+        if(mMappedData != nullptr) { munmap((void*) mMappedData, (size_t) mSize); }
+        close(mFile);
+#endif
+        mMappedData = nullptr;
+        bHasFile = false;
+    }
+}
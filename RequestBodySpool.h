@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace WebServer
+{
+#ifdef _WIN32
+    typedef void* SpoolFileHandle;      // HANDLE
+#else
+    typedef int SpoolFileHandle;
+#endif
+
+    // A request body gathered whole for its handler without holding more than a fixed budget of it in memory. It stays in
+    // memory while it fits, past that the buffer becomes a write buffer for an unnamed temp file, flushed a full buffer
+    // at a time so the disk sees large sequential writes. The file goes away with the spool (or whoever it's moved to).
+    class SpooledRequestBody
+    {
+    public:
+        SpooledRequestBody() = default;
+        SpooledRequestBody(const SpooledRequestBody& Other) = delete;
+        SpooledRequestBody& operator=(const SpooledRequestBody& Other) = delete;
+        SpooledRequestBody(SpooledRequestBody&& Other) noexcept;
+        SpooledRequestBody& operator=(SpooledRequestBody&& Other) noexcept;
+        ~SpooledRequestBody();
+
+        // Directory is where the temp file goes, the system's temp directory if empty
+        void Start(size_t MemoryBudget, int64_t MaxBodyBytes, const std::string& Directory);
+
+        // False once the body's gone over its limit or the file couldn't be written, anything after is dropped
+        bool Append(const char* Data, int DataLen);
+
+        // Writes out what's left in the buffer and frees it, the body's readable after this
+        bool Finish();
+
+        bool IsFailed() const { return bFailed; }
+        bool IsOverLimit() const { return bOverLimit; }
+
+        int64_t GetSize() const { return mSize; }
+        bool IsInMemory() const { return bHasFile == false; }
+
+        // The whole body in one view, mapped read-only on first call when it's in a file. nullptr for an empty body or
+        // if the mapping fails
+        const char* GetData();
+
+        // The temp file for reading it directly (pread, ReadFile), only valid while IsInMemory is false
+        SpoolFileHandle GetFileHandle() const { return mFile; }
+
+    private:
+        bool OpenFile();
+        bool FlushBuffer();
+        void Release();
+
+        std::vector<char> mBuffer;
+        size_t mMemoryBudget = 0;
+        int64_t mMaxBodyBytes = 0;
+        int64_t mSize = 0;
+        std::string mDirectory;
+
+        bool bHasFile = false;
+        SpoolFileHandle mFile{};
+        const char* mMappedData = nullptr;
+#ifdef _WIN32
+        void* mFileMapping = nullptr;
+#endif
+
+        bool bFailed = false;
+        bool bOverLimit = false;
+    };
+}
@@ -0,0 +1,67 @@
+#include "RequestHandlerPool.h"
+
+#include <algorithm>
+
+namespace WebServer
+{
+    RequestHandlerPool::~RequestHandlerPool()
+    {
+        Stop();
+    }
+
+    void RequestHandlerPool::Start(int NumThreads)
+    {
+        bStopping = false;
+        for(int i = 0; i < std::max(NumThreads, 1); i++)
+        {
+            mThreads.emplace_back(&RequestHandlerPool::HandlerThread, this);
+        }
+    }
+
+    void RequestHandlerPool::Stop()
+    {
+        {
+            std::lock_guard<std::mutex> JobsLock(mJobsMutex);
+            bStopping = true;
+        }
+        mJobQueued.notify_all();
+
+        for(std::thread& Thread : mThreads)
+        {
+            Thread.join();
+        }
+        mThreads.clear();
+    }
+
+    void RequestHandlerPool::QueueJob(Job NewJob)
+    {
+        {
+            std::lock_guard<std::mutex> JobsLock(mJobsMutex);
+            if(bStopping)
+            {
+                return;
+            }
+            mJobs.push_back(std::move(NewJob));
+        }
+        mJobQueued.notify_one();
+    }
+
+    void RequestHandlerPool::HandlerThread()
+    {
+        while(true)
+        {
+            Job NextJob;
+            {
+                std::unique_lock<std::mutex> JobsLock(mJobsMutex);
+                mJobQueued.wait(JobsLock, [this] () { return mJobs.empty() == false || bStopping; });
+                if(mJobs.empty())
+                {
+                    return;
+                }
+                NextJob = std::move(mJobs.front());
+                mJobs.pop_front();
+            }
+            NextJob();
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace WebServer
+{
+    // Threads that run request handlers away from the event loops, so a slow one holds up its own request and nothing
+    // else. Jobs start in the order they're queued, as many at once as there are threads
+    class RequestHandlerPool
+    {
+    public:
+        typedef std::function<void()> Job;
+
+        RequestHandlerPool() = default;
+        RequestHandlerPool(const RequestHandlerPool& Other) = delete;
+        RequestHandlerPool& operator=(const RequestHandlerPool& Other) = delete;
+        ~RequestHandlerPool();
+
+        void Start(int NumThreads);
+
+        // Runs whatever's already queued, then joins the threads. Jobs queued after this are dropped
+        void Stop();
+
+        // Any thread
+        void QueueJob(Job NewJob);
+
+        bool IsRunning() const { return mThreads.empty() == false; }
+
+    private:
+        void HandlerThread();
+
+        std::vector<std::thread> mThreads;
+        std::deque<Job> mJobs;
+        std::mutex mJobsMutex;
+        std::condition_variable mJobQueued;
+        bool bStopping = false;
+    };
+}
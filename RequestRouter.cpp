@@ -0,0 +1,296 @@
+#include "RequestRouter.h"
+
+#include <cstring>
+
+namespace
+{
+    bool IsParamStart(std::string_view Pattern, size_t Offset)
+    {
+        return Offset > 0 && Pattern[Offset - 1] == '/' && (Pattern[Offset] == ':' || Pattern[Offset] == '*');
+    }
+
+    // Where the parameter starting at Offset ends, a wildcard's runs to the end
+    size_t GetParamEnd(std::string_view Pattern, size_t Offset)
+    {
+        const size_t SegmentEnd = Pattern.find('/', Offset);
+        return (Pattern[Offset] == '*' || SegmentEnd == std::string_view::npos) ? Pattern.size() : SegmentEnd;
+    }
+
+    bool IsValidPattern(std::string_view Pattern)
+    {
+        if(Pattern.empty() || Pattern[0] != '/')
+        {
+            return false;
+        }
+
+        int NumParams = 0;
+        for(size_t Offset = 1; Offset < Pattern.size(); Offset++)
+        {
+            if(IsParamStart(Pattern, Offset) == false)
+            {
+                continue;
+            }
+
+            const size_t ParamEnd = GetParamEnd(Pattern, Offset);
+            const std::string_view Name = Pattern.substr(Offset + 1, ParamEnd - Offset - 1);
+            const bool bWildcard = Pattern[Offset] == '*';
+            if((bWildcard == false && Name.empty()) || (bWildcard && Name.find('/') != std::string_view::npos) || ++NumParams > WebServer::RouteParams::MaxParams)
+            {
+                return false;
+            }
+            Offset = ParamEnd;
+        }
+        return true;
+    }
+}
+
+namespace WebServer
+{
+    std::string_view RouteParams::Find(std::string_view Name) const
+    {
+        for(int i = 0; i < NumParams; i++)
+        {
+            if(Params[i].Name == Name)
+            {
+                return Params[i].Value;
+            }
+        }
+        return {};
+    }
+
+    bool RequestRouter::AddRoute(ServerRequestType Method, std::string_view Pattern, uint32_t RouteId)
+    {
+        const int MethodIndex = (int) Method;
+        if(MethodIndex < 0 || MethodIndex >= MaxMethods || RouteId == NoRoute || IsValidPattern(Pattern) == false)
+        {
+            return false;
+        }
+
+        if(mRoots[MethodIndex] == NoNode)
+        {
+            mRoots[MethodIndex] = AddNode(RouteNodeType::RouteNodeType_Static, {});
+        }
+
+        uint32_t NodeIndex = mRoots[MethodIndex];
+        size_t Offset = 0;
+        while(Offset < Pattern.size())
+        {
+            if(IsParamStart(Pattern, Offset))
+            {
+                const size_t ParamEnd = GetParamEnd(Pattern, Offset);
+                const RouteNodeType Type = (Pattern[Offset] == ':') ? RouteNodeType::RouteNodeType_Param : RouteNodeType::RouteNodeType_Wildcard;
+                NodeIndex = AddParamChild(NodeIndex, Type, Pattern.substr(Offset + 1, ParamEnd - Offset - 1));
+                if(NodeIndex == NoNode)
+                {
+                    return false;
+                }
+                Offset = ParamEnd;
+                continue;
+            }
+
+            // Static bytes up to the next parameter
+            size_t RunEnd = Offset + 1;
+            while(RunEnd < Pattern.size() && IsParamStart(Pattern, RunEnd) == false)
+            {
+                RunEnd++;
+            }
+            NodeIndex = AddStaticChild(NodeIndex, Pattern.substr(Offset, RunEnd - Offset));
+            Offset = RunEnd;
+        }
+
+        mNodes[NodeIndex].RouteId = RouteId;
+        return true;
+    }
+
+    uint32_t RequestRouter::Match(ServerRequestType Method, std::string_view Path, RouteParams& OutParams) const
+    {
+        OutParams.NumParams = 0;
+
+        const int MethodIndex = (int) Method;
+        if(MethodIndex < 0 || MethodIndex >= MaxMethods || mRoots[MethodIndex] == NoNode)
+        {
+            return NoRoute;
+        }
+
+        uint32_t RouteId = NoRoute;
+        if(MatchNode(mRoots[MethodIndex], Path.data(), Path.data() + Path.size(), OutParams, RouteId) == false)
+        {
+            OutParams.NumParams = 0;
+            return NoRoute;
+        }
+        return RouteId;
+    }
+
+    uint32_t RequestRouter::AddNode(RouteNodeType Type, std::string_view Prefix)
+    {
+        RouteNode Node;
+        Node.Type = Type;
+        Node.PrefixOffset = (uint32_t) mPrefixData.size();
+        Node.PrefixLength = (uint32_t) Prefix.size();
+        mPrefixData.append(Prefix.data(), Prefix.size());
+        mNodes.push_back(Node);
+        return (uint32_t) (mNodes.size() - 1);
+    }
+
+    void RequestRouter::AddChild(uint32_t NodeIndex, uint32_t Child)
+    {
+        // A node's children are kept together, moved to the end of the pool to make room unless they're there already
+        RouteNode& Node = mNodes[NodeIndex];
+        if(Node.ChildrenOffset + Node.NumChildren != mChildNodes.size())
+        {
+            const uint32_t NewOffset = (uint32_t) mChildNodes.size();
+            mChildFirstBytes.append(mChildFirstBytes, Node.ChildrenOffset, Node.NumChildren);
+            for(uint32_t i = 0; i < Node.NumChildren; i++)
+            {
+                const uint32_t MovedChild = mChildNodes[Node.ChildrenOffset + i];
+                mChildNodes.push_back(MovedChild);
+            }
+            Node.ChildrenOffset = NewOffset;
+        }
+        mChildFirstBytes.push_back(mPrefixData[mNodes[Child].PrefixOffset]);
+        mChildNodes.push_back(Child);
+        Node.NumChildren++;
+    }
+
+    uint32_t RequestRouter::AddStaticChild(uint32_t NodeIndex, std::string_view Run)
+    {
+        while(Run.empty() == false)
+        {
+            const std::string_view FirstBytes(mChildFirstBytes.data() + mNodes[NodeIndex].ChildrenOffset, mNodes[NodeIndex].NumChildren);
+            const size_t ChildSlot = FirstBytes.find(Run[0]);
+            if(ChildSlot == std::string_view::npos)
+            {
+                const uint32_t Child = AddNode(RouteNodeType::RouteNodeType_Static, Run);
+                AddChild(NodeIndex, Child);
+                return Child;
+            }
+
+            const uint32_t ChildSlotIndex = mNodes[NodeIndex].ChildrenOffset + (uint32_t) ChildSlot;
+            uint32_t Child = mChildNodes[ChildSlotIndex];
+            const std::string_view ChildPrefix = GetPrefix(mNodes[Child]);
+            size_t CommonLength = 1;
+            while(CommonLength < ChildPrefix.size() && CommonLength < Run.size() && ChildPrefix[CommonLength] == Run[CommonLength])
+            {
+                CommonLength++;
+            }
+
+            // The run leaves the child part way through its prefix, split it there. Both halves keep pointing into the
+            // child's bytes
+            if(CommonLength < ChildPrefix.size())
+            {
+                const uint32_t Split = (uint32_t) mNodes.size();
+                RouteNode SplitNode;
+                SplitNode.PrefixOffset = mNodes[Child].PrefixOffset;
+                SplitNode.PrefixLength = (uint32_t) CommonLength;
+                mNodes.push_back(SplitNode);
+
+                mNodes[Child].PrefixOffset += (uint32_t) CommonLength;
+                mNodes[Child].PrefixLength -= (uint32_t) CommonLength;
+                AddChild(Split, Child);
+                mChildNodes[ChildSlotIndex] = Split;
+                Child = Split;
+            }
+
+            NodeIndex = Child;
+            Run.remove_prefix(CommonLength);
+        }
+        return NodeIndex;
+    }
+
+    uint32_t RequestRouter::AddParamChild(uint32_t NodeIndex, RouteNodeType Type, std::string_view Name)
+    {
+        const uint32_t Existing = (Type == RouteNodeType::RouteNodeType_Param) ? mNodes[NodeIndex].ParamChild : mNodes[NodeIndex].WildcardChild;
+        if(Existing != NoNode)
+        {
+            // Both routes capture here, they'd have to agree on what it's called
+            return (GetPrefix(mNodes[Existing]) == Name) ? Existing : NoNode;
+        }
+
+        const uint32_t Child = AddNode(Type, Name);
+        (Type == RouteNodeType::RouteNodeType_Param ? mNodes[NodeIndex].ParamChild : mNodes[NodeIndex].WildcardChild) = Child;
+        return Child;
+    }
+
+    bool RequestRouter::MatchNode(uint32_t NodeIndex, const char* Path, const char* PathEnd, RouteParams& Params, uint32_t& OutRouteId) const
+    {
+        while(true)
+        {
+            const RouteNode& Node = mNodes[NodeIndex];
+            switch(Node.Type)
+            {
+                case RouteNodeType::RouteNodeType_Static:
+                {
+                    const size_t PrefixLength = Node.PrefixLength;
+                    if((size_t) (PathEnd - Path) < PrefixLength || memcmp(Path, mPrefixData.data() + Node.PrefixOffset, PrefixLength) != 0)
+                    {
+                        return false;
+                    }
+                    Path += PrefixLength;
+                    break;
+                }
+                case RouteNodeType::RouteNodeType_Param:
+                {
+                    const char* SegmentEnd = (const char*) memchr(Path, '/', PathEnd - Path);
+                    SegmentEnd = (SegmentEnd != nullptr) ? SegmentEnd : PathEnd;
+                    if(SegmentEnd == Path || Params.NumParams == RouteParams::MaxParams)
+                    {
+                        return false;
+                    }
+                    Params.Params[Params.NumParams++] = { GetPrefix(Node), std::string_view(Path, SegmentEnd - Path) };
+                    Path = SegmentEnd;
+                    break;
+                }
+                case RouteNodeType::RouteNodeType_Wildcard:
+                {
+                    if(Node.RouteId == NoRoute || Params.NumParams == RouteParams::MaxParams)
+                    {
+                        return false;
+                    }
+                    Params.Params[Params.NumParams++] = { GetPrefix(Node), std::string_view(Path, PathEnd - Path) };
+                    OutRouteId = Node.RouteId;
+                    return true;
+                }
+            }
+
+            if(Path == PathEnd)
+            {
+                if(Node.RouteId != NoRoute)
+                {
+                    OutRouteId = Node.RouteId;
+                    return true;
+                }
+
+                // A wildcard can match nothing at all
+                return Node.WildcardChild != NoNode && MatchNode(Node.WildcardChild, Path, PathEnd, Params, OutRouteId);
+            }
+
+            const char* FirstBytes = mChildFirstBytes.data() + Node.ChildrenOffset;
+            const char* ChildSlot = (const char*) memchr(FirstBytes, *Path, Node.NumChildren);
+            const uint32_t StaticChild = (ChildSlot != nullptr) ? mChildNodes[Node.ChildrenOffset + (ChildSlot - FirstBytes)] : NoNode;
+
+            // Nothing to fall back on, carry straight on down
+            if(Node.ParamChild == NoNode && Node.WildcardChild == NoNode)
+            {
+                if(StaticChild == NoNode)
+                {
+                    return false;
+                }
+                NodeIndex = StaticChild;
+                continue;
+            }
+
+            const int NumParams = Params.NumParams;
+            if(StaticChild != NoNode && MatchNode(StaticChild, Path, PathEnd, Params, OutRouteId))
+            {
+                return true;
+            }
+            Params.NumParams = NumParams;
+            if(Node.ParamChild != NoNode && MatchNode(Node.ParamChild, Path, PathEnd, Params, OutRouteId))
+            {
+                return true;
+            }
+            Params.NumParams = NumParams;
+            return Node.WildcardChild != NoNode && MatchNode(Node.WildcardChild, Path, PathEnd, Params, OutRouteId);
+        }
+    }
+}
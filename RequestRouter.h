@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace WebServer
+{
+    enum class ServerRequestType;
+
+    struct RouteParam
+    {
+        std::string_view Name;      // as declared in the route, without the ':' or '*'
+        std::string_view Value;     // view into the matched path
+    };
+
+    // A request's captured path parameters, held inline so matching doesn't allocate
+    struct RouteParams
+    {
+        static constexpr int MaxParams = 8;
+
+        // Empty if the route has no parameter by that name
+        std::string_view Find(std::string_view Name) const;
+
+        RouteParam Params[MaxParams];
+        int NumParams = 0;
+    };
+
+    // Routes (method plus path pattern) to ids in a compressed radix tree, one tree per method.
+    // A segment starting ':' captures that segment ("/users/:id"), one starting '*' captures the rest of the path, slashes
+    // and all, and has to come last ("/static/*file"). Anywhere else ':' and '*' are just characters.
+    // Static segments take priority over a parameter, which takes priority over a wildcard. Matching is a walk down the
+    // tree comparing each node's bytes once, only stepping back when a static branch fails where a parameter could match
+    class RequestRouter
+    {
+    public:
+        static constexpr uint32_t NoRoute = UINT32_MAX;
+
+        // Replaces the id of a route that's already there. False if the pattern doesn't start with '/', has an empty
+        // parameter name, a wildcard before the end or too many parameters, or names a parameter differently to a route
+        // already sharing that position
+        bool AddRoute(ServerRequestType Method, std::string_view Pattern, uint32_t RouteId);
+
+        // The matching route's id or NoRoute, OutParams' values are views into Path and its names into the router
+        uint32_t Match(ServerRequestType Method, std::string_view Path, RouteParams& OutParams) const;
+
+        size_t GetNumNodes() const { return mNodes.size(); }
+
+    private:
+        static constexpr int MaxMethods = 8;
+        static constexpr uint32_t NoNode = UINT32_MAX;
+
+        enum class RouteNodeType : uint8_t
+        {
+            RouteNodeType_Static,
+            RouteNodeType_Param,
+            RouteNodeType_Wildcard,
+        };
+
+        // Kept small, the bytes and child lists live in shared pools so a lookup touches as little memory as it can
+        struct RouteNode
+        {
+            uint32_t PrefixOffset = 0;          // into mPrefixData, the bytes a static node matches or a parameter's name
+            uint32_t PrefixLength = 0;
+            uint32_t ChildrenOffset = 0;        // into mChildFirstBytes and mChildNodes
+            uint16_t NumChildren = 0;           // static ones
+            RouteNodeType Type = RouteNodeType::RouteNodeType_Static;
+            uint32_t ParamChild = NoNode;
+            uint32_t WildcardChild = NoNode;
+            uint32_t RouteId = NoRoute;
+        };
+
+        std::string_view GetPrefix(const RouteNode& Node) const { return std::string_view(mPrefixData.data() + Node.PrefixOffset, Node.PrefixLength); }
+
+        uint32_t AddNode(RouteNodeType Type, std::string_view Prefix);
+        void AddChild(uint32_t NodeIndex, uint32_t Child);
+        uint32_t AddStaticChild(uint32_t NodeIndex, std::string_view Run);
+        uint32_t AddParamChild(uint32_t NodeIndex, RouteNodeType Type, std::string_view Name);
+        bool MatchNode(uint32_t NodeIndex, const char* Path, const char* PathEnd, RouteParams& Params, uint32_t& OutRouteId) const;
+
+        std::vector<RouteNode> mNodes;
+        std::string mPrefixData;
+        std::string mChildFirstBytes;           // first byte of each static child's prefix, searched to pick one
+        std::vector<uint32_t> mChildNodes;
+        uint32_t mRoots[MaxMethods] = { NoNode, NoNode, NoNode, NoNode, NoNode, NoNode, NoNode, NoNode };
+    };
+}
@@ -0,0 +1,174 @@
+#include "Socket.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace WebServer
+{
+    int SocketGlobalInit()
+    {
+#ifdef _WIN32
+        WSADATA WSAData;
+        int Result = WSAStartup(MAKEWORD(2, 2), &WSAData);
+        if(Result != 0)
+        {
+            std::cout << "WSAStartup failed: " << Result << "\n";
+            return 1;
+        }
+#endif
+        return 0;
+    }
+
+    void SocketGlobalCleanup()
+    {
+#ifdef _WIN32
+        WSACleanup();
+#endif
+    }
+
+    bool SetSocketNonBlocking(SOCKET Socket)
+    {
+#ifdef _WIN32
+        u_long NonBlockingMode = 1;
+        return ioctlsocket(Socket, FIONBIO, &NonBlockingMode) == NO_ERROR;
+#else
+        int Flags = fcntl(Socket, F_GETFL, 0);
+        return Flags != -1 && fcntl(Socket, F_SETFL, Flags | O_NONBLOCK) != -1;
+#endif
+    }
+
+    bool SetSocketReuseAddress(SOCKET Socket)
+    {
+#ifdef _WIN32
+        // SO_REUSEADDR on windows lets another process steal the port, leave it alone
+        return true;
+#else
+        int Enable = 1;
+        return setsockopt(Socket, SOL_SOCKET, SO_REUSEADDR, &Enable, sizeof(Enable)) == 0;
+#endif
+    }
+
+    bool IsSocketReusePortSupported()
+    {
+#ifdef SO_REUSEPORT
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool SetSocketReusePort(SOCKET Socket)
+    {
+#ifdef SO_REUSEPORT
+        int Enable = 1;
+        return setsockopt(Socket, SOL_SOCKET, SO_REUSEPORT, &Enable, sizeof(Enable)) == 0;
+#else
+        return false;
+#endif
+    }
+
+    int SendSocketData(SOCKET Socket, const char* Data, int DataLen)
+    {
+#ifdef MSG_NOSIGNAL
+        return send(Socket, Data, DataLen, MSG_NOSIGNAL);
+#else
+        return send(Socket, Data, DataLen, 0);
+#endif
+    }
+
+    int SendSocketDataVectored(SOCKET Socket, const SocketSendBuffer* Buffers, int NumBuffers)
+    {
+        constexpr int MaxBuffersPerCall = 64;
+
+        int TotalSent = 0;
+        for(int First = 0; First < NumBuffers; First += MaxBuffersPerCall)
+        {
+            int NumCallBuffers = std::min(NumBuffers - First, MaxBuffersPerCall);
+            int CallLength = 0;
+
+#ifdef _WIN32
+            WSABUF SendBuffers[MaxBuffersPerCall];
+            for(int i = 0; i < NumCallBuffers; i++)
+            {
+                SendBuffers[i].buf = (CHAR*) Buffers[First + i].Data;
+                SendBuffers[i].len = (ULONG) Buffers[First + i].DataLen;
+                CallLength += Buffers[First + i].DataLen;
+            }
+
+            DWORD BytesSent = 0;
+            int Sent = (WSASend(Socket, SendBuffers, (DWORD) NumCallBuffers, &BytesSent, 0, nullptr, nullptr) == 0) ? (int) BytesSent : SOCKET_ERROR;
+#else
+            iovec SendBuffers[MaxBuffersPerCall];
+            for(int i = 0; i < NumCallBuffers; i++)
+            {
+                SendBuffers[i].iov_base = (void*) Buffers[First + i].Data;
+                SendBuffers[i].iov_len = (size_t) Buffers[First + i].DataLen;
+                CallLength += Buffers[First + i].DataLen;
+            }
+
+            msghdr Message{};
+            Message.msg_iov = SendBuffers;
+            Message.msg_iovlen = (size_t) NumCallBuffers;
+#ifdef MSG_NOSIGNAL
+            int Sent = (int) sendmsg(Socket, &Message, MSG_NOSIGNAL);
+#else
+            int Sent = (int) sendmsg(Socket, &Message, 0);
+#endif
+#endif
+            if(Sent == SOCKET_ERROR)
+            {
+                return (TotalSent > 0) ? TotalSent : SOCKET_ERROR;
+            }
+
+            TotalSent += Sent;
+            if(Sent < CallLength)
+            {
+                break;
+            }
+        }
+        return TotalSent;
+    }
+
+    bool WaitSocketWritable(SOCKET Socket, int TimeoutMs)
+    {
+#ifdef _WIN32
+        WSAPOLLFD PollSocket{ Socket, POLLWRNORM, 0 };
+        return WSAPoll(&PollSocket, 1, TimeoutMs) > 0 && (PollSocket.revents & POLLWRNORM) != 0;
+#else
+        pollfd PollSocket{ Socket, POLLOUT, 0 };
+        return poll(&PollSocket, 1, TimeoutMs) > 0 && (PollSocket.revents & POLLOUT) != 0;
+#endif
+    }
+
+    void CloseSocket(SOCKET Socket)
+    {
+#ifdef _WIN32
+        closesocket(Socket);
+#else
+        close(Socket);
+#endif
+    }
+
+    void ShutdownSocketSend(SOCKET Socket)
+    {
+        shutdown(Socket, SD_SEND);
+    }
+
+    int GetSocketError()
+    {
+#ifdef _WIN32
+        return WSAGetLastError();
+#else
+        return errno;
+#endif
+    }
+
+    bool IsSocketWouldBlockError(int ErrorCode)
+    {
+#ifdef _WIN32
+        return ErrorCode == WSAEWOULDBLOCK;
+#else
+        return ErrorCode == EWOULDBLOCK || ErrorCode == EAGAIN;
+#endif
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+// Platform socket layer, everything above this file talks in SOCKET and the helpers below
+
+#ifdef _WIN32
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#pragma comment(lib, "Ws2_32.lib")
+
+#else
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <sys/uio.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+
+typedef int SOCKET;
+
+#define INVALID_SOCKET (-1)
+#define SOCKET_ERROR (-1)
+#define SD_SEND SHUT_WR
+
+#endif
+
+namespace WebServer
+{
+    struct SocketSendBuffer
+    {
+        const char* Data = nullptr;
+        int DataLen = 0;
+        bool bPersistentData = true;    // outlives the send, async engines needn't copy it
+    };
+
+    // Winsock needs starting up once per process, a no-op elsewhere
+    int SocketGlobalInit();
+    void SocketGlobalCleanup();
+
+    bool SetSocketNonBlocking(SOCKET Socket);
+    bool SetSocketReuseAddress(SOCKET Socket);
+
+    // SO_REUSEPORT, several sockets bound to one port with the kernel balancing accepts between them
+    bool IsSocketReusePortSupported();
+    bool SetSocketReusePort(SOCKET Socket);
+
+    // send() without raising SIGPIPE when the peer has already gone
+    int SendSocketData(SOCKET Socket, const char* Data, int DataLen);
+
+    // Gathers the buffers into as few sendmsg/WSASend calls as possible, returns the bytes sent or SOCKET_ERROR
+    int SendSocketDataVectored(SOCKET Socket, const SocketSendBuffer* Buffers, int NumBuffers);
+
+    // Blocks until the socket can take more data or the timeout passes, for threads that own a socket outright
+    bool WaitSocketWritable(SOCKET Socket, int TimeoutMs);
+
+    void CloseSocket(SOCKET Socket);
+    void ShutdownSocketSend(SOCKET Socket);
+
+    // Last error raised by a socket call on this thread (WSAGetLastError / errno)
+    int GetSocketError();
+    bool IsSocketWouldBlockError(int ErrorCode);
+}
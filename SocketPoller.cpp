@@ -0,0 +1,212 @@
+#include "SocketPoller.h"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+namespace
+{
+    using namespace WebServer;
+
+    constexpr int MaxEventsPerWait = 1024;
+
+#ifdef __linux__
+    uint32_t ToEpollEvents(uint32_t Events)
+    {
+        uint32_t EpollEvents = EPOLLET | EPOLLRDHUP;
+        EpollEvents |= (Events & SocketPollEvent_Read) ? (uint32_t) EPOLLIN : 0u;
+        EpollEvents |= (Events & SocketPollEvent_Write) ? (uint32_t) EPOLLOUT : 0u;
+        return EpollEvents;
+    }
+
+    uint32_t FromEpollEvents(uint32_t EpollEvents)
+    {
+        uint32_t Events = SocketPollEvent_None;
+        Events |= (EpollEvents & EPOLLIN) ? (uint32_t) SocketPollEvent_Read : 0u;
+        Events |= (EpollEvents & EPOLLOUT) ? (uint32_t) SocketPollEvent_Write : 0u;
+        Events |= (EpollEvents & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) ? (uint32_t) SocketPollEvent_Closed : 0u;
+        return Events;
+    }
+#else
+    short ToPollEvents(uint32_t Events)
+    {
+        short PollEvents = 0;
+        PollEvents |= (Events & SocketPollEvent_Read) ? POLLIN : 0;
+        PollEvents |= (Events & SocketPollEvent_Write) ? POLLOUT : 0;
+        return PollEvents;
+    }
+
+    uint32_t FromPollEvents(short PollEvents)
+    {
+        uint32_t Events = SocketPollEvent_None;
+        Events |= (PollEvents & POLLIN) ? (uint32_t) SocketPollEvent_Read : 0u;
+        Events |= (PollEvents & POLLOUT) ? (uint32_t) SocketPollEvent_Write : 0u;
+        Events |= (PollEvents & (POLLHUP | POLLERR)) ? (uint32_t) SocketPollEvent_Closed : 0u;
+        return Events;
+    }
+#endif
+}
+
+namespace WebServer
+{
+#ifdef __linux__
+
+    SocketPoller::~SocketPoller()
+    {
+        if(mWakeHandle != -1) { close(mWakeHandle); }
+        if(mEpollHandle != -1) { close(mEpollHandle); }
+    }
+
+    bool SocketPoller::Initialise()
+    {
+        mEpollHandle = epoll_create1(EPOLL_CLOEXEC);
+        mWakeHandle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        mEpollEvents.resize(MaxEventsPerWait);
+        return mEpollHandle != -1 && mWakeHandle != -1 && AddSocket(mWakeHandle, SocketPollEvent_Read);
+    }
+
+    bool SocketPoller::AddSocket(SOCKET Socket, uint32_t Events)
+    {
+        epoll_event Event{};
+        Event.events = ToEpollEvents(Events);
+        Event.data.fd = Socket;
+        return epoll_ctl(mEpollHandle, EPOLL_CTL_ADD, Socket, &Event) == 0;
+    }
+
+    bool SocketPoller::ModifySocket(SOCKET Socket, uint32_t Events)
+    {
+        epoll_event Event{};
+        Event.events = ToEpollEvents(Events);
+        Event.data.fd = Socket;
+        return epoll_ctl(mEpollHandle, EPOLL_CTL_MOD, Socket, &Event) == 0;
+    }
+
+    void SocketPoller::RemoveSocket(SOCKET Socket)
+    {
+        epoll_ctl(mEpollHandle, EPOLL_CTL_DEL, Socket, nullptr);
+    }
+
+    int SocketPoller::Wait(std::vector<SocketPollResult>& OutResults, int TimeoutMs)
+    {
+        OutResults.clear();
+
+        int NumEvents = epoll_wait(mEpollHandle, mEpollEvents.data(), (int) mEpollEvents.size(), TimeoutMs);
+        for(int i = 0; i < NumEvents; i++)
+        {
+            if(mEpollEvents[i].data.fd == mWakeHandle)
+            {
+                uint64_t WakeCount;
+                while(read(mWakeHandle, &WakeCount, sizeof(WakeCount)) > 0) {}
+                continue;
+            }
+            OutResults.push_back({ mEpollEvents[i].data.fd, FromEpollEvents(mEpollEvents[i].events) });
+        }
+
+        return (int) OutResults.size();
+    }
+
+    void SocketPoller::Wake()
+    {
+        uint64_t WakeCount = 1;
+        (void) !write(mWakeHandle, &WakeCount, sizeof(WakeCount));
+    }
+
+#else
+
+    SocketPoller::~SocketPoller()
+    {
+        if(mWakeSocket != INVALID_SOCKET) { CloseSocket(mWakeSocket); }
+    }
+
+    bool SocketPoller::Initialise()
+    {
+        mWakeSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if(mWakeSocket == INVALID_SOCKET)
+        {
+            return false;
+        }
+
+        sockaddr_in WakeAddress{};
+        WakeAddress.sin_family = AF_INET;
+        WakeAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t WakeAddressLength = sizeof(WakeAddress);
+        if(bind(mWakeSocket, (sockaddr*) &WakeAddress, sizeof(WakeAddress)) == SOCKET_ERROR
+            || getsockname(mWakeSocket, (sockaddr*) &WakeAddress, &WakeAddressLength) == SOCKET_ERROR
+            || connect(mWakeSocket, (sockaddr*) &WakeAddress, sizeof(WakeAddress)) == SOCKET_ERROR)
+        {
+            return false;
+        }
+        return SetSocketNonBlocking(mWakeSocket) && AddSocket(mWakeSocket, SocketPollEvent_Read);
+    }
+
+    bool SocketPoller::AddSocket(SOCKET Socket, uint32_t Events)
+    {
+        mPollSockets.push_back({});
+        mPollSockets.back().fd = Socket;
+        mPollSockets.back().events = ToPollEvents(Events);
+        return true;
+    }
+
+    bool SocketPoller::ModifySocket(SOCKET Socket, uint32_t Events)
+    {
+        for(auto& PollSocket : mPollSockets)
+        {
+            if(PollSocket.fd == Socket)
+            {
+                PollSocket.events = ToPollEvents(Events);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void SocketPoller::RemoveSocket(SOCKET Socket)
+    {
+        auto PollSocket = std::find_if(mPollSockets.begin(), mPollSockets.end(), [=] (const auto& Entry) { return Entry.fd == Socket; });
+        if(PollSocket != mPollSockets.end())
+        {
+            *PollSocket = mPollSockets.back();
+            mPollSockets.pop_back();
+        }
+    }
+
+    int SocketPoller::Wait(std::vector<SocketPollResult>& OutResults, int TimeoutMs)
+    {
+        OutResults.clear();
+
+#ifdef _WIN32
+        int NumReady = WSAPoll(mPollSockets.data(), (ULONG) mPollSockets.size(), TimeoutMs);
+#else
+        int NumReady = poll(mPollSockets.data(), mPollSockets.size(), TimeoutMs);
+#endif
+        int NumSeen = 0;
+        for(size_t i = 0; i < mPollSockets.size() && NumSeen < NumReady; i++)
+        {
+            if(mPollSockets[i].revents == 0)
+            {
+                continue;
+            }
+
+            NumSeen++;
+            if(mPollSockets[i].fd == mWakeSocket)
+            {
+                char WakeData[64];
+                while(recv(mWakeSocket, WakeData, sizeof(WakeData), 0) > 0) {}
+                continue;
+            }
+            OutResults.push_back({ mPollSockets[i].fd, FromPollEvents(mPollSockets[i].revents) });
+        }
+
+        return (int) OutResults.size();
+    }
+
+    void SocketPoller::Wake()
+    {
+        const char WakeData = 1;
+        send(mWakeSocket, &WakeData, 1, 0);
+    }
+
+#endif
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Socket.h"
+
+#include <cstdint>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#elif !defined(_WIN32)
+#include <poll.h>
+#endif
+
+namespace WebServer
+{
+    enum SocketPollEvent : uint32_t
+    {
+        SocketPollEvent_None = 0,
+        SocketPollEvent_Read = 1 << 0,
+        SocketPollEvent_Write = 1 << 1,
+        SocketPollEvent_Closed = 1 << 2,    // hang-up or error, a read will report which
+    };
+
+    struct SocketPollResult
+    {
+        SOCKET Socket;
+        uint32_t Events;
+    };
+
+    // Readiness notification for a set of sockets. Edge-triggered epoll on linux, level-triggered poll elsewhere,
+    // callers drain a socket until it would block so both behave the same
+    class SocketPoller
+    {
+    public:
+        SocketPoller() = default;
+        SocketPoller(const SocketPoller& Other) = delete;
+        SocketPoller& operator=(const SocketPoller& Other) = delete;
+        ~SocketPoller();
+
+        bool Initialise();
+
+        bool AddSocket(SOCKET Socket, uint32_t Events);
+        bool ModifySocket(SOCKET Socket, uint32_t Events);
+        void RemoveSocket(SOCKET Socket);
+
+        // Blocks until a socket is ready or the timeout passes, -1 waits forever
+        int Wait(std::vector<SocketPollResult>& OutResults, int TimeoutMs);
+
+        // Any thread, cuts the Wait in progress (or the next one) short. It returns without reporting anything for it
+        void Wake();
+
+    private:
+#ifdef __linux__
+        int mEpollHandle = -1;
+        int mWakeHandle = -1;           // eventfd
+        std::vector<epoll_event> mEpollEvents;
+#else
+        // A loopback udp socket sending to itself, the poll set only takes sockets
+        SOCKET mWakeSocket = INVALID_SOCKET;
+#ifdef _WIN32
+        std::vector<WSAPOLLFD> mPollSockets;
+#else
+        std::vector<pollfd> mPollSockets;
+#endif
+#endif
+    };
+}
@@ -0,0 +1,92 @@
+#include "SocketSendQueue.h"
+
+#include <algorithm>
+
+namespace WebServer
+{
+    void SocketSendQueue::Push(const char* Data, int DataLen, bool bPersistentData)
+    {
+        if(DataLen <= 0)
+        {
+            return;
+        }
+
+        QueuedBuffer& Queued = mBuffers.emplace_back();
+        Queued.Buffer = SocketSendBuffer{ Data, DataLen, bPersistentData };
+        if(bPersistentData == false)
+        {
+            Queued.OwnedData.assign(Data, Data + DataLen);
+            Queued.Buffer.Data = Queued.OwnedData.data();
+        }
+        mQueuedBytes += (size_t) DataLen;
+    }
+
+    SocketSendResult SocketSendQueue::Flush(SOCKET Socket)
+    {
+        constexpr int MaxBuffersPerFlush = 64;
+        SocketSendBuffer FlushBuffers[MaxBuffersPerFlush];
+
+        while(IsEmpty() == false)
+        {
+            int NumBuffers = GatherBuffers(FlushBuffers, MaxBuffersPerFlush);
+
+            size_t GatheredBytes = 0;
+            for(int i = 0; i < NumBuffers; i++)
+            {
+                GatheredBytes += (size_t) FlushBuffers[i].DataLen;
+            }
+
+            int Sent = SendSocketDataVectored(Socket, FlushBuffers, NumBuffers);
+            if(Sent == SOCKET_ERROR)
+            {
+                return IsSocketWouldBlockError(GetSocketError()) ? SocketSendResult::SocketSendResult_WouldBlock : SocketSendResult::SocketSendResult_Error;
+            }
+
+            Consume((size_t) Sent);
+
+            // Short send, the socket's buffer is full
+            if((size_t) Sent < GatheredBytes)
+            {
+                return SocketSendResult::SocketSendResult_WouldBlock;
+            }
+        }
+        return SocketSendResult::SocketSendResult_Complete;
+    }
+
+    int SocketSendQueue::GatherBuffers(SocketSendBuffer* OutBuffers, int MaxBuffers) const
+    {
+        int NumBuffers = std::min((int) mBuffers.size(), MaxBuffers);
+        for(int i = 0; i < NumBuffers; i++)
+        {
+            OutBuffers[i] = mBuffers[i].Buffer;
+        }
+        return NumBuffers;
+    }
+
+    void SocketSendQueue::Consume(size_t NumBytes)
+    {
+        NumBytes = std::min(NumBytes, mQueuedBytes);
+        mQueuedBytes -= NumBytes;
+
+        while(NumBytes > 0)
+        {
+            SocketSendBuffer& Front = mBuffers.front().Buffer;
+            if(NumBytes < (size_t) Front.DataLen)
+            {
+                // Partly sent, the rest goes first next time
+                Front.Data += NumBytes;
+                Front.DataLen -= (int) NumBytes;
+                return;
+            }
+
+            NumBytes -= (size_t) Front.DataLen;
+            mBuffers.pop_front();
+        }
+    }
+
+    void SocketSendQueue::Clear()
+    {
+        mBuffers.clear();
+        mQueuedBytes = 0;
+    }
+}
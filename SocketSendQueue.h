@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Socket.h"
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+namespace WebServer
+{
+    enum class SocketSendResult
+    {
+        SocketSendResult_Complete,
+        SocketSendResult_WouldBlock,     // socket's send buffer is full, wait for it to become writable
+        SocketSendResult_Error,
+    };
+
+    // Ordered outbound data for one connection. Buffers are written out with as few vectored sends as the socket
+    // will take, whatever doesn't fit stays queued (partly sent buffers included) for the next flush.
+    // Persistent buffers are referenced, the rest are copied in so the caller's data can go straight away.
+    class SocketSendQueue
+    {
+    public:
+        void Push(const char* Data, int DataLen, bool bPersistentData);
+
+        // Writes until the queue is empty or the socket would block
+        SocketSendResult Flush(SOCKET Socket);
+
+        // Fills OutBuffers from the front of the queue, returns how many were filled
+        int GatherBuffers(SocketSendBuffer* OutBuffers, int MaxBuffers) const;
+
+        // Drops NumBytes from the front of the queue, once they've been sent
+        void Consume(size_t NumBytes);
+
+        void Clear();
+
+        bool IsEmpty() const { return mBuffers.empty(); }
+        size_t GetQueuedBytes() const { return mQueuedBytes; }
+
+    private:
+        struct QueuedBuffer
+        {
+            SocketSendBuffer Buffer;
+            std::vector<char> OwnedData;
+        };
+
+        std::deque<QueuedBuffer> mBuffers;
+        size_t mQueuedBytes = 0;
+    };
+}
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace WebServer
+{
+    enum class ServerRequestType;
+
+    // A route known when the server's built, an exact url (no parameters) for one method
+    struct StaticRoute
+    {
+        ServerRequestType Method{};
+        std::string_view Url;
+    };
+
+    namespace StaticRouteHash
+    {
+        constexpr uint64_t Multiplier = 0x9E3779B97F4A7C15ull;
+
+        // Eight bytes at a time, the method and length mixed in first (XORed straight in they'd cancel against the url's
+        // bytes, "GET /item/13" and "POST /item/10" came out the same). Put together a byte at a time so it works at
+        // compile time, compilers turn each word back into a single load
+        constexpr uint64_t HashUrl(ServerRequestType Method, std::string_view Url)
+        {
+            uint64_t Hash = (0xCBF29CE484222325ull ^ ((uint64_t) Method << 32) ^ (uint64_t) Url.size()) * Multiplier;
+            Hash ^= Hash >> 29;
+            size_t i = 0;
+            for(; i + 8 <= Url.size(); i += 8)
+            {
+                uint64_t Word = 0;
+                for(size_t b = 0; b < 8; b++)
+                {
+                    Word |= (uint64_t) (uint8_t) Url[i + b] << (b * 8);
+                }
+                Hash = (Hash ^ Word) * Multiplier;
+                Hash ^= Hash >> 29;
+            }
+
+            uint64_t Tail = 0;
+            for(size_t b = 0; i + b < Url.size(); b++)
+            {
+                Tail |= (uint64_t) (uint8_t) Url[i + b] << (b * 8);
+            }
+            Hash = (Hash ^ Tail) * Multiplier;
+            return Hash ^ (Hash >> 32);
+        }
+
+        // Routes are grouped into buckets by the hash's low bits, each bucket's seed is picked so its routes land in
+        // slots of their own
+        constexpr uint32_t GetSlot(uint64_t Hash, uint32_t BucketSeed, uint32_t SlotMask)
+        {
+            return (uint32_t) (((Hash ^ BucketSeed) * Multiplier) >> 32) & SlotMask;
+        }
+
+        constexpr uint32_t RoundUpToPowerOfTwo(size_t Value)
+        {
+            uint32_t PowerOfTwo = 1;
+            while(PowerOfTwo < Value)
+            {
+                PowerOfTwo <<= 1;
+            }
+            return PowerOfTwo;
+        }
+    }
+
+    // A StaticRouteTable seen without its size, for the server to look urls up in
+    struct StaticRouteLookup
+    {
+        // Index of the route or -1, a hash of the url and one compare
+        int Find(ServerRequestType Method, std::string_view Url) const
+        {
+            return (NumRoutes > 0) ? Find(Method, Url, StaticRouteHash::HashUrl(Method, Url)) : -1;
+        }
+
+        // With the url already hashed (StaticRouteHash::HashUrl), as a parsed request's is
+        int Find(ServerRequestType Method, std::string_view Url, uint64_t Hash) const
+        {
+            if(NumRoutes == 0)
+            {
+                return -1;
+            }
+
+            const int32_t Index = Slots[StaticRouteHash::GetSlot(Hash, BucketSeeds[Hash & BucketMask], SlotMask)];
+            return (Index >= 0 && Routes[Index].Method == Method && Routes[Index].Url == Url) ? Index : -1;
+        }
+
+        const StaticRoute* Routes = nullptr;
+        const uint32_t* BucketSeeds = nullptr;
+        const int32_t* Slots = nullptr;
+        uint32_t BucketMask = 0;
+        uint32_t SlotMask = 0;
+        int NumRoutes = 0;
+    };
+
+    // A perfect hash over routes declared at compile time, built by the compiler:
+    //
+    //     constexpr StaticRoute SiteRoutes[] = { { ServerRequestType::ServerRequestType_GET, "/" }, ... };
+    //     constexpr auto SiteRouteTable = MakeStaticRouteTable(SiteRoutes);
+    //
+    // Find's result can go straight into a switch with IndexOf for its cases. A url declared twice stops the build.
+    // The table has to outlive any GetLookup() taken from it, a constexpr one at namespace scope always does
+    template<size_t NumRoutes>
+    class StaticRouteTable
+    {
+    public:
+        static_assert(NumRoutes > 0, "a static route table needs at least one route");
+
+        static constexpr uint32_t NumSlots = StaticRouteHash::RoundUpToPowerOfTwo(NumRoutes * 2);
+        static constexpr uint32_t NumBuckets = StaticRouteHash::RoundUpToPowerOfTwo((NumRoutes + 1) / 2);
+
+        constexpr StaticRouteTable(const StaticRoute* InRoutes)
+        {
+            for(size_t i = 0; i < NumRoutes; i++)
+            {
+                mRoutes[i] = InRoutes[i];
+            }
+            Build();
+        }
+
+        constexpr int Find(ServerRequestType Method, std::string_view Url) const
+        {
+            const uint64_t Hash = StaticRouteHash::HashUrl(Method, Url);
+            const int32_t Index = mSlots[StaticRouteHash::GetSlot(Hash, mBucketSeeds[Hash & (NumBuckets - 1)], NumSlots - 1)];
+            return (Index >= 0 && mRoutes[Index].Method == Method && mRoutes[Index].Url == Url) ? Index : -1;
+        }
+
+        // For case labels, stops the build if the route isn't in the table
+        constexpr int IndexOf(ServerRequestType Method, std::string_view Url) const
+        {
+            const int Index = Find(Method, Url);
+            return (Index >= 0) ? Index : throw "route isn't in the static route table";
+        }
+
+        constexpr const StaticRoute& GetRoute(int Index) const { return mRoutes[Index]; }
+        constexpr size_t Size() const { return NumRoutes; }
+
+        constexpr StaticRouteLookup GetLookup() const
+        {
+            StaticRouteLookup Lookup;
+            Lookup.Routes = mRoutes;
+            Lookup.BucketSeeds = mBucketSeeds;
+            Lookup.Slots = mSlots;
+            Lookup.BucketMask = NumBuckets - 1;
+            Lookup.SlotMask = NumSlots - 1;
+            Lookup.NumRoutes = (int) NumRoutes;
+            return Lookup;
+        }
+
+    private:
+        // Fullest buckets first while there's most room, each gets the first seed that puts all its routes in free slots
+        constexpr void Build()
+        {
+            uint64_t Hashes[NumRoutes] = {};
+            for(size_t i = 0; i < NumRoutes; i++)
+            {
+                Hashes[i] = StaticRouteHash::HashUrl(mRoutes[i].Method, mRoutes[i].Url);
+                for(size_t j = 0; j < i; j++)
+                {
+                    if(Hashes[i] == Hashes[j] && mRoutes[i].Method == mRoutes[j].Method && mRoutes[i].Url == mRoutes[j].Url)
+                    {
+                        throw "a url is declared twice for the same method";
+                    }
+                }
+            }
+
+            // Each bucket's routes together in BucketRoutes, from BucketStarts[Bucket] up to the next bucket's start
+            uint32_t BucketStarts[NumBuckets + 1] = {};
+            uint32_t BucketRoutes[NumRoutes] = {};
+            for(size_t i = 0; i < NumRoutes; i++)
+            {
+                BucketStarts[(Hashes[i] & (NumBuckets - 1)) + 1]++;
+            }
+            for(uint32_t i = 0; i < NumBuckets; i++)
+            {
+                BucketStarts[i + 1] += BucketStarts[i];
+            }
+            uint32_t BucketFill[NumBuckets] = {};
+            for(size_t i = 0; i < NumRoutes; i++)
+            {
+                const uint32_t Bucket = (uint32_t) (Hashes[i] & (NumBuckets - 1));
+                BucketRoutes[BucketStarts[Bucket] + BucketFill[Bucket]++] = (uint32_t) i;
+            }
+
+            uint32_t BucketOrder[NumBuckets] = {};
+            for(uint32_t i = 0; i < NumBuckets; i++)
+            {
+                uint32_t j = i;
+                for(; j > 0 && BucketFill[BucketOrder[j - 1]] < BucketFill[i]; j--)
+                {
+                    BucketOrder[j] = BucketOrder[j - 1];
+                }
+                BucketOrder[j] = i;
+            }
+
+            for(uint32_t i = 0; i < NumSlots; i++)
+            {
+                mSlots[i] = -1;
+            }
+            for(uint32_t Bucket : BucketOrder)
+            {
+                const uint32_t* Routes = BucketRoutes + BucketStarts[Bucket];
+                const uint32_t NumBucketRoutes = BucketFill[Bucket];
+                if(NumBucketRoutes == 0)
+                {
+                    break;
+                }
+
+                mBucketSeeds[Bucket] = FindBucketSeed(Hashes, Routes, NumBucketRoutes);
+                for(uint32_t r = 0; r < NumBucketRoutes; r++)
+                {
+                    mSlots[StaticRouteHash::GetSlot(Hashes[Routes[r]], mBucketSeeds[Bucket], NumSlots - 1)] = (int32_t) Routes[r];
+                }
+            }
+        }
+
+        constexpr uint32_t FindBucketSeed(const uint64_t* Hashes, const uint32_t* Routes, uint32_t NumBucketRoutes) const
+        {
+            for(uint32_t Seed = 1; Seed < (1u << 20); Seed++)
+            {
+                bool bSlotsFree = true;
+                for(uint32_t r = 0; r < NumBucketRoutes && bSlotsFree; r++)
+                {
+                    const uint32_t Slot = StaticRouteHash::GetSlot(Hashes[Routes[r]], Seed, NumSlots - 1);
+                    bSlotsFree = mSlots[Slot] < 0;
+                    for(uint32_t Other = 0; Other < r && bSlotsFree; Other++)
+                    {
+                        bSlotsFree = StaticRouteHash::GetSlot(Hashes[Routes[Other]], Seed, NumSlots - 1) != Slot;
+                    }
+                }
+                if(bSlotsFree)
+                {
+                    return Seed;
+                }
+            }
+            throw "no seed separates a bucket's routes";
+        }
+
+        StaticRoute mRoutes[NumRoutes] = {};
+        uint32_t mBucketSeeds[NumBuckets] = {};
+        int32_t mSlots[NumSlots] = {};
+    };
+
+    template<size_t NumRoutes>
+    constexpr StaticRouteTable<NumRoutes> MakeStaticRouteTable(const StaticRoute (&Routes)[NumRoutes])
+    {
+        return StaticRouteTable<NumRoutes>(Routes);
+    }
+
+    template<size_t NumRoutes>
+    constexpr StaticRouteTable<NumRoutes> MakeStaticRouteTable(const std::array<StaticRoute, NumRoutes>& Routes)
+    {
+        return StaticRouteTable<NumRoutes>(Routes.data());
+    }
+}
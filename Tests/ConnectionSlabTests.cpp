@@ -0,0 +1,105 @@
+#include "ConnectionSlab.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace WebServer;
+
+namespace
+{
+    struct TestRecord
+    {
+        int Value = 0;
+        std::string Name;
+    };
+
+    std::vector<SOCKET> ActiveSockets(ConnectionSlab<TestRecord>& Slab)
+    {
+        std::vector<SOCKET> Sockets;
+        Slab.ForEach([&Sockets] (SOCKET Socket, TestRecord&) { Sockets.push_back(Socket); });
+        std::sort(Sockets.begin(), Sockets.end());
+        return Sockets;
+    }
+}
+
+TEST(ConnectionSlab, AcquireThenFind)
+{
+    ConnectionSlab<TestRecord> Slab;
+    EXPECT_EQ(Slab.Find((SOCKET) 5), nullptr);
+
+    Slab.Acquire((SOCKET) 5).Value = 42;
+    ASSERT_NE(Slab.Find((SOCKET) 5), nullptr);
+    EXPECT_EQ(Slab.Find((SOCKET) 5)->Value, 42);
+    EXPECT_EQ(Slab.Size(), 1u);
+
+    // Acquiring an active socket again hands back the same record untouched
+    EXPECT_EQ(Slab.Acquire((SOCKET) 5).Value, 42);
+    EXPECT_EQ(Slab.Size(), 1u);
+}
+
+TEST(ConnectionSlab, InvalidSocketIsNeverFound)
+{
+    ConnectionSlab<TestRecord> Slab;
+    Slab.Acquire((SOCKET) 0);
+    EXPECT_EQ(Slab.Find(INVALID_SOCKET), nullptr);
+}
+
+TEST(ConnectionSlab, RemoveMakesIdStale)
+{
+    ConnectionSlab<TestRecord> Slab;
+    Slab.Acquire((SOCKET) 7).Name = "first";
+    const ConnectionId FirstId = Slab.GetId((SOCKET) 7);
+    EXPECT_NE(Slab.Find(FirstId), nullptr);
+
+    EXPECT_TRUE(Slab.Remove(FirstId));
+    EXPECT_EQ(Slab.Find((SOCKET) 7), nullptr);
+    EXPECT_FALSE(Slab.Remove(FirstId));
+
+    // The descriptor comes back for a new connection, the old id mustn't reach it
+    TestRecord& Reused = Slab.Acquire((SOCKET) 7);
+    EXPECT_TRUE(Reused.Name.empty());
+    EXPECT_EQ(Slab.Find(FirstId), nullptr);
+    EXPECT_FALSE(Slab.Remove(FirstId));
+
+    const ConnectionId SecondId = Slab.GetId((SOCKET) 7);
+    EXPECT_NE(SecondId.Generation, FirstId.Generation);
+    EXPECT_EQ(Slab.Find(SecondId), &Reused);
+}
+
+TEST(ConnectionSlab, RemoveKeepsTheRestFindable)
+{
+    ConnectionSlab<TestRecord> Slab;
+    for(int Socket : { 3, 4, 9, 300, 1000 })
+    {
+        Slab.Acquire((SOCKET) Socket).Value = Socket;
+    }
+
+    // Removing from the middle swaps the last active socket into its place
+    EXPECT_TRUE(Slab.Remove(Slab.GetId((SOCKET) 4)));
+    EXPECT_EQ(ActiveSockets(Slab), (std::vector<SOCKET>{ 3, 9, 300, 1000 }));
+    for(int Socket : { 3, 9, 300, 1000 })
+    {
+        ASSERT_NE(Slab.Find((SOCKET) Socket), nullptr);
+        EXPECT_EQ(Slab.Find((SOCKET) Socket)->Value, Socket);
+    }
+
+    EXPECT_TRUE(Slab.Remove(Slab.GetId((SOCKET) 1000)));
+    EXPECT_TRUE(Slab.Remove(Slab.GetId((SOCKET) 3)));
+    EXPECT_EQ(ActiveSockets(Slab), (std::vector<SOCKET>{ 9, 300 }));
+    EXPECT_EQ(Slab.Size(), 2u);
+}
+
+TEST(ConnectionSlab, RecordsStayPutAsPagesAreAdded)
+{
+    ConnectionSlab<TestRecord> Slab;
+    TestRecord* First = &Slab.Acquire((SOCKET) 1);
+    for(int Socket = 2; Socket < 5000; Socket++)
+    {
+        Slab.Acquire((SOCKET) Socket);
+    }
+    EXPECT_EQ(Slab.Find((SOCKET) 1), First);
+    EXPECT_EQ(Slab.Size(), 4999u);
+}
@@ -0,0 +1,198 @@
+#include "ContentStore.h"
+#include "WebServer.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace WebServer;
+
+namespace
+{
+    std::shared_ptr<const ServerResponseMessage> MakePage(const std::string& Body)
+    {
+        std::shared_ptr<ServerResponseMessage> Page = std::make_shared<ServerResponseMessage>(ServerResponseStatusCode::ServerResponseStatusCode_200);
+        Page->AddContent(std::vector<char>(Body.begin(), Body.end()), "text/plain");
+        Page->BuildMessage();
+        return Page;
+    }
+
+    const ContentEntry* Find(const ContentSnapshot& Snapshot, const std::string& Url)
+    {
+        RouteParams Params;
+        return Snapshot.Find(Url, ContentSnapshot::HashUrl(Url), Params);
+    }
+
+    std::string GetBody(const ContentSnapshot& Snapshot, const std::string& Url)
+    {
+        const ContentEntry* Entry = Find(Snapshot, Url);
+        return (Entry != nullptr && Entry->Page != nullptr) ? std::string(Entry->Page->GetContentData(), Entry->Page->GetContentLength()) : "";
+    }
+}
+
+TEST(ContentStore, CommitPublishesTheBatch)
+{
+    ContentStore Store;
+    const ContentSnapshot& First = Store.GetSnapshot();
+    EXPECT_EQ(First.Size(), 0u);
+    EXPECT_EQ(Find(First, "/"), nullptr);
+    const uint64_t FirstGeneration = Store.GetGeneration();
+
+    ContentBatch Batch;
+    EXPECT_TRUE(Batch.IsEmpty());
+    Batch.Upload("/", MakePage("home"));
+    Batch.Upload("/a", MakePage("a"));
+    Batch.Upload("/a", MakePage("a again"));    // the last change to a url wins
+    Batch.AddWebSocket("/ws");
+    Batch.Upload("/gone", MakePage("gone"));
+    Batch.Remove("/gone");
+    Store.Commit(std::move(Batch));
+
+    const ContentSnapshot& Second = Store.GetSnapshot();
+    EXPECT_EQ(Second.GetGeneration(), FirstGeneration + 1);
+    EXPECT_EQ(Store.GetGeneration(), FirstGeneration + 1);
+    EXPECT_EQ(Second.Size(), 3u);
+    EXPECT_EQ(GetBody(Second, "/"), "home");
+    EXPECT_EQ(GetBody(Second, "/a"), "a again");
+    ASSERT_NE(Find(Second, "/ws"), nullptr);
+    EXPECT_TRUE(Find(Second, "/ws")->bWebSocket);
+    EXPECT_EQ(Find(Second, "/gone"), nullptr);
+
+    // Nothing to publish, nothing changes
+    Store.Commit(ContentBatch());
+    EXPECT_EQ(Store.GetGeneration(), FirstGeneration + 1);
+}
+
+TEST(ContentStore, PatternsMatchAfterExactUrls)
+{
+    ContentStore Store;
+    ContentBatch Batch;
+    Batch.Upload("/users/:id", MakePage("user"));
+    Batch.Upload("/users/me", MakePage("me"));
+    Store.Commit(std::move(Batch));
+
+    RouteParams Params;
+    const ContentEntry* Entry = Store.GetSnapshot().Find("/users/7", ContentSnapshot::HashUrl("/users/7"), Params);
+    ASSERT_NE(Entry, nullptr);
+    EXPECT_EQ(Entry->Url, "/users/:id");
+    EXPECT_EQ(Params.Find("id"), "7");
+    EXPECT_EQ(GetBody(Store.GetSnapshot(), "/users/me"), "me");
+
+    // Removing the pattern takes its matches with it
+    ContentBatch Removal;
+    Removal.Remove("/users/:id");
+    Store.Commit(std::move(Removal));
+    EXPECT_EQ(Find(Store.GetSnapshot(), "/users/7"), nullptr);
+    EXPECT_EQ(GetBody(Store.GetSnapshot(), "/users/me"), "me");
+}
+
+TEST(ContentStore, ManyUrlsOverTheShards)
+{
+    ContentStore Store;
+    for(int Round = 0; Round < 4; Round++)
+    {
+        ContentBatch Batch;
+        for(int i = 0; i < 500; i++)
+        {
+            Batch.Upload("/page/" + std::to_string(Round * 500 + i), MakePage(std::to_string(Round * 500 + i)));
+        }
+        Store.Commit(std::move(Batch));
+    }
+
+    const ContentSnapshot& Snapshot = Store.GetSnapshot();
+    ASSERT_EQ(Snapshot.Size(), 2000u);
+    for(int i = 0; i < 2000; i++)
+    {
+        ASSERT_EQ(GetBody(Snapshot, "/page/" + std::to_string(i)), std::to_string(i));
+    }
+    EXPECT_EQ(Find(Snapshot, "/page/2000"), nullptr);
+}
+
+TEST(ContentStore, OldSnapshotsLastUntilTheReaderIsPastThem)
+{
+    ContentStore Store;
+    {
+        ContentBatch Batch;
+        Batch.Upload("/", MakePage("old"));
+        Store.Commit(std::move(Batch));
+    }
+    EXPECT_FALSE(Store.HasRetired());     // no readers, nothing to wait for
+
+    // A reader sending from the current snapshot's page says so, as a worker does with a send pending
+    std::atomic<uint64_t>* Reader = Store.RegisterReader();
+    EXPECT_EQ(Reader->load(), ContentStore::ReaderIdle);
+    const ContentSnapshot& Pinned = Store.GetSnapshot();
+    Reader->store(Store.GetGeneration());
+    const ServerResponseMessage* SendingPage = Find(Pinned, "/")->Page.get();
+
+    // The page's replaced and the batch's own reference dropped, the pinned snapshot is all that's keeping it
+    std::weak_ptr<const ServerResponseMessage> OldPage;
+    {
+        std::shared_ptr<const ServerResponseMessage> Page = MakePage("new");
+        ContentBatch Batch;
+        Batch.Upload("/", Page);
+        Store.Commit(std::move(Batch));
+        OldPage = Find(Pinned, "/")->Page;
+    }
+    EXPECT_EQ(GetBody(Store.GetSnapshot(), "/"), "new");
+    EXPECT_EQ(Store.GetNumRetired(), 1u);
+    ASSERT_FALSE(OldPage.expired());
+    EXPECT_EQ(std::string(SendingPage->GetContentData(), SendingPage->GetContentLength()), "old");
+
+    // More commits and reclaims while it's pinned free nothing it needs
+    for(int i = 0; i < 3; i++)
+    {
+        ContentBatch Batch;
+        Batch.Upload("/other", MakePage(std::to_string(i)));
+        Store.Commit(std::move(Batch));
+        Store.TryReclaim();
+    }
+    EXPECT_EQ(Store.GetNumRetired(), 4u);
+    EXPECT_FALSE(OldPage.expired());
+
+    // Sends drained, the reader moves up to the current generation and the lot goes
+    Reader->store(Store.GetGeneration());
+    Store.TryReclaim();
+    EXPECT_FALSE(Store.HasRetired());
+    EXPECT_TRUE(OldPage.expired());
+
+    // Idle holds nothing either
+    Reader->store(ContentStore::ReaderIdle);
+    ContentBatch Batch;
+    Batch.Remove("/other");
+    Store.Commit(std::move(Batch));
+    EXPECT_FALSE(Store.HasRetired());
+}
+
+TEST(ContentStore, OldestReaderDecides)
+{
+    ContentStore Store;
+    std::atomic<uint64_t>* Older = Store.RegisterReader();
+    std::atomic<uint64_t>* Newer = Store.RegisterReader();
+
+    Older->store(Store.GetGeneration());
+    for(int i = 0; i < 2; i++)
+    {
+        ContentBatch Batch;
+        Batch.Upload("/", MakePage(std::to_string(i)));
+        Store.Commit(std::move(Batch));
+    }
+    Newer->store(Store.GetGeneration());
+    EXPECT_EQ(Store.GetNumRetired(), 2u);
+
+    // The newer reader moving on changes nothing, it never held them
+    Newer->store(ContentStore::ReaderIdle);
+    Store.TryReclaim();
+    EXPECT_EQ(Store.GetNumRetired(), 2u);
+
+    // The older one moving up by one frees only the snapshot it's now past
+    Older->store(Older->load() + 1);
+    Store.TryReclaim();
+    EXPECT_EQ(Store.GetNumRetired(), 1u);
+
+    Older->store(ContentStore::ReaderIdle);
+    Store.TryReclaim();
+    EXPECT_EQ(Store.GetNumRetired(), 0u);
+}
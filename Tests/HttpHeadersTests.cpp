@@ -0,0 +1,250 @@
+#include "HttpHeaders.h"
+
+#include <gtest/gtest.h>
+
+#include <cctype>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace WebServer;
+
+namespace
+{
+    // "Key: Value\r\n" lines laid out in a buffer, added to a list as the parser would
+    class HeaderLines
+    {
+    public:
+        void Add(const std::string& Key, const std::string& Value)
+        {
+            const int KeyOffset = (int) mData.size();
+            mData += Key + ": ";
+            const int ValueOffset = (int) mData.size();
+            mData += Value + "\r\n";
+            mList.Add(FindHttpHeader(Key), KeyOffset, (int) Key.size(), ValueOffset, (int) Value.size());
+            mList.Bind(mData.data());
+        }
+
+        // As if the bytes had been moved somewhere else between reads
+        void Move()
+        {
+            mData = std::string(mData.begin(), mData.end());
+            mData.reserve(mData.size() * 2);
+            mList.Bind(mData.data());
+        }
+
+        std::vector<std::pair<std::string, std::string>> GetAll() const
+        {
+            std::vector<std::pair<std::string, std::string>> All;
+            mList.ForEach([&All] (std::string_view Key, std::string_view Value) { All.emplace_back(Key, Value); });
+            return All;
+        }
+
+        const RequestHeaderList& GetList() const { return mList; }
+
+    private:
+        std::string mData;
+        RequestHeaderList mList;
+    };
+}
+
+TEST(RequestHeaderList, FindsKnownAndOtherHeaders)
+{
+    HeaderLines Lines;
+    Lines.Add("Host", "example.com");
+    Lines.Add("X-Request-Id", "abc");
+    Lines.Add("content-type", "text/plain");
+    EXPECT_EQ(Lines.GetList().GetNum(), 3);
+
+    std::string_view Value;
+    ASSERT_TRUE(Lines.GetList().Find(HttpHeader::HttpHeader_Host, Value));
+    EXPECT_EQ(Value, "example.com");
+    ASSERT_TRUE(Lines.GetList().Find(HttpHeader::HttpHeader_ContentType, Value));
+    EXPECT_EQ(Value, "text/plain");
+    EXPECT_FALSE(Lines.GetList().Find(HttpHeader::HttpHeader_Cookie, Value));
+    EXPECT_FALSE(Lines.GetList().Find(HttpHeader::HttpHeader_Unknown, Value));
+
+    // Names are case-insensitive whether they're known or not
+    ASSERT_TRUE(Lines.GetList().Find("HOST", Value));
+    EXPECT_EQ(Value, "example.com");
+    ASSERT_TRUE(Lines.GetList().Find("x-request-ID", Value));
+    EXPECT_EQ(Value, "abc");
+    EXPECT_FALSE(Lines.GetList().Find("X-Request", Value));
+    EXPECT_FALSE(Lines.GetList().Find("X-Request-Id2", Value));
+}
+
+TEST(RequestHeaderList, RepeatsKeepTheFirstAndAllAreListed)
+{
+    HeaderLines Lines;
+    Lines.Add("Accept", "text/html");
+    Lines.Add("X-Thing", "1");
+    Lines.Add("Accept", "text/plain");
+    Lines.Add("X-Thing", "2");
+    EXPECT_EQ(Lines.GetList().GetNum(), 4);
+
+    std::string_view Value;
+    ASSERT_TRUE(Lines.GetList().Find(HttpHeader::HttpHeader_Accept, Value));
+    EXPECT_EQ(Value, "text/html");
+    ASSERT_TRUE(Lines.GetList().Find("x-thing", Value));
+    EXPECT_EQ(Value, "1");
+
+    // Known headers first in HttpHeader order, then the rest (repeats of known ones among them) as they arrived
+    const std::vector<std::pair<std::string, std::string>> Expected =
+    {
+        { "Accept", "text/html" }, { "X-Thing", "1" }, { "Accept", "text/plain" }, { "X-Thing", "2" },
+    };
+    EXPECT_EQ(Lines.GetAll(), Expected);
+}
+
+TEST(RequestHeaderList, ForEachListsKnownHeadersInTheirOrder)
+{
+    HeaderLines Lines;
+    Lines.Add("User-Agent", "test");
+    Lines.Add("X-First", "a");
+    Lines.Add("Accept", "*/*");
+    Lines.Add("Host", "h");
+    Lines.Add("X-Second", "b");
+
+    const std::vector<std::pair<std::string, std::string>> Expected =
+    {
+        { "Accept", "*/*" }, { "Host", "h" }, { "User-Agent", "test" }, { "X-First", "a" }, { "X-Second", "b" },
+    };
+    EXPECT_EQ(Lines.GetAll(), Expected);
+}
+
+TEST(RequestHeaderList, OverflowsPastTheInlineHeaders)
+{
+    HeaderLines Lines;
+    const int NumOther = RequestHeaderList::InlineCapacity + 10;
+    Lines.Add("Host", "h");
+    for(int i = 0; i < NumOther; i++)
+    {
+        Lines.Add("X-Header-" + std::to_string(i), "value-" + std::to_string(i));
+    }
+    EXPECT_EQ(Lines.GetList().GetNum(), NumOther + 1);
+
+    // Either side of the inline ones running out, and every one in order
+    std::string_view Value;
+    for(int i : { 0, RequestHeaderList::InlineCapacity - 1, RequestHeaderList::InlineCapacity, NumOther - 1 })
+    {
+        ASSERT_TRUE(Lines.GetList().Find("x-header-" + std::to_string(i), Value)) << i;
+        EXPECT_EQ(Value, "value-" + std::to_string(i));
+    }
+    EXPECT_FALSE(Lines.GetList().Find("X-Header-" + std::to_string(NumOther), Value));
+
+    const std::vector<std::pair<std::string, std::string>> All = Lines.GetAll();
+    ASSERT_EQ(All.size(), (size_t) NumOther + 1);
+    EXPECT_EQ(All[0].first, "Host");
+    for(int i = 0; i < NumOther; i++)
+    {
+        EXPECT_EQ(All[i + 1].first, "X-Header-" + std::to_string(i));
+        EXPECT_EQ(All[i + 1].second, "value-" + std::to_string(i));
+    }
+}
+
+TEST(RequestHeaderList, ViewsFollowTheBoundData)
+{
+    HeaderLines Lines;
+    Lines.Add("Host", "example.com");
+    Lines.Add("X-Custom", "value");
+    Lines.Move();
+
+    std::string_view Value;
+    ASSERT_TRUE(Lines.GetList().Find("X-Custom", Value));
+    EXPECT_EQ(Value, "value");
+    ASSERT_TRUE(Lines.GetList().Find(HttpHeader::HttpHeader_Host, Value));
+    EXPECT_EQ(Value, "example.com");
+}
+
+TEST(HttpHeaderInterning, EveryKnownNameInAnyCase)
+{
+    for(int i = 0; i < NumKnownHttpHeaders; i++)
+    {
+        const HttpHeader Header = (HttpHeader) i;
+        const std::string Name(GetHttpHeaderName(Header));
+        std::string Lower = Name;
+        std::string Upper = Name;
+        std::string Alternating = Name;
+        for(size_t c = 0; c < Name.size(); c++)
+        {
+            Lower[c] = (char) tolower((unsigned char) Name[c]);
+            Upper[c] = (char) toupper((unsigned char) Name[c]);
+            Alternating[c] = (c % 2 == 0) ? Upper[c] : Lower[c];
+        }
+        EXPECT_EQ(FindHttpHeader(Name), Header) << Name;
+        EXPECT_EQ(FindHttpHeader(Lower), Header) << Lower;
+        EXPECT_EQ(FindHttpHeader(Upper), Header) << Upper;
+        EXPECT_EQ(FindHttpHeader(Alternating), Header) << Alternating;
+    }
+}
+
+TEST(HttpHeaderInterning, UnknownNames)
+{
+    for(const char* Name : { "", "X-Custom", "Hosts", "Hos", "Content-Lengths", "Accept-Charset", "Sec-WebSocket-Extensions", "DNT" })
+    {
+        EXPECT_EQ(FindHttpHeader(Name), HttpHeader::HttpHeader_Unknown) << Name;
+    }
+
+    // Longer than any slot's name, nothing past the slot gets read
+    EXPECT_EQ(FindHttpHeader(std::string(64, 'a')), HttpHeader::HttpHeader_Unknown);
+    EXPECT_EQ(FindHttpHeader("Sec-WebSocket-Protocol-And-A-Lot-More"), HttpHeader::HttpHeader_Unknown);
+}
+
+TEST(HttpHeaderInterning, NearMissesAreUnknown)
+{
+    for(int i = 0; i < NumKnownHttpHeaders; i++)
+    {
+        const std::string Name(GetHttpHeaderName((HttpHeader) i));
+        for(size_t c = 0; c < Name.size(); c++)
+        {
+            // Same length, first, middle and last character as the name (so the same slot) but one byte off
+            if(c != 0 && c != Name.size() / 2 && c != Name.size() - 1)
+            {
+                std::string Changed = Name;
+                Changed[c] = (Changed[c] == 'q') ? 'z' : 'q';
+                EXPECT_EQ(FindHttpHeader(Changed), HttpHeader::HttpHeader_Unknown) << Changed;
+            }
+
+            // Bytes that only lower case to the name's if the top bit or non-letters are lowered carelessly
+            std::string HighBit = Name;
+            HighBit[c] = (char) (HighBit[c] | 0x80);
+            EXPECT_EQ(FindHttpHeader(HighBit), HttpHeader::HttpHeader_Unknown) << i << " " << c;
+            if(Name[c] == '-')
+            {
+                std::string ControlByte = Name;
+                ControlByte[c] = '\r';      // '\r' | 0x20 is '-'
+                EXPECT_EQ(FindHttpHeader(ControlByte), HttpHeader::HttpHeader_Unknown) << i << " " << c;
+            }
+        }
+    }
+}
+
+TEST(ResponseHeaderList, AddKeepsAndSetReplaces)
+{
+    ResponseHeaderList Headers;
+    Headers.Add("Content-Type", "text/plain");
+    Headers.Add("content-type", "text/html");
+    Headers.Add("X-Custom", "1");
+    Headers.Add("x-custom", "2");
+    ASSERT_NE(Headers.Find(HttpHeader::HttpHeader_ContentType), nullptr);
+    EXPECT_EQ(*Headers.Find(HttpHeader::HttpHeader_ContentType), "text/plain");
+    ASSERT_NE(Headers.Find("X-CUSTOM"), nullptr);
+    EXPECT_EQ(*Headers.Find("X-CUSTOM"), "1");
+
+    Headers.Set("CONTENT-TYPE", "text/html");
+    Headers.Set("x-custom", "2");
+    EXPECT_EQ(*Headers.Find("Content-Type"), "text/html");
+    EXPECT_EQ(*Headers.Find("X-Custom"), "2");
+    EXPECT_EQ(Headers.Find("X-Missing"), nullptr);
+    EXPECT_EQ(Headers.Find(HttpHeader::HttpHeader_Host), nullptr);
+
+    // Known ones under their canonical name in HttpHeader order, then the rest as first added
+    Headers.Add("Cache-Control", "no-store");
+    std::vector<std::pair<std::string, std::string>> All;
+    Headers.ForEach([&All] (std::string_view Key, const std::string& Value) { All.emplace_back(Key, Value); });
+    const std::vector<std::pair<std::string, std::string>> Expected =
+    {
+        { "Cache-Control", "no-store" }, { "Content-Type", "text/html" }, { "X-Custom", "2" },
+    };
+    EXPECT_EQ(All, Expected);
+}
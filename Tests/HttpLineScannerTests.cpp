@@ -0,0 +1,220 @@
+#include "HttpLineScanner.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace WebServer;
+
+namespace
+{
+    const HttpScanImplementation Implementations[] =
+    {
+        HttpScanImplementation::HttpScanImplementation_Scalar,
+        HttpScanImplementation::HttpScanImplementation_Sse42,
+        HttpScanImplementation::HttpScanImplementation_Avx2,
+    };
+
+    const char* GetImplementationName(HttpScanImplementation Implementation)
+    {
+        switch(Implementation)
+        {
+            case HttpScanImplementation::HttpScanImplementation_Sse42: return "sse4.2";
+            case HttpScanImplementation::HttpScanImplementation_Avx2: return "avx2";
+            default: return "scalar";
+        }
+    }
+
+    ::testing::AssertionResult ScansMatch(const HttpLineScan& Actual, const HttpLineScan& Expected)
+    {
+        if(Actual.ScannedLength == Expected.ScannedLength && Actual.LineLength == Expected.LineLength && Actual.FirstColon == Expected.FirstColon
+            && Actual.FirstSpace == Expected.FirstSpace && Actual.LastSpace == Expected.LastSpace && Actual.FirstNonToken == Expected.FirstNonToken
+            && Actual.FirstControl == Expected.FirstControl)
+        {
+            return ::testing::AssertionSuccess();
+        }
+        return ::testing::AssertionFailure() << "scanned " << Actual.ScannedLength << "/" << Expected.ScannedLength << " length " << Actual.LineLength << "/"
+            << Expected.LineLength << " colon " << Actual.FirstColon << "/" << Expected.FirstColon << " space " << Actual.FirstSpace << "/" << Expected.FirstSpace
+            << " last space " << Actual.LastSpace << "/" << Expected.LastSpace << " non token " << Actual.FirstNonToken << "/" << Expected.FirstNonToken
+            << " control " << Actual.FirstControl << "/" << Expected.FirstControl;
+    }
+
+    // Worked out a byte at a time with nothing clever, what every implementation has to agree with
+    HttpLineScan ReferenceScan(const std::string& Data)
+    {
+        HttpLineScan Scan;
+        for(int i = 0; i < (int) Data.size(); i++)
+        {
+            const unsigned char c = (unsigned char) Data[i];
+            if(c == '\n')
+            {
+                Scan.LineLength = i;
+                Scan.ScannedLength = i + 1;
+                return Scan;
+            }
+            const bool bToken = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || std::string("!#$%&'*+-.^_`|~").find((char) c) != std::string::npos;
+            const bool bControl = (c < 0x20 && c != '\t') || c == 0x7F;
+            Scan.FirstColon = (Scan.FirstColon == -1 && c == ':') ? i : Scan.FirstColon;
+            Scan.FirstSpace = (Scan.FirstSpace == -1 && c == ' ') ? i : Scan.FirstSpace;
+            Scan.LastSpace = (c == ' ') ? i : Scan.LastSpace;
+            Scan.FirstNonToken = (Scan.FirstNonToken == -1 && bToken == false) ? i : Scan.FirstNonToken;
+            Scan.FirstControl = (Scan.FirstControl == -1 && bControl) ? i : Scan.FirstControl;
+        }
+        Scan.ScannedLength = (int) Data.size();
+        return Scan;
+    }
+
+    // Random bytes weighted towards the ones the scan looks for, Length of them then a '\n' and some of the next line
+    std::string BuildRandomLine(std::mt19937& Random, int Length)
+    {
+        static const std::string Common = "abcXYZ019-_.!~ :/?=&\t";
+        std::string Line;
+        for(int i = 0; i < Length; i++)
+        {
+            const unsigned Pick = Random() % 100;
+            if(Pick < 85)
+            {
+                Line += Common[Random() % Common.size()];
+            }
+            else if(Pick < 90)
+            {
+                Line += (char) (Random() % 0x20);       // control bytes, '\n' among them
+            }
+            else if(Pick < 95)
+            {
+                Line += (char) (0x7F + Random() % 0x81);     // DEL and up
+            }
+            else
+            {
+                Line += (Random() % 2 == 0) ? '\r' : '"';
+            }
+        }
+        return Line + "\nNext: line";
+    }
+
+    // Each implementation in turn, whatever was active is put back afterwards
+    class HttpLineScannerTest : public ::testing::Test
+    {
+    protected:
+        void SetUp() override { mPrevious = GetHttpScanImplementation(); }
+        void TearDown() override { SetHttpScanImplementation(mPrevious); }
+
+        // Data whole, then split in two at every point, then a byte at a time, checked against the reference each way
+        void CheckAllImplementations(const std::string& Data)
+        {
+            const HttpLineScan Expected = ReferenceScan(Data);
+            const int LineEnd = Expected.IsComplete() ? Expected.LineLength : (int) Data.size();
+            for(HttpScanImplementation Implementation : Implementations)
+            {
+                if(SetHttpScanImplementation(Implementation) == false)
+                {
+                    continue;
+                }
+                SCOPED_TRACE(GetImplementationName(Implementation));
+
+                HttpLineScan Whole;
+                ContinueHttpLineScan(Data.data(), (int) Data.size(), Whole);
+                if(Expected.IsComplete())
+                {
+                    ASSERT_TRUE(ScansMatch(Whole, Expected)) << EscapedLine(Data);
+                }
+                else
+                {
+                    // A vector path may hold a partial block back until there's more, what it has found so far has to be right
+                    EXPECT_FALSE(Whole.IsComplete());
+                    EXPECT_LE(Whole.ScannedLength, (int) Data.size());
+                }
+
+                // The bytes past a split are there in the buffer, a scan that read beyond its length would see the '\n' early
+                for(int Split = 0; Split <= (int) Data.size(); Split++)
+                {
+                    HttpLineScan Resumed;
+                    ContinueHttpLineScan(Data.data(), Split, Resumed);
+                    EXPECT_EQ(Resumed.IsComplete(), Expected.IsComplete() && Split > LineEnd) << "split at " << Split << EscapedLine(Data);
+                    ContinueHttpLineScan(Data.data(), (int) Data.size(), Resumed);
+                    if(Expected.IsComplete())
+                    {
+                        ASSERT_TRUE(ScansMatch(Resumed, Expected)) << "split at " << Split << EscapedLine(Data);
+                    }
+                }
+
+                HttpLineScan ByteByByte;
+                for(int Length = 1; Length <= (int) Data.size() && ByteByByte.IsComplete() == false; Length++)
+                {
+                    ContinueHttpLineScan(Data.data(), Length, ByteByByte);
+                }
+                if(Expected.IsComplete())
+                {
+                    ASSERT_TRUE(ScansMatch(ByteByByte, Expected)) << "byte by byte" << EscapedLine(Data);
+                }
+            }
+        }
+
+        static std::string EscapedLine(const std::string& Data)
+        {
+            std::string Escaped = " in \"";
+            for(char c : Data)
+            {
+                char Hex[8];
+                snprintf(Hex, sizeof(Hex), "\\x%02x", (unsigned char) c);
+                Escaped += (c >= 0x20 && c < 0x7F) ? std::string(1, c) : std::string(Hex);
+            }
+            return Escaped + "\"";
+        }
+
+        HttpScanImplementation mPrevious = HttpScanImplementation::HttpScanImplementation_Scalar;
+    };
+}
+
+TEST_F(HttpLineScannerTest, ScalarIsAlwaysSupported)
+{
+    EXPECT_TRUE(IsHttpScanImplementationSupported(HttpScanImplementation::HttpScanImplementation_Scalar));
+    EXPECT_TRUE(IsHttpScanImplementationSupported(GetHttpScanImplementation()));
+    EXPECT_TRUE(SetHttpScanImplementation(HttpScanImplementation::HttpScanImplementation_Scalar));
+    EXPECT_EQ(GetHttpScanImplementation(), HttpScanImplementation::HttpScanImplementation_Scalar);
+}
+
+TEST_F(HttpLineScannerTest, RequestHeadLines)
+{
+    CheckAllImplementations("GET /index.html?a=b HTTP/1.1\r\n");
+    CheckAllImplementations("Host: example.com\r\n");
+    CheckAllImplementations("Content-Type: multipart/form-data; boundary=----WebKitFormBoundary7MA4YWxkTrZu0gW\r\n");
+    CheckAllImplementations("\r\n");
+    CheckAllImplementations("\n");
+    CheckAllImplementations("X-Tabbed:\tvalue\twith tabs\r\n");
+}
+
+TEST_F(HttpLineScannerTest, FindingsAtBlockEdges)
+{
+    // Each thing the scan looks for at every position either side of the 16 and 32 byte blocks
+    const char Specials[] = { '\n', ':', ' ', '"', '\x01', '\x7f', '\r', '\x80', '\t' };
+    for(char Special : Specials)
+    {
+        for(int Position = 0; Position < 70; Position++)
+        {
+            std::string Line(80, 'a');
+            Line[Position] = Special;
+            CheckAllImplementations(Line + "\n");
+        }
+    }
+}
+
+TEST_F(HttpLineScannerTest, IncompleteLines)
+{
+    for(int Length = 0; Length < 100; Length++)
+    {
+        CheckAllImplementations(std::string(Length, 'k') + ": v");
+    }
+}
+
+TEST_F(HttpLineScannerTest, RandomLinesMatchTheReference)
+{
+    std::mt19937 Random(12345);
+    for(int i = 0; i < 300; i++)
+    {
+        CheckAllImplementations(BuildRandomLine(Random, (int) (Random() % 130)));
+    }
+}
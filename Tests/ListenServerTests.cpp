@@ -0,0 +1,688 @@
+#include "TestCommon.h"
+
+#include "IoUringEngine.h"
+#include "WebServer.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace WebServer;
+
+namespace
+{
+    const std::string PageBody = "hello";
+
+    // A server with one page on its own port, run on the engine the test's parameter picks
+    class ListenServerTest : public ::testing::TestWithParam<ListenServerIoMode>
+    {
+    protected:
+        void StartServer(uint16_t BasePort, ListenServerConfig Config = {})
+        {
+            StartServer(mServer, BasePort, Config);
+            bStarted = HasFatalFailure() == false && IsSkipped() == false;
+        }
+
+        // A server of the test's own, for one that has to go before the test's done
+        void StartServer(ListenServer& Server, uint16_t BasePort, ListenServerConfig Config = {})
+        {
+            if(GetParam() == ListenServerIoMode::ListenServerIoMode_IoUring && IoUringEngine::IsSupported() == false)
+            {
+                GTEST_SKIP() << "io_uring unavailable";
+            }
+
+            // The two engines run side by side under ctest -j, they each get a port
+            mPort = (uint16_t) (BasePort + ((GetParam() == ListenServerIoMode::ListenServerIoMode_IoUring) ? 1 : 0));
+            Config.IoMode = GetParam();
+            // Long enough that a connection closing can only have been the server deciding to
+            Config.KeepAliveIdleTimeoutMs = 30000;
+            ASSERT_EQ(Server.Initialise(std::to_string(mPort).c_str(), Config), 0);
+            Server.UploadData("/page", std::vector<char>(PageBody.begin(), PageBody.end()), "text/plain", {});
+            Server.AsyncStart();
+        }
+
+        void TearDown() override
+        {
+            if(bStarted)
+            {
+                mServer.CloseServer();
+            }
+        }
+
+        // The workers start listening on their own threads, a connection can be refused for a moment after AsyncStart
+        SOCKET Connect(int ReceiveBufferSize = 0)
+        {
+            SOCKET Socket = TestUtil::ConnectLoopback(mPort, ReceiveBufferSize);
+            for(int i = 0; i < 200 && Socket == INVALID_SOCKET; i++)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                Socket = TestUtil::ConnectLoopback(mPort, ReceiveBufferSize);
+            }
+            return Socket;
+        }
+
+        // The response to Request on Socket, checked as the page
+        std::string RequestPage(SOCKET Socket, const std::string& Request)
+        {
+            EXPECT_TRUE(TestUtil::SendString(Socket, Request));
+            std::string Response = TestUtil::ReceiveResponse(Socket);
+            EXPECT_EQ(Response.rfind("HTTP/1.1 200 Ok\r\n", 0), 0u) << Response;
+            EXPECT_EQ(Response.size() >= PageBody.size() ? Response.substr(Response.size() - PageBody.size()) : Response, PageBody);
+            return Response;
+        }
+
+        // Pages with bodies that say which they are, so a response turning up in the wrong place shows
+        static std::string BuildNumberedBody(int Number, size_t Length)
+        {
+            std::string Body = "page " + std::to_string(Number) + "|";
+            Body.reserve(Length);
+            for(size_t i = Body.size(); i < Length; i++)
+            {
+                Body += (char) ('a' + (Number + i) % 26);
+            }
+            return Body;
+        }
+
+        // Page i on UrlPrefix + i, Lengths[i] long
+        void UploadNumberedPages(const std::string& UrlPrefix, const std::vector<size_t>& Lengths)
+        {
+            for(int i = 0; i < (int) Lengths.size(); i++)
+            {
+                const std::string Body = BuildNumberedBody(i, Lengths[i]);
+                mServer.UploadData(UrlPrefix + std::to_string(i), std::vector<char>(Body.begin(), Body.end()), "text/plain", {});
+            }
+        }
+
+        // A client that takes its time, a small receive buffer keeps the server's sends coming back short
+        SOCKET ConnectSlowReader()
+        {
+            return Connect(16 * 1024);
+        }
+
+        // Requests sent one at a time alongside the reading, so the server queues responses while earlier ones are still
+        // part way out
+        static std::thread SendRequestsSpacedOut(SOCKET Socket, std::vector<std::string> Requests)
+        {
+            return std::thread([Socket, Requests = std::move(Requests)] ()
+            {
+                for(const std::string& Request : Requests)
+                {
+                    TestUtil::SendString(Socket, Request);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                }
+            });
+        }
+
+        // Each response in turn has to be the numbered page it asked for, whole. Read a little at a time with pauses
+        // in between, so the server's sends keep finding the socket full and come back short
+        void ExpectNumberedResponses(SOCKET Socket, const std::string& UrlPrefix, const std::vector<int>& Numbers, const std::vector<size_t>& Lengths)
+        {
+            std::string Received;
+            size_t ResponseStart = 0;
+            const auto ReceiveMore = [&Received, Socket] ()
+            {
+                char Buffer[4096];
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                const int Read = TestUtil::ReceiveSome(Socket, Buffer, (int) sizeof(Buffer));
+                Received.append(Buffer, (size_t) std::max(Read, 0));
+                return Read > 0;
+            };
+
+            for(size_t i = 0; i < Numbers.size(); i++)
+            {
+                size_t HeadEnd;
+                while((HeadEnd = Received.find("\r\n\r\n", ResponseStart)) == std::string::npos)
+                {
+                    ASSERT_TRUE(ReceiveMore()) << "response " << i << " never came";
+                }
+                const std::string Head = Received.substr(ResponseStart, HeadEnd + 4 - ResponseStart);
+                ASSERT_EQ(Head.rfind("HTTP/1.1 200 Ok\r\n", 0), 0u) << UrlPrefix << Numbers[i] << ", response " << i << ": " << Head;
+                const size_t LengthHeader = Head.find("Content-Length: ");
+                ASSERT_NE(LengthHeader, std::string::npos) << Head;
+                const size_t Length = Lengths[Numbers[i]];
+                ASSERT_EQ(std::strtoull(Head.c_str() + LengthHeader + 16, nullptr, 10), Length) << Head;
+
+                while(Received.size() < HeadEnd + 4 + Length)
+                {
+                    ASSERT_TRUE(ReceiveMore()) << UrlPrefix << Numbers[i] << " cut short";
+                }
+                const std::string Body = BuildNumberedBody(Numbers[i], Length);
+                ASSERT_TRUE(Received.compare(HeadEnd + 4, Length, Body) == 0)
+                    << UrlPrefix << Numbers[i] << ", response " << i << " isn't its page, there's a head at "
+                    << (long long) Received.find("HTTP/1.1", HeadEnd + 4) - (long long) (HeadEnd + 4);
+                ResponseStart = HeadEnd + 4 + Length;
+            }
+            EXPECT_EQ(Received.size(), ResponseStart);
+        }
+
+        // A chunked response's head, with its body put back together after it. Empty if the connection went first
+        static std::string ReceiveChunkedResponse(SOCKET Socket)
+        {
+            std::string Received;
+            size_t Parsed = std::string::npos;
+            std::string Body;
+            while(true)
+            {
+                if(Parsed == std::string::npos && (Parsed = Received.find("\r\n\r\n")) != std::string::npos)
+                {
+                    Parsed += 4;
+                }
+
+                // As many whole chunks as there are so far
+                size_t SizeEnd;
+                while(Parsed != std::string::npos && (SizeEnd = Received.find("\r\n", Parsed)) != std::string::npos)
+                {
+                    const size_t ChunkSize = std::strtoull(Received.c_str() + Parsed, nullptr, 16);
+                    if(Received.size() < SizeEnd + 2 + ChunkSize + 2)
+                    {
+                        break;
+                    }
+                    if(ChunkSize == 0)
+                    {
+                        return Received.substr(0, Received.find("\r\n\r\n") + 4) + Body;
+                    }
+                    Body.append(Received, SizeEnd + 2, ChunkSize);
+                    Parsed = SizeEnd + 2 + ChunkSize + 2;
+                }
+
+                char Buffer[64 * 1024];
+                const int Read = TestUtil::ReceiveSome(Socket, Buffer, (int) sizeof(Buffer));
+                if(Read <= 0)
+                {
+                    return "";
+                }
+                Received.append(Buffer, (size_t) Read);
+            }
+        }
+
+        ListenServer mServer;
+        uint16_t mPort = 0;
+        bool bStarted = false;
+    };
+
+    std::string IoModeName(const ::testing::TestParamInfo<ListenServerIoMode>& Info)
+    {
+        return (Info.param == ListenServerIoMode::ListenServerIoMode_IoUring) ? "IoUring" : "Poll";
+    }
+}
+
+TEST_P(ListenServerTest, Http10ClosesAfterItsResponse)
+{
+    StartServer(28410);
+    SOCKET Socket = Connect();
+    ASSERT_NE(Socket, INVALID_SOCKET);
+
+    const std::string Response = RequestPage(Socket, "GET /page HTTP/1.0\r\n\r\n");
+    EXPECT_NE(Response.find("Connection: close\r\n"), std::string::npos) << Response;
+    EXPECT_TRUE(TestUtil::IsClosedByPeer(Socket));
+    CloseSocket(Socket);
+}
+
+TEST_P(ListenServerTest, Http10KeepAliveIsAnnouncedAndKept)
+{
+    StartServer(28412);
+    SOCKET Socket = Connect();
+    ASSERT_NE(Socket, INVALID_SOCKET);
+
+    for(int i = 0; i < 3; i++)
+    {
+        const std::string Response = RequestPage(Socket, "GET /page HTTP/1.0\r\nConnection: keep-alive\r\n\r\n");
+        EXPECT_NE(Response.find("Connection: keep-alive\r\n"), std::string::npos) << Response;
+    }
+
+    // Once it stops asking it's closed like any other 1.0 request
+    const std::string Response = RequestPage(Socket, "GET /page HTTP/1.0\r\n\r\n");
+    EXPECT_NE(Response.find("Connection: close\r\n"), std::string::npos) << Response;
+    EXPECT_TRUE(TestUtil::IsClosedByPeer(Socket));
+    CloseSocket(Socket);
+}
+
+TEST_P(ListenServerTest, Http11KeepsAliveWithoutSayingSo)
+{
+    StartServer(28414);
+    SOCKET Socket = Connect();
+    ASSERT_NE(Socket, INVALID_SOCKET);
+
+    for(int i = 0; i < 3; i++)
+    {
+        const std::string Response = RequestPage(Socket, "GET /page HTTP/1.1\r\nHost: a\r\n\r\n");
+        EXPECT_EQ(Response.find("Connection:"), std::string::npos) << Response;
+    }
+
+    const std::string Response = RequestPage(Socket, "GET /page HTTP/1.1\r\nConnection: close\r\n\r\n");
+    EXPECT_NE(Response.find("Connection: close\r\n"), std::string::npos) << Response;
+    EXPECT_TRUE(TestUtil::IsClosedByPeer(Socket));
+    CloseSocket(Socket);
+}
+
+TEST_P(ListenServerTest, RequestCapClosesAKeptHttp10Connection)
+{
+    ListenServerConfig Config;
+    Config.MaxKeepAliveRequests = 2;
+    StartServer(28416, Config);
+    SOCKET Socket = Connect();
+    ASSERT_NE(Socket, INVALID_SOCKET);
+
+    const std::string First = RequestPage(Socket, "GET /page HTTP/1.0\r\nConnection: keep-alive\r\n\r\n");
+    EXPECT_NE(First.find("Connection: keep-alive\r\n"), std::string::npos) << First;
+    const std::string Second = RequestPage(Socket, "GET /page HTTP/1.0\r\nConnection: keep-alive\r\n\r\n");
+    EXPECT_NE(Second.find("Connection: close\r\n"), std::string::npos) << Second;
+    EXPECT_TRUE(TestUtil::IsClosedByPeer(Socket));
+    CloseSocket(Socket);
+}
+
+TEST_P(ListenServerTest, UnsupportedVersionGets505)
+{
+    StartServer(28418);
+    SOCKET Socket = Connect();
+    ASSERT_NE(Socket, INVALID_SOCKET);
+
+    ASSERT_TRUE(TestUtil::SendString(Socket, "GET /page HTTP/2.0\r\n\r\n"));
+    const std::string Response = TestUtil::ReceiveResponse(Socket);
+    EXPECT_EQ(Response.rfind("HTTP/1.1 505 HTTP Version Not Supported\r\n", 0), 0u) << Response;
+    EXPECT_TRUE(TestUtil::IsClosedByPeer(Socket));
+    CloseSocket(Socket);
+
+    // A version that isn't one at all is still a bad request
+    Socket = Connect();
+    ASSERT_NE(Socket, INVALID_SOCKET);
+    ASSERT_TRUE(TestUtil::SendString(Socket, "GET /page HTTP/one\r\n\r\n"));
+    const std::string BadResponse = TestUtil::ReceiveResponse(Socket);
+    EXPECT_EQ(BadResponse.rfind("HTTP/1.1 400 Bad Request\r\n", 0), 0u) << BadResponse;
+    CloseSocket(Socket);
+}
+
+TEST_P(ListenServerTest, DynamicHandlersRunOffTheLoop)
+{
+    // Held until the test lets it go, the page on the same worker has to be served in the meantime. Shared so a failed
+    // assert can still let it go before the server's closed
+    struct HandlerGate
+    {
+        void Release()
+        {
+            {
+                std::lock_guard<std::mutex> Lock(Mutex);
+                bReleased = true;
+            }
+            Released.notify_all();
+        }
+
+        std::mutex Mutex;
+        std::condition_variable Released;
+        bool bReleased = false;
+    };
+    std::shared_ptr<HandlerGate> Gate = std::make_shared<HandlerGate>();
+    std::unique_ptr<HandlerGate, void (*)(HandlerGate*)> ReleaseOnExit(Gate.get(), [] (HandlerGate* Held) { Held->Release(); });
+
+    mServer.CreateDynamicHandler(ServerRequestType::ServerRequestType_GET, "/slow/:id", [Gate] (HandlerRequest& Request)
+    {
+        std::unique_lock<std::mutex> Lock(Gate->Mutex);
+        Gate->Released.wait(Lock, [&Gate] () { return Gate->bReleased; });
+        ServerResponseMessage Response(ServerResponseStatusCode::ServerResponseStatusCode_200);
+        const std::string_view Id = Request.FindParam("id");
+        Response.AddContent(std::vector<char>(Id.begin(), Id.end()), "text/plain");
+        Response.BuildMessage();
+        return Response;
+    });
+    mServer.CreateDynamicHandler(ServerRequestType::ServerRequestType_GET, "/throws", [] (HandlerRequest&) -> ServerResponseMessage
+    {
+        throw std::runtime_error("handler failed");
+    });
+    ListenServerConfig Config;
+    Config.NumWorkers = 1;
+    StartServer(28420, Config);
+
+    SOCKET Slow = Connect();
+    ASSERT_NE(Slow, INVALID_SOCKET);
+    ASSERT_TRUE(TestUtil::SendString(Slow, "GET /slow/42 HTTP/1.1\r\n\r\n"));
+
+    SOCKET Socket = Connect();
+    ASSERT_NE(Socket, INVALID_SOCKET);
+    RequestPage(Socket, "GET /page HTTP/1.1\r\n\r\n");
+
+    ASSERT_TRUE(TestUtil::SendString(Socket, "GET /throws HTTP/1.1\r\n\r\n"));
+    const std::string Failed = TestUtil::ReceiveResponse(Socket);
+    EXPECT_EQ(Failed.rfind("HTTP/1.1 500 Internal Server Error\r\n", 0), 0u) << Failed;
+    CloseSocket(Socket);
+
+    Gate->Release();
+    const std::string Response = TestUtil::ReceiveResponse(Slow);
+    EXPECT_EQ(Response.rfind("HTTP/1.1 200 Ok\r\n", 0), 0u) << Response;
+    EXPECT_EQ(Response.substr(Response.size() >= 2 ? Response.size() - 2 : 0), "42") << Response;
+    CloseSocket(Slow);
+}
+
+TEST_P(ListenServerTest, ReplacedPageLastsUntilItsSendsAreDone)
+{
+    // Big enough that most of it's still queued on the server while the client isn't reading
+    std::vector<char> Body(32 * 1024 * 1024);
+    for(size_t i = 0; i < Body.size(); i++)
+    {
+        Body[i] = (char) ('a' + i % 26);
+    }
+    const std::string ExpectedBody(Body.begin(), Body.end());
+    std::weak_ptr<const ServerResponseMessage> OldPage;
+    {
+        std::shared_ptr<ServerResponseMessage> Page = std::make_shared<ServerResponseMessage>(ServerResponseStatusCode::ServerResponseStatusCode_200);
+        Page->AddContent(std::move(Body), "text/plain");
+        Page->BuildMessage();
+        OldPage = Page;
+        ContentBatch Batch;
+        Batch.Upload("/big", std::move(Page));
+        mServer.CommitContent(std::move(Batch));
+    }
+    StartServer(28422);
+
+    SOCKET Socket = Connect();
+    ASSERT_NE(Socket, INVALID_SOCKET);
+    ASSERT_TRUE(TestUtil::SendString(Socket, "GET /big HTTP/1.1\r\n\r\n"));
+    char First = 0;
+    ASSERT_EQ(TestUtil::ReceiveSome(Socket, &First, 1), 1);
+
+    // Replaced while its send's still going, the old snapshot stays retired rather than freed
+    mServer.UploadData("/big", { 'n', 'e', 'w' }, "text/plain", {});
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_FALSE(OldPage.expired());
+
+    const std::string Response = First + TestUtil::ReceiveResponse(Socket);
+    ASSERT_GE(Response.size(), ExpectedBody.size());
+    EXPECT_TRUE(Response.compare(Response.size() - ExpectedBody.size(), ExpectedBody.size(), ExpectedBody) == 0);
+
+    // Sent in full, the worker reports its pin gone and the snapshot's freed
+    for(int i = 0; i < 500 && OldPage.expired() == false; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_TRUE(OldPage.expired());
+
+    ASSERT_TRUE(TestUtil::SendString(Socket, "GET /big HTTP/1.1\r\n\r\n"));
+    const std::string Replaced = TestUtil::ReceiveResponse(Socket);
+    EXPECT_EQ(Replaced.substr(Replaced.size() >= 3 ? Replaced.size() - 3 : 0), "new") << Replaced;
+    CloseSocket(Socket);
+}
+
+TEST_P(ListenServerTest, PipelinedLargeResponsesStayInOrder)
+{
+    // Sends to a slow reader come back short, the rest of each has to go before the responses queued behind it
+    constexpr int NumRequests = 80;
+    const std::vector<size_t> Lengths(NumRequests, 256 * 1024);
+    UploadNumberedPages("/big/", Lengths);
+    StartServer(28424);
+
+    SOCKET Socket = ConnectSlowReader();
+    ASSERT_NE(Socket, INVALID_SOCKET);
+    std::vector<std::string> Requests;
+    std::vector<int> Numbers;
+    for(int i = 0; i < NumRequests; i++)
+    {
+        Requests.push_back("GET /big/" + std::to_string(i) + " HTTP/1.1\r\n\r\n");
+        Numbers.push_back(i);
+    }
+    std::thread Sender = SendRequestsSpacedOut(Socket, std::move(Requests));
+    ExpectNumberedResponses(Socket, "/big/", Numbers, Lengths);
+    Sender.join();
+    CloseSocket(Socket);
+}
+
+TEST_P(ListenServerTest, ClosingConnectionSendsItsLastResponseInFull)
+{
+    // The last request asks for the connection to close, which waits for all of its response to go rather than for a
+    // send that came back short
+    constexpr int NumRequests = 20;
+    const std::vector<size_t> Lengths(NumRequests, 512 * 1024);
+    UploadNumberedPages("/big/", Lengths);
+    StartServer(28426);
+
+    for(int Attempt = 0; Attempt < 3; Attempt++)
+    {
+        SOCKET Socket = ConnectSlowReader();
+        ASSERT_NE(Socket, INVALID_SOCKET);
+        std::vector<std::string> Requests;
+        std::vector<int> Numbers;
+        for(int i = 0; i < NumRequests; i++)
+        {
+            Requests.push_back("GET /big/" + std::to_string(i) + " HTTP/1.1\r\n" + ((i == NumRequests - 1) ? "Connection: close\r\n" : "") + "\r\n");
+            Numbers.push_back(i);
+        }
+        std::thread Sender = SendRequestsSpacedOut(Socket, std::move(Requests));
+        ExpectNumberedResponses(Socket, "/big/", Numbers, Lengths);
+        Sender.join();
+        EXPECT_TRUE(TestUtil::IsClosedByPeer(Socket));
+        CloseSocket(Socket);
+    }
+}
+
+TEST_P(ListenServerTest, PipelinedRequestsInOneSegment)
+{
+    // Enough responses in one go to need several 64 buffer sendmsgs, with every tenth bigger than the client's
+    // receive buffer. Some pages are asked for more than once
+    constexpr int NumPages = 40;
+    std::vector<size_t> Lengths;
+    for(int i = 0; i < NumPages; i++)
+    {
+        Lengths.push_back((i % 10 == 9) ? 64 * 1024 : 1000 + i * 10);
+    }
+    UploadNumberedPages("/p/", Lengths);
+    StartServer(28428);
+
+    SOCKET Socket = ConnectSlowReader();
+    ASSERT_NE(Socket, INVALID_SOCKET);
+    std::string Requests;
+    std::vector<int> Numbers;
+    for(int i = 0; i < 150; i++)
+    {
+        Numbers.push_back((i * 7) % NumPages);
+        Requests += "GET /p/" + std::to_string(Numbers.back()) + " HTTP/1.1\r\nHost: a\r\n\r\n";
+    }
+    ASSERT_LT(Requests.size(), (size_t) 8192);     // one segment, read by the server in one go
+    ASSERT_TRUE(TestUtil::SendString(Socket, Requests));
+    ExpectNumberedResponses(Socket, "/p/", Numbers, Lengths);
+    CloseSocket(Socket);
+}
+
+TEST_P(ListenServerTest, ResponseTokensOutliveTheServer)
+{
+    // Handed off somewhere the server knows nothing about and still held once it's gone, one to complete and one to drop
+    struct HeldTokens
+    {
+        std::mutex Mutex;
+        std::condition_variable Arrived;
+        std::vector<ResponseToken> Tokens;
+    };
+    std::shared_ptr<HeldTokens> Held = std::make_shared<HeldTokens>();
+    std::unique_ptr<ListenServer> Server = std::make_unique<ListenServer>();
+    Server->CreateDeferredHandler(ServerRequestType::ServerRequestType_GET, "/held", [Held] (HandlerRequest&, ResponseToken Token)
+    {
+        {
+            std::lock_guard<std::mutex> Lock(Held->Mutex);
+            Held->Tokens.push_back(std::move(Token));
+        }
+        Held->Arrived.notify_all();
+    });
+    StartServer(*Server, 28430);
+
+    SOCKET Sockets[2];
+    for(SOCKET& Socket : Sockets)
+    {
+        Socket = Connect();
+        ASSERT_NE(Socket, INVALID_SOCKET);
+        ASSERT_TRUE(TestUtil::SendString(Socket, "GET /held HTTP/1.1\r\n\r\n"));
+    }
+    {
+        std::unique_lock<std::mutex> Lock(Held->Mutex);
+        ASSERT_TRUE(Held->Arrived.wait_for(Lock, std::chrono::seconds(5), [&Held] () { return Held->Tokens.size() == 2; }));
+    }
+
+    Server.reset();
+    for(SOCKET Socket : Sockets)
+    {
+        CloseSocket(Socket);
+    }
+
+    ServerResponseMessage Response(ServerResponseStatusCode::ServerResponseStatusCode_200);
+    Response.AddContent(std::vector<char>(PageBody.begin(), PageBody.end()), "text/plain");
+    EXPECT_FALSE(Held->Tokens[0].Complete(std::move(Response)));
+    EXPECT_FALSE(Held->Tokens[1].IsCompleted());
+    Held->Tokens.clear();
+}
+
+TEST_P(ListenServerTest, ResponseTokensAnswerOnce)
+{
+    // What the handlers saw, for the test to check once their responses are in
+    struct TokenResults
+    {
+        std::atomic<bool> bFirstCompleted = false;
+        std::atomic<bool> bSecondCompleted = true;
+        std::atomic<bool> bCopyCompleted = true;
+        std::atomic<bool> bCompletedAfter = false;
+    };
+    std::shared_ptr<TokenResults> Results = std::make_shared<TokenResults>();
+    std::vector<std::thread> Completers;
+    std::mutex CompletersMutex;
+
+    const auto BuildResponse = [] (const std::string& Body)
+    {
+        ServerResponseMessage Response(ServerResponseStatusCode::ServerResponseStatusCode_200);
+        Response.AddContent(std::vector<char>(Body.begin(), Body.end()), "text/plain");
+        return Response;
+    };
+    mServer.CreateDeferredHandler(ServerRequestType::ServerRequestType_GET, "/twice", [Results, BuildResponse] (HandlerRequest&, ResponseToken Token)
+    {
+        ResponseToken Copy = Token;
+        Results->bFirstCompleted = Token.Complete(BuildResponse("first"));
+        Results->bSecondCompleted = Token.Complete(BuildResponse("second"));
+        Results->bCopyCompleted = Copy.Complete(BuildResponse("copy"));
+        Results->bCompletedAfter = Copy.IsCompleted();
+    });
+    mServer.CreateDeferredHandler(ServerRequestType::ServerRequestType_GET, "/dropped", [] (HandlerRequest&, ResponseToken)
+    {
+    });
+    mServer.CreateDeferredHandler(ServerRequestType::ServerRequestType_GET, "/elsewhere/:id", [&Completers, &CompletersMutex, BuildResponse] (HandlerRequest& Request, ResponseToken Token)
+    {
+        // Finished on a thread of its own, after the handler's long gone
+        std::lock_guard<std::mutex> Lock(CompletersMutex);
+        Completers.emplace_back([Token, Body = std::string(Request.FindParam("id")), BuildResponse] () mutable
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            Token.Complete(BuildResponse(Body));
+        });
+    });
+    ListenServerConfig Config;
+    Config.NumWorkers = 1;
+    StartServer(28432, Config);
+
+    SOCKET Socket = Connect();
+    ASSERT_NE(Socket, INVALID_SOCKET);
+
+    // The first Complete wins, any after it from the token or its copies come to nothing
+    ASSERT_TRUE(TestUtil::SendString(Socket, "GET /twice HTTP/1.1\r\n\r\n"));
+    const std::string Twice = TestUtil::ReceiveResponse(Socket);
+    EXPECT_EQ(Twice.rfind("HTTP/1.1 200 Ok\r\n", 0), 0u) << Twice;
+    EXPECT_EQ(Twice.substr(Twice.size() >= 5 ? Twice.size() - 5 : 0), "first") << Twice;
+    EXPECT_TRUE(Results->bFirstCompleted);
+    EXPECT_FALSE(Results->bSecondCompleted);
+    EXPECT_FALSE(Results->bCopyCompleted);
+    EXPECT_TRUE(Results->bCompletedAfter);
+
+    // Nobody answered, the connection still gets a response and carries on
+    ASSERT_TRUE(TestUtil::SendString(Socket, "GET /dropped HTTP/1.1\r\n\r\n"));
+    const std::string Dropped = TestUtil::ReceiveResponse(Socket);
+    EXPECT_EQ(Dropped.rfind("HTTP/1.1 500 Internal Server Error\r\n", 0), 0u) << Dropped;
+    RequestPage(Socket, "GET /page HTTP/1.1\r\n\r\n");
+
+    // Pipelined, each answered from another thread and in the order asked for
+    ASSERT_TRUE(TestUtil::SendString(Socket, "GET /elsewhere/one HTTP/1.1\r\n\r\nGET /elsewhere/two HTTP/1.1\r\n\r\n"));
+    for(const std::string Id : { "one", "two" })
+    {
+        const std::string Response = TestUtil::ReceiveResponse(Socket);
+        EXPECT_EQ(Response.rfind("HTTP/1.1 200 Ok\r\n", 0), 0u) << Response;
+        EXPECT_EQ(Response.substr(Response.size() >= Id.size() ? Response.size() - Id.size() : 0), Id) << Response;
+    }
+    CloseSocket(Socket);
+
+    std::lock_guard<std::mutex> Lock(CompletersMutex);
+    for(std::thread& Completer : Completers)
+    {
+        Completer.join();
+    }
+}
+
+TEST_P(ListenServerTest, CoroutineHandlersWaitOnTheLoop)
+{
+    // Echoes the body back as it comes, waiting whenever the client's behind on reading
+    constexpr size_t MaxPendingSendBytes = 64 * 1024;
+    std::shared_ptr<std::atomic<size_t>> NumEchoed = std::make_shared<std::atomic<size_t>>(0);
+    mServer.CreateCoroutineHandler(ServerRequestType::ServerRequestType_POST, "/echo", [NumEchoed] (RequestContext& Context) -> RequestTask
+    {
+        co_await Context.Sleep(20);
+        for(std::string_view Chunk = co_await Context.ReadBody(); Chunk.empty() == false; Chunk = co_await Context.ReadBody())
+        {
+            co_await Context.Write(Chunk);
+            *NumEchoed += Chunk.size();
+        }
+    });
+
+    // Reads the lot, then gives up without answering
+    std::shared_ptr<std::atomic<size_t>> NumRead = std::make_shared<std::atomic<size_t>>(0);
+    mServer.CreateCoroutineHandler(ServerRequestType::ServerRequestType_POST, "/throws", [NumRead] (RequestContext& Context) -> RequestTask
+    {
+        co_await Context.Sleep(20);
+        for(std::string_view Chunk = co_await Context.ReadBody(); Chunk.empty() == false; Chunk = co_await Context.ReadBody())
+        {
+            *NumRead += Chunk.size();
+        }
+        throw std::runtime_error("handler failed");
+    });
+    ListenServerConfig Config;
+    Config.NumWorkers = 1;
+    Config.MaxPendingSendBytes = MaxPendingSendBytes;
+    Config.BodySpoolMemoryBytes = 64 * 1024;
+    StartServer(28434, Config);
+
+    SOCKET Socket = ConnectSlowReader();
+    ASSERT_NE(Socket, INVALID_SOCKET);
+
+    // More than the socket buffers hold between them, with nobody reading the echo has to stop part way
+    std::string Body(16 * 1024 * 1024, '\0');
+    for(size_t i = 0; i < Body.size(); i++)
+    {
+        Body[i] = (char) ('a' + (i / 7) % 26);
+    }
+    std::thread Sender([Socket, &Body] ()
+    {
+        TestUtil::SendString(Socket, "POST /echo HTTP/1.1\r\nContent-Length: " + std::to_string(Body.size()) + "\r\n\r\n");
+        TestUtil::SendString(Socket, Body);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    EXPECT_GT(NumEchoed->load(), 0u);
+    EXPECT_LT(NumEchoed->load(), Body.size());
+
+    const std::string Echoed = ReceiveChunkedResponse(Socket);
+    Sender.join();
+    ASSERT_EQ(Echoed.rfind("HTTP/1.1 200 Ok\r\n", 0), 0u) << Echoed.substr(0, 200);
+    const size_t HeadEnd = Echoed.find("\r\n\r\n") + 4;
+    EXPECT_EQ(Echoed.size() - HeadEnd, Body.size());
+    EXPECT_TRUE(Echoed.compare(HeadEnd, std::string::npos, Body) == 0);
+    EXPECT_EQ(NumEchoed->load(), Body.size());
+
+    // Throwing before it's answered is a 500, after the whole body's been read through, and the connection carries on
+    const std::string Upload(2 * 1024 * 1024, 'u');
+    ASSERT_TRUE(TestUtil::SendString(Socket, "POST /throws HTTP/1.1\r\nContent-Length: " + std::to_string(Upload.size()) + "\r\n\r\n" + Upload));
+    const std::string Failed = TestUtil::ReceiveResponse(Socket);
+    EXPECT_EQ(Failed.rfind("HTTP/1.1 500 Internal Server Error\r\n", 0), 0u) << Failed;
+    EXPECT_EQ(NumRead->load(), Upload.size());
+    RequestPage(Socket, "GET /page HTTP/1.1\r\n\r\n");
+    CloseSocket(Socket);
+}
+
+INSTANTIATE_TEST_SUITE_P(Engines, ListenServerTest, ::testing::Values(ListenServerIoMode::ListenServerIoMode_Poll, ListenServerIoMode::ListenServerIoMode_IoUring), IoModeName);
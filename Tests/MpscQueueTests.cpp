@@ -0,0 +1,112 @@
+#include "MpscQueue.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace WebServer;
+
+TEST(MpscQueue, EmptyQueuePopsNothing)
+{
+    MpscQueue<int> Queue;
+    int Value = -1;
+    EXPECT_FALSE(Queue.Pop(Value));
+    EXPECT_EQ(Value, -1);
+}
+
+TEST(MpscQueue, FirstInFirstOut)
+{
+    MpscQueue<int> Queue;
+    int Value = 0;
+
+    // A few at a time too, so the stub goes back behind the last node more than once
+    for(int Round = 0; Round < 3; Round++)
+    {
+        for(int i = 0; i < 5; i++)
+        {
+            Queue.Push(Round * 10 + i);
+        }
+        for(int i = 0; i < 5; i++)
+        {
+            ASSERT_TRUE(Queue.Pop(Value));
+            EXPECT_EQ(Value, Round * 10 + i);
+        }
+        EXPECT_FALSE(Queue.Pop(Value));
+    }
+
+    // One in, one out, always the last node
+    for(int i = 0; i < 10; i++)
+    {
+        Queue.Push(i);
+        ASSERT_TRUE(Queue.Pop(Value));
+        EXPECT_EQ(Value, i);
+        EXPECT_FALSE(Queue.Pop(Value));
+    }
+}
+
+TEST(MpscQueue, LeftoversAreFreedWithTheQueue)
+{
+    std::shared_ptr<int> Shared = std::make_shared<int>(7);
+    {
+        MpscQueue<std::shared_ptr<int>> Queue;
+        for(int i = 0; i < 4; i++)
+        {
+            Queue.Push(Shared);
+        }
+        std::shared_ptr<int> Popped;
+        ASSERT_TRUE(Queue.Pop(Popped));
+        EXPECT_EQ(Shared.use_count(), 5);
+    }
+    EXPECT_EQ(Shared.use_count(), 1);
+}
+
+TEST(MpscQueue, ManyProducers)
+{
+    constexpr int NumProducers = 4;
+    constexpr int NumPerProducer = 50000;
+    MpscQueue<std::unique_ptr<int>> Queue;     // move only, and something for the sanitizers to track
+
+    std::atomic<bool> bGo{ false };
+    std::vector<std::thread> Producers;
+    for(int Producer = 0; Producer < NumProducers; Producer++)
+    {
+        Producers.emplace_back([&Queue, &bGo, Producer] ()
+        {
+            while(bGo.load() == false)
+            {
+            }
+            for(int i = 0; i < NumPerProducer; i++)
+            {
+                Queue.Push(std::make_unique<int>(Producer * NumPerProducer + i));
+            }
+        });
+    }
+    bGo.store(true);
+
+    // Every value once, and each producer's in the order it pushed them
+    std::vector<int> NextFrom(NumProducers, 0);
+    int NumPopped = 0;
+    std::unique_ptr<int> Value;
+    while(NumPopped < NumProducers * NumPerProducer)
+    {
+        if(Queue.Pop(Value) == false)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        ASSERT_NE(Value, nullptr);
+        const int Producer = *Value / NumPerProducer;
+        ASSERT_EQ(*Value % NumPerProducer, NextFrom[Producer]);
+        NextFrom[Producer]++;
+        NumPopped++;
+    }
+
+    for(std::thread& Thread : Producers)
+    {
+        Thread.join();
+    }
+    EXPECT_FALSE(Queue.Pop(Value));
+}
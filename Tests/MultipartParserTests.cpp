@@ -0,0 +1,394 @@
+#include "MultipartParser.h"
+#include "HttpLineScanner.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace WebServer;
+
+namespace
+{
+    struct ParsedPart
+    {
+        std::string Name;
+        std::string FileName;
+        std::string ContentType;
+        std::string Data;
+        bool bEnded = false;
+    };
+
+    struct ParseResult
+    {
+        bool bFed = true;           // every Feed returned true
+        bool bComplete = false;
+        MultipartParsePhase Phase = MultipartParsePhase::MultipartParsePhase_Preamble;
+        std::vector<ParsedPart> Parts;
+    };
+
+    // Which callback stops the parse, and on which call of it (0 for none)
+    struct StopAt
+    {
+        int PartStart = 0;
+        int PartData = 0;
+        int PartEnd = 0;
+    };
+
+    // Body fed PieceLength bytes at a time, each piece in its own buffer as separate reads would be
+    ParseResult ParseInPieces(const std::string& Boundary, const std::string& Body, size_t PieceLength, StopAt Stop = {})
+    {
+        ParseResult Result;
+        int NumStarts = 0;
+        int NumData = 0;
+        int NumEnds = 0;
+        MultipartParser Parser;
+        Parser.Start(Boundary,
+            [&] (const MultipartPart& Part) {
+                Result.Parts.push_back({ std::string(Part.Name), std::string(Part.FileName), std::string(Part.ContentType), "", false });
+                return ++NumStarts != Stop.PartStart;
+            },
+            [&] (const char* Data, int DataLen) {
+                EXPECT_FALSE(Result.Parts.empty());
+                EXPECT_GT(DataLen, 0);
+                Result.Parts.back().Data.append(Data, DataLen);
+                return ++NumData != Stop.PartData;
+            },
+            [&] () {
+                Result.Parts.back().bEnded = true;
+                return ++NumEnds != Stop.PartEnd;
+            });
+
+        for(size_t Offset = 0; Offset < Body.size(); Offset += PieceLength)
+        {
+            const std::string Piece = Body.substr(Offset, PieceLength);
+            Result.bFed = Parser.Feed(Piece.data(), (int) Piece.size()) && Result.bFed;
+        }
+        Result.bComplete = Parser.IsComplete();
+        Result.Phase = Parser.GetPhase();
+        return Result;
+    }
+
+    ParseResult ParseWhole(const std::string& Boundary, const std::string& Body, StopAt Stop = {})
+    {
+        return ParseInPieces(Boundary, Body, Body.size(), Stop);
+    }
+
+    const std::string Boundary = "----WebKitFormBoundary7MA4YWxkTrZu0gW";
+
+    const std::string FormBody =
+        "preamble, ignored\r\n"
+        "------WebKitFormBoundary7MA4YWxkTrZu0gW\r\n"
+        "Content-Disposition: form-data; name=\"field\"\r\n"
+        "\r\n"
+        "value\r\n"
+        "------WebKitFormBoundary7MA4YWxkTrZu0gW\r\n"
+        "Content-Disposition: form-data; name=\"upload\"; filename=\"a;b.txt\"\r\n"
+        "Content-Type: text/plain\r\n"
+        "\r\n"
+        "line one\r\nline two\r\n\r\n"
+        "------WebKitFormBoundary7MA4YWxkTrZu0gW--\r\n"
+        "epilogue, ignored";
+
+    void ExpectFormParts(const ParseResult& Result)
+    {
+        EXPECT_TRUE(Result.bFed);
+        EXPECT_TRUE(Result.bComplete);
+        ASSERT_EQ(Result.Parts.size(), 2u);
+        EXPECT_EQ(Result.Parts[0].Name, "field");
+        EXPECT_EQ(Result.Parts[0].FileName, "");
+        EXPECT_EQ(Result.Parts[0].ContentType, "");
+        EXPECT_EQ(Result.Parts[0].Data, "value");
+        EXPECT_TRUE(Result.Parts[0].bEnded);
+        EXPECT_EQ(Result.Parts[1].Name, "upload");
+        EXPECT_EQ(Result.Parts[1].FileName, "a;b.txt");
+        EXPECT_EQ(Result.Parts[1].ContentType, "text/plain");
+        EXPECT_EQ(Result.Parts[1].Data, "line one\r\nline two\r\n");
+        EXPECT_TRUE(Result.Parts[1].bEnded);
+    }
+
+    std::string BuildPart(const std::string& Name, const std::string& Data)
+    {
+        return "--" + Boundary + "\r\nContent-Disposition: form-data; name=\"" + Name + "\"\r\n\r\n" + Data + "\r\n";
+    }
+
+    std::string CloseDelimiter()
+    {
+        return "--" + Boundary + "--\r\n";
+    }
+
+    // The delimiter search for each implementation the cpu has, whatever was active is put back afterwards
+    class MultipartSearchTest : public ::testing::TestWithParam<HttpScanImplementation>
+    {
+    protected:
+        void SetUp() override
+        {
+            mPrevious = GetHttpScanImplementation();
+            if(SetHttpScanImplementation(GetParam()) == false)
+            {
+                GTEST_SKIP() << "not supported on this cpu";
+            }
+        }
+        void TearDown() override { SetHttpScanImplementation(mPrevious); }
+
+        HttpScanImplementation mPrevious = HttpScanImplementation::HttpScanImplementation_Scalar;
+    };
+
+    std::string ImplementationName(const ::testing::TestParamInfo<HttpScanImplementation>& Info)
+    {
+        switch(Info.param)
+        {
+            case HttpScanImplementation::HttpScanImplementation_Sse42: return "Sse";
+            case HttpScanImplementation::HttpScanImplementation_Avx2: return "Avx2";
+            default: return "Scalar";
+        }
+    }
+}
+
+TEST(MultipartParser, FindBoundary)
+{
+    std::string_view Found;
+    ASSERT_TRUE(MultipartParser::FindBoundary("multipart/form-data; boundary=abc123", Found));
+    EXPECT_EQ(Found, "abc123");
+    ASSERT_TRUE(MultipartParser::FindBoundary("Multipart/Form-Data; charset=utf-8; BOUNDARY=\"quoted; boundary\"", Found));
+    EXPECT_EQ(Found, "quoted; boundary");
+    ASSERT_TRUE(MultipartParser::FindBoundary("multipart/mixed;boundary=" + std::string(70, 'b'), Found));
+
+    const std::string Unusable[] =
+    {
+        "text/plain; boundary=abc",
+        "multipart/form-data",
+        "multipart/form-data; charset=utf-8",
+        "multipart/form-data; boundary=",
+        "multipart/form-data; boundary=\"\"",
+        "multipart/form-data; boundary=" + std::string(71, 'b'),
+        "multipart/form-data; boundary=\"a\rb\"",
+        "multi",
+    };
+    for(const std::string& ContentType : Unusable)
+    {
+        EXPECT_FALSE(MultipartParser::FindBoundary(ContentType, Found)) << ContentType;
+    }
+}
+
+TEST(MultipartParser, ParsesAForm)
+{
+    ExpectFormParts(ParseWhole(Boundary, FormBody));
+}
+
+TEST(MultipartParser, EveryPieceSizeMatches)
+{
+    // Boundaries, CRLFs and header lines split across reads at every point
+    for(size_t PieceLength = 1; PieceLength < FormBody.size(); PieceLength++)
+    {
+        SCOPED_TRACE("pieces of " + std::to_string(PieceLength));
+        ExpectFormParts(ParseInPieces(Boundary, FormBody, PieceLength));
+    }
+}
+
+TEST(MultipartParser, BoundarySplitAcrossReads)
+{
+    // The delimiter before the close arrives a byte at a time after a read ending mid way through it
+    const std::string Body = BuildPart("a", "data") + CloseDelimiter();
+    const size_t DelimiterStart = Body.find("\r\n--" + Boundary + "--");
+    for(size_t Split = DelimiterStart; Split < DelimiterStart + Boundary.size() + 4; Split++)
+    {
+        MultipartParser Parser;
+        std::string Data;
+        Parser.Start(Boundary, nullptr, [&Data] (const char* Bytes, int Length) { Data.append(Bytes, Length); return true; }, nullptr);
+        const std::string First = Body.substr(0, Split);
+        ASSERT_TRUE(Parser.Feed(First.data(), (int) First.size()));
+        EXPECT_EQ(Data, "data") << "split at " << Split;     // what might be a delimiter is held back, nothing else
+        const std::string Rest = Body.substr(Split);
+        ASSERT_TRUE(Parser.Feed(Rest.data(), (int) Rest.size()));
+        EXPECT_TRUE(Parser.IsComplete());
+        EXPECT_EQ(Data, "data");
+    }
+}
+
+TEST(MultipartParser, NearMissesAreData)
+{
+    // Things that start like a delimiter and aren't one, each at the end of a read and in the middle of one
+    const std::string NearMisses[] =
+    {
+        "\r\n--" + Boundary.substr(0, Boundary.size() - 1) + "X",      // last byte off
+        "\r\n--" + Boundary.substr(0, Boundary.size() - 1),            // one short, then more data
+        "\r\n-" + Boundary,
+        "\n--" + Boundary,                                              // no CR
+        "\r--" + Boundary,
+        "\r\n\r\n--" + Boundary.substr(0, 10),
+        "\r\n--\r\n--" + Boundary.substr(0, 5),
+        "\r\r\r\n",
+        "\r",
+    };
+    for(const std::string& NearMiss : NearMisses)
+    {
+        const std::string PartData = "before" + NearMiss + "after" + NearMiss;
+        const std::string Body = BuildPart("a", PartData) + CloseDelimiter();
+        for(size_t PieceLength : { (size_t) 1, (size_t) 7, (size_t) 16, Body.size() })
+        {
+            const ParseResult Result = ParseInPieces(Boundary, Body, PieceLength);
+            EXPECT_TRUE(Result.bComplete) << "pieces of " << PieceLength;
+            ASSERT_EQ(Result.Parts.size(), 1u);
+            EXPECT_EQ(Result.Parts[0].Data, PartData) << "pieces of " << PieceLength;
+        }
+
+        // Each read ending right on the near miss
+        MultipartParser Parser;
+        std::string Data;
+        Parser.Start(Boundary, nullptr, [&Data] (const char* Bytes, int Length) { Data.append(Bytes, Length); return true; }, nullptr);
+        const std::string Start = BuildPart("a", "before" + NearMiss);
+        const std::string Rest = Body.substr(Start.size() - 2);
+        ASSERT_TRUE(Parser.Feed(Start.data(), (int) Start.size() - 2));
+        ASSERT_TRUE(Parser.Feed(Rest.data(), (int) Rest.size()));
+        EXPECT_TRUE(Parser.IsComplete());
+        EXPECT_EQ(Data, PartData);
+    }
+}
+
+TEST(MultipartParser, EmptyPartsAndPadding)
+{
+    // No preamble, an empty part, transport padding after a boundary and a bare LF
+    const std::string Body = "--" + Boundary + " \t\r\nContent-Disposition: form-data; name=\"empty\"\r\n\r\n"
+        "\r\n--" + Boundary + "\nContent-Disposition: form-data; name=\"next\"\n\nx\r\n--" + Boundary + "--";
+    for(size_t PieceLength : { (size_t) 1, (size_t) 5, Body.size() })
+    {
+        const ParseResult Result = ParseInPieces(Boundary, Body, PieceLength);
+        EXPECT_TRUE(Result.bComplete);
+        ASSERT_EQ(Result.Parts.size(), 2u);
+        EXPECT_EQ(Result.Parts[0].Name, "empty");
+        EXPECT_EQ(Result.Parts[0].Data, "");
+        EXPECT_TRUE(Result.Parts[0].bEnded);
+        EXPECT_EQ(Result.Parts[1].Name, "next");
+        EXPECT_EQ(Result.Parts[1].Data, "x");
+    }
+}
+
+TEST(MultipartParser, MissingCloseDelimiterIsIncomplete)
+{
+    // Fine as far as it goes, it's up to whoever's feeding it to say the body ended too soon
+    const std::string Cases[] =
+    {
+        BuildPart("a", "data"),
+        BuildPart("a", "data") + "--" + Boundary,
+        BuildPart("a", "data") + "--" + Boundary + "-",
+        BuildPart("a", "data").substr(0, 20),
+        "no boundary at all",
+        "",
+    };
+    for(const std::string& Body : Cases)
+    {
+        const ParseResult Result = ParseWhole(Boundary, Body);
+        EXPECT_TRUE(Result.bFed) << Body;
+        EXPECT_FALSE(Result.bComplete) << Body;
+    }
+
+    // The last part isn't ended without its delimiter
+    const ParseResult Unclosed = ParseWhole(Boundary, BuildPart("a", "data") + "more");
+    ASSERT_EQ(Unclosed.Parts.size(), 1u);
+    EXPECT_FALSE(Unclosed.Parts[0].bEnded);
+}
+
+TEST(MultipartParser, MalformedBodies)
+{
+    const std::string Cases[] =
+    {
+        "--" + Boundary + "junk\r\n\r\n",                                       // something after the boundary
+        "--" + Boundary + "-x",                                                 // one '-' of the close
+        "--" + Boundary + "\r\nNo colon here\r\n\r\ndata",
+        "--" + Boundary + "\r\n: no name\r\n\r\ndata",
+        "--" + Boundary + "\r\nX-Big: " + std::string(17 * 1024, 'v') + "\r\n\r\n",  // headers past 16k
+        "--" + Boundary + "\r\nX-Big: " + std::string(17 * 1024, 'v'),              // caught before the line ends
+    };
+    for(const std::string& Body : Cases)
+    {
+        for(size_t PieceLength : { (size_t) 1, (size_t) 100, Body.size() })
+        {
+            const ParseResult Result = ParseInPieces(Boundary, Body, PieceLength);
+            EXPECT_FALSE(Result.bFed) << Body.substr(0, 80);
+            EXPECT_EQ(Result.Phase, MultipartParsePhase::MultipartParsePhase_Malformed) << Body.substr(0, 80);
+        }
+    }
+
+    // Stays malformed
+    MultipartParser Parser;
+    Parser.Start(Boundary, nullptr, nullptr, nullptr);
+    const std::string Bad = "--" + Boundary + "!";
+    EXPECT_FALSE(Parser.Feed(Bad.data(), (int) Bad.size()));
+    const std::string Good = "\r\n\r\n";
+    EXPECT_FALSE(Parser.Feed(Good.data(), (int) Good.size()));
+}
+
+TEST(MultipartParser, CallbacksCanStopIt)
+{
+    StopAt AtStart;
+    AtStart.PartStart = 2;
+    ParseResult Result = ParseWhole(Boundary, FormBody, AtStart);
+    EXPECT_FALSE(Result.bFed);
+    EXPECT_EQ(Result.Parts.size(), 2u);
+    EXPECT_EQ(Result.Parts[1].Data, "");
+
+    StopAt AtData;
+    AtData.PartData = 1;
+    Result = ParseWhole(Boundary, FormBody, AtData);
+    EXPECT_FALSE(Result.bFed);
+    EXPECT_EQ(Result.Parts.size(), 1u);
+
+    StopAt AtEnd;
+    AtEnd.PartEnd = 1;
+    Result = ParseWhole(Boundary, FormBody, AtEnd);
+    EXPECT_FALSE(Result.bFed);
+    EXPECT_EQ(Result.Parts.size(), 1u);
+    EXPECT_EQ(Result.Phase, MultipartParsePhase::MultipartParsePhase_Malformed);
+
+    // Stopping in a later read
+    Result = ParseInPieces(Boundary, FormBody, 3, AtData);
+    EXPECT_FALSE(Result.bFed);
+}
+
+TEST(MultipartParser, EpilogueIsIgnored)
+{
+    MultipartParser Parser;
+    int NumParts = 0;
+    Parser.Start(Boundary, [&NumParts] (const MultipartPart&) { NumParts++; return true; }, nullptr, nullptr);
+    const std::string Body = BuildPart("a", "x") + CloseDelimiter();
+    ASSERT_TRUE(Parser.Feed(Body.data(), (int) Body.size()));
+    ASSERT_TRUE(Parser.IsComplete());
+
+    // Another part after the close isn't one
+    const std::string After = BuildPart("b", "y") + "--" + Boundary + "junk";
+    EXPECT_TRUE(Parser.Feed(After.data(), (int) After.size()));
+    EXPECT_EQ(NumParts, 1);
+}
+
+TEST_P(MultipartSearchTest, DelimiterAtEveryOffset)
+{
+    // Part data either side of each vector block size, with lone delimiter bytes in it that aren't a delimiter
+    for(size_t Length = 0; Length < 200; Length++)
+    {
+        std::string PartData;
+        for(size_t i = 0; i < Length; i++)
+        {
+            PartData += (i % 37 == 5) ? '\r' : (i % 41 == 9) ? Boundary.back() : (char) ('a' + i % 26);
+        }
+        const std::string Body = BuildPart("a", PartData) + BuildPart("b", PartData + PartData) + CloseDelimiter();
+        const ParseResult Result = ParseWhole(Boundary, Body);
+        ASSERT_TRUE(Result.bComplete) << Length;
+        ASSERT_EQ(Result.Parts.size(), 2u);
+        EXPECT_EQ(Result.Parts[0].Data, PartData) << Length;
+        EXPECT_EQ(Result.Parts[1].Data, PartData + PartData) << Length;
+    }
+}
+
+TEST_P(MultipartSearchTest, ShortBoundary)
+{
+    const std::string Body = "--x\r\n\r\n" + std::string(100, 'y') + "\r\n--x\r\n\r\nz\r\n--x--";
+    const ParseResult Result = ParseWhole("x", Body);
+    EXPECT_TRUE(Result.bComplete);
+    ASSERT_EQ(Result.Parts.size(), 2u);
+    EXPECT_EQ(Result.Parts[0].Data, std::string(100, 'y'));
+    EXPECT_EQ(Result.Parts[1].Data, "z");
+}
+
+INSTANTIATE_TEST_SUITE_P(Implementations, MultipartSearchTest, ::testing::Values(HttpScanImplementation::HttpScanImplementation_Scalar,
+    HttpScanImplementation::HttpScanImplementation_Sse42, HttpScanImplementation::HttpScanImplementation_Avx2), ImplementationName);
@@ -0,0 +1,219 @@
+#include "RequestBodyDecoder.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+
+using namespace WebServer;
+
+namespace
+{
+    struct DecodeResult
+    {
+        RequestBodyState State = RequestBodyState::RequestBodyState_Reading;
+        std::string Body;
+        int Consumed = 0;       // bytes Decode said were the body's
+    };
+
+    // Data handed over PieceLength bytes at a time (the way it'd arrive over several reads), stopping once the body's finished
+    DecodeResult DecodeInPieces(bool bChunked, int64_t ContentLength, const std::string& Data, int PieceLength)
+    {
+        RequestBodyDecoder Decoder;
+        Decoder.Start(bChunked, ContentLength);
+        DecodeResult Result;
+        for(size_t Offset = 0; Offset < Data.size() && Decoder.IsFinished() == false; Offset += PieceLength)
+        {
+            const std::string Piece = Data.substr(Offset, PieceLength);
+            Result.Consumed += Decoder.Decode(Piece.data(), (int) Piece.size(), [&Result] (const char* Bytes, int Length) {
+                Result.Body.append(Bytes, Length);
+                return true;
+                });
+        }
+        EXPECT_EQ(Decoder.GetNumBodyBytes(), (int64_t) Result.Body.size());
+        Result.State = Decoder.GetState();
+        return Result;
+    }
+
+    DecodeResult DecodeChunked(const std::string& Data)
+    {
+        return DecodeInPieces(true, 0, Data, (int) std::max<size_t>(Data.size(), 1));
+    }
+
+    // The same whatever size pieces it comes in
+    void ExpectChunked(const std::string& Data, RequestBodyState State, const std::string& Body, int Consumed)
+    {
+        for(int PieceLength = 1; PieceLength <= (int) Data.size(); PieceLength++)
+        {
+            const DecodeResult Result = DecodeInPieces(true, 0, Data, PieceLength);
+            EXPECT_EQ(Result.State, State) << "pieces of " << PieceLength;
+            if(State == RequestBodyState::RequestBodyState_Complete)
+            {
+                EXPECT_EQ(Result.Body, Body) << "pieces of " << PieceLength;
+                EXPECT_EQ(Result.Consumed, Consumed) << "pieces of " << PieceLength;
+            }
+        }
+    }
+
+    void ExpectMalformed(const std::string& Data)
+    {
+        for(int PieceLength : { 1, 3, (int) Data.size() })
+        {
+            EXPECT_EQ(DecodeInPieces(true, 0, Data, PieceLength).State, RequestBodyState::RequestBodyState_Malformed) << "pieces of " << PieceLength << " in " << Data.substr(0, 64);
+        }
+    }
+}
+
+TEST(RequestBodyDecoder, ContentLengthBody)
+{
+    const std::string Data = "hello worldGET / HTTP/1.1\r\n";
+    for(int PieceLength : { 1, 4, 11, (int) Data.size() })
+    {
+        const DecodeResult Result = DecodeInPieces(false, 11, Data, PieceLength);
+        EXPECT_EQ(Result.State, RequestBodyState::RequestBodyState_Complete);
+        EXPECT_EQ(Result.Body, "hello world");
+        EXPECT_EQ(Result.Consumed, 11);     // the next request's left alone
+    }
+
+    const DecodeResult Partial = DecodeInPieces(false, 20, "hello", 5);
+    EXPECT_EQ(Partial.State, RequestBodyState::RequestBodyState_Reading);
+    EXPECT_EQ(Partial.Body, "hello");
+}
+
+TEST(RequestBodyDecoder, NoBodyIsCompleteAtOnce)
+{
+    RequestBodyDecoder Decoder;
+    Decoder.Start(false, 0);
+    EXPECT_TRUE(Decoder.IsFinished());
+    EXPECT_EQ(Decoder.GetState(), RequestBodyState::RequestBodyState_Complete);
+    EXPECT_EQ(Decoder.Decode("abc", 3, nullptr), 0);
+}
+
+TEST(RequestBodyDecoder, RefusedByItsReceiver)
+{
+    int NumCalls = 0;
+    auto RefuseSecond = [&NumCalls] (const char*, int) { return ++NumCalls < 2; };
+
+    RequestBodyDecoder Decoder;
+    Decoder.Start(false, 10);
+    EXPECT_EQ(Decoder.Decode("hello", 5, RefuseSecond), 5);
+    EXPECT_EQ(Decoder.Decode("wor", 3, RefuseSecond), 3);
+    EXPECT_EQ(Decoder.GetState(), RequestBodyState::RequestBodyState_Refused);
+    EXPECT_EQ(Decoder.Decode("ld", 2, RefuseSecond), 0);
+
+    NumCalls = 0;
+    Decoder.Start(true, 0);
+    const std::string Chunked = "5\r\nhello\r\n5\r\nworld\r\n0\r\n\r\n";
+    Decoder.Decode(Chunked.data(), (int) Chunked.size(), RefuseSecond);
+    EXPECT_EQ(Decoder.GetState(), RequestBodyState::RequestBodyState_Refused);
+    EXPECT_EQ(NumCalls, 2);
+}
+
+TEST(RequestBodyDecoder, SkipsTheBodyWithoutAReceiver)
+{
+    RequestBodyDecoder Decoder;
+    Decoder.Start(true, 0);
+    const std::string Chunked = "5\r\nhello\r\n0\r\n\r\n";
+    EXPECT_EQ(Decoder.Decode(Chunked.data(), (int) Chunked.size(), nullptr), (int) Chunked.size());
+    EXPECT_EQ(Decoder.GetState(), RequestBodyState::RequestBodyState_Complete);
+    EXPECT_EQ(Decoder.GetNumBodyBytes(), 5);
+}
+
+TEST(RequestBodyDecoder, ChunkedBody)
+{
+    const std::string Body = "5\r\nhello\r\n6\r\n world\r\nB\r\n 0123456789\r\n0\r\n\r\n";
+    ExpectChunked(Body + "GET / HTTP/1.1\r\n", RequestBodyState::RequestBodyState_Complete, "hello world 0123456789", (int) Body.size());
+
+    // Bare LF line ends, either case of hex digit and leading zeros
+    const std::string Mixed = "5\nhello\n00c\n hello world\nC\r\n hello again\r\n0\n\n";
+    ExpectChunked(Mixed, RequestBodyState::RequestBodyState_Complete, "hello hello world hello again", (int) Mixed.size());
+
+    // Just the last chunk
+    ExpectChunked("0\r\n\r\n", RequestBodyState::RequestBodyState_Complete, "", 5);
+
+    // Not there yet
+    EXPECT_EQ(DecodeChunked("5\r\nhel").State, RequestBodyState::RequestBodyState_Reading);
+    EXPECT_EQ(DecodeChunked("5\r\nhello\r\n0\r\n").State, RequestBodyState::RequestBodyState_Reading);
+}
+
+TEST(RequestBodyDecoder, ChunkExtensionsAreSkipped)
+{
+    const std::string Data = "5;name=value;flag\r\nhello\r\n6 ; quoted=\"a;b\"\r\n world\r\n0;last\r\n\r\n";
+    ExpectChunked(Data, RequestBodyState::RequestBodyState_Complete, "hello world", (int) Data.size());
+    ExpectChunked("5\t;x\r\nhello\r\n0\r\n\r\n", RequestBodyState::RequestBodyState_Complete, "hello", 18);
+}
+
+TEST(RequestBodyDecoder, TrailersAreSkipped)
+{
+    const std::string Data = "5\r\nhello\r\n0\r\nX-Checksum: abc\r\nExpires: never\nLast: 1\r\n\r\nNEXT";
+    ExpectChunked(Data, RequestBodyState::RequestBodyState_Complete, "hello", (int) Data.size() - 4);
+
+    // The blank line isn't there until its LF is, and a line with anything else in it isn't blank
+    EXPECT_EQ(DecodeChunked("0\r\nA: b\r\n\r").State, RequestBodyState::RequestBodyState_Reading);
+    EXPECT_EQ(DecodeChunked("0\r\nA: b\r\nx\r\n").State, RequestBodyState::RequestBodyState_Reading);
+}
+
+TEST(RequestBodyDecoder, ChunkSizeDigitLimit)
+{
+    // 15 digits is as many as there can be, leading zeros included
+    const std::string Fifteen = "00000000000000" "5\r\nhello\r\n0\r\n\r\n";
+    ExpectChunked(Fifteen, RequestBodyState::RequestBodyState_Complete, "hello", (int) Fifteen.size());
+    EXPECT_EQ(DecodeChunked("fffffffffffffff\r\nabc").State, RequestBodyState::RequestBodyState_Reading);
+
+    ExpectMalformed("000000000000000" "5\r\nhello\r\n0\r\n\r\n");
+    ExpectMalformed("ffffffffffffffff\r\n");
+    ExpectMalformed("FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF\r\n");
+}
+
+TEST(RequestBodyDecoder, ChunkSizeLineLimit)
+{
+    // The size line's digits, extensions and CR count, 4k of them at most
+    const std::string AtLimit = "5;" + std::string(4 * 1024 - 3, 'x') + "\r\nhello\r\n0\r\n\r\n";
+    EXPECT_EQ(DecodeChunked(AtLimit).State, RequestBodyState::RequestBodyState_Complete);
+    EXPECT_EQ(DecodeInPieces(true, 0, AtLimit, 1).State, RequestBodyState::RequestBodyState_Complete);
+
+    ExpectMalformed("5;" + std::string(4 * 1024 - 2, 'x') + "\r\nhello\r\n0\r\n\r\n");
+
+    // Caught before the line ends
+    ExpectMalformed("5;" + std::string(8 * 1024, 'x'));
+}
+
+TEST(RequestBodyDecoder, TrailersLimit)
+{
+    // Every byte after the last chunk's size line counts, the blank line ending them included
+    const std::string Trailer = "X-Pad: ";
+    const std::string AtLimit = "0\r\n" + Trailer + std::string(64 * 1024 - Trailer.size() - 4, 'x') + "\r\n\r\n";
+    EXPECT_EQ(DecodeChunked(AtLimit).State, RequestBodyState::RequestBodyState_Complete);
+
+    ExpectMalformed("0\r\n" + Trailer + std::string(64 * 1024 - Trailer.size() - 3, 'x') + "\r\n\r\n");
+
+    // Lots of short ones add up the same
+    std::string ManyTrailers = "0\r\n";
+    while(ManyTrailers.size() < 70 * 1024)
+    {
+        ManyTrailers += "A: b\r\n";
+    }
+    ExpectMalformed(ManyTrailers + "\r\n");
+}
+
+TEST(RequestBodyDecoder, MalformedChunkFraming)
+{
+    ExpectMalformed("\r\n");                        // no size
+    ExpectMalformed(";ext\r\n");
+    ExpectMalformed(" 5\r\nhello\r\n0\r\n\r\n");
+    ExpectMalformed("-5\r\n");
+    ExpectMalformed("0x5\r\nhello\r\n");
+    ExpectMalformed("g\r\n");
+    ExpectMalformed("5x\r\nhello\r\n");             // junk after the digits
+    ExpectMalformed("5\r\nhelloX\r\n0\r\n\r\n");    // data longer than its size
+    ExpectMalformed("5\r\nhel\r\n0\r\n\r\n");       // or shorter
+    ExpectMalformed("5\r\nhello\r\r\n0\r\n\r\n");   // two CRs after the data
+    ExpectMalformed("5\r\nhello\r0\r\n\r\n");       // a CR without its LF
+
+    // Stays malformed, nothing more is taken
+    RequestBodyDecoder Decoder;
+    Decoder.Start(true, 0);
+    EXPECT_EQ(Decoder.Decode("zz", 2, nullptr), 1);
+    EXPECT_EQ(Decoder.GetState(), RequestBodyState::RequestBodyState_Malformed);
+    EXPECT_EQ(Decoder.Decode("5\r\n", 3, nullptr), 0);
+}
@@ -0,0 +1,142 @@
+#include "RequestBodySpool.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+using namespace WebServer;
+
+namespace
+{
+    constexpr size_t MemoryBudget = 4 * 1024;     // the smallest Start allows
+
+    std::string BuildBody(size_t Length)
+    {
+        std::string Body;
+        for(size_t i = 0; i < Length; i++)
+        {
+            Body += (char) ('a' + (i * 7 + i / 26) % 26);
+        }
+        return Body;
+    }
+
+    // Body appended PieceLength bytes at a time
+    bool AppendInPieces(SpooledRequestBody& Spool, const std::string& Body, size_t PieceLength)
+    {
+        for(size_t Offset = 0; Offset < Body.size(); Offset += PieceLength)
+        {
+            const std::string Piece = Body.substr(Offset, PieceLength);
+            if(Spool.Append(Piece.data(), (int) Piece.size()) == false)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+TEST(SpooledRequestBody, SmallBodyStaysInMemory)
+{
+    SpooledRequestBody Spool;
+    Spool.Start(MemoryBudget, 1024 * 1024, "");
+    const std::string Body = BuildBody(MemoryBudget);     // the whole budget still fits
+    ASSERT_TRUE(AppendInPieces(Spool, Body, 1000));
+    ASSERT_TRUE(Spool.Finish());
+    EXPECT_TRUE(Spool.IsInMemory());
+    EXPECT_EQ(Spool.GetSize(), (int64_t) Body.size());
+    ASSERT_NE(Spool.GetData(), nullptr);
+    EXPECT_EQ(std::string(Spool.GetData(), (size_t) Spool.GetSize()), Body);
+}
+
+TEST(SpooledRequestBody, EmptyBody)
+{
+    SpooledRequestBody Spool;
+    Spool.Start(MemoryBudget, 1024, "");
+    ASSERT_TRUE(Spool.Finish());
+    EXPECT_EQ(Spool.GetSize(), 0);
+    EXPECT_EQ(Spool.GetData(), nullptr);
+}
+
+TEST(SpooledRequestBody, LargeBodyGoesToAFile)
+{
+    for(size_t PieceLength : { (size_t) 1, (size_t) 1000, MemoryBudget, (size_t) 100 * 1024 })
+    {
+        SpooledRequestBody Spool;
+        Spool.Start(MemoryBudget, 1024 * 1024, "");
+        const std::string Body = BuildBody(10 * MemoryBudget + 123);
+        ASSERT_TRUE(AppendInPieces(Spool, Body, PieceLength));
+        ASSERT_TRUE(Spool.Finish());
+        EXPECT_FALSE(Spool.IsInMemory());
+        EXPECT_EQ(Spool.GetSize(), (int64_t) Body.size());
+
+        ASSERT_NE(Spool.GetData(), nullptr);
+        EXPECT_EQ(std::string(Spool.GetData(), (size_t) Spool.GetSize()), Body) << "pieces of " << PieceLength;
+
+#ifndef _WIN32
+        // The same bytes through the file
+        std::string FromFile(Body.size(), '\0');
+        ASSERT_EQ(pread(Spool.GetFileHandle(), &FromFile[0], FromFile.size(), 0), (ssize_t) Body.size());
+        EXPECT_EQ(FromFile, Body);
+#endif
+    }
+}
+
+TEST(SpooledRequestBody, OverTheLimitIsRefused)
+{
+    SpooledRequestBody Spool;
+    Spool.Start(MemoryBudget, 10000, "");
+    const std::string Body = BuildBody(10000);
+    ASSERT_TRUE(AppendInPieces(Spool, Body, 999));
+    EXPECT_FALSE(Spool.IsOverLimit());
+
+    EXPECT_FALSE(Spool.Append("x", 1));
+    EXPECT_TRUE(Spool.IsOverLimit());
+    EXPECT_TRUE(Spool.IsFailed());
+    EXPECT_FALSE(Spool.Append("x", 0));    // nothing more's taken
+    EXPECT_FALSE(Spool.Finish());
+
+    // Starting again clears it
+    Spool.Start(MemoryBudget, 10, "");
+    EXPECT_FALSE(Spool.IsFailed());
+    EXPECT_TRUE(Spool.Append("0123456789", 10));
+    EXPECT_TRUE(Spool.Finish());
+}
+
+TEST(SpooledRequestBody, UnwritableDirectoryFails)
+{
+    SpooledRequestBody Spool;
+    Spool.Start(MemoryBudget, 1024 * 1024, "/nonexistent/webserver-spool-test");
+    const std::string Body = BuildBody(2 * MemoryBudget);
+    EXPECT_FALSE(AppendInPieces(Spool, Body, 1000));
+    EXPECT_TRUE(Spool.IsFailed());
+    EXPECT_FALSE(Spool.IsOverLimit());
+    EXPECT_FALSE(Spool.Finish());
+}
+
+TEST(SpooledRequestBody, MovedBodyKeepsItsFile)
+{
+    const std::string Body = BuildBody(3 * MemoryBudget);
+    SpooledRequestBody Kept;
+    {
+        SpooledRequestBody Spool;
+        Spool.Start(MemoryBudget, 1024 * 1024, "");
+        ASSERT_TRUE(AppendInPieces(Spool, Body, 1000));
+        ASSERT_TRUE(Spool.Finish());
+        ASSERT_NE(Spool.GetData(), nullptr);     // mapped before the move, the mapping moves with it
+        Kept = std::move(Spool);
+        EXPECT_EQ(Spool.GetSize(), 0);
+    }
+    EXPECT_FALSE(Kept.IsInMemory());
+    ASSERT_EQ(Kept.GetSize(), (int64_t) Body.size());
+    ASSERT_NE(Kept.GetData(), nullptr);
+    EXPECT_EQ(std::string(Kept.GetData(), Body.size()), Body);
+
+    SpooledRequestBody Constructed(std::move(Kept));
+    ASSERT_NE(Constructed.GetData(), nullptr);
+    EXPECT_EQ(std::string(Constructed.GetData(), Body.size()), Body);
+}
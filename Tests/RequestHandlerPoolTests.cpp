@@ -0,0 +1,97 @@
+#include "RequestHandlerPool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace WebServer;
+
+TEST(RequestHandlerPool, RunsEveryJob)
+{
+    std::atomic<int> NumRun{ 0 };
+    {
+        RequestHandlerPool Pool;
+        Pool.Start(4);
+        EXPECT_TRUE(Pool.IsRunning());
+        for(int i = 0; i < 1000; i++)
+        {
+            Pool.QueueJob([&NumRun] () { NumRun++; });
+        }
+    }   // going out of scope runs what's left
+    EXPECT_EQ(NumRun.load(), 1000);
+}
+
+TEST(RequestHandlerPool, SlowJobsDontHoldUpTheRest)
+{
+    RequestHandlerPool Pool;
+    Pool.Start(2);
+
+    // One job stuck until it's let go, the other thread carries on with everything queued behind it
+    std::mutex Mutex;
+    std::condition_variable Changed;
+    bool bRelease = false;
+    int NumQuick = 0;
+    Pool.QueueJob([&] ()
+    {
+        std::unique_lock<std::mutex> Lock(Mutex);
+        Changed.wait(Lock, [&] () { return bRelease; });
+    });
+    for(int i = 0; i < 10; i++)
+    {
+        Pool.QueueJob([&] ()
+        {
+            std::lock_guard<std::mutex> Lock(Mutex);
+            NumQuick++;
+            Changed.notify_all();
+        });
+    }
+
+    {
+        std::unique_lock<std::mutex> Lock(Mutex);
+        EXPECT_TRUE(Changed.wait_for(Lock, std::chrono::seconds(5), [&] () { return NumQuick == 10; }));
+        bRelease = true;
+    }
+    Changed.notify_all();
+    Pool.Stop();
+    EXPECT_FALSE(Pool.IsRunning());
+}
+
+TEST(RequestHandlerPool, OneThreadRunsJobsInOrder)
+{
+    std::vector<int> Order;
+    RequestHandlerPool Pool;
+    Pool.Start(0);      // at least one thread whatever's asked for
+    for(int i = 0; i < 100; i++)
+    {
+        Pool.QueueJob([&Order, i] () { Order.push_back(i); });
+    }
+    Pool.Stop();
+
+    ASSERT_EQ(Order.size(), 100u);
+    for(int i = 0; i < 100; i++)
+    {
+        EXPECT_EQ(Order[i], i);
+    }
+}
+
+TEST(RequestHandlerPool, JobsAfterStopAreDropped)
+{
+    std::atomic<int> NumRun{ 0 };
+    RequestHandlerPool Pool;
+    Pool.Start(2);
+    Pool.QueueJob([&NumRun] () { NumRun++; });
+    Pool.Stop();
+    Pool.QueueJob([&NumRun] () { NumRun++; });
+    EXPECT_EQ(NumRun.load(), 1);
+
+    // Started again it takes jobs again
+    Pool.Start(1);
+    Pool.QueueJob([&NumRun] () { NumRun++; });
+    Pool.Stop();
+    EXPECT_EQ(NumRun.load(), 2);
+}
@@ -0,0 +1,213 @@
+#include "RequestRouter.h"
+#include "WebServer.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace WebServer;
+
+namespace
+{
+    constexpr ServerRequestType GET = ServerRequestType::ServerRequestType_GET;
+    constexpr ServerRequestType POST = ServerRequestType::ServerRequestType_POST;
+
+    uint32_t Match(const RequestRouter& Router, std::string_view Path)
+    {
+        RouteParams Params;
+        return Router.Match(GET, Path, Params);
+    }
+}
+
+TEST(RequestRouter, StaticRoutes)
+{
+    RequestRouter Router;
+    ASSERT_TRUE(Router.AddRoute(GET, "/", 1));
+    ASSERT_TRUE(Router.AddRoute(GET, "/about", 2));
+    ASSERT_TRUE(Router.AddRoute(GET, "/abc", 3));      // splits "/about"'s node
+    ASSERT_TRUE(Router.AddRoute(GET, "/ab", 4));       // ends on the split
+    ASSERT_TRUE(Router.AddRoute(GET, "/about/team", 5));
+
+    EXPECT_EQ(Match(Router, "/"), 1u);
+    EXPECT_EQ(Match(Router, "/about"), 2u);
+    EXPECT_EQ(Match(Router, "/abc"), 3u);
+    EXPECT_EQ(Match(Router, "/ab"), 4u);
+    EXPECT_EQ(Match(Router, "/about/team"), 5u);
+
+    for(const char* Path : { "", "/a", "/abo", "/abcd", "/about/", "/about/tea", "/about/teams", "/About", "/x" })
+    {
+        EXPECT_EQ(Match(Router, Path), RequestRouter::NoRoute) << Path;
+    }
+}
+
+TEST(RequestRouter, MethodsAreSeparate)
+{
+    RequestRouter Router;
+    ASSERT_TRUE(Router.AddRoute(GET, "/item", 1));
+    ASSERT_TRUE(Router.AddRoute(POST, "/item", 2));
+
+    RouteParams Params;
+    EXPECT_EQ(Router.Match(GET, "/item", Params), 1u);
+    EXPECT_EQ(Router.Match(POST, "/item", Params), 2u);
+    EXPECT_EQ(Router.Match(ServerRequestType::ServerRequestType_PUT, "/item", Params), RequestRouter::NoRoute);
+    EXPECT_EQ(Router.Match(ServerRequestType::ServerRequestType_Invalid, "/item", Params), RequestRouter::NoRoute);
+}
+
+TEST(RequestRouter, ReaddingReplacesTheId)
+{
+    RequestRouter Router;
+    ASSERT_TRUE(Router.AddRoute(GET, "/users/:id", 1));
+    const size_t NumNodes = Router.GetNumNodes();
+    ASSERT_TRUE(Router.AddRoute(GET, "/users/:id", 7));
+    EXPECT_EQ(Router.GetNumNodes(), NumNodes);
+    EXPECT_EQ(Match(Router, "/users/3"), 7u);
+}
+
+TEST(RequestRouter, ParametersCaptureASegment)
+{
+    RequestRouter Router;
+    ASSERT_TRUE(Router.AddRoute(GET, "/users/:id", 1));
+    ASSERT_TRUE(Router.AddRoute(GET, "/users/:id/posts/:post", 2));
+
+    RouteParams Params;
+    ASSERT_EQ(Router.Match(GET, "/users/42", Params), 1u);
+    ASSERT_EQ(Params.NumParams, 1);
+    EXPECT_EQ(Params.Params[0].Name, "id");
+    EXPECT_EQ(Params.Find("id"), "42");
+    EXPECT_EQ(Params.Find("missing"), "");
+
+    ASSERT_EQ(Router.Match(GET, "/users/alice/posts/hello-world", Params), 2u);
+    ASSERT_EQ(Params.NumParams, 2);
+    EXPECT_EQ(Params.Find("id"), "alice");
+    EXPECT_EQ(Params.Find("post"), "hello-world");
+
+    // A parameter takes a whole non-empty segment
+    for(const char* Path : { "/users/", "/users", "/users//posts/x", "/users/1/", "/users/1/posts/", "/users/1/posts" })
+    {
+        EXPECT_EQ(Router.Match(GET, Path, Params), RequestRouter::NoRoute) << Path;
+        EXPECT_EQ(Params.NumParams, 0) << Path;
+    }
+}
+
+TEST(RequestRouter, WildcardCapturesTheRest)
+{
+    RequestRouter Router;
+    ASSERT_TRUE(Router.AddRoute(GET, "/static/*file", 1));
+    ASSERT_TRUE(Router.AddRoute(GET, "/any/*", 2));
+
+    RouteParams Params;
+    ASSERT_EQ(Router.Match(GET, "/static/css/site.css", Params), 1u);
+    EXPECT_EQ(Params.Find("file"), "css/site.css");
+    ASSERT_EQ(Router.Match(GET, "/static/", Params), 1u);      // nothing at all is still the rest
+    EXPECT_EQ(Params.Find("file"), "");
+    EXPECT_EQ(Router.Match(GET, "/static", Params), RequestRouter::NoRoute);
+
+    ASSERT_EQ(Router.Match(GET, "/any/a/b/c", Params), 2u);
+    ASSERT_EQ(Params.NumParams, 1);
+    EXPECT_EQ(Params.Params[0].Name, "");
+    EXPECT_EQ(Params.Params[0].Value, "a/b/c");
+}
+
+TEST(RequestRouter, StaticBeatsParameterBeatsWildcard)
+{
+    RequestRouter Router;
+    ASSERT_TRUE(Router.AddRoute(GET, "/files/*path", 1));
+    ASSERT_TRUE(Router.AddRoute(GET, "/files/:name", 2));
+    ASSERT_TRUE(Router.AddRoute(GET, "/files/index", 3));
+    ASSERT_TRUE(Router.AddRoute(GET, "/files/:name/raw", 4));
+    ASSERT_TRUE(Router.AddRoute(GET, "/files/index/meta", 5));
+
+    RouteParams Params;
+    EXPECT_EQ(Router.Match(GET, "/files/index", Params), 3u);
+    EXPECT_EQ(Params.NumParams, 0);
+    EXPECT_EQ(Router.Match(GET, "/files/readme", Params), 2u);
+    EXPECT_EQ(Params.Find("name"), "readme");
+    EXPECT_EQ(Router.Match(GET, "/files/a/b", Params), 1u);
+    EXPECT_EQ(Params.Find("path"), "a/b");
+
+    // The static branch gets as far as it can then gives way, without leaving its captures behind
+    ASSERT_EQ(Router.Match(GET, "/files/index/raw", Params), 4u);
+    ASSERT_EQ(Params.NumParams, 1);
+    EXPECT_EQ(Params.Find("name"), "index");
+    EXPECT_EQ(Router.Match(GET, "/files/index/meta", Params), 5u);
+    EXPECT_EQ(Router.Match(GET, "/files/indexes", Params), 2u);
+    ASSERT_EQ(Router.Match(GET, "/files/index/other", Params), 1u);
+    ASSERT_EQ(Params.NumParams, 1);
+    EXPECT_EQ(Params.Find("path"), "index/other");
+}
+
+TEST(RequestRouter, SpecialCharactersMidSegmentAreLiteral)
+{
+    RequestRouter Router;
+    ASSERT_TRUE(Router.AddRoute(GET, "/a:b", 1));
+    ASSERT_TRUE(Router.AddRoute(GET, "/x*y/:id", 2));
+
+    RouteParams Params;
+    EXPECT_EQ(Router.Match(GET, "/a:b", Params), 1u);
+    EXPECT_EQ(Router.Match(GET, "/aXb", Params), RequestRouter::NoRoute);
+    ASSERT_EQ(Router.Match(GET, "/x*y/9", Params), 2u);
+    EXPECT_EQ(Params.Find("id"), "9");
+}
+
+TEST(RequestRouter, MaxParams)
+{
+    std::string Pattern;
+    std::string Path;
+    for(int i = 0; i < RouteParams::MaxParams; i++)
+    {
+        Pattern += "/:p" + std::to_string(i);
+        Path += "/v" + std::to_string(i);
+    }
+
+    RequestRouter Router;
+    ASSERT_TRUE(Router.AddRoute(GET, Pattern, 1));
+    RouteParams Params;
+    ASSERT_EQ(Router.Match(GET, Path, Params), 1u);
+    ASSERT_EQ(Params.NumParams, RouteParams::MaxParams);
+    EXPECT_EQ(Params.Find("p7"), "v7");
+
+    EXPECT_FALSE(Router.AddRoute(GET, Pattern + "/:one_more", 2));
+    EXPECT_FALSE(Router.AddRoute(GET, Pattern + "/*rest", 2));
+}
+
+TEST(RequestRouter, InvalidPatternsAreRefused)
+{
+    RequestRouter Router;
+    for(const char* Pattern : { "", "users", ":id", "/users/:", "/users/:/x", "/static/*file/more", "/a/*b/c" })
+    {
+        EXPECT_FALSE(Router.AddRoute(GET, Pattern, 1)) << Pattern;
+    }
+    EXPECT_FALSE(Router.AddRoute(GET, "/ok", RequestRouter::NoRoute));
+    EXPECT_FALSE(Router.AddRoute((ServerRequestType) 100, "/ok", 1));
+
+    // Parameters sharing a position have to share a name
+    ASSERT_TRUE(Router.AddRoute(GET, "/users/:id", 1));
+    EXPECT_FALSE(Router.AddRoute(GET, "/users/:name/posts", 2));
+    EXPECT_TRUE(Router.AddRoute(GET, "/users/:id/posts", 2));
+    ASSERT_TRUE(Router.AddRoute(GET, "/files/*path", 3));
+    EXPECT_FALSE(Router.AddRoute(GET, "/files/*other", 4));
+
+    // Refusing one leaves the rest as they were
+    EXPECT_EQ(Match(Router, "/users/1"), 1u);
+    EXPECT_EQ(Match(Router, "/users/1/posts"), 2u);
+}
+
+TEST(RequestRouter, ManyRoutesSharingPrefixes)
+{
+    // Enough siblings that children get moved around the pool as they're added
+    RequestRouter Router;
+    std::vector<std::string> Paths;
+    for(int i = 0; i < 300; i++)
+    {
+        Paths.push_back("/api/v" + std::to_string(i % 3) + "/item" + std::to_string(i));
+        ASSERT_TRUE(Router.AddRoute(GET, Paths.back(), (uint32_t) i));
+        ASSERT_TRUE(Router.AddRoute(GET, Paths.back() + "/:id", (uint32_t) (1000 + i)));
+    }
+    for(int i = 0; i < 300; i++)
+    {
+        EXPECT_EQ(Match(Router, Paths[i]), (uint32_t) i) << Paths[i];
+        EXPECT_EQ(Match(Router, Paths[i] + "/x"), (uint32_t) (1000 + i)) << Paths[i];
+        EXPECT_EQ(Match(Router, Paths[i] + "0000"), RequestRouter::NoRoute) << Paths[i];
+    }
+}
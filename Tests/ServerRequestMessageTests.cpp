@@ -0,0 +1,399 @@
+#include "WebServer.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace WebServer;
+
+namespace
+{
+    // The message's views point into Data, it has to outlive them
+    void ParseWhole(ServerRequestMessage& Message, const std::string& Data)
+    {
+        Message.ParseData(Data.data(), (int) Data.size());
+    }
+
+    // Everything the parse produced, copied out so it can be compared after the data's gone
+    struct ParseResult
+    {
+        bool bComplete = false;
+        bool bMalformed = false;
+        int HeadLength = 0;
+        ServerRequestType RequestType = ServerRequestType::ServerRequestType_Invalid;
+        int HttpMinorVersion = -1;
+        std::string Url;
+        std::string Query;
+        std::vector<std::pair<std::string, std::string>> Headers;
+
+        bool operator==(const ParseResult& Other) const
+        {
+            return bComplete == Other.bComplete && bMalformed == Other.bMalformed && HeadLength == Other.HeadLength && RequestType == Other.RequestType
+                && HttpMinorVersion == Other.HttpMinorVersion && Url == Other.Url && Query == Other.Query && Headers == Other.Headers;
+        }
+    };
+
+    ParseResult GetResult(const ServerRequestMessage& Message, int HeadLength)
+    {
+        ParseResult Result;
+        Result.bComplete = Message.bIsMessageComplete;
+        Result.bMalformed = Message.bIsMessageMalformed;
+        Result.HeadLength = HeadLength;
+        if(Result.bComplete)
+        {
+            Result.RequestType = Message.mRequestType;
+            Result.HttpMinorVersion = Message.mHttpMinorVersion;
+            Result.Url = std::string(Message.mUrl);
+            Result.Query = std::string(Message.mQuery);
+            Message.mHeaders.ForEach([&Result] (std::string_view Key, std::string_view Value) { Result.Headers.emplace_back(Key, Value); });
+        }
+        return Result;
+    }
+
+    ParseResult ParseAtOnce(const std::string& Data)
+    {
+        ServerRequestMessage Message;
+        const int HeadLength = Message.ParseData(Data.data(), (int) Data.size());
+        return GetResult(Message, HeadLength);
+    }
+
+    // Fed as it would arrive over several reads, each read's bytes in a fresh buffer as if the connection's stream had
+    // moved them. Data[0, Split) first, then a byte at a time from there (Split = 0 for byte by byte throughout)
+    ParseResult ParseInPieces(const std::string& Data, size_t Split)
+    {
+        ServerRequestMessage Message;
+        std::string Received;
+        int HeadLength = 0;
+        size_t Length = (Split > 0) ? Split : 1;
+        for(; Length <= Data.size(); Length++)
+        {
+            Received = Data.substr(0, Length);
+            Received.reserve(Received.size() + Length % 7 * 64);    // so it isn't always in the same place
+            HeadLength = Message.ParseData(Received.data(), (int) Received.size());
+            if(Message.bIsMessageComplete || Message.bIsMessageMalformed)
+            {
+                break;
+            }
+        }
+        return GetResult(Message, HeadLength);
+    }
+
+    const std::string FullRequest =
+        "POST /upload/file.txt?name=value&other=1 HTTP/1.1\r\n"
+        "Host: example.com\r\n"
+        "User-Agent: test\r\n"
+        "X-Custom-Header:   padded value \t\r\n"
+        "Content-Length: 11\r\n"
+        "Accept: */*\r\n"
+        "\r\n";
+}
+
+TEST(ServerRequestMessage, ParsesAWholeRequest)
+{
+    const ParseResult Result = ParseAtOnce(FullRequest + "hello world");
+    ASSERT_TRUE(Result.bComplete);
+    EXPECT_FALSE(Result.bMalformed);
+    EXPECT_EQ(Result.HeadLength, (int) FullRequest.size());
+    EXPECT_EQ(Result.RequestType, ServerRequestType::ServerRequestType_POST);
+    EXPECT_EQ(Result.Url, "/upload/file.txt");
+    EXPECT_EQ(Result.Query, "name=value&other=1");
+    EXPECT_EQ(Result.HttpMinorVersion, 1);
+
+    ServerRequestMessage Message;
+    const std::string Data = FullRequest;
+    ParseWhole(Message, Data);
+    std::string_view Value;
+    ASSERT_TRUE(Message.mHeaders.Find(HttpHeader::HttpHeader_Host, Value));
+    EXPECT_EQ(Value, "example.com");
+    ASSERT_TRUE(Message.mHeaders.Find("x-custom-header", Value));
+    EXPECT_EQ(Value, "padded value");
+    EXPECT_EQ(Message.mHeaders.GetNum(), 5);
+    EXPECT_EQ(Message.GetContentLength(), 11);
+    EXPECT_TRUE(Message.HasBody());
+    EXPECT_FALSE(Message.IsBodyChunked());
+}
+
+TEST(ServerRequestMessage, ByteByByteMatchesAtOnce)
+{
+    const ParseResult AtOnce = ParseAtOnce(FullRequest);
+    ASSERT_TRUE(AtOnce.bComplete);
+    EXPECT_TRUE(ParseInPieces(FullRequest, 0) == AtOnce);
+}
+
+TEST(ServerRequestMessage, EverySplitMatchesAtOnce)
+{
+    // Every point a read could end at, each CR LF split between reads among them
+    const ParseResult AtOnce = ParseAtOnce(FullRequest);
+    for(size_t Split = 1; Split < FullRequest.size(); Split++)
+    {
+        EXPECT_TRUE(ParseInPieces(FullRequest, Split) == AtOnce) << "split at " << Split;
+    }
+}
+
+TEST(ServerRequestMessage, CrLfSplitAcrossReads)
+{
+    const std::string Data = "GET /a HTTP/1.1\r\nHost: x\r\n\r\n";
+    ServerRequestMessage Message;
+
+    // Up to the CR of the blank line, then the LF on its own
+    std::string Received = Data.substr(0, Data.size() - 1);
+    EXPECT_EQ(Message.ParseData(Received.data(), (int) Received.size()), 0);
+    EXPECT_FALSE(Message.bIsMessageComplete);
+    EXPECT_FALSE(Message.bIsMessageMalformed);
+
+    Received = Data;
+    EXPECT_EQ(Message.ParseData(Received.data(), (int) Received.size()), (int) Data.size());
+    EXPECT_TRUE(Message.bIsMessageComplete);
+    EXPECT_EQ(Message.mUrl, "/a");
+}
+
+TEST(ServerRequestMessage, BareLfLinesAndLeadingBlankLinesAreAccepted)
+{
+    const ParseResult Result = ParseAtOnce("\r\n\nGET /a HTTP/1.1\nHost: x\n\n");
+    ASSERT_TRUE(Result.bComplete);
+    EXPECT_EQ(Result.Url, "/a");
+    ASSERT_EQ(Result.Headers.size(), 1u);
+    EXPECT_EQ(Result.Headers[0].second, "x");
+}
+
+TEST(ServerRequestMessage, StopsAtTheEndOfTheHead)
+{
+    // A pipelined request after this one is left for the next parse
+    const std::string First = "GET /first HTTP/1.1\r\n\r\n";
+    const std::string Data = First + "GET /second HTTP/1.1\r\n\r\n";
+    ServerRequestMessage Message;
+    EXPECT_EQ(Message.ParseData(Data.data(), (int) Data.size()), (int) First.size());
+    EXPECT_EQ(Message.mUrl, "/first");
+}
+
+TEST(ServerRequestMessage, UnknownMethodIsStillARequest)
+{
+    const ParseResult Result = ParseAtOnce("BREW /pot HTTP/1.1\r\n\r\n");
+    ASSERT_TRUE(Result.bComplete);
+    EXPECT_EQ(Result.RequestType, ServerRequestType::ServerRequestType_Invalid);
+}
+
+TEST(ServerRequestMessage, OversizeHeadIsMalformed)
+{
+    // One line that never ends
+    const std::string LongLine = "GET /" + std::string(70 * 1024, 'a');
+    const ParseResult LongLineResult = ParseAtOnce(LongLine);
+    EXPECT_TRUE(LongLineResult.bMalformed);
+
+    // Lots of short headers adding up to too much
+    std::string ManyHeaders = "GET / HTTP/1.1\r\n";
+    for(int i = 0; ManyHeaders.size() < 70 * 1024; i++)
+    {
+        ManyHeaders += "X-Header-" + std::to_string(i) + ": " + std::string(100, 'v') + "\r\n";
+    }
+    EXPECT_TRUE(ParseAtOnce(ManyHeaders + "\r\n").bMalformed);
+    EXPECT_TRUE(ParseAtOnce(ManyHeaders).bMalformed);
+
+    // Caught while it's still arriving, not just once it's whole
+    EXPECT_TRUE(ParseInPieces(ManyHeaders, ManyHeaders.size() - 1000).bMalformed);
+
+    // Just under the limit is fine
+    std::string BigHead = "GET / HTTP/1.1\r\nX-Big: " + std::string(60 * 1024, 'v') + "\r\n\r\n";
+    EXPECT_TRUE(ParseAtOnce(BigHead).bComplete);
+}
+
+TEST(ServerRequestMessage, InvalidTokenBytesAreMalformed)
+{
+    const char* const Requests[] =
+    {
+        "G(T / HTTP/1.1\r\n\r\n",                  // separator in the method
+        "GE\"T / HTTP/1.1\r\n\r\n",
+        " GET / HTTP/1.1\r\n\r\n",                 // no method
+        "GET  HTTP/1.1\r\n\r\n",                   // no target
+        "GET a/b HTTP/1.1\r\n\r\n",                // target not starting '/'
+        "GET / HTTP/1.1\r\nBad Key: v\r\n\r\n",     // space in a header name
+        "GET / HTTP/1.1\r\nKey : v\r\n\r\n",        // space before the colon
+        "GET / HTTP/1.1\r\nK@y: v\r\n\r\n",
+        "GET / HTTP/1.1\r\n: v\r\n\r\n",            // no header name
+        "GET / HTTP/1.1\r\nNoColon\r\n\r\n",
+        "GET / HTTP/1.1\r\n folded: v\r\n\r\n",     // obsolete line folding
+        "GET / HTTP/1.1 \r\n\r\n",
+        "GET / http/1.1\r\n\r\n",
+        "GET / HTTP/1.10\r\n\r\n",
+        "GET / HTTP/1.x\r\n\r\n",
+        "GET / HTTP/11\r\n\r\n",
+        "GET / HTTP/2\r\n\r\n",
+    };
+    for(const char* Request : Requests)
+    {
+        const ParseResult Result = ParseAtOnce(Request);
+        EXPECT_TRUE(Result.bMalformed) << Request;
+        EXPECT_FALSE(Result.bComplete) << Request;
+        EXPECT_TRUE(ParseInPieces(Request, 0).bMalformed) << Request;
+
+        ServerRequestMessage Message;
+        const std::string Data = Request;
+        ParseWhole(Message, Data);
+        EXPECT_FALSE(Message.bIsVersionUnsupported) << Request;
+    }
+}
+
+TEST(ServerRequestMessage, OnlyHttp10And11AreSupported)
+{
+    for(const char* Version : { "HTTP/1.0", "HTTP/1.1" })
+    {
+        ServerRequestMessage Message;
+        const std::string Data = std::string("GET / ") + Version + "\r\n\r\n";
+        ParseWhole(Message, Data);
+        EXPECT_TRUE(Message.bIsMessageComplete) << Version;
+        EXPECT_FALSE(Message.bIsVersionUnsupported) << Version;
+    }
+
+    // Well formed but not spoken here, they're told so rather than that they're malformed
+    for(const char* Version : { "HTTP/1.2", "HTTP/1.9", "HTTP/2.0", "HTTP/0.9", "HTTP/3.0" })
+    {
+        ServerRequestMessage Message;
+        const std::string Data = std::string("GET / ") + Version + "\r\n\r\n";
+        ParseWhole(Message, Data);
+        EXPECT_FALSE(Message.bIsMessageComplete) << Version;
+        EXPECT_TRUE(Message.bIsMessageMalformed) << Version;
+        EXPECT_TRUE(Message.bIsVersionUnsupported) << Version;
+    }
+}
+
+TEST(ServerRequestMessage, ControlBytesAreMalformed)
+{
+    const std::string Requests[] =
+    {
+        std::string("GET /a\x01b HTTP/1.1\r\n\r\n"),
+        std::string("GET /a\x7f HTTP/1.1\r\n\r\n"),
+        std::string("GET /a HTTP/1.1\r\nKey: v\x1b\r\n\r\n"),
+        std::string("GET /a HTTP/1.1\r\nKey: a\rb\r\n\r\n"),         // bare CR
+        std::string("GET /a HTTP/1.1\r\nKey: v\r\r\n\r\n"),
+        std::string("GET /a HTTP/1.1\r\nKey: \0v\r\n\r\n", 28),
+        std::string("GET /a HTTP/1.1\r\nKey: v\r\n\r\r\n"),             // the blank line too
+    };
+    for(const std::string& Request : Requests)
+    {
+        EXPECT_TRUE(ParseAtOnce(Request).bMalformed) << Request;
+        EXPECT_TRUE(ParseInPieces(Request, 0).bMalformed) << Request;
+    }
+
+    // Tabs are fine in a value
+    const ParseResult Tabbed = ParseAtOnce("GET /a HTTP/1.1\r\nKey: a\tb\r\n\r\n");
+    ASSERT_TRUE(Tabbed.bComplete);
+    EXPECT_EQ(Tabbed.Headers[0].second, "a\tb");
+
+    // Bytes past 0x7f aren't control bytes
+    const ParseResult HighBytes = ParseAtOnce("GET /caf\xc3\xa9 HTTP/1.1\r\nKey: \xff\r\n\r\n");
+    EXPECT_TRUE(HighBytes.bComplete);
+}
+
+TEST(ServerRequestMessage, BodyFramingHeaders)
+{
+    ServerRequestMessage Chunked;
+    const std::string ChunkedData = "POST / HTTP/1.1\r\nTransfer-Encoding: Chunked\r\n\r\n";
+    ParseWhole(Chunked, ChunkedData);
+    ASSERT_TRUE(Chunked.bIsMessageComplete);
+    EXPECT_TRUE(Chunked.IsBodyChunked());
+    EXPECT_TRUE(Chunked.HasBody());
+
+    ServerRequestMessage Repeated;
+    const std::string RepeatedData = "POST / HTTP/1.1\r\nContent-Length: 5\r\nContent-Length: 5\r\n\r\n";
+    ParseWhole(Repeated, RepeatedData);
+    ASSERT_TRUE(Repeated.bIsMessageComplete);
+    EXPECT_EQ(Repeated.GetContentLength(), 5);
+
+    ServerRequestMessage NoBody;
+    const std::string NoBodyData = "GET / HTTP/1.1\r\n\r\n";
+    ParseWhole(NoBody, NoBodyData);
+    EXPECT_FALSE(NoBody.HasBody());
+    EXPECT_EQ(NoBody.GetContentLength(), -1);
+
+    const char* const Malformed[] =
+    {
+        "POST / HTTP/1.1\r\nContent-Length: 5\r\nContent-Length: 6\r\n\r\n",        // disagreeing repeats
+        "POST / HTTP/1.1\r\nContent-Length: 5\r\nTransfer-Encoding: chunked\r\n\r\n", // framed both ways
+        "POST / HTTP/1.1\r\nContent-Length: -5\r\n\r\n",
+        "POST / HTTP/1.1\r\nContent-Length: 5x\r\n\r\n",
+        "POST / HTTP/1.1\r\nContent-Length: \r\n\r\n",
+        "POST / HTTP/1.1\r\nContent-Length: 1234567890123456789\r\n\r\n",            // could overflow
+        "POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n",
+    };
+    for(const char* Request : Malformed)
+    {
+        EXPECT_TRUE(ParseAtOnce(Request).bMalformed) << Request;
+    }
+}
+
+TEST(ServerRequestMessage, Http10ClosesUnlessAskedToKeepAlive)
+{
+    const std::string Plain = "GET / HTTP/1.0\r\nHost: a\r\n\r\n";
+    ServerRequestMessage PlainMessage;
+    ParseWhole(PlainMessage, Plain);
+    ASSERT_TRUE(PlainMessage.bIsMessageComplete);
+    EXPECT_EQ(PlainMessage.mHttpMinorVersion, 0);
+    EXPECT_EQ(PlainMessage.GetConnectionPersistence(), ConnectionPersistence::ConnectionPersistence_Close);
+
+    const std::string KeepAlive = "GET / HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n";
+    ServerRequestMessage KeepAliveMessage;
+    ParseWhole(KeepAliveMessage, KeepAlive);
+    EXPECT_EQ(KeepAliveMessage.GetConnectionPersistence(), ConnectionPersistence::ConnectionPersistence_KeepAliveAnnounced);
+}
+
+TEST(ServerRequestMessage, Http11KeepsAliveUnlessAskedToClose)
+{
+    const std::string Plain = "GET / HTTP/1.1\r\nHost: a\r\n\r\n";
+    ServerRequestMessage PlainMessage;
+    ParseWhole(PlainMessage, Plain);
+    EXPECT_EQ(PlainMessage.mHttpMinorVersion, 1);
+    EXPECT_EQ(PlainMessage.GetConnectionPersistence(), ConnectionPersistence::ConnectionPersistence_KeepAlive);
+
+    // 1.1 doesn't need telling it's being kept
+    const std::string KeepAlive = "GET / HTTP/1.1\r\nConnection: keep-alive\r\n\r\n";
+    ServerRequestMessage KeepAliveMessage;
+    ParseWhole(KeepAliveMessage, KeepAlive);
+    EXPECT_EQ(KeepAliveMessage.GetConnectionPersistence(), ConnectionPersistence::ConnectionPersistence_KeepAlive);
+
+    const std::string Close = "GET / HTTP/1.1\r\nConnection: close\r\n\r\n";
+    ServerRequestMessage CloseMessage;
+    ParseWhole(CloseMessage, Close);
+    EXPECT_EQ(CloseMessage.GetConnectionPersistence(), ConnectionPersistence::ConnectionPersistence_Close);
+}
+
+TEST(ServerRequestMessage, ConnectionOptionsAreAList)
+{
+    const std::string KeepAlive = "GET / HTTP/1.0\r\nConnection: Upgrade ,\tkeep-alive\r\n\r\n";
+    ServerRequestMessage KeepAliveMessage;
+    ParseWhole(KeepAliveMessage, KeepAlive);
+    EXPECT_EQ(KeepAliveMessage.GetConnectionPersistence(), ConnectionPersistence::ConnectionPersistence_KeepAliveAnnounced);
+
+    // Close wins over keep-alive
+    const std::string Both = "GET / HTTP/1.0\r\nConnection: keep-alive, CLOSE\r\n\r\n";
+    ServerRequestMessage BothMessage;
+    ParseWhole(BothMessage, Both);
+    EXPECT_EQ(BothMessage.GetConnectionPersistence(), ConnectionPersistence::ConnectionPersistence_Close);
+
+    // Only whole options count
+    const std::string NotQuite = "GET / HTTP/1.1\r\nConnection: closed, keep-alive-ish\r\n\r\n";
+    ServerRequestMessage NotQuiteMessage;
+    ParseWhole(NotQuiteMessage, NotQuite);
+    EXPECT_EQ(NotQuiteMessage.GetConnectionPersistence(), ConnectionPersistence::ConnectionPersistence_KeepAlive);
+}
+
+TEST(ServerResponseMessage, HeaderBlockFollowsPersistence)
+{
+    ServerResponseMessage Response(ServerResponseStatusCode::ServerResponseStatusCode_200);
+    Response.AddContent({ 'h', 'i' }, "text/plain");
+    Response.BuildMessage();
+
+    const std::string& Plain = Response.GetHeaderBlock(ConnectionPersistence::ConnectionPersistence_KeepAlive);
+    const std::string& KeepAlive = Response.GetHeaderBlock(ConnectionPersistence::ConnectionPersistence_KeepAliveAnnounced);
+    const std::string& Close = Response.GetHeaderBlock(ConnectionPersistence::ConnectionPersistence_Close);
+    EXPECT_EQ(Plain.find("Connection:"), std::string::npos);
+    EXPECT_NE(KeepAlive.find("Connection: keep-alive\r\n"), std::string::npos);
+    EXPECT_NE(Close.find("Connection: close\r\n"), std::string::npos);
+    for(const std::string* HeaderBlock : { &Plain, &KeepAlive, &Close })
+    {
+        EXPECT_EQ(HeaderBlock->rfind("HTTP/1.1 200 Ok\r\n", 0), 0u);
+        EXPECT_NE(HeaderBlock->find("Content-Length: 2\r\n"), std::string::npos);
+        EXPECT_EQ(HeaderBlock->substr(HeaderBlock->size() - 4), "\r\n\r\n");
+    }
+}
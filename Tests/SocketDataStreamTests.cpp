@@ -0,0 +1,136 @@
+#include "Common.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+using namespace WebServer;
+
+namespace
+{
+    // Enough bytes to run over a few chunks, each position recognisable
+    std::string BuildData(int Length)
+    {
+        std::string Data((size_t) Length, '\0');
+        for(int i = 0; i < Length; i++)
+        {
+            Data[(size_t) i] = (char) ('a' + (i * 7) % 26);
+        }
+        return Data;
+    }
+
+    std::string ReadFront(const SocketDataStream& Stream)
+    {
+        const char* Front = nullptr;
+        const int FrontLength = Stream.GetFrontData(Front);
+        return std::string(Front, (size_t) FrontLength);
+    }
+}
+
+TEST(SocketDataStream, StartsEmpty)
+{
+    SocketDataStream Stream;
+    const char* Front = nullptr;
+    EXPECT_EQ(Stream.GetDataLen(), 0);
+    EXPECT_EQ(Stream.GetFrontData(Front), 0);
+}
+
+TEST(SocketDataStream, LinearDataJoinsChunks)
+{
+    const std::string Data = BuildData(SocketChunkPool::ChunkSize * 3 + 100);
+    SocketDataStream Stream;
+    Stream.StreamRequestData(Data.data(), (int) Data.size());
+
+    // Only the first chunk is contiguous until it's asked for all of it
+    EXPECT_EQ(ReadFront(Stream), Data.substr(0, SocketChunkPool::ChunkSize));
+    ASSERT_EQ(Stream.GetDataLen(), (int) Data.size());
+    EXPECT_EQ(std::string(Stream.GetLinearData(), Data.size()), Data);
+    EXPECT_EQ(ReadFront(Stream), Data);
+}
+
+TEST(SocketDataStream, PrepareWriteStopsAtTheChunksEnd)
+{
+    SocketDataStream Stream;
+    int WriteLength = 100;
+    char* Write = Stream.PrepareWrite(WriteLength);
+    ASSERT_EQ(WriteLength, 100);
+    memset(Write, 'x', 60);
+    Stream.CommitWrite(60);
+
+    // What's left of the chunk, not the whole ask
+    WriteLength = SocketChunkPool::ChunkSize;
+    Write = Stream.PrepareWrite(WriteLength);
+    EXPECT_EQ(WriteLength, SocketChunkPool::ChunkSize - 60);
+    memset(Write, 'y', WriteLength);
+    Stream.CommitWrite(WriteLength);
+
+    // A full chunk starts another
+    WriteLength = 10;
+    Write = Stream.PrepareWrite(WriteLength);
+    EXPECT_EQ(WriteLength, 10);
+    memcpy(Write, "0123456789", 10);
+    Stream.CommitWrite(10);
+
+    const std::string Expected = std::string(60, 'x') + std::string(SocketChunkPool::ChunkSize - 60, 'y') + "0123456789";
+    EXPECT_EQ(std::string(Stream.GetLinearData(), (size_t) Stream.GetDataLen()), Expected);
+}
+
+TEST(SocketDataStream, ConsumeKeepsWhatFollows)
+{
+    const std::string Data = BuildData(SocketChunkPool::ChunkSize * 2 + 500);
+    SocketDataStream Stream;
+    Stream.StreamRequestData(Data.data(), (int) Data.size());
+
+    Stream.Consume(10);
+    EXPECT_EQ(ReadFront(Stream), Data.substr(10, SocketChunkPool::ChunkSize - 10));
+
+    // Past the end of the first chunk
+    Stream.Consume(SocketChunkPool::ChunkSize);
+    ASSERT_EQ(Stream.GetDataLen(), (int) Data.size() - SocketChunkPool::ChunkSize - 10);
+    EXPECT_EQ(std::string(Stream.GetLinearData(), (size_t) Stream.GetDataLen()), Data.substr(SocketChunkPool::ChunkSize + 10));
+
+    // Appending after consuming carries on from the end
+    Stream.StreamRequestData("tail", 4);
+    EXPECT_EQ(std::string(Stream.GetLinearData(), (size_t) Stream.GetDataLen()), Data.substr(SocketChunkPool::ChunkSize + 10) + "tail");
+
+    Stream.Consume(Stream.GetDataLen() + 100);
+    EXPECT_EQ(Stream.GetDataLen(), 0);
+}
+
+TEST(SocketDataStream, CopiesAndMovesKeepTheBytes)
+{
+    const std::string Data = BuildData(SocketChunkPool::ChunkSize + 1000);
+    SocketDataStream Stream;
+    Stream.StreamRequestData(Data.data(), (int) Data.size());
+    Stream.Consume(5);
+
+    SocketDataStream Copy(Stream);
+    EXPECT_EQ(std::string(Copy.GetLinearData(), (size_t) Copy.GetDataLen()), Data.substr(5));
+
+    SocketDataStream Moved(std::move(Stream));
+    EXPECT_EQ(std::string(Moved.GetLinearData(), (size_t) Moved.GetDataLen()), Data.substr(5));
+    EXPECT_EQ(Stream.GetDataLen(), 0);
+
+    SocketDataStream Assigned;
+    Assigned.StreamRequestData("old", 3);
+    Assigned = std::move(Moved);
+    EXPECT_EQ(std::string(Assigned.GetLinearData(), (size_t) Assigned.GetDataLen()), Data.substr(5));
+}
+
+TEST(SocketDataStream, ChunksAreRecycled)
+{
+    char* Chunk = SocketChunkPool::AcquireChunk();
+    SocketChunkPool::ReleaseChunk(Chunk);
+    EXPECT_EQ(SocketChunkPool::AcquireChunk(), Chunk);
+    SocketChunkPool::ReleaseChunk(Chunk);
+
+    // A reset stream's chunk is the next one handed out
+    SocketDataStream Stream;
+    int WriteLength = 10;
+    char* Write = Stream.PrepareWrite(WriteLength);
+    Stream.CommitWrite(WriteLength);
+    Stream.Reset();
+    EXPECT_EQ(SocketChunkPool::AcquireChunk(), Write);
+    SocketChunkPool::ReleaseChunk(Write);
+}
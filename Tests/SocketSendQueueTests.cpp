@@ -0,0 +1,132 @@
+#include "TestCommon.h"
+
+#include "SocketSendQueue.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace WebServer;
+
+namespace
+{
+    std::string GatherAll(const SocketSendQueue& Queue)
+    {
+        SocketSendBuffer Buffers[64];
+        const int NumBuffers = Queue.GatherBuffers(Buffers, 64);
+        std::string Gathered;
+        for(int i = 0; i < NumBuffers; i++)
+        {
+            Gathered.append(Buffers[i].Data, (size_t) Buffers[i].DataLen);
+        }
+        return Gathered;
+    }
+}
+
+TEST(SocketSendQueue, PersistentDataIsReferencedTheRestCopied)
+{
+    const std::string Persistent = "persistent";
+    std::string Transient = "transient";
+
+    SocketSendQueue Queue;
+    Queue.Push(Persistent.data(), (int) Persistent.size(), true);
+    Queue.Push(Transient.data(), (int) Transient.size(), false);
+    Transient.assign(Transient.size(), 'x');
+
+    SocketSendBuffer Buffers[2];
+    ASSERT_EQ(Queue.GatherBuffers(Buffers, 2), 2);
+    EXPECT_EQ(Buffers[0].Data, Persistent.data());
+    EXPECT_NE(Buffers[1].Data, Transient.data());
+    EXPECT_EQ(GatherAll(Queue), "persistenttransient");
+    EXPECT_EQ(Queue.GetQueuedBytes(), Persistent.size() + Transient.size());
+}
+
+TEST(SocketSendQueue, EmptyPushesAreIgnored)
+{
+    SocketSendQueue Queue;
+    Queue.Push("", 0, true);
+    Queue.Push(nullptr, 0, false);
+    EXPECT_TRUE(Queue.IsEmpty());
+    EXPECT_EQ(Queue.GetQueuedBytes(), 0u);
+}
+
+TEST(SocketSendQueue, ConsumeLeavesPartlySentBufferAtTheFront)
+{
+    SocketSendQueue Queue;
+    Queue.Push("abcdef", 6, true);
+    Queue.Push("ghij", 4, false);
+
+    Queue.Consume(4);
+    EXPECT_EQ(GatherAll(Queue), "efghij");
+    EXPECT_EQ(Queue.GetQueuedBytes(), 6u);
+
+    Queue.Consume(3);
+    EXPECT_EQ(GatherAll(Queue), "hij");
+
+    // More than's queued just empties it
+    Queue.Consume(100);
+    EXPECT_TRUE(Queue.IsEmpty());
+    EXPECT_EQ(Queue.GetQueuedBytes(), 0u);
+}
+
+TEST(SocketSendQueue, FlushStopsWhenTheSocketIsFullAndResumes)
+{
+    TestUtil::LoopbackConnection Connection;
+    ASSERT_TRUE(Connection.IsConnected());
+    ASSERT_TRUE(SetSocketNonBlocking(Connection.Server));
+
+    // Far more than loopback's socket buffers hold, in more buffers than one vectored send takes
+    std::vector<std::string> Parts;
+    std::string Expected;
+    for(int i = 0; i < 200; i++)
+    {
+        Parts.push_back(std::string(64 * 1024, (char) ('a' + i % 26)));
+        Expected += Parts.back();
+    }
+
+    SocketSendQueue Queue;
+    for(size_t i = 0; i < Parts.size(); i++)
+    {
+        Queue.Push(Parts[i].data(), (int) Parts[i].size(), i % 2 == 0);
+    }
+
+    ASSERT_EQ(Queue.Flush(Connection.Server), SocketSendResult::SocketSendResult_WouldBlock);
+    EXPECT_FALSE(Queue.IsEmpty());
+    EXPECT_LT(Queue.GetQueuedBytes(), Expected.size());
+
+    // Drain the other end a bit at a time, flushing whenever there's room
+    std::string Received;
+    char Buffer[64 * 1024];
+    while(Received.size() < Expected.size())
+    {
+        const int Read = TestUtil::ReceiveSome(Connection.Client, Buffer, (int) sizeof(Buffer));
+        ASSERT_GT(Read, 0);
+        Received.append(Buffer, (size_t) Read);
+        if(Queue.IsEmpty() == false)
+        {
+            ASSERT_NE(Queue.Flush(Connection.Server), SocketSendResult::SocketSendResult_Error);
+        }
+    }
+    EXPECT_TRUE(Queue.IsEmpty());
+    EXPECT_TRUE(Received == Expected);     // not EXPECT_EQ, a mismatch would print megabytes
+}
+
+TEST(SocketSendQueue, FlushToAClosedPeerErrors)
+{
+    TestUtil::LoopbackConnection Connection;
+    ASSERT_TRUE(Connection.IsConnected());
+    ASSERT_TRUE(SetSocketNonBlocking(Connection.Server));
+    CloseSocket(Connection.Client);
+    Connection.Client = INVALID_SOCKET;
+
+    const std::string Data(16 * 1024, 'x');
+    SocketSendQueue Queue;
+    SocketSendResult Result = SocketSendResult::SocketSendResult_Complete;
+    for(int i = 0; i < 64 && Result != SocketSendResult::SocketSendResult_Error; i++)
+    {
+        Queue.Push(Data.data(), (int) Data.size(), true);
+        Result = Queue.Flush(Connection.Server);
+    }
+    EXPECT_EQ(Result, SocketSendResult::SocketSendResult_Error);
+}
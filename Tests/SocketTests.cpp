@@ -0,0 +1,114 @@
+#include "TestCommon.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace WebServer;
+
+TEST(Socket, GlobalInitSucceeds)
+{
+    EXPECT_EQ(SocketGlobalInit(), 0);
+    SocketGlobalCleanup();
+}
+
+TEST(Socket, NonBlockingReceiveWouldBlock)
+{
+    TestUtil::LoopbackConnection Connection;
+    ASSERT_TRUE(Connection.IsConnected());
+    ASSERT_TRUE(SetSocketNonBlocking(Connection.Server));
+
+    char Buffer[16];
+    EXPECT_EQ(recv(Connection.Server, Buffer, sizeof(Buffer), 0), SOCKET_ERROR);
+    EXPECT_TRUE(IsSocketWouldBlockError(GetSocketError()));
+}
+
+TEST(Socket, SendDataArrives)
+{
+    TestUtil::LoopbackConnection Connection;
+    ASSERT_TRUE(Connection.IsConnected());
+
+    const std::string Message = "GET / HTTP/1.1\r\n\r\n";
+    EXPECT_EQ(SendSocketData(Connection.Client, Message.data(), (int) Message.size()), (int) Message.size());
+    EXPECT_EQ(TestUtil::ReceiveBytes(Connection.Server, Message.size()), Message);
+}
+
+TEST(Socket, VectoredSendGathersBuffersInOrder)
+{
+    TestUtil::LoopbackConnection Connection;
+    ASSERT_TRUE(Connection.IsConnected());
+
+    // More than one sendmsg call's worth of buffers
+    std::vector<std::string> Parts;
+    std::string Expected;
+    for(int i = 0; i < 150; i++)
+    {
+        Parts.push_back("part-" + std::to_string(i) + ";");
+        Expected += Parts.back();
+    }
+    std::vector<SocketSendBuffer> Buffers;
+    for(const std::string& Part : Parts)
+    {
+        Buffers.push_back({ Part.data(), (int) Part.size(), true });
+    }
+
+    EXPECT_EQ(SendSocketDataVectored(Connection.Server, Buffers.data(), (int) Buffers.size()), (int) Expected.size());
+    EXPECT_EQ(TestUtil::ReceiveBytes(Connection.Client, Expected.size()), Expected);
+}
+
+TEST(Socket, VectoredSendOfNothingSendsNothing)
+{
+    TestUtil::LoopbackConnection Connection;
+    ASSERT_TRUE(Connection.IsConnected());
+
+    EXPECT_EQ(SendSocketDataVectored(Connection.Server, nullptr, 0), 0);
+}
+
+TEST(Socket, FreshConnectionIsWritable)
+{
+    TestUtil::LoopbackConnection Connection;
+    ASSERT_TRUE(Connection.IsConnected());
+
+    EXPECT_TRUE(WaitSocketWritable(Connection.Server, 1000));
+}
+
+TEST(Socket, ShutdownSendEndsPeersReads)
+{
+    TestUtil::LoopbackConnection Connection;
+    ASSERT_TRUE(Connection.IsConnected());
+
+    const std::string Message = "last";
+    SendSocketData(Connection.Server, Message.data(), (int) Message.size());
+    ShutdownSocketSend(Connection.Server);
+
+    EXPECT_EQ(TestUtil::ReceiveBytes(Connection.Client, 64), Message);
+    char Buffer[16];
+    EXPECT_EQ(recv(Connection.Client, Buffer, sizeof(Buffer), 0), 0);
+}
+
+TEST(Socket, SendToClosedPeerFailsWithoutSignal)
+{
+    TestUtil::LoopbackConnection Connection;
+    ASSERT_TRUE(Connection.IsConnected());
+    CloseSocket(Connection.Client);
+    Connection.Client = INVALID_SOCKET;
+
+    // The first send can still be accepted before the reset comes back, a later one mustn't raise SIGPIPE
+    const std::vector<char> Data(64 * 1024, 'x');
+    int Result = 0;
+    for(int i = 0; i < 64 && Result != SOCKET_ERROR; i++)
+    {
+        Result = SendSocketData(Connection.Server, Data.data(), (int) Data.size());
+    }
+    EXPECT_EQ(Result, SOCKET_ERROR);
+}
+
+TEST(Socket, ReuseOptionsApply)
+{
+    SOCKET Socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    ASSERT_NE(Socket, INVALID_SOCKET);
+
+    EXPECT_TRUE(SetSocketReuseAddress(Socket));
+    EXPECT_EQ(SetSocketReusePort(Socket), IsSocketReusePortSupported());
+    CloseSocket(Socket);
+}
@@ -0,0 +1,161 @@
+#include "StaticRouteTable.h"
+#include "WebServer.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace WebServer;
+
+namespace
+{
+    constexpr ServerRequestType GET = ServerRequestType::ServerRequestType_GET;
+    constexpr ServerRequestType POST = ServerRequestType::ServerRequestType_POST;
+
+    constexpr StaticRoute SiteRoutes[] =
+    {
+        { GET, "/" },
+        { GET, "/index.html" },
+        { GET, "/about" },
+        { POST, "/about" },
+        { GET, "/api/v1/users" },
+        { POST, "/api/v1/users" },
+        { GET, "/a-rather-long-url/that/runs/past/several/eight/byte/words.html" },
+        { GET, "/favicon.ico" },
+        { ServerRequestType::ServerRequestType_DELETE, "/api/v1/session" },
+    };
+    constexpr auto SiteRouteTable = MakeStaticRouteTable(SiteRoutes);
+
+    // Worked out by the compiler
+    static_assert(SiteRouteTable.Size() == 9);
+    static_assert(SiteRouteTable.Find(GET, "/about") == 2);
+    static_assert(SiteRouteTable.Find(POST, "/about") == 3);
+    static_assert(SiteRouteTable.Find(POST, "/") == -1);
+    static_assert(SiteRouteTable.IndexOf(GET, "/favicon.ico") == 7);
+    static_assert(StaticRouteHash::HashUrl(GET, "/about") != StaticRouteHash::HashUrl(POST, "/about"));
+
+    constexpr std::array<StaticRoute, 1> SingleRoute = { { { GET, "/only" } } };
+    constexpr auto SingleRouteTable = MakeStaticRouteTable(SingleRoute);
+    static_assert(SingleRouteTable.Find(GET, "/only") == 0);
+    static_assert(SingleRouteTable.Find(GET, "/other") == -1);
+
+    // What a handler does with it, IndexOf gives the case labels
+    const char* Describe(ServerRequestType Method, std::string_view Url)
+    {
+        switch(SiteRouteTable.Find(Method, Url))
+        {
+            case SiteRouteTable.IndexOf(GET, "/"): return "home";
+            case SiteRouteTable.IndexOf(GET, "/about"): return "about";
+            case SiteRouteTable.IndexOf(POST, "/about"): return "about form";
+            default: return "other";
+        }
+    }
+}
+
+TEST(StaticRouteTable, FindsEveryRoute)
+{
+    for(int i = 0; i < (int) SiteRouteTable.Size(); i++)
+    {
+        const StaticRoute& Route = SiteRouteTable.GetRoute(i);
+        EXPECT_EQ(SiteRouteTable.Find(Route.Method, Route.Url), i) << Route.Url;
+    }
+
+    EXPECT_STREQ(Describe(GET, "/"), "home");
+    EXPECT_STREQ(Describe(GET, "/about"), "about");
+    EXPECT_STREQ(Describe(POST, "/about"), "about form");
+    EXPECT_STREQ(Describe(GET, "/index.html"), "other");
+    EXPECT_STREQ(Describe(GET, "/nowhere"), "other");
+}
+
+TEST(StaticRouteTable, MissesAreMisses)
+{
+    for(const char* Url : { "", "/About", "/about/", "/abou", "/index.htm", "/index.html ", "/api/v1/user", "/api/v1/users?x=1" })
+    {
+        EXPECT_EQ(SiteRouteTable.Find(GET, Url), -1) << Url;
+    }
+    EXPECT_EQ(SiteRouteTable.Find(ServerRequestType::ServerRequestType_PUT, "/about"), -1);
+    EXPECT_EQ(SiteRouteTable.Find(ServerRequestType::ServerRequestType_DELETE, "/api/v1/users"), -1);
+
+    // A trailing NUL only changes the hash through the length
+    const std::string WithNul("/about\0", 7);
+    EXPECT_NE(StaticRouteHash::HashUrl(GET, WithNul), StaticRouteHash::HashUrl(GET, "/about"));
+    EXPECT_EQ(SiteRouteTable.Find(GET, WithNul), -1);
+}
+
+TEST(StaticRouteTable, HashSeparatesMethodsAndUrls)
+{
+    // The method used to be XORed over the url's eighth byte, these two came out the same
+    EXPECT_NE(StaticRouteHash::HashUrl(GET, "/item/13"), StaticRouteHash::HashUrl(POST, "/item/10"));
+
+    std::set<uint64_t> Hashes;
+    size_t NumHashed = 0;
+    for(int Method = (int) GET; Method <= (int) ServerRequestType::ServerRequestType_DELETE; Method++)
+    {
+        for(int i = 0; i < 5000; i++)
+        {
+            for(const std::string& Url : { "/item/" + std::to_string(i), "/" + std::to_string(i), std::to_string(i) + "/" })
+            {
+                Hashes.insert(StaticRouteHash::HashUrl((ServerRequestType) Method, Url));
+                NumHashed++;
+            }
+        }
+    }
+    EXPECT_EQ(Hashes.size(), NumHashed);
+}
+
+TEST(StaticRouteTable, LookupMatchesTheTable)
+{
+    const StaticRouteLookup Lookup = SiteRouteTable.GetLookup();
+    EXPECT_EQ(Lookup.NumRoutes, (int) SiteRouteTable.Size());
+    for(int i = 0; i < (int) SiteRouteTable.Size(); i++)
+    {
+        const StaticRoute& Route = SiteRouteTable.GetRoute(i);
+        EXPECT_EQ(Lookup.Find(Route.Method, Route.Url), i);
+
+        // A hash worked out at run time, as the request parser does, is the compiler's
+        const std::string Url(Route.Url);
+        EXPECT_EQ(Lookup.Find(Route.Method, Url, StaticRouteHash::HashUrl(Route.Method, Url)), i);
+    }
+    EXPECT_EQ(Lookup.Find(GET, "/missing"), -1);
+
+    // One that was never given a table has nothing in it
+    const StaticRouteLookup Empty;
+    EXPECT_EQ(Empty.Find(GET, "/"), -1);
+    EXPECT_EQ(Empty.Find(GET, "/", StaticRouteHash::HashUrl(GET, "/")), -1);
+}
+
+TEST(StaticRouteTable, ManyRoutes)
+{
+    // Built at run time here so there can be plenty, the build's the same one the compiler runs
+    constexpr size_t NumRoutes = 2000;
+    std::vector<std::string> Urls;
+    std::vector<StaticRoute> Routes;
+    Urls.reserve(NumRoutes);
+    for(size_t i = 0; i < NumRoutes; i++)
+    {
+        Urls.push_back((i % 2 == 0) ? "/item/" + std::to_string(i) : "/assets/chunk-" + std::to_string(i) + ".js");
+        Routes.push_back({ (i % 3 == 0) ? POST : GET, Urls.back() });
+    }
+    std::unique_ptr<StaticRouteTable<NumRoutes>> Table = std::make_unique<StaticRouteTable<NumRoutes>>(Routes.data());
+    const StaticRouteLookup Lookup = Table->GetLookup();
+    for(size_t i = 0; i < NumRoutes; i++)
+    {
+        ASSERT_EQ(Table->Find(Routes[i].Method, Urls[i]), (int) i) << Urls[i];
+        ASSERT_EQ(Lookup.Find(Routes[i].Method, Urls[i]), (int) i) << Urls[i];
+        EXPECT_EQ(Table->Find((Routes[i].Method == GET) ? POST : GET, Urls[i]), -1) << Urls[i];
+        EXPECT_EQ(Table->Find(Routes[i].Method, Urls[i] + "x"), -1) << Urls[i];
+    }
+}
+
+TEST(StaticRouteTable, DuplicateRouteIsRefused)
+{
+    // A compile error for a constexpr table, a throw when it's built at run time
+    const StaticRoute Duplicated[] = { { GET, "/a" }, { POST, "/a" }, { GET, "/a" } };
+    EXPECT_ANY_THROW(StaticRouteTable<3> Table(Duplicated));
+
+    const StaticRoute SameUrlDifferentMethods[] = { { GET, "/a" }, { POST, "/a" }, { ServerRequestType::ServerRequestType_PUT, "/a" } };
+    EXPECT_NO_THROW(StaticRouteTable<3> Table(SameUrlDifferentMethods));
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "Socket.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+// Helpers the unit tests share, sockets connected to each other over loopback
+namespace TestUtil
+{
+    // Both ends of a TCP connection on 127.0.0.1, closed when it goes
+    struct LoopbackConnection
+    {
+        SOCKET Client = INVALID_SOCKET;
+        SOCKET Server = INVALID_SOCKET;
+
+        LoopbackConnection()
+        {
+            WebServer::SocketGlobalInit();
+
+            SOCKET Listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            sockaddr_in Address{};
+            Address.sin_family = AF_INET;
+            Address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            Address.sin_port = 0;
+            socklen_t AddressLength = sizeof(Address);
+            if(Listener == INVALID_SOCKET || bind(Listener, (sockaddr*) &Address, sizeof(Address)) != 0 || listen(Listener, 1) != 0
+                || getsockname(Listener, (sockaddr*) &Address, &AddressLength) != 0)
+            {
+                WebServer::CloseSocket(Listener);
+                return;
+            }
+
+            Client = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            if(connect(Client, (sockaddr*) &Address, sizeof(Address)) == 0)
+            {
+                Server = accept(Listener, nullptr, nullptr);
+            }
+            WebServer::CloseSocket(Listener);
+        }
+
+        ~LoopbackConnection()
+        {
+            WebServer::CloseSocket(Client);
+            WebServer::CloseSocket(Server);
+        }
+
+        LoopbackConnection(const LoopbackConnection& Other) = delete;
+        LoopbackConnection& operator=(const LoopbackConnection& Other) = delete;
+
+        bool IsConnected() const { return Client != INVALID_SOCKET && Server != INVALID_SOCKET; }
+    };
+
+    // Blocking recv that carries on through signals, the server's io_uring can interrupt blocking calls on other threads
+    inline int ReceiveSome(SOCKET Socket, char* Buffer, int Length)
+    {
+        int Read = recv(Socket, Buffer, Length, 0);
+#ifndef _WIN32
+        while(Read == SOCKET_ERROR && errno == EINTR)
+        {
+            Read = recv(Socket, Buffer, Length, 0);
+        }
+#endif
+        return Read;
+    }
+
+    // Blocking connection to a server on this machine, reads give up after a few seconds rather than hang a test.
+    // A receive buffer size has to be set before connecting to limit the window the server's offered
+    inline SOCKET ConnectLoopback(uint16_t Port, int ReceiveBufferSize = 0)
+    {
+        SOCKET Socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if(Socket != INVALID_SOCKET && ReceiveBufferSize > 0)
+        {
+            setsockopt(Socket, SOL_SOCKET, SO_RCVBUF, (const char*) &ReceiveBufferSize, sizeof(ReceiveBufferSize));
+        }
+        sockaddr_in Address{};
+        Address.sin_family = AF_INET;
+        Address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        Address.sin_port = htons(Port);
+        if(Socket == INVALID_SOCKET || connect(Socket, (sockaddr*) &Address, sizeof(Address)) != 0)
+        {
+            WebServer::CloseSocket(Socket);
+            return INVALID_SOCKET;
+        }
+
+#ifdef _WIN32
+        DWORD Timeout = 5000;
+#else
+        timeval Timeout{ 5, 0 };
+#endif
+        setsockopt(Socket, SOL_SOCKET, SO_RCVTIMEO, (const char*) &Timeout, sizeof(Timeout));
+        return Socket;
+    }
+
+    inline bool SendString(SOCKET Socket, const std::string& Data)
+    {
+        return WebServer::SendSocketData(Socket, Data.data(), (int) Data.size()) == (int) Data.size();
+    }
+
+    // One response, its head and a Content-Length body. Whatever arrived if the connection closed or timed out first
+    inline std::string ReceiveResponse(SOCKET Socket)
+    {
+        std::string Received;
+        char Buffer[4096];
+        size_t HeadEnd = std::string::npos;
+        size_t ResponseLength = std::string::npos;
+        while(ResponseLength == std::string::npos || Received.size() < ResponseLength)
+        {
+            // A byte at a time until the head's in, so none of the next response gets taken
+            const size_t ReadLength = (ResponseLength == std::string::npos) ? 1 : std::min(sizeof(Buffer), ResponseLength - Received.size());
+            int Read = ReceiveSome(Socket, Buffer, (int) ReadLength);
+            if(Read <= 0)
+            {
+                break;
+            }
+            Received.append(Buffer, (size_t) Read);
+
+            if(HeadEnd == std::string::npos && (HeadEnd = Received.find("\r\n\r\n")) != std::string::npos)
+            {
+                const size_t LengthHeader = Received.find("Content-Length: ");
+                const size_t BodyLength = (LengthHeader < HeadEnd) ? (size_t) std::strtoull(Received.c_str() + LengthHeader + 16, nullptr, 10) : 0;
+                ResponseLength = HeadEnd + 4 + BodyLength;
+            }
+        }
+        return Received;
+    }
+
+    // True if the peer closes the connection within the socket's receive timeout without sending anything more
+    inline bool IsClosedByPeer(SOCKET Socket)
+    {
+        char Buffer[1];
+        return ReceiveSome(Socket, Buffer, 1) == 0;
+    }
+
+    // Blocking reads until Length bytes have come or the socket closes/errors
+    inline std::string ReceiveBytes(SOCKET Socket, size_t Length)
+    {
+        std::string Received;
+        char Buffer[4096];
+        while(Received.size() < Length)
+        {
+            int Read = ReceiveSome(Socket, Buffer, (int) std::min(sizeof(Buffer), Length - Received.size()));
+            if(Read <= 0)
+            {
+                break;
+            }
+            Received.append(Buffer, (size_t) Read);
+        }
+        return Received;
+    }
+}
@@ -0,0 +1,153 @@
+#include "TimerWheel.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace WebServer;
+
+namespace
+{
+    // The wheel counts from when it was made, times are given from just after that
+    struct TestWheel
+    {
+        explicit TestWheel(int TickMs) : Wheel(TickMs), Start(TimerWheel::Clock::now()) {}
+
+        int AdvanceTo(int Ms) { return Wheel.Advance(Start + std::chrono::milliseconds(Ms)); }
+
+        TimerWheel Wheel;
+        TimerWheel::Clock::time_point Start;
+    };
+}
+
+TEST(TimerWheel, FiresOnceAtItsDelay)
+{
+    TestWheel Test(10);
+    int NumFired = 0;
+    TimerHandle Handle = Test.Wheel.AddTimer([&NumFired] () { NumFired++; });
+    Test.Wheel.Arm(Handle, 100);
+    EXPECT_TRUE(Test.Wheel.IsArmed(Handle));
+
+    Test.AdvanceTo(95);
+    EXPECT_EQ(NumFired, 0);
+    EXPECT_EQ(Test.AdvanceTo(105), 1);
+    EXPECT_EQ(NumFired, 1);
+    EXPECT_FALSE(Test.Wheel.IsArmed(Handle));
+
+    Test.AdvanceTo(1000);
+    EXPECT_EQ(NumFired, 1);
+}
+
+TEST(TimerWheel, PeriodicTimerRepeatsUntilCancelled)
+{
+    TestWheel Test(10);
+    int NumFired = 0;
+    TimerHandle Handle = Test.Wheel.AddTimer([&NumFired] () { NumFired++; });
+    Test.Wheel.Arm(Handle, 50, 50);
+
+    Test.AdvanceTo(255);
+    EXPECT_EQ(NumFired, 5);
+    EXPECT_TRUE(Test.Wheel.IsArmed(Handle));
+
+    Test.Wheel.Cancel(Handle);
+    Test.AdvanceTo(1000);
+    EXPECT_EQ(NumFired, 5);
+    EXPECT_EQ(Test.Wheel.NumArmed(), 0u);
+}
+
+TEST(TimerWheel, RearmMovesTheTimer)
+{
+    TestWheel Test(10);
+    int NumFired = 0;
+    TimerHandle Handle = Test.Wheel.AddTimer([&NumFired] () { NumFired++; });
+    Test.Wheel.Arm(Handle, 100);
+    Test.Wheel.Arm(Handle, 300);
+    EXPECT_EQ(Test.Wheel.NumArmed(), 1u);
+
+    Test.AdvanceTo(295);
+    EXPECT_EQ(NumFired, 0);
+    Test.AdvanceTo(305);
+    EXPECT_EQ(NumFired, 1);
+}
+
+TEST(TimerWheel, LongDelaysCascadeDownTheLevels)
+{
+    TestWheel Test(10);
+    std::vector<int> Fired;
+    const int Delays[] = { 700, 50000, 3000000 };    // one, two and three levels up
+    for(int Delay : Delays)
+    {
+        TimerHandle Handle = Test.Wheel.AddTimer([&Fired, Delay] () { Fired.push_back(Delay); });
+        Test.Wheel.Arm(Handle, Delay);
+    }
+
+    for(int Delay : Delays)
+    {
+        const size_t NumBefore = Fired.size();
+        Test.AdvanceTo(Delay - 5);
+        EXPECT_EQ(Fired.size(), NumBefore) << Delay;
+        Test.AdvanceTo(Delay + 5);
+        ASSERT_EQ(Fired.size(), NumBefore + 1) << Delay;
+        EXPECT_EQ(Fired.back(), Delay);
+    }
+}
+
+TEST(TimerWheel, DelayPastTheTopLevelStillFiresOnTime)
+{
+    // 64^4 one millisecond ticks is a bit under 4.7 hours
+    TestWheel Test(1);
+    int NumFired = 0;
+    TimerHandle Handle = Test.Wheel.AddTimer([&NumFired] () { NumFired++; });
+    Test.Wheel.Arm(Handle, 20000000);
+
+    Test.AdvanceTo(19999990);
+    EXPECT_EQ(NumFired, 0);
+    Test.AdvanceTo(20000010);
+    EXPECT_EQ(NumFired, 1);
+}
+
+TEST(TimerWheel, CallbackCanRearmAndRemoveTimers)
+{
+    TestWheel Test(10);
+    int NumFired = 0;
+    TimerHandle Handle;
+    Handle = Test.Wheel.AddTimer([&] () {
+        if(++NumFired < 3)
+        {
+            Test.Wheel.Arm(Handle, 20);
+        }
+        else
+        {
+            Test.Wheel.RemoveTimer(Handle);
+        }
+        });
+    Test.Wheel.Arm(Handle, 20);
+
+    Test.AdvanceTo(1000);
+    EXPECT_EQ(NumFired, 3);
+    EXPECT_FALSE(Handle.IsValid());
+    EXPECT_EQ(Test.Wheel.NumArmed(), 0u);
+}
+
+TEST(TimerWheel, RemovedHandleGoesStale)
+{
+    TestWheel Test(10);
+    int NumFired = 0;
+    TimerHandle Handle = Test.Wheel.AddTimer([&NumFired] () { NumFired++; });
+    TimerHandle Copy = Handle;
+    Test.Wheel.Arm(Handle, 50);
+    Test.Wheel.RemoveTimer(Handle);
+    EXPECT_FALSE(Handle.IsValid());
+
+    // The slot's reused for a new timer, the old handle mustn't reach it
+    int NumNewFired = 0;
+    TimerHandle NewHandle = Test.Wheel.AddTimer([&NumNewFired] () { NumNewFired++; });
+    EXPECT_EQ(NewHandle.Index, Copy.Index);
+    Test.Wheel.Arm(Copy, 50);
+    EXPECT_FALSE(Test.Wheel.IsArmed(Copy));
+    EXPECT_FALSE(Test.Wheel.IsArmed(NewHandle));
+
+    Test.AdvanceTo(1000);
+    EXPECT_EQ(NumFired, 0);
+    EXPECT_EQ(NumNewFired, 0);
+}
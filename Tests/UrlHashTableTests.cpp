@@ -0,0 +1,223 @@
+#include "UrlHashTable.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+
+using namespace WebServer;
+
+namespace
+{
+    struct TestEntry
+    {
+        std::string Url;
+        int Id = 0;
+    };
+
+    // Hashes are the caller's, so the tests pick them to put urls exactly where they want
+    struct TestTable
+    {
+        bool Insert(const std::string& Url, uint64_t Hash, int Id)
+        {
+            Hashes[Url] = Hash;
+            return Table.Insert(std::make_shared<const TestEntry>(TestEntry{ Url, Id }), Hash);
+        }
+
+        bool Erase(const std::string& Url)
+        {
+            const bool bErased = Table.Erase(Url, Hashes[Url]);
+            Hashes.erase(Url);
+            return bErased;
+        }
+
+        // -1 if it's not there
+        int Find(const std::string& Url, uint64_t Hash) const
+        {
+            const TestEntry* Entry = Table.Find(Url, Hash);
+            return (Entry != nullptr) ? Entry->Id : -1;
+        }
+
+        UrlHashTable<TestEntry> Table;
+        std::map<std::string, uint64_t> Hashes;
+    };
+}
+
+TEST(UrlHashTable, EmptyTableFindsNothing)
+{
+    UrlHashTable<TestEntry> Table;
+    EXPECT_EQ(Table.Find("/", 0), nullptr);
+    EXPECT_FALSE(Table.Erase("/", 0));
+    EXPECT_EQ(Table.Size(), 0u);
+    EXPECT_EQ(Table.GetNumSlots(), 0u);
+}
+
+TEST(UrlHashTable, InsertReplacesAndErases)
+{
+    TestTable Test;
+    EXPECT_TRUE(Test.Insert("/a", 1, 1));
+    EXPECT_TRUE(Test.Insert("/b", 2, 2));
+    EXPECT_FALSE(Test.Insert("/a", 1, 3));     // already there, replaced
+    EXPECT_EQ(Test.Table.Size(), 2u);
+    EXPECT_EQ(Test.Find("/a", 1), 3);
+    EXPECT_EQ(Test.Find("/b", 2), 2);
+
+    // Only ever found under its own hash
+    EXPECT_EQ(Test.Find("/a", 2), -1);
+
+    EXPECT_TRUE(Test.Erase("/a"));
+    EXPECT_FALSE(Test.Table.Erase("/a", 1));
+    EXPECT_EQ(Test.Find("/a", 1), -1);
+    EXPECT_EQ(Test.Find("/b", 2), 2);
+    EXPECT_EQ(Test.Table.Size(), 1u);
+}
+
+TEST(UrlHashTable, SameHashDifferentUrls)
+{
+    // The tag and length both match, only the url itself tells them apart
+    TestTable Test;
+    ASSERT_TRUE(Test.Insert("/aa", 5, 1));
+    ASSERT_TRUE(Test.Insert("/bb", 5, 2));
+    ASSERT_TRUE(Test.Insert("/ccc", 5, 3));
+    EXPECT_EQ(Test.Find("/aa", 5), 1);
+    EXPECT_EQ(Test.Find("/bb", 5), 2);
+    EXPECT_EQ(Test.Find("/ccc", 5), 3);
+    EXPECT_EQ(Test.Find("/dd", 5), -1);
+
+    // High half different, low half the same, still the same tag
+    EXPECT_EQ(Test.Find("/aa", 5 | (7ull << 32)), 1);
+}
+
+TEST(UrlHashTable, EraseShiftsBackAcrossTheWrap)
+{
+    // Eight slots. Three urls at home in slot 6 run 6, 7, 0, then one from 7 and one from 0 get pushed on to 1 and 2
+    TestTable Test;
+    ASSERT_TRUE(Test.Insert("/six-a", 6, 1));
+    ASSERT_TRUE(Test.Insert("/six-b", 6, 2));
+    ASSERT_TRUE(Test.Insert("/six-c", 6, 3));
+    ASSERT_TRUE(Test.Insert("/seven", 7, 4));
+    ASSERT_TRUE(Test.Insert("/zero", 8, 5));      // 8 & 7, home's slot 0
+    ASSERT_EQ(Test.Table.GetNumSlots(), 8u);
+
+    // Erasing from the middle of the run pulls everything after it back over the end of the array
+    ASSERT_TRUE(Test.Erase("/six-b"));
+    EXPECT_EQ(Test.Find("/six-a", 6), 1);
+    EXPECT_EQ(Test.Find("/six-b", 6), -1);
+    EXPECT_EQ(Test.Find("/six-c", 6), 3);
+    EXPECT_EQ(Test.Find("/seven", 7), 4);
+    EXPECT_EQ(Test.Find("/zero", 8), 5);
+
+    // A url already in its home slot past the wrap stays put, the ones before it still move
+    ASSERT_TRUE(Test.Insert("/two", 2, 6));
+    ASSERT_TRUE(Test.Erase("/six-a"));
+    EXPECT_EQ(Test.Find("/six-c", 6), 3);
+    EXPECT_EQ(Test.Find("/seven", 7), 4);
+    EXPECT_EQ(Test.Find("/zero", 8), 5);
+    EXPECT_EQ(Test.Find("/two", 2), 6);
+
+    // Down to one, then none, from the far end of the run
+    ASSERT_TRUE(Test.Erase("/zero"));
+    ASSERT_TRUE(Test.Erase("/six-c"));
+    ASSERT_TRUE(Test.Erase("/two"));
+    EXPECT_EQ(Test.Find("/seven", 7), 4);
+    ASSERT_TRUE(Test.Erase("/seven"));
+    EXPECT_EQ(Test.Table.Size(), 0u);
+
+    int NumLeft = 0;
+    Test.Table.ForEach([&NumLeft] (const TestEntry&) { NumLeft++; });
+    EXPECT_EQ(NumLeft, 0);
+}
+
+TEST(UrlHashTable, LookupsAfterGrowing)
+{
+    // All wanting the last slot, so each size's run wraps round to the start until growing spreads them out
+    TestTable Test;
+    size_t LastNumSlots = 0;
+    int NumGrows = 0;
+    for(int i = 0; i < 200; i++)
+    {
+        const uint64_t Hash = ((uint64_t) i << 3) | 7;     // home 7 of 8, 7 or 15 of 16, and so on
+        ASSERT_TRUE(Test.Insert("/url/" + std::to_string(i), Hash, i));
+        if(Test.Table.GetNumSlots() != LastNumSlots)
+        {
+            LastNumSlots = Test.Table.GetNumSlots();
+            NumGrows++;
+        }
+        ASSERT_LE(Test.Table.Size() * 4, Test.Table.GetNumSlots() * 3);
+
+        // Everything put in so far, where the last grow moved it
+        for(int j = 0; j <= i; j++)
+        {
+            ASSERT_EQ(Test.Find("/url/" + std::to_string(j), ((uint64_t) j << 3) | 7), j) << "after " << i;
+        }
+    }
+    EXPECT_GE(NumGrows, 6);
+    EXPECT_EQ(Test.Table.Size(), 200u);
+
+    // And erasing after the grows leaves the rest where they can be found
+    for(int i = 0; i < 200; i += 3)
+    {
+        ASSERT_TRUE(Test.Erase("/url/" + std::to_string(i)));
+    }
+    for(int i = 0; i < 200; i++)
+    {
+        EXPECT_EQ(Test.Find("/url/" + std::to_string(i), ((uint64_t) i << 3) | 7), (i % 3 == 0) ? -1 : i);
+    }
+}
+
+TEST(UrlHashTable, MatchesAMap)
+{
+    // Few distinct hashes, so runs are long, wrap and overlap
+    std::mt19937 Random(1234);
+    TestTable Test;
+    std::map<std::string, int> Expected;
+    for(int Step = 0; Step < 20000; Step++)
+    {
+        const int Key = (int) (Random() % 300);
+        const std::string Url = "/k" + std::to_string(Key);
+        const uint64_t Hash = (uint64_t) (Key % 23) * 0x9E3779B9u;
+        if(Random() % 3 == 0)
+        {
+            EXPECT_EQ(Test.Erase(Url), Expected.erase(Url) == 1);
+        }
+        else
+        {
+            EXPECT_EQ(Test.Insert(Url, Hash, Step), Expected.count(Url) == 0);
+            Expected[Url] = Step;
+        }
+
+        if(Step % 100 == 0)
+        {
+            ASSERT_EQ(Test.Table.Size(), Expected.size());
+            for(int Other = 0; Other < 300; Other++)
+            {
+                const std::string OtherUrl = "/k" + std::to_string(Other);
+                const std::map<std::string, int>::const_iterator Found = Expected.find(OtherUrl);
+                ASSERT_EQ(Test.Find(OtherUrl, (uint64_t) (Other % 23) * 0x9E3779B9u), (Found != Expected.end()) ? Found->second : -1) << OtherUrl;
+            }
+        }
+    }
+}
+
+TEST(UrlHashTable, CopiesShareValuesButNotChanges)
+{
+    TestTable Test;
+    for(int i = 0; i < 20; i++)
+    {
+        ASSERT_TRUE(Test.Insert("/" + std::to_string(i), (uint64_t) i, i));
+    }
+    const TestEntry* Shared = Test.Table.Find("/3", 3);
+
+    UrlHashTable<TestEntry> Copy = Test.Table;
+    EXPECT_EQ(Copy.Find("/3", 3), Shared);
+    ASSERT_TRUE(Copy.Erase("/3", 3));
+    ASSERT_TRUE(Copy.Insert(std::make_shared<const TestEntry>(TestEntry{ "/new", 100 }), 100));
+
+    EXPECT_EQ(Test.Table.Find("/3", 3), Shared);
+    EXPECT_EQ(Test.Table.Find("/new", 100), nullptr);
+    EXPECT_EQ(Test.Table.Size(), 20u);
+    EXPECT_EQ(Copy.Size(), 20u);
+}
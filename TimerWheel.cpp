@@ -0,0 +1,229 @@
+#include "TimerWheel.h"
+
+namespace WebServer
+{
+    TimerWheel::TimerWheel(int TickMs)
+        : mStartTime(Clock::now()), mTickMs(TickMs > 0 ? TickMs : 1)
+    {
+        mSlotHeads.fill(NoTimer);
+    }
+
+    TimerHandle TimerWheel::AddTimer(std::function<void()> Callback)
+    {
+        uint32_t TimerIndex;
+        if(mFreeTimers.empty() == false)
+        {
+            TimerIndex = mFreeTimers.back();
+            mFreeTimers.pop_back();
+        }
+        else
+        {
+            TimerIndex = (uint32_t) mTimers.size();
+            mTimers.emplace_back();
+        }
+
+        Timer& NewTimer = mTimers[TimerIndex];
+        NewTimer.Callback = std::move(Callback);
+        NewTimer.bAllocated = true;
+        return TimerHandle{ TimerIndex, NewTimer.Generation };
+    }
+
+    void TimerWheel::RemoveTimer(TimerHandle& Handle)
+    {
+        Timer* RemovedTimer = GetTimer(Handle);
+        if(RemovedTimer != nullptr)
+        {
+            if(RemovedTimer->bArmed)
+            {
+                Unlink(Handle.Index);
+            }
+
+            RemovedTimer->Callback = nullptr;
+            RemovedTimer->bAllocated = false;
+            RemovedTimer->Generation++;
+            mFreeTimers.push_back(Handle.Index);
+        }
+        Handle = TimerHandle{};
+    }
+
+    void TimerWheel::Arm(TimerHandle Handle, int DelayMs, int PeriodMs)
+    {
+        Timer* ArmedTimer = GetTimer(Handle);
+        if(ArmedTimer == nullptr)
+        {
+            return;
+        }
+
+        if(ArmedTimer->bArmed)
+        {
+            Unlink(Handle.Index);
+        }
+
+        // Round up so a timer never fires early, and at least one tick out so it can't land in the slot being fired
+        uint64_t DelayTicks = (DelayMs > 0) ? ((uint64_t) DelayMs + mTickMs - 1) / mTickMs : 1;
+        ArmedTimer->ExpiryTick = mCurrentTick + (DelayTicks > 0 ? DelayTicks : 1);
+        ArmedTimer->PeriodMs = PeriodMs;
+        Link(Handle.Index);
+    }
+
+    void TimerWheel::Cancel(TimerHandle Handle)
+    {
+        Timer* CancelledTimer = GetTimer(Handle);
+        if(CancelledTimer == nullptr)
+        {
+            return;
+        }
+
+        if(CancelledTimer->bArmed)
+        {
+            Unlink(Handle.Index);
+        }
+        CancelledTimer->PeriodMs = 0;
+    }
+
+    bool TimerWheel::IsArmed(TimerHandle Handle) const
+    {
+        const Timer* ArmedTimer = GetTimer(Handle);
+        return ArmedTimer != nullptr && ArmedTimer->bArmed;
+    }
+
+    int TimerWheel::Advance(Clock::time_point Now)
+    {
+        uint64_t TargetTick = (uint64_t) std::chrono::duration_cast<std::chrono::milliseconds>(Now - mStartTime).count() / mTickMs;
+
+        int NumFired = 0;
+        while(mCurrentTick < TargetTick)
+        {
+            // Nothing left to fire, skip straight to the target
+            if(mNumArmed == 0)
+            {
+                mCurrentTick = TargetTick;
+                break;
+            }
+
+            mCurrentTick++;
+
+            // Each time a level wraps, the next level's slot for this tick moves down
+            for(int Level = 1; Level < NumLevels; Level++)
+            {
+                if((mCurrentTick & ((1ull << (LevelBits * Level)) - 1)) != 0)
+                {
+                    break;
+                }
+                Cascade(Level);
+            }
+
+            NumFired += FireSlot((uint32_t) (mCurrentTick & (SlotsPerLevel - 1)));
+        }
+        return NumFired;
+    }
+
+    TimerWheel::Timer* TimerWheel::GetTimer(TimerHandle Handle)
+    {
+        bool bValid = Handle.Index < mTimers.size() && mTimers[Handle.Index].bAllocated && mTimers[Handle.Index].Generation == Handle.Generation;
+        return bValid ? &mTimers[Handle.Index] : nullptr;
+    }
+
+    const TimerWheel::Timer* TimerWheel::GetTimer(TimerHandle Handle) const
+    {
+        bool bValid = Handle.Index < mTimers.size() && mTimers[Handle.Index].bAllocated && mTimers[Handle.Index].Generation == Handle.Generation;
+        return bValid ? &mTimers[Handle.Index] : nullptr;
+    }
+
+    void TimerWheel::Link(uint32_t TimerIndex)
+    {
+        Timer& LinkedTimer = mTimers[TimerIndex];
+
+        // Timers further out than the top level can reach wait in its furthest slot and cascade from there
+        constexpr uint64_t MaxDelta = (1ull << (LevelBits * NumLevels)) - 1;
+        uint64_t Delta = LinkedTimer.ExpiryTick - mCurrentTick;
+        uint64_t SlotTick = (Delta > MaxDelta) ? mCurrentTick + MaxDelta : LinkedTimer.ExpiryTick;
+
+        int Level = 0;
+        while(Level < NumLevels - 1 && Delta >= (1ull << (LevelBits * (Level + 1))))
+        {
+            Level++;
+        }
+
+        uint32_t SlotIndex = (uint32_t) ((SlotTick >> (LevelBits * Level)) & (SlotsPerLevel - 1));
+        LinkedTimer.Slot = (uint16_t) (Level * SlotsPerLevel + SlotIndex);
+
+        LinkedTimer.Prev = NoTimer;
+        LinkedTimer.Next = mSlotHeads[LinkedTimer.Slot];
+        if(LinkedTimer.Next != NoTimer)
+        {
+            mTimers[LinkedTimer.Next].Prev = TimerIndex;
+        }
+        mSlotHeads[LinkedTimer.Slot] = TimerIndex;
+
+        LinkedTimer.bArmed = true;
+        mNumArmed++;
+    }
+
+    void TimerWheel::Unlink(uint32_t TimerIndex)
+    {
+        Timer& UnlinkedTimer = mTimers[TimerIndex];
+
+        if(UnlinkedTimer.Prev != NoTimer)
+        {
+            mTimers[UnlinkedTimer.Prev].Next = UnlinkedTimer.Next;
+        }
+        else
+        {
+            mSlotHeads[UnlinkedTimer.Slot] = UnlinkedTimer.Next;
+        }
+
+        if(UnlinkedTimer.Next != NoTimer)
+        {
+            mTimers[UnlinkedTimer.Next].Prev = UnlinkedTimer.Prev;
+        }
+
+        UnlinkedTimer.Prev = NoTimer;
+        UnlinkedTimer.Next = NoTimer;
+        UnlinkedTimer.bArmed = false;
+        mNumArmed--;
+    }
+
+    void TimerWheel::Cascade(int Level)
+    {
+        uint32_t Slot = Level * SlotsPerLevel + (uint32_t) ((mCurrentTick >> (LevelBits * Level)) & (SlotsPerLevel - 1));
+
+        while(mSlotHeads[Slot] != NoTimer)
+        {
+            uint32_t TimerIndex = mSlotHeads[Slot];
+            Unlink(TimerIndex);
+            Link(TimerIndex);
+        }
+    }
+
+    int TimerWheel::FireSlot(uint32_t Slot)
+    {
+        int NumFired = 0;
+
+        // Pop one at a time, a callback is free to cancel or re-arm timers still in this slot
+        while(mSlotHeads[Slot] != NoTimer)
+        {
+            uint32_t TimerIndex = mSlotHeads[Slot];
+            Unlink(TimerIndex);
+
+            // Callbacks can add timers and grow the pool, so call a moved out copy rather than the one in the pool
+            uint32_t Generation = mTimers[TimerIndex].Generation;
+            std::function<void()> Callback = std::move(mTimers[TimerIndex].Callback);
+            Callback();
+            NumFired++;
+
+            Timer& FiredTimer = mTimers[TimerIndex];
+            if(FiredTimer.bAllocated && FiredTimer.Generation == Generation)
+            {
+                FiredTimer.Callback = std::move(Callback);
+
+                // Repeat unless the callback re-armed or cancelled it
+                if(FiredTimer.bArmed == false && FiredTimer.PeriodMs > 0)
+                {
+                    Arm(TimerHandle{ TimerIndex, Generation }, FiredTimer.PeriodMs, FiredTimer.PeriodMs);
+                }
+            }
+        }
+        return NumFired;
+    }
+}
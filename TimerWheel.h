@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace WebServer
+{
+    struct TimerHandle
+    {
+        uint32_t Index = UINT32_MAX;
+        uint32_t Generation = 0;
+
+        bool IsValid() const { return Index != UINT32_MAX; }
+    };
+
+    // Hierarchical timer wheel on the steady clock. Four levels of 64 slots, each level's slot spanning a whole
+    // revolution of the level below, timers sit in an intrusive list per slot and cascade down as their time nears.
+    // Arm, re-arm and cancel are O(1), Advance only touches the slots for the ticks that have passed.
+    // Timers are owned by the caller: AddTimer once, Arm/Cancel as often as needed, RemoveTimer when done with it.
+    // A callback may arm, cancel or remove any timer, including its own.
+    class TimerWheel
+    {
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        TimerWheel(int TickMs = 10);
+        TimerWheel(const TimerWheel& Other) = delete;
+        TimerWheel& operator=(const TimerWheel& Other) = delete;
+
+        TimerHandle AddTimer(std::function<void()> Callback);
+        void RemoveTimer(TimerHandle& Handle);
+
+        // Arms the timer to fire DelayMs from the wheel's current tick, then every PeriodMs if given.
+        // Re-arming moves an already armed timer, cancelling also stops it repeating
+        void Arm(TimerHandle Handle, int DelayMs, int PeriodMs = 0);
+        void Cancel(TimerHandle Handle);
+        bool IsArmed(TimerHandle Handle) const;
+
+        // Fires every timer due by Now, returns the number fired
+        int Advance(Clock::time_point Now);
+
+        size_t NumArmed() const { return mNumArmed; }
+
+    private:
+        static constexpr int LevelBits = 6;
+        static constexpr int SlotsPerLevel = 1 << LevelBits;
+        static constexpr int NumLevels = 4;
+        static constexpr uint32_t NoTimer = UINT32_MAX;
+
+        struct Timer
+        {
+            std::function<void()> Callback;
+            uint64_t ExpiryTick = 0;
+            int PeriodMs = 0;
+            uint32_t Prev = NoTimer;
+            uint32_t Next = NoTimer;
+            uint32_t Generation = 0;
+            uint16_t Slot = 0;
+            bool bArmed = false;
+            bool bAllocated = false;
+        };
+
+        Timer* GetTimer(TimerHandle Handle);
+        const Timer* GetTimer(TimerHandle Handle) const;
+
+        void Link(uint32_t TimerIndex);
+        void Unlink(uint32_t TimerIndex);
+        void Cascade(int Level);
+        int FireSlot(uint32_t Slot);
+
+        const Clock::time_point mStartTime;
+        const int mTickMs;
+        uint64_t mCurrentTick = 0;
+        size_t mNumArmed = 0;
+
+        std::array<uint32_t, SlotsPerLevel * NumLevels> mSlotHeads;
+        std::vector<Timer> mTimers;
+        std::vector<uint32_t> mFreeTimers;
+    };
+}
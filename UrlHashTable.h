@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace WebServer
+{
+    // Url to value, open addressing with linear probing over one flat array of 16 byte slots (four to a cache line).
+    // A slot holds the low half of the url's hash, its length and a pointer to the value, so a probe only leaves the
+    // array to compare the url of a slot whose hash and length both match. Hashes come from the caller, a request's is
+    // worked out once while it's parsed (ServerRequestMessage::mUrlHash). T has a std::string Url.
+    // Copies share the values, the table's cheap to copy for a copy-on-write update
+    template<typename T>
+    class UrlHashTable
+    {
+    public:
+        const T* Find(std::string_view Url, uint64_t UrlHash) const
+        {
+            if(mSlots.empty())
+            {
+                return nullptr;
+            }
+
+            const uint32_t Tag = (uint32_t) UrlHash;
+            for(size_t Index = Tag & mSlotMask;; Index = (Index + 1) & mSlotMask)
+            {
+                const UrlTableSlot& Slot = mSlots[Index];
+                if(Slot.Value == nullptr)
+                {
+                    return nullptr;
+                }
+                if(Slot.HashTag == Tag && Slot.UrlLength == Url.size() && Slot.Value->Url == Url)
+                {
+                    return Slot.Value;
+                }
+            }
+        }
+
+        // Replaces whatever's on the value's url, true if it wasn't there before
+        bool Insert(std::shared_ptr<const T> Value, uint64_t UrlHash)
+        {
+            if((mNumValues + 1) * 4 > mSlots.size() * 3)
+            {
+                Grow();
+            }
+
+            const size_t Index = FindSlot(Value->Url, (uint32_t) UrlHash);
+            const bool bAdded = mSlots[Index].Value == nullptr;
+            mSlots[Index] = UrlTableSlot{ (uint32_t) UrlHash, (uint32_t) Value->Url.size(), Value.get() };
+            mValues[Index] = std::move(Value);
+            mNumValues += bAdded ? 1 : 0;
+            return bAdded;
+        }
+
+        // False if there was nothing on Url
+        bool Erase(std::string_view Url, uint64_t UrlHash)
+        {
+            if(mSlots.empty())
+            {
+                return false;
+            }
+
+            size_t Hole = FindSlot(Url, (uint32_t) UrlHash);
+            if(mSlots[Hole].Value == nullptr)
+            {
+                return false;
+            }
+
+            // Shift back anything further along the run that the hole now cuts off from its home slot
+            for(size_t Index = (Hole + 1) & mSlotMask; mSlots[Index].Value != nullptr; Index = (Index + 1) & mSlotMask)
+            {
+                const size_t Home = mSlots[Index].HashTag & mSlotMask;
+                if(((Index - Home) & mSlotMask) >= ((Index - Hole) & mSlotMask))
+                {
+                    mSlots[Hole] = mSlots[Index];
+                    mValues[Hole] = std::move(mValues[Index]);
+                    Hole = Index;
+                }
+            }
+            mSlots[Hole] = UrlTableSlot{};
+            mValues[Hole].reset();
+            mNumValues--;
+            return true;
+        }
+
+        template<typename FuncType>
+        void ForEach(const FuncType& Func) const
+        {
+            for(const UrlTableSlot& Slot : mSlots)
+            {
+                if(Slot.Value != nullptr)
+                {
+                    Func(*Slot.Value);
+                }
+            }
+        }
+
+        size_t Size() const { return mNumValues; }
+        size_t GetNumSlots() const { return mSlots.size(); }
+
+    private:
+        struct UrlTableSlot
+        {
+            uint32_t HashTag = 0;       // the low half of the hash, which also gives the home slot
+            uint32_t UrlLength = 0;
+            const T* Value = nullptr;   // null for an empty slot
+        };
+
+        // Where Url is or where it would go
+        size_t FindSlot(std::string_view Url, uint32_t Tag) const
+        {
+            size_t Index = Tag & mSlotMask;
+            for(; mSlots[Index].Value != nullptr; Index = (Index + 1) & mSlotMask)
+            {
+                if(mSlots[Index].HashTag == Tag && mSlots[Index].UrlLength == Url.size() && mSlots[Index].Value->Url == Url)
+                {
+                    break;
+                }
+            }
+            return Index;
+        }
+
+        // Slots know their home from their tag, nothing's hashed again
+        void Grow()
+        {
+            std::vector<UrlTableSlot> OldSlots = std::move(mSlots);
+            std::vector<std::shared_ptr<const T>> OldValues = std::move(mValues);
+
+            const size_t NumSlots = OldSlots.empty() ? 8 : OldSlots.size() * 2;
+            mSlots.assign(NumSlots, UrlTableSlot{});
+            mValues.assign(NumSlots, nullptr);
+            mSlotMask = NumSlots - 1;
+            for(size_t i = 0; i < OldSlots.size(); i++)
+            {
+                if(OldSlots[i].Value == nullptr)
+                {
+                    continue;
+                }
+                size_t Index = OldSlots[i].HashTag & mSlotMask;
+                while(mSlots[Index].Value != nullptr)
+                {
+                    Index = (Index + 1) & mSlotMask;
+                }
+                mSlots[Index] = OldSlots[i];
+                mValues[Index] = std::move(OldValues[i]);
+            }
+        }
+
+        std::vector<UrlTableSlot> mSlots;
+        std::vector<std::shared_ptr<const T>> mValues;     // owners, slot for slot, kept off the probed array
+        size_t mSlotMask = 0;
+        size_t mNumValues = 0;
+    };
+}
@@ -6,12 +6,20 @@
 #include <memory>
 #include <cassert>
 #include <bitset>
+#include <algorithm>
+#include <climits>
 
 //helpers
 namespace 
 {
     using namespace WebServer;
     constexpr int SecondsToMs = 1000;
+    constexpr int ServerPollTimeoutMs = 50;
+    constexpr int ReceiveTimeoutMs = 5 * SecondsToMs;
+    constexpr int MinReceiveReadSize = 4 * 1024;
+    constexpr int MaxReceiveReadSize = SocketChunkPool::ChunkSize;
+    constexpr int SendTimeoutMs = 30 * SecondsToMs;      // a client that takes nothing for this long is dropped
+    constexpr int WebSocketTimeoutMs = 600 * SecondsToMs;
 
     enum class StatusLogSeverity : uint16_t
     {
@@ -37,7 +45,7 @@ namespace
     {
         addrinfo AddressInfo;
 
-        ZeroMemory(&AddressInfo, sizeof(AddressInfo));
+        memset(&AddressInfo, 0, sizeof(AddressInfo));
         AddressInfo.ai_family = AF_INET;
         AddressInfo.ai_socktype = SOCK_STREAM;
         AddressInfo.ai_protocol = Protocol;
@@ -46,7 +54,7 @@ namespace
         return AddressInfo;
     }
 
-    int SetupNonBlockingSocket(const char* PortNumber, SOCKET& OutSocket)
+    int SetupNonBlockingSocket(const char* PortNumber, SOCKET& OutSocket, bool bReusePort)
     {
         // Resolve the local address and port to be used by the server
         addrinfo AddressInfoHints = BuildAddressInfoHints(IPPROTO_TCP);
@@ -62,15 +70,26 @@ namespace
         OutSocket = socket(AddressInfo->ai_family, AddressInfo->ai_socktype, AddressInfo->ai_protocol);
         if(OutSocket == INVALID_SOCKET)
         {
-            printf("Error at socket(): %ld\n", WSAGetLastError());
+            printf("Error at socket(): %d\n", GetSocketError());
             return 1;
         }
 
-        u_long NonBlockingMode = 1;
-        int Result_SocketMode = ioctlsocket(OutSocket, FIONBIO, &NonBlockingMode);
-        if(Result_SocketMode != NO_ERROR)
+        if(SetSocketNonBlocking(OutSocket) == false)
         {
-            printf("Socket mode change failed: %d\n", WSAGetLastError());
+            printf("Socket mode change failed: %d\n", GetSocketError());
+            return 1;
+        }
+
+        if(SetSocketReuseAddress(OutSocket) == false)
+        {
+            printf("Socket reuse address failed: %d\n", GetSocketError());
+            return 1;
+        }
+
+        // Lets every worker bind its own socket to the port, the kernel spreads connections between them
+        if(bReusePort && SetSocketReusePort(OutSocket) == false)
+        {
+            printf("Socket reuse port failed: %d\n", GetSocketError());
             return 1;
         }
 
@@ -78,7 +97,7 @@ namespace
         int Result_Bind = bind(OutSocket, AddressInfo->ai_addr, (int) AddressInfo->ai_addrlen);
         if(Result_Bind == SOCKET_ERROR)
         {
-            printf("bind failed with error: %d\n", WSAGetLastError());
+            printf("bind failed with error: %d\n", GetSocketError());
             return 1;
         }
 
@@ -91,16 +110,15 @@ namespace
         //TODO: Add functionality to upload custom status responses from dll API
 
         ServerResponseMessage StatusResponseMessage(StatusCode);
-        StatusResponseMessage.AddMessageHeaders({ std::make_pair("Connection", "Close") });
 
         std::vector<char> PageHtml = GenerateHtmlPage(ServerResponseStatusStrings.at(StatusCode));
-        StatusResponseMessage.AddContent(PageHtml, "text/html; charset=utf-8");
+        StatusResponseMessage.AddContent(std::move(PageHtml), "text/html; charset=utf-8");
         StatusResponseMessage.BuildMessage();
 
         return StatusResponseMessage;
     }
 
-    void PopulateStatusMessageResponses(std::map<std::string, ServerResponseMessage>& UrlData)
+    void PopulateStatusMessageResponses(ServerUrlDataMap& UrlData)
     {
         for(const auto& StatusResponsePair : ServerResponseStatusStrings)
         {
@@ -112,189 +130,427 @@ namespace
         WebSocketSucessBaseMessage.AddMessageHeaders({std::make_pair("Connection", "Upgrade")});
         WebSocketSucessBaseMessage.AddMessageHeaders({ std::make_pair("Upgrade", "websocket") });
         UrlData.emplace("websocket-success-base", std::move(WebSocketSucessBaseMessage));
+
+        // Interim response to "Expect: 100-continue", the client holds its body back until it's sent (1xx can't have a body)
+        UrlData.emplace("100-continue", ServerResponseMessage(ServerResponseStatusCode::ServerResponseStatusCode_100));
+    }
+
+    // Sent before it returns, so whether the data outlives the call doesn't matter
+    bool DirectSendData(SOCKET ClientSocket, const char* Data, int DataLen, bool)
+    {
+        return SendSocketData(ClientSocket, Data, DataLen) != SOCKET_ERROR;
     }
 
-    bool SendServerResponseMessage(SOCKET ClientSocket, const ServerResponseMessage& MessageData)
+    bool SendServerResponseMessage(SOCKET ClientSocket, const ServerResponseMessage& MessageData, const SocketSendDataFunc& SendData,
+        ConnectionPersistence Persistence = ConnectionPersistence::ConnectionPersistence_KeepAlive, bool bPersistentMessage = true)
     {
-        int SendResult = send(ClientSocket, MessageData.mMessage, MessageData.mMessageLength, 0);
-        if(SendResult == SOCKET_ERROR)
+        // Headers and body go out as separate buffers, the queued send gathers them into one writev instead of joining them in memory
+        const std::string& HeaderBlock = MessageData.GetHeaderBlock(Persistence);
+        bool bSent = SendData(ClientSocket, HeaderBlock.data(), (int) HeaderBlock.size(), bPersistentMessage);
+        if(bSent && MessageData.GetContentLength() > 0)
+        {
+            bSent = SendData(ClientSocket, MessageData.GetContentData(), MessageData.GetContentLength(), bPersistentMessage);
+        }
+
+        if(bSent == false)
         {
             StatusLogPost("Send message failed", StatusLogSeverity::StatusLogSeverity_Error);
             return false;
         }
 
-        std::cout << "Reply-Send - Success - Bytes sent: " << SendResult;
+        std::cout << "Reply-Send - Success - Bytes sent: " << HeaderBlock.size() + MessageData.GetContentLength();
         return true;
     }
 
-    void SendServerStatusResponse(SOCKET ClientSocket, std::string LogMessage, ServerResponseStatusCode StatusCode, const std::map<std::string, ServerResponseMessage>& UrlData)
+    void SendServerStatusResponse(SOCKET ClientSocket, std::string LogMessage, ServerResponseStatusCode StatusCode, const ServerUrlDataMap& UrlData, const SocketSendDataFunc& SendData,
+        ConnectionPersistence Persistence = ConnectionPersistence::ConnectionPersistence_Close)
     {
         StatusLogPost(LogMessage, StatusLogSeverity::StatusLogSeverity_Error);
 
-        const std::string& StatusResponseUrl = ServerResponseStatusStrings.at(StatusCode);
-        const ServerResponseMessage& StatusResponseMessage = UrlData.at(StatusResponseUrl);
-        SendServerResponseMessage(ClientSocket, StatusResponseMessage);
+        const ServerResponseMessage& StatusResponseMessage = UrlData.at(ServerResponseStatusStrings.at(StatusCode));
+        SendServerResponseMessage(ClientSocket, StatusResponseMessage, SendData, Persistence);
     }
 
-    void ReceiveMessageTick(SOCKET ClientSocket, std::function<void(SocketDataStream&&)> MessageRecievedCallback, std::function<void()> ErrorCallback)
+    // The client's waiting to hear the body's wanted before sending it
+    void SendContinueIfExpected(SOCKET ClientSocket, const ServerRequestMessage& RequestMessage, const ServerUrlDataMap& UrlData, const SocketSendDataFunc& SendData)
     {
-        char Receivebuffer[DEFAULT_BUFLEN]; SocketDataStream wsDataStream{};    //TODO: take these as parameters to save allocs
+        std::string_view ExpectValue;
+        if(RequestMessage.HasBody() && RequestMessage.mHeaders.Find(HttpHeader::HttpHeader_Expect, ExpectValue) && EqualsIgnoreCase(ExpectValue, "100-continue"))
+        {
+            SendServerResponseMessage(ClientSocket, UrlData.find("100-continue")->second, SendData);
+        }
+    }
 
-        int ReceiveResult = recv(ClientSocket, Receivebuffer, DEFAULT_BUFLEN, 0);
-        if(ReceiveResult > 0)
+    // The connection's buffers will have moved on by the time a handler gets to the request, it gets a copy of its own
+    void CopyHandlerRequest(const ServerRequestMessage& RequestMessage, HandlerRequest& OutRequest)
+    {
+        OutRequest.Method = RequestMessage.mRequestType;
+        OutRequest.Url = RequestMessage.mUrl;
+        OutRequest.Query = RequestMessage.mQuery;
+        OutRequest.Headers.reserve(RequestMessage.mHeaders.GetNum());
+        RequestMessage.mHeaders.ForEach([&OutRequest] (std::string_view Key, std::string_view Value) { OutRequest.Headers.emplace_back(Key, Value); });
+        for(int i = 0; i < RequestMessage.mRouteParams.NumParams; i++)
         {
-            wsDataStream.StreamRequestData(Receivebuffer, ReceiveResult);
-            MessageRecievedCallback(std::move(wsDataStream));
+            OutRequest.Params.emplace_back(RequestMessage.mRouteParams.Params[i].Name, RequestMessage.mRouteParams.Params[i].Value);
         }
-        else if(WSAGetLastError() != WSAEWOULDBLOCK)
+    }
+
+    // Handlers needn't bother with a length for an empty response or building the message
+    void FinishHandlerResponse(ServerResponseMessage& Response)
+    {
+        if(Response.mHeaders.Find(HttpHeader::HttpHeader_ContentLength) == nullptr)
         {
-            ErrorCallback();
-        }     
+            Response.mHeaders.Add("Content-Length", "0");
+        }
+        Response.BuildMessage();
     }
 
-    void ReceieveMessageLoop(SOCKET ClientSocket, std::atomic<bool>* LoopCondition, const std::vector<TimedFunctionPair>& TimedFunctions,
-        std::function<void(SocketDataStream&&)> MessageRecievedCallback, std::function<void()> ErrorCallback, TimedFunctionPair TimeOutCallBack)
+    // From a catch block, whatever a handler threw
+    void LogHandlerException()
     {
-        auto ServerTime = std::chrono::system_clock::now();
+        try
+        {
+            throw;
+        }
+        catch(const std::exception& Exception)
+        {
+            StatusLogPost(std::string("Handler - Threw: ") + Exception.what(), StatusLogSeverity::StatusLogSeverity_Error);
+        }
+        catch(...)
+        {
+            StatusLogPost("Handler - Threw", StatusLogSeverity::StatusLogSeverity_Error);
+        }
+    }
 
-        auto RecievedDataCallback = [&] (SocketDataStream&& DataReceived) {TimeOutCallBack.first.ResetClock(ServerTime); MessageRecievedCallback(std::move(DataReceived)); };
-        auto ReceiveErrorCallBack = [&] () {*LoopCondition = false; ErrorCallback(); };
+    // Returns false once the socket has no more data to give (would block or errored)
+    bool ReceiveMessageTick(SOCKET ClientSocket, SocketDataStream& ReceiveStream, int& ReadSize, const std::function<void(int)>& MessageRecievedCallback,
+        const std::function<void()>& ErrorCallback)
+    {
+        // recv writes straight onto the end of the connection's stream, no staging buffer and chunks come from the pool
+        int ReadLength = ReadSize;
+        char* ReadData = ReceiveStream.PrepareWrite(ReadLength);
 
-        while(*LoopCondition == true)
+        int ReceiveResult = recv(ClientSocket, ReadData, ReadLength, 0);
+        if(ReceiveResult > 0)
         {
-            ServerTime = std::chrono::system_clock::now();
+            ReceiveStream.CommitWrite(ReceiveResult);
 
-            for(const auto& TimedFunctionPair : TimedFunctions)
+            // A read that fills the space probably has more behind it, ask for more next time and less once it's quiet
+            if(ReceiveResult == ReadLength)
             {
-                if(TimedFunctionPair.first.DurationReached(ServerTime))
-                {
-                    TimedFunctionPair.second();
-                }
+                ReadSize = std::min(ReadSize * 2, MaxReceiveReadSize);
             }
-
-            ReceiveMessageTick(ClientSocket, RecievedDataCallback, ReceiveErrorCallBack);
-
-            if(TimeOutCallBack.first.DurationReached(ServerTime) && *LoopCondition == true)
+            else if(ReceiveResult < ReadSize / 4)
             {
-                TimeOutCallBack.second();
-                *LoopCondition = false;
+                ReadSize = std::max(ReadSize / 2, MinReceiveReadSize);
             }
+
+            MessageRecievedCallback(ReceiveResult);
+            return true;
+        }
+        else if(ReceiveResult == 0 || IsSocketWouldBlockError(GetSocketError()) == false)
+        {
+            ErrorCallback();
         }
+        return false;
     }
 
-    void HandleSocketDataReceiveTick(SOCKET ClientSocket, const ReceiveDataTickInfo& ReceiveTickInfo)
+    void ReceieveMessageLoop(SOCKET ClientSocket, std::atomic<bool>* LoopCondition, TimerWheel& Timers,
+        std::function<void(const SocketDataStream&)> MessageRecievedCallback, std::function<void()> ErrorCallback)
     {
-        auto ServerTime = std::chrono::system_clock::now();
+        auto ReceiveErrorCallBack = [&] () {*LoopCondition = false; ErrorCallback(); };
 
-        ReceiveMessageTick(ClientSocket, ReceiveTickInfo.MessageRecievedCallback, ReceiveTickInfo.ErrorCallback);
+        // Each read is handed over on its own, the stream's buffer is reused for the next
+        SocketDataStream ReceiveStream;
+        int ReadSize = MinReceiveReadSize;
+        auto ReceivedCallBack = [&] (int) { MessageRecievedCallback(ReceiveStream); ReceiveStream.Reset(); };
 
-        for(const auto& TimedFunctionPair : ReceiveTickInfo.TimedFunctions)
+        while(*LoopCondition == true)
         {
-            if(TimedFunctionPair.first.DurationReached(ServerTime))
-            {
-                TimedFunctionPair.second();
-            }
-        }
+            Timers.Advance(TimerWheel::Clock::now());
 
-        if(ReceiveTickInfo.ReceiveTimeout.first.DurationReached(ServerTime))
-        {
-            ReceiveTickInfo.ReceiveTimeout.second();
+            ReceiveMessageTick(ClientSocket, ReceiveStream, ReadSize, ReceivedCallBack, ReceiveErrorCallBack);
         }
     }
 
-    void BuildReceiveTickInfo(ReceiveDataTickInfo& ReceiveDataTickInfo, SOCKET ClientSocket, std::function<void(SOCKET, ServerRequestMessage&)> OnReceivedServerRequest, std::function<void(SOCKET, bool)> OnReceiveFinished, const std::map<std::string, ServerResponseMessage>& UrlData)
+    void HandleSocketDataReceive(SOCKET ClientSocket, ReceiveDataTickInfo& ReceiveTickInfo)
     {
-        auto ServerTime = std::chrono::system_clock::now();
+        // Edge triggered, keep reading until the socket runs dry or we won't get told again (or the send side backs up)
+        while(ReceiveTickInfo.bReceivePaused == false
+            && ReceiveMessageTick(ClientSocket, ReceiveTickInfo.ReceiveDataStream, ReceiveTickInfo.ReadSize, ReceiveTickInfo.MessageRecievedCallback, ReceiveTickInfo.ErrorCallback)) {}
+    }
 
-        std::function<void()> ReceiveTimeoutCallBack = [=] () {
-            SendServerStatusResponse(ClientSocket, "recv - Timed out", ServerResponseStatusCode::ServerResponseStatusCode_408, UrlData);
+    void BuildReceiveTickInfo(ReceiveDataTickInfo& ReceiveDataTickInfo, SOCKET ClientSocket, std::function<RequestConnectionAction(SOCKET, ServerRequestMessage&, ConnectionPersistence)> OnReceivedServerRequest,
+        std::function<void(SOCKET, bool)> OnReceiveFinished, const ServerUrlDataMap& UrlData, const SocketSendDataFunc& SendData, TimerWheel& Timers,
+        const ListenServerConfig& Config)
+    {
+        // UrlData and SendData belong to the server, capture by reference rather than copying them into every connection
+        std::function<void()> ReceiveTimeoutCallBack = [=, &ReceiveDataTickInfo, &UrlData, &SendData] () {
+            // An idle keep-alive connection just closes, a request that stalled part way gets told why
+            if(ReceiveDataTickInfo.ReceiveDataStream.GetDataLen() > 0 || ReceiveDataTickInfo.NumRequestsServed == 0 || ReceiveDataTickInfo.bReadingBody)
+            {
+                SendServerStatusResponse(ClientSocket, "recv - Timed out", ServerResponseStatusCode::ServerResponseStatusCode_408, UrlData, SendData);
+            }
             OnReceiveFinished(ClientSocket, false);
             };
 
-        std::function<void()> ReceiveErrorCallBack = [=] () {
-            SendServerStatusResponse(ClientSocket, "recv - failed", ServerResponseStatusCode::ServerResponseStatusCode_500, UrlData);
+        std::function<void()> ReceiveErrorCallBack = [=, &UrlData, &SendData] () {
+            SendServerStatusResponse(ClientSocket, "recv - failed", ServerResponseStatusCode::ServerResponseStatusCode_500, UrlData, SendData);
             OnReceiveFinished(ClientSocket, false);
             };
 
-        ReceiveDataTickInfo.ReceiveTimeout = { MilliSecStopwatch{ ServerTime, 5 * SecondsToMs }, ReceiveTimeoutCallBack };
-        ReceiveDataTickInfo.TimedFunctions.push_back(std::make_pair(MilliSecStopwatch{ ServerTime, 250 }, std::bind(StatusLogPost, "recv - Awaiting data", StatusLogSeverity::StatusLogSeverity_Log)));
+        ReceiveDataTickInfo.ReceiveTimeoutTimer = Timers.AddTimer(ReceiveTimeoutCallBack);
+        Timers.Arm(ReceiveDataTickInfo.ReceiveTimeoutTimer, ReceiveTimeoutMs);
+
+        ReceiveDataTickInfo.AwaitingDataTimer = Timers.AddTimer(std::bind(StatusLogPost, "recv - Awaiting data", StatusLogSeverity::StatusLogSeverity_Log));
+        Timers.Arm(ReceiveDataTickInfo.AwaitingDataTimer, 250, 250);
         ReceiveDataTickInfo.ErrorCallback = ReceiveErrorCallBack;
 
-        const auto MessageRecievedCallback = [&, ClientSocket, OnReceivedServerRequest, OnReceiveFinished] (SocketDataStream&& DataStream)
+        // The new bytes have already been appended to ReceiveDataStream by the time this is called
+        const auto MessageRecievedCallback = [&, ClientSocket, OnReceivedServerRequest, OnReceiveFinished] (int BytesReceived)
             {
-                ServerTime = std::chrono::system_clock::now();
-                std::cout << OutputServerTime(ServerTime) << "recv - Bytes received: " << DataStream.GetDataLen() << "\n";
+                auto ServerTime = std::chrono::system_clock::now();
+                std::cout << OutputServerTime(ServerTime) << "recv - Bytes received: " << BytesReceived << "\n";
+
+                // Anything arriving after the connection's been finished with is dropped
+                if(ReceiveDataTickInfo.bReceiveFinished)
+                {
+                    return;
+                }
 
-                ReceiveDataTickInfo.ReceiveDataStream.StreamRequestData(DataStream.mData, DataStream.GetDataLen());
+                // First bytes of a new request on a persistent connection, it now has the receive timeout to arrive in full
+                SocketDataStream& RequestStream = ReceiveDataTickInfo.ReceiveDataStream;
+                if(BytesReceived > 0 && RequestStream.GetDataLen() == BytesReceived && ReceiveDataTickInfo.NumRequestsServed > 0)
+                {
+                    Timers.Arm(ReceiveDataTickInfo.ReceiveTimeoutTimer, ReceiveTimeoutMs);
+                }
 
-                ServerRequestMessage RequestMessage;
-                RequestMessage.BuildFromDataStream(ReceiveDataTickInfo.ReceiveDataStream);
-                if(RequestMessage.bIsMessageComplete)
+                // Pipelined requests can share a segment, answer every complete one in order
+                int NumRequestsAnswered = 0;
+                bool bBodyProgressed = false;
+                RequestBodyDecoder& BodyDecoder = ReceiveDataTickInfo.BodyDecoder;
+                while(ReceiveDataTickInfo.bReceiveFinished == false && ReceiveDataTickInfo.bReceivePaused == false
+                    && (RequestStream.GetDataLen() > 0 || (ReceiveDataTickInfo.bReadingBody && BodyDecoder.IsFinished())))
                 {
+                    if(ReceiveDataTickInfo.bReadingBody)
+                    {
+                        // Decoded a chunk of the stream at a time and dropped straight after, the body's never buffered whole.
+                        // Whatever it's going to can pause receive until it's caught up
+                        while(BodyDecoder.IsFinished() == false && RequestStream.GetDataLen() > 0 && ReceiveDataTickInfo.bReceivePaused == false)
+                        {
+                            const char* BodyData = nullptr;
+                            int BodyDataLen = RequestStream.GetFrontData(BodyData);
+                            RequestStream.Consume(BodyDecoder.Decode(BodyData, BodyDataLen, ReceiveDataTickInfo.BodyDataCallback));
+                        }
+                        bBodyProgressed = true;
+                        if(BodyDecoder.IsFinished() == false)
+                        {
+                            break;
+                        }
+
+                        const bool bBodyMalformed = BodyDecoder.GetState() == RequestBodyState::RequestBodyState_Malformed;
+                        RequestConnectionAction ConnectionAction = bBodyMalformed ? RequestConnectionAction::RequestConnectionAction_Close : RequestConnectionAction::RequestConnectionAction_KeepAlive;
+                        if(ReceiveDataTickInfo.BodyFinishedCallback)
+                        {
+                            ConnectionAction = ReceiveDataTickInfo.BodyFinishedCallback(BodyDecoder.GetState());
+                        }
+                        else if(bBodyMalformed)
+                        {
+                            SendServerStatusResponse(ClientSocket, "recv - Malformed request body", ServerResponseStatusCode::ServerResponseStatusCode_400, UrlData, SendData);
+                        }
+
+                        ReceiveDataTickInfo.bReadingBody = false;
+                        ReceiveDataTickInfo.BodyDataCallback = nullptr;
+                        ReceiveDataTickInfo.BodyFinishedCallback = nullptr;
+                        ReceiveDataTickInfo.BodyAbortedCallback = nullptr;
+                        if(ConnectionAction == RequestConnectionAction::RequestConnectionAction_Close)
+                        {
+                            ReceiveDataTickInfo.bReceiveFinished = true;
+                            OnReceiveFinished(ClientSocket, false);
+                        }
+                        continue;
+                    }
+
+                    // Picks up where the last read left off, only the new bytes get looked at
+                    ServerRequestMessage& RequestMessage = ReceiveDataTickInfo.PendingRequest;
+                    int RequestLength = RequestMessage.ParseData(RequestStream.GetLinearData(), RequestStream.GetDataLen());
+                    if(RequestMessage.bIsMessageMalformed)
+                    {
+                        if(RequestMessage.bIsVersionUnsupported)
+                        {
+                            SendServerStatusResponse(ClientSocket, "recv - Unsupported HTTP version", ServerResponseStatusCode::ServerResponseStatusCode_505, UrlData, SendData);
+                        }
+                        else
+                        {
+                            SendServerStatusResponse(ClientSocket, "recv - Malformed request", ServerResponseStatusCode::ServerResponseStatusCode_400, UrlData, SendData);
+                        }
+                        ReceiveDataTickInfo.bReceiveFinished = true;
+                        OnReceiveFinished(ClientSocket, false);
+                        break;
+                    }
+                    if(RequestMessage.bIsMessageComplete == false)
+                    {
+                        break;
+                    }
+
                     StatusLogPost("recv - Request Complete - Proceeding to response", StatusLogSeverity::StatusLogSeverity_Log);
                     RequestMessage.DebugPrint();
 
-                    OnReceivedServerRequest(ClientSocket, RequestMessage);
-                    if(RequestMessage.CheckHeaderValue("Connection", "keep-alive") == false)
+                    // The response to the last request the connection will serve says so
+                    const bool bRequestLimitReached = ReceiveDataTickInfo.NumRequestsServed + 1 >= Config.MaxKeepAliveRequests;
+                    const ConnectionPersistence Persistence = bRequestLimitReached ? ConnectionPersistence::ConnectionPersistence_Close : RequestMessage.GetConnectionPersistence();
+                    const bool bLastRequest = Persistence == ConnectionPersistence::ConnectionPersistence_Close;
+                    RequestConnectionAction ConnectionAction = OnReceivedServerRequest(ClientSocket, RequestMessage, Persistence);
+                    RequestStream.Consume(RequestLength);
+
+                    // A body has to be read past before the next request, whether or not anything wants it. A response still
+                    // to come decides for itself whether the connection carries on
+                    const bool bAwaitingBody = ConnectionAction == RequestConnectionAction::RequestConnectionAction_AwaitingBody;
+                    const bool bAwaitingResponse = ConnectionAction == RequestConnectionAction::RequestConnectionAction_AwaitingResponse;
+                    if(bAwaitingBody || (ConnectionAction == RequestConnectionAction::RequestConnectionAction_KeepAlive && bLastRequest == false && RequestMessage.HasBody()))
+                    {
+                        BodyDecoder.Start(RequestMessage.IsBodyChunked(), RequestMessage.GetContentLength());
+                        ReceiveDataTickInfo.bReadingBody = true;
+                    }
+
+                    RequestMessage = ServerRequestMessage{};
+                    NumRequestsAnswered++;
+                    ReceiveDataTickInfo.NumRequestsServed++;
+
+                    if(ConnectionAction == RequestConnectionAction::RequestConnectionAction_HandedOff)
                     {
-                        OnReceiveFinished(ClientSocket, RequestMessage.CheckHeaderValue("Connection", "Upgrade"));
+                        ReceiveDataTickInfo.bReceiveFinished = true;
+                        OnReceiveFinished(ClientSocket, true);
+                    }
+                    else if(ConnectionAction == RequestConnectionAction::RequestConnectionAction_Close || (bLastRequest && bAwaitingBody == false && bAwaitingResponse == false))
+                    {
+                        ReceiveDataTickInfo.bReceiveFinished = true;
+                        OnReceiveFinished(ClientSocket, false);
                     }
                 }
-            };
 
-        ReceiveDataTickInfo.MessageRecievedCallback = MessageRecievedCallback;
-    }
+                if(ReceiveDataTickInfo.bReceiveFinished)
+                {
+                    return;
+                }
 
-    bool IsServerRequestComplete(const char* InRequestData, int InRequestDataLen)
-    {
-        return InRequestDataLen != -1 && InRequestData[InRequestDataLen - 4] == '\r' && InRequestData[InRequestDataLen - 3] == '\n'
-            && InRequestData[InRequestDataLen - 2] == '\r' && InRequestData[InRequestDataLen - 1] == '\n';
-    }
+                // Waiting on the client to take its responses, the send timeout covers the connection until then
+                if(ReceiveDataTickInfo.bReceivePaused)
+                {
+                    Timers.Cancel(ReceiveDataTickInfo.ReceiveTimeoutTimer);
+                    return;
+                }
 
-    bool IsServerRequestStartLine(const char* HttpRequestLine, int Len)
-    {
-        constexpr char const* HttpRequestStartLineEnding = "HTTP/1.1\r";
-        int StartLineEndingLength = std::strlen(HttpRequestStartLineEnding);
+                if(NumRequestsAnswered == 0 && bBodyProgressed == false)
+                {
+                    return;
+                }
+
+                // Whatever's left is a request or body still arriving (which has the receive timeout from its last progress),
+                // otherwise wait on the connection going idle
+                const bool bRequestArriving = RequestStream.GetDataLen() > 0 || ReceiveDataTickInfo.bReadingBody;
+                Timers.Arm(ReceiveDataTickInfo.ReceiveTimeoutTimer, bRequestArriving ? ReceiveTimeoutMs : Config.KeepAliveIdleTimeoutMs);
+            };
 
-        const char* RequestLineOffset = &HttpRequestLine[Len - StartLineEndingLength];
-        return std::strncmp(RequestLineOffset, HttpRequestStartLineEnding, StartLineEndingLength) == 0;
+        ReceiveDataTickInfo.MessageRecievedCallback = MessageRecievedCallback;
     }
 
-    ServerRequestType ResolveServerRequestDetails(char* HttpRequestLine, std::string& OutUrl, std::string& OutQuery)
+    // Method, url, query and version from "GET /path?query HTTP/1.1", false if the line isn't one. Any HTTP/x.y is
+    // resolved, which of them get served is up to the caller
+    bool ResolveServerRequestDetails(const char* Line, int LineLength, const HttpLineScan& Scan, ServerRequestType& OutRequestType, std::string_view& OutUrl, std::string_view& OutQuery,
+        int& OutHttpMajorVersion, int& OutHttpMinorVersion)
     {
-        int UrlStartIndex = FindCharIndex(HttpRequestLine, '/');
-        int QueryStartIndex = FindCharIndex(HttpRequestLine, '?');
+        // The method's a token running up to the first space, the target sits between that and the last
+        const int MethodLength = Scan.FirstSpace;
+        if(MethodLength <= 0 || Scan.FirstNonToken != MethodLength || Scan.LastSpace == MethodLength)
+        {
+            return false;
+        }
 
-        char* UrlStart = &HttpRequestLine[UrlStartIndex];
-        char* QueryStart = (QueryStartIndex != -1) ? &HttpRequestLine[QueryStartIndex] : nullptr;
+        const char* TargetStart = Line + MethodLength + 1;
+        const char* TargetEnd = Line + Scan.LastSpace;
+        if(*TargetStart != '/')
+        {
+            return false;
+        }
 
-        int UrlLen = (QueryStartIndex != -1) ? QueryStartIndex - UrlStartIndex : FindCharIndex(UrlStart, ' ');
-        OutUrl = std::string(UrlStart, UrlLen);
+        // "HTTP/" DIGIT "." DIGIT
+        constexpr char const* HttpVersionPrefix = "HTTP/";
+        const int HttpVersionPrefixLength = (int) std::strlen(HttpVersionPrefix);
+        const char* Version = TargetEnd + 1 + HttpVersionPrefixLength;
+        if(LineLength - (Scan.LastSpace + 1) != HttpVersionPrefixLength + 3 || std::strncmp(TargetEnd + 1, HttpVersionPrefix, HttpVersionPrefixLength) != 0
+            || Version[0] < '0' || Version[0] > '9' || Version[1] != '.' || Version[2] < '0' || Version[2] > '9')
+        {
+            return false;
+        }
+        OutHttpMajorVersion = Version[0] - '0';
+        OutHttpMinorVersion = Version[2] - '0';
 
+        const char* QueryStart = (const char*) memchr(TargetStart, '?', TargetEnd - TargetStart);
+        OutUrl = std::string_view(TargetStart, ((QueryStart != nullptr) ? QueryStart : TargetEnd) - TargetStart);
         if(QueryStart != nullptr)
         {
-            int QueryLength = FindCharIndex(QueryStart, ' ');
-            OutQuery = std::string(&HttpRequestLine[QueryStartIndex + 1], QueryLength - 1);
+            OutQuery = std::string_view(QueryStart + 1, TargetEnd - (QueryStart + 1));
         }
 
+        // Unknown methods are still a request, just one that can't be served
+        OutRequestType = ServerRequestType::ServerRequestType_Invalid;
         for(const auto& RequestTypePair : ServerRequestTypeStrings)
         {
-            if(std::strncmp(HttpRequestLine, RequestTypePair.second.c_str(), RequestTypePair.second.size()) == 0)
+            if((int) RequestTypePair.second.size() == MethodLength && std::strncmp(Line, RequestTypePair.second.c_str(), MethodLength) == 0)
+            {
+                OutRequestType = RequestTypePair.first;
+                break;
+            }
+        }
+        return true;
+    }
+
+    // Connection's value is a comma separated list ("keep-alive, Upgrade"), options are case-insensitive
+    bool HasConnectionOption(std::string_view ConnectionValue, std::string_view Option)
+    {
+        while(ConnectionValue.empty() == false)
+        {
+            const size_t Comma = ConnectionValue.find(',');
+            std::string_view Item = ConnectionValue.substr(0, Comma);
+            const size_t ItemStart = Item.find_first_not_of(" \t");
+            if(ItemStart != std::string_view::npos)
             {
-                return RequestTypePair.first;
+                Item = Item.substr(ItemStart, Item.find_last_not_of(" \t") + 1 - ItemStart);
+                if(EqualsIgnoreCase(Item, Option))
+                {
+                    return true;
+                }
             }
+            ConnectionValue = (Comma == std::string_view::npos) ? std::string_view() : ConnectionValue.substr(Comma + 1);
         }
+        return false;
     }
 
-    std::pair<std::string, std::string> ResolveRequestHeader(char* RequestLine)
+    // "Key: Value" with the whitespace around the value trimmed, false if the line isn't a header
+    bool ResolveRequestHeader(const char* Line, int LineLength, const HttpLineScan& Scan, std::string_view& OutKey, std::string_view& OutValue)
     {
-        int MetaTagKeyEndIndex = FindCharIndex(RequestLine, ':');
-        std::string MetaTagKey = std::string(RequestLine, MetaTagKeyEndIndex);
+        // The name's a token running right up to the colon
+        const int KeyLength = Scan.FirstColon;
+        if(KeyLength <= 0 || Scan.FirstNonToken != KeyLength)
+        {
+            return false;
+        }
 
-        int MetaTagValueOffset = FindCharIndex(&RequestLine[MetaTagKeyEndIndex + 2], '\r');
-        std::string MetaTagValue = std::string(&RequestLine[MetaTagKeyEndIndex + 2], MetaTagValueOffset);
+        const char* ValueStart = Line + KeyLength + 1;
+        const char* ValueEnd = Line + LineLength;
+        while(ValueStart < ValueEnd && (*ValueStart == ' ' || *ValueStart == '\t'))
+        {
+            ValueStart++;
+        }
+        while(ValueEnd > ValueStart && (ValueEnd[-1] == ' ' || ValueEnd[-1] == '\t'))
+        {
+            ValueEnd--;
+        }
 
-        return std::make_pair(MetaTagKey, MetaTagValue);
+        OutKey = std::string_view(Line, KeyLength);
+        OutValue = std::string_view(ValueStart, ValueEnd - ValueStart);
+        return true;
     }
 
     std::vector<std::pair<std::string, std::string>> GenerateMetaDataMessageHeaders()
@@ -308,13 +564,13 @@ namespace
     {
         bool Valid = Message.mStatusCode != ServerResponseStatusCode::ServerResponseStatusCode_Invalid;
 
-        auto ContentTypeHeader = Message.mHeaders.find("Content-Type");
-        if(ContentTypeHeader != Message.mHeaders.end() && ContentTypeHeader->second == "image/webp")
+        const std::string* ContentType = Message.mHeaders.Find(HttpHeader::HttpHeader_ContentType);
+        if(ContentType != nullptr && *ContentType == "image/webp")
         {
             Valid &= MessageContent != nullptr && ContentLength > 1;
             //image checks
         }
-        else if(ContentTypeHeader != Message.mHeaders.end() && ContentTypeHeader->second == "text/html")
+        else if(ContentType != nullptr && *ContentType == "text/html")
         {
             Valid &= MessageContent != nullptr && ContentLength > 1;
             //html checks
@@ -329,13 +585,12 @@ namespace
         return snprintf(Buffer, BufLen, "%s %s\r\n", "HTTP/1.1", StatusString.c_str());
     }
 
-    int PrintnResponseMessageHeaders(char* Buffer, int BufLen, std::map<std::string, std::string>& Headers)
+    int PrintnResponseMessageHeaders(char* Buffer, int BufLen, const ResponseHeaderList& Headers)
     {
         int HeadersLength = 0;
-        for(const auto& Header : Headers)
-        {
-            HeadersLength += snprintf(Buffer + HeadersLength, BufLen, "%s: %s\r\n", Header.first.c_str(), Header.second.c_str());
-        }
+        Headers.ForEach([&] (std::string_view Key, const std::string& Value) {
+            HeadersLength += snprintf(Buffer + HeadersLength, BufLen, "%.*s: %s\r\n", (int) Key.size(), Key.data(), Value.c_str());
+            });
         HeadersLength += snprintf(Buffer + HeadersLength, BufLen, "\r\n");
 
         return HeadersLength;
@@ -343,7 +598,9 @@ namespace
 
     ServerResponseMessage BuildWSHandshakeAcceptResponse(const ServerRequestMessage& InRequestMessage, const ServerResponseMessage& AcceptMessageBase)
     {
-        std::string wsRequestKey = (*InRequestMessage.mHeaders.find("Sec-WebSocket-Key")).second;
+        std::string_view wsRequestKeyView;
+        InRequestMessage.mHeaders.Find(HttpHeader::HttpHeader_SecWebSocketKey, wsRequestKeyView);
+        std::string wsRequestKey = std::string(wsRequestKeyView);
         std::string wsAcceptValue = WSHelpers::GetWebSocketAcceptValue(wsRequestKey);
 
         ServerResponseMessage AcceptResponse = AcceptMessageBase;
@@ -429,302 +686,1766 @@ namespace
 namespace WebServer
 {
 
-#pragma region ListenServer
+#pragma region ResponseToken
 
-    ListenServer::~ListenServer()
+    // Where responses from off the loop go. Held by tokens and handler jobs, which can outlive the worker, and let go of
+    // the worker once its loop's stopped. Anything posted after that is dropped
+    struct HandlerResponseTarget
     {
-        if(mListenSocket != INVALID_SOCKET) { closesocket(mListenSocket); }
-    }
+        bool Post(ConnectionId Connection, uint64_t RequestId, std::unique_ptr<ServerResponseMessage> Response, ConnectionPersistence Persistence)
+        {
+            std::lock_guard<std::mutex> Lock(Mutex);
+            if(Worker == nullptr)
+            {
+                return false;
+            }
+            Worker->CompleteResponse(Connection, RequestId, std::move(Response), Persistence);
+            return true;
+        }
 
-    int ListenServer::Initialise(const char* PortNumber)
-    {
-        PopulateStatusMessageResponses(mUrlData);
-        return SetupNonBlockingSocket(PortNumber, mListenSocket);
-    }
+        std::mutex Mutex;
+        ListenServerWorker* Worker = nullptr;
+    };
 
-    void ListenServer::AsyncStart()
+    // Shared by a deferred request's tokens, the last one going answers the request if none of them did
+    struct DeferredResponseState
     {
-        bRunListenServer = true;
-        mListenThread = std::thread(&ListenServer::ListenServerMainThread, this);
-    }
+        ~DeferredResponseState()
+        {
+            if(bCompleted.load() == false)
+            {
+                StatusLogPost("Handler - Response token dropped without completing its request", StatusLogSeverity::StatusLogSeverity_Error);
+                Target->Post(Connection, RequestId, std::make_unique<ServerResponseMessage>(BuildBasicStatusResponse(ServerResponseStatusCode::ServerResponseStatusCode_500)),
+                    Persistence);
+            }
+        }
 
-    int ListenServer::CloseServer()
-    {
-        bRunListenServer = false;
+        std::shared_ptr<HandlerResponseTarget> Target;
+        ConnectionId Connection;
+        uint64_t RequestId = 0;
+        ConnectionPersistence Persistence = ConnectionPersistence::ConnectionPersistence_KeepAlive;
+        std::atomic<bool> bCompleted = false;
+    };
 
-        if(mListenThread.joinable())
+    bool ResponseToken::Complete(ServerResponseMessage Response)
+    {
+        if(mState == nullptr || mState->bCompleted.exchange(true))
         {
-            mListenThread.join();
+            return false;
         }
 
-        return 0;
+        // Built on the completing thread, the loop only has to send it
+        FinishHandlerResponse(Response);
+        return mState->Target->Post(mState->Connection, mState->RequestId, std::make_unique<ServerResponseMessage>(std::move(Response)), mState->Persistence);
     }
 
-    void ListenServer::UploadData(const std::string& Url, std::vector<char> Data, const std::string& ContentType, std::vector<std::pair<std::string, std::string>> MessageHeaders)
+    bool ResponseToken::IsCompleted() const
     {
-        ServerResponseMessage ServerResponseMessage(ServerResponseStatusCode::ServerResponseStatusCode_200);
-        ServerResponseMessage.AddContent(Data, ContentType);
-        ServerResponseMessage.AddMessageHeaders(MessageHeaders);
-        ServerResponseMessage.BuildMessage();
-
-        mUrlData.emplace(Url, std::move(ServerResponseMessage));
+        return mState != nullptr && mState->bCompleted.load();
     }
 
-    void ListenServer::CreateWebSocket(const std::string& Url, WebSocketReceiveDataCallBack RecieveDataCallback, WebSocketClientJoinedCallback ClientJoinedCallback)
-    {
-        ServerResponseMessage WebSocketEmptySuccessResponse(ServerResponseStatusCode::ServerResponseStatusCode_100);
-        WebSocketInfo WebSocketInfo{ ClientJoinedCallback, RecieveDataCallback };
+#pragma endregion   //ResponseToken
 
-        mUrlData.emplace(Url, std::move(WebSocketEmptySuccessResponse));
-        mWebSocketsInfo.emplace(Url, WebSocketInfo);
-    }
+#pragma region ListenServer
 
-    void ListenServer::SendWebSocketMessage(const std::string& Url, uint64_t ClientId, const char* Content, int ContentLen, WebSocketOpCode OpCode)
+    ListenServer::ListenServer() = default;
+
+    ListenServer::~ListenServer()
     {
-        auto WSSendFunction = mWebSocketsInfo.at(Url).SendDataFunctions.at(ClientId);
-        WSSendFunction(Content, ContentLen, OpCode);
+        CloseServer();
     }
 
-    void ListenServer::ListenServerMainThread()
+    int ListenServer::Initialise(const char* PortNumber, const ListenServerConfig& Config)
     {
-        using namespace std::placeholders;
+        mConfig = Config;
+        PopulateStatusMessageResponses(mUrlData);
 
-        if(listen(mListenSocket, SOMAXCONN) == SOCKET_ERROR)
+        int NumWorkers = std::max(Config.NumWorkers, 1);
+        if(NumWorkers > 1 && IsSocketReusePortSupported() == false)
         {
-            StatusLogPost("Serv - Listen failed", StatusLogSeverity::StatusLogSeverity_Error);
-            bRunListenServer = false;
+            StatusLogPost("Serv - SO_REUSEPORT unavailable - Running a single worker", StatusLogSeverity::StatusLogSeverity_Log);
+            NumWorkers = 1;
         }
 
-        auto ServerTime = std::chrono::system_clock::now();
-        MilliSecStopwatch ServerStatusClock{ ServerTime, 500 };
-
-        std::vector<std::pair<SOCKET, bool>> SocketsFinishedReceiving;
-        auto OnReceiveFinished = [&] (SOCKET Socket, bool KeepSocketOpen) {SocketsFinishedReceiving.push_back({Socket, KeepSocketOpen}); };
-
-        while(bRunListenServer)
+        for(int i = 0; i < NumWorkers; i++)
         {
-            ServerTime = std::chrono::system_clock::now();
-
-            if(ServerStatusClock.DurationReached(ServerTime))
-            {
-                StatusLogPost("Serv-Listen - Running listen server", StatusLogSeverity::StatusLogSeverity_Log);
-            }
-
-            // Accept connections
-            SOCKET ClientSocket = INVALID_SOCKET;
-            ClientSocket = accept(mListenSocket, NULL, NULL);
-            if(ClientSocket != INVALID_SOCKET && mSocketsReceivingData.find(ClientSocket) == mSocketsReceivingData.end())
-            {
-                StatusLogPost("Serv-Listen - Accepted message - Proceeding to recieve data", StatusLogSeverity::StatusLogSeverity_Log);
-
-                ReceiveDataTickInfo& ReceiveTickInfo = mSocketsReceivingData[ClientSocket];
-                BuildReceiveTickInfo(ReceiveTickInfo, ClientSocket, std::bind(&ListenServer::HandleServerRequest, this, _1, _2), OnReceiveFinished, mUrlData);
-            }
-            else if(WSAGetLastError() != WSAEWOULDBLOCK)
-            {
-                StatusLogPost("Serv - Listen - accept failed", StatusLogSeverity::StatusLogSeverity_Error);
-                bRunListenServer = false;
-            }
-
-            // Receive data
-            for(const auto& ReceiveTickPair : mSocketsReceivingData)
-            {
-                SOCKET Socket = ReceiveTickPair.first;
-                const ReceiveDataTickInfo& ReceiveDataInfo = ReceiveTickPair.second;
-                HandleSocketDataReceiveTick(Socket, ReceiveDataInfo);
-            }
+            mWorkers.push_back(std::make_unique<ListenServerWorker>(*this));
 
-            // Clear sockets
-            for(auto SocketCloseDetails : SocketsFinishedReceiving)
+            int ReturnCode = mWorkers.back()->Initialise(PortNumber, Config.IoMode, NumWorkers > 1);
+            if(ReturnCode != 0)
             {
-                SOCKET Socket = SocketCloseDetails.first;
-                bool KeepSocketAlive = SocketCloseDetails.second;
-
-                mSocketsReceivingData.erase(Socket);
-                if(KeepSocketAlive == false)
-                {
-                    shutdown(Socket, SD_SEND);
-                    closesocket(Socket);
-                }
+                return ReturnCode;
             }
         }
+
+        return 0;
     }
 
-    void ListenServer::HandleServerRequest(SOCKET ClientSocket, ServerRequestMessage& RequestMessage)
+    void ListenServer::AsyncStart()
     {
-        if(RequestMessage.mRequestType != ServerRequestType::ServerRequestType_GET)
+        if(bHasDynamicHandlers && mHandlerPool.IsRunning() == false)
         {
-            SendServerStatusResponse(ClientSocket, "Response - failed: 501 Request Not Implemented", ServerResponseStatusCode::ServerResponseStatusCode_501, mUrlData);
-            return;
+            mHandlerPool.Start(mConfig.NumHandlerThreads);
         }
 
-        if(mUrlData.find(RequestMessage.mUrl) == mUrlData.end())
+        for(auto& Worker : mWorkers)
         {
-            SendServerStatusResponse(ClientSocket, "Response - failed: 404 Page Not Found\n", ServerResponseStatusCode::ServerResponseStatusCode_404, mUrlData);
-            return;
+            Worker->AsyncStart();
         }
+    }
 
-        if(RequestMessage.CheckHeaderValue("Connection", "Upgrade") && RequestMessage.CheckHeaderValue("Upgrade", "websocket"))
+    int ListenServer::CloseServer()
+    {
+        for(auto& Worker : mWorkers)
         {
-            StatusLogPost("Response - Success - Web socket upgrade requested", StatusLogSeverity::StatusLogSeverity_Log);
-            HandleWebSocketRequest(ClientSocket, RequestMessage);
-            return;
+            Worker->Stop();
         }
 
-        StatusLogPost("Response - Success - Proceeding to send reply", StatusLogSeverity::StatusLogSeverity_Log);
-
-        const ServerResponseMessage& ResponseMessage = mUrlData.at(RequestMessage.mUrl);
-        SendServerResponseMessage(ClientSocket, ResponseMessage);
+        // Handlers still running finish into nothing, their workers have let go of them
+        mHandlerPool.Stop();
+        return 0;
     }
 
-    void ListenServer::HandleWebSocketRequest(SOCKET ClientSocket, const ServerRequestMessage& RequestMessage)
+    void ListenServer::UploadData(const std::string& Url, std::vector<char> Data, const std::string& ContentType, std::vector<std::pair<std::string, std::string>> MessageHeaders)
     {
-        using namespace std::placeholders;
-
-        ServerResponseMessage wsAcceptResponse = BuildWSHandshakeAcceptResponse(RequestMessage, mUrlData.find("websocket-success-base")->second);
-        SendServerResponseMessage(ClientSocket, wsAcceptResponse);
-
-        mActiveWebSockets.emplace(std::make_pair(ClientSocket, WebSocketHandle{}));
-        WebSocketHandle& wsHandle =  mActiveWebSockets.at(ClientSocket);
-        WebSocketSendDataFunc wsPushMessageFunction = std::bind(&WebSocketHandle::AddMessageToSendQueue, &wsHandle, _1, _2, _3);
-        
-        uint64_t wsClientId = (uint64_t) ClientSocket;
-        WebSocketInfo& wsInfo = mWebSocketsInfo.at(RequestMessage.mUrl);
-        wsInfo.SendDataFunctions.emplace(wsClientId, wsPushMessageFunction);
-
-        wsHandle.StartWebSocketThread(ClientSocket, wsInfo.RecieveDataCallbackFunction);
-        wsInfo.ClientJoinedCallback(RequestMessage.mUrl, wsClientId);
+        ContentBatch Batch;
+        UploadData(Batch, Url, std::move(Data), ContentType, std::move(MessageHeaders));
+        mContent.Commit(std::move(Batch));
     }
 
-#pragma endregion   //ListenServer
-
-#pragma region ServerRequestMessage
+    void ListenServer::UploadData(ContentBatch& Batch, const std::string& Url, std::vector<char> Data, const std::string& ContentType, std::vector<std::pair<std::string, std::string>> MessageHeaders)
+    {
+        std::shared_ptr<ServerResponseMessage> Page = std::make_shared<ServerResponseMessage>(ServerResponseStatusCode::ServerResponseStatusCode_200);
+        Page->AddContent(std::move(Data), ContentType);
+        Page->AddMessageHeaders(MessageHeaders);
+        Page->BuildMessage();
+        Batch.Upload(Url, std::move(Page));
+    }
 
-    void ServerRequestMessage::BuildFromDataStream(const SocketDataStream& DataStream)
+    void ListenServer::RemoveData(const std::string& Url)
     {
-        bIsMessageComplete = IsServerRequestComplete(DataStream.mData, DataStream.GetDataLen());
+        ContentBatch Batch;
+        Batch.Remove(Url);
+        mContent.Commit(std::move(Batch));
+    }
 
-        std::string LogMessage = "Computing request data (Request " + bIsMessageComplete ? "Complete)" : "Incomplete)";
-        StatusLogPost(LogMessage, StatusLogSeverity::StatusLogSeverity_Log);
+    void ListenServer::CommitContent(ContentBatch Batch)
+    {
+        mContent.Commit(std::move(Batch));
+    }
 
-        char LineBuffer[1024];
-        const char* LineIteratorPtr = DataStream.mData;
-        while(GetStrLine(LineIteratorPtr, LineBuffer, 1024, LineIteratorPtr))
+    void ListenServer::CreateWebSocket(const std::string& Url, WebSocketReceiveDataCallBack RecieveDataCallback, WebSocketClientJoinedCallback ClientJoinedCallback)
+    {
+        WebSocketInfo WebSocketInfo{ ClientJoinedCallback, RecieveDataCallback };
         {
-            int LineLength = strlen(LineBuffer);
-            bool IsCompleteRequestLine = LineLength > 2 && LineBuffer[LineLength - 1] == '\r';
-
-            if(IsCompleteRequestLine && IsServerRequestStartLine(LineBuffer, LineLength))
-            {
-                mRequestType = ResolveServerRequestDetails(LineBuffer, mUrl, mQuery);
-            }
-            else if(IsCompleteRequestLine)
-            {
-                mHeaders.emplace(ResolveRequestHeader(LineBuffer));
-            }
+            std::lock_guard<std::mutex> WebSocketsInfoLock(mWebSocketsInfoMutex);
+            mWebSocketsInfo.emplace(Url, WebSocketInfo);
         }
 
-        // TODO: if message had content parse that (eg POST)
-        // Any errors in parsing need the bad request response message
+        // Callbacks first, the url's live as soon as it's committed
+        ContentBatch Batch;
+        Batch.AddWebSocket(Url);
+        mContent.Commit(std::move(Batch));
     }
 
-    bool ServerRequestMessage::CheckHeaderValue(const std::string& InHeader, const std::string& InValue)
+    void ListenServer::SendWebSocketMessage(const std::string& Url, uint64_t ClientId, const char* Content, int ContentLen, WebSocketOpCode OpCode)
     {
-        auto header = mHeaders.find(InHeader);
-        return header != mHeaders.end() && (*header).second.compare(InValue) == 0;
+        WebSocketSendDataFunc WSSendFunction;
+        {
+            std::lock_guard<std::mutex> WebSocketsInfoLock(mWebSocketsInfoMutex);
+            WSSendFunction = mWebSocketsInfo.at(Url).SendDataFunctions.at(ClientId);
+        }
+        WSSendFunction(Content, ContentLen, OpCode);
     }
 
-    void ServerRequestMessage::DebugPrint()
+    void ListenServer::CreateRequestHandler(const std::string& Url, RequestHandler Handler)
     {
-        std::cout << OutputServerTime_GetTime() << "Request data:\n\n";
-        std::cout << "--------------------REQUEST-START--------------------\n\n";
-        std::cout << ServerRequestTypeStrings.at(mRequestType) << " | " << mUrl << " | ?" << mQuery << "\n";
-        
-        for(const auto& RequestTag : mHeaders)
+        for(ServerRequestType Method : { ServerRequestType::ServerRequestType_POST, ServerRequestType::ServerRequestType_PUT, ServerRequestType::ServerRequestType_PATCH, ServerRequestType::ServerRequestType_DELETE })
         {
-            std::cout << RequestTag.first << " : " << RequestTag.second << "\n";
+            ServerRoute Route;
+            Route.Handler = Handler;
+            AddRoute(Method, Url, std::move(Route));
         }
+    }
 
-        std::cout << "---------------------REQUEST-END---------------------\n\n";
+    void ListenServer::CreateDynamicHandler(ServerRequestType Method, const std::string& Url, DynamicRequestCallback Callback)
+    {
+        ServerRoute Route;
+        Route.DynamicHandler = std::move(Callback);
+        bHasDynamicHandlers |= AddRoute(Method, Url, std::move(Route));
     }
 
-#pragma endregion //ServerRequestMessage
+    void ListenServer::CreateDeferredHandler(ServerRequestType Method, const std::string& Url, DeferredRequestCallback Callback)
+    {
+        ServerRoute Route;
+        Route.DeferredHandler = std::move(Callback);
+        AddRoute(Method, Url, std::move(Route));
+    }
 
-#pragma region ServerResponseMessage
+    void ListenServer::CreateCoroutineHandler(ServerRequestType Method, const std::string& Url, CoroutineRequestCallback Callback)
+    {
+        ServerRoute Route;
+        Route.CoroutineHandler = std::move(Callback);
+        AddRoute(Method, Url, std::move(Route));
+    }
 
-    ServerResponseMessage::ServerResponseMessage(ServerResponseStatusCode MessageStatus)
-        : mStatusCode(MessageStatus)
+    void ListenServer::SetStaticRoutes(const StaticRouteLookup& StaticRoutes)
     {
-        AddMessageHeaders(GenerateMetaDataMessageHeaders());  
+        mStaticRouteLookup = StaticRoutes;
+        mStaticRoutes.clear();
+        mStaticRoutes.resize(StaticRoutes.NumRoutes);
     }
 
-    ServerResponseMessage::ServerResponseMessage(const ServerResponseMessage& Other)
-        : mStatusCode(Other.mStatusCode), mMessageLength(Other.mMessageLength), mContentLength(Other.mContentLength)
+    bool ListenServer::AddRoute(ServerRequestType Method, const std::string& Url, ServerRoute Route)
     {
-        mHeaders = Other.mHeaders;
+        Route.Url = Url;
 
-        if(Other.mMessage != nullptr)
+        const int StaticIndex = mStaticRouteLookup.Find(Method, Url);
+        if(StaticIndex >= 0)
         {
-            mMessage = (const char*)malloc(mMessageLength);
-            memcpy((char*) mMessage, Other.mMessage, mMessageLength);
+            mStaticRoutes[StaticIndex] = std::move(Route);
+            return true;
         }
-        
-        if(Other.mContentData != nullptr)
+
+        if(mRouter.AddRoute(Method, Url, (uint32_t) mRoutes.size()) == false)
         {
-            mContentData = (const char*) malloc(mContentLength);
-            memcpy((char*) mContentData, Other.mContentData, mContentLength);
+            StatusLogPost("Serv - Route not added, bad url pattern or parameter name clash: " + Url, StatusLogSeverity::StatusLogSeverity_Warning);
+            return false;
         }
+        mRoutes.push_back(std::move(Route));
+        return true;
     }
 
-    ServerResponseMessage::ServerResponseMessage(ServerResponseMessage&& Other) noexcept
-        : mStatusCode(Other.mStatusCode), mMessage(Other.mMessage), mMessageLength(Other.mMessageLength), mContentData(Other.mContentData), mContentLength(Other.mContentLength)
+    const ServerRoute* ListenServer::FindRoute(ServerRequestType Method, std::string_view Url, uint64_t UrlHash, RouteParams& OutParams) const
     {
-        mHeaders = std::move(Other.mHeaders);
-        Other.mMessage = nullptr;
-        Other.mContentData = nullptr;
+        // Declared ones first, an exact url only costs a slot and a compare with its hash already worked out
+        const int StaticIndex = mStaticRouteLookup.Find(Method, Url, UrlHash);
+        if(StaticIndex >= 0 && mStaticRoutes[StaticIndex].Url.empty() == false)
+        {
+            OutParams.NumParams = 0;
+            return &mStaticRoutes[StaticIndex];
+        }
+
+        const uint32_t RouteId = mRouter.Match(Method, Url, OutParams);
+        return (RouteId != RequestRouter::NoRoute) ? &mRoutes[RouteId] : nullptr;
     }
 
-    ServerResponseMessage::~ServerResponseMessage()
+#pragma endregion   //ListenServer
+
+#pragma region ListenServerWorker
+
+    ListenServerWorker::ListenServerWorker(ListenServer& Server)
+        : mServer(Server)
+        , mContentReader(Server.mContent.RegisterReader())
     {
-        if(mContentData){ free((char*) mContentData); }
-        if(mMessage){ free((char*) mMessage); }
     }
 
-    void ServerResponseMessage::AddContent(const std::vector<char>& MessageContent, const std::string& ContentType)
+    ListenServerWorker::~ListenServerWorker()
     {
-        mContentLength = MessageContent.size();
-        mContentData = (const char*) malloc(mContentLength);
-        memcpy((char*) mContentData, MessageContent.data(), mContentLength);
-
-        mHeaders.emplace(std::make_pair("Content-Type", ContentType));
-        mHeaders.emplace(std::make_pair("Content-Length", std::to_string(mContentLength)));
+        Stop();
+        if(mListenSocket != INVALID_SOCKET) { CloseSocket(mListenSocket); }
     }
 
-    void ServerResponseMessage::BuildMessage()
+    int ListenServerWorker::Initialise(const char* PortNumber, ListenServerIoMode IoMode, bool bReusePort)
     {
-        //TODO: could check if anything has changed since last build
-
-        if(mMessage) { free((char*) mMessage); }
-        assert(ValidResponseMessageData(*this, mContentData, mContentLength));
- 
-        mMessageLength = mContentLength + PrintnResponseMessageStatus(NULL, 0, mStatusCode) + PrintnResponseMessageHeaders(NULL, 0, mHeaders);
-        char* MessageBuffer = (char*) malloc(mMessageLength + 1);
-        int MessageBufferIndex = 0;
-
-        MessageBufferIndex += PrintnResponseMessageStatus(&MessageBuffer[MessageBufferIndex], mMessageLength + 1, mStatusCode);
-        MessageBufferIndex += PrintnResponseMessageHeaders(&MessageBuffer[MessageBufferIndex], mMessageLength + 1, mHeaders);
-
-        if(mContentData != nullptr)
+        bUseIoUring = IoMode != ListenServerIoMode::ListenServerIoMode_Poll && IoUringEngine::IsSupported();
+        if(IoMode == ListenServerIoMode::ListenServerIoMode_IoUring && bUseIoUring == false)
         {
-            memcpy(&MessageBuffer[MessageBufferIndex], mContentData, mContentLength);
+            StatusLogPost("Serv - io_uring unavailable - Falling back to socket polling", StatusLogSeverity::StatusLogSeverity_Log);
         }
 
-        mMessage = MessageBuffer;
-    }
+        if(mSocketPoller.Initialise() == false)
+        {
+            StatusLogPost("Serv - Socket poller init failed", StatusLogSeverity::StatusLogSeverity_Error);
+            return 1;
+        }
+
+        return SetupNonBlockingSocket(PortNumber, mListenSocket, bReusePort);
+    }
+
+    void ListenServerWorker::AsyncStart()
+    {
+        // Held from here, before the loop can look at a snapshot
+        mContentReader->store(mServer.mContent.GetGeneration());
+        bRunListenServer = true;
+        mResponseTarget = std::make_shared<HandlerResponseTarget>();
+        mResponseTarget->Worker = this;
+        mListenThread = std::thread(bUseIoUring ? &ListenServerWorker::ListenServerIoUringThread : &ListenServerWorker::ListenServerMainThread, this);
+    }
+
+    void ListenServerWorker::Stop()
+    {
+        bRunListenServer = false;
+
+        // Responses still to come from handlers have nowhere to go once the loop's finished
+        if(mResponseTarget != nullptr)
+        {
+            std::lock_guard<std::mutex> Lock(mResponseTarget->Mutex);
+            mResponseTarget->Worker = nullptr;
+        }
+
+        if(mListenThread.joinable())
+        {
+            mListenThread.join();
+
+            // Whatever sends were left went with the loop
+            mContentPins.clear();
+            mContentReader->store(ContentStore::ReaderIdle);
+        }
+    }
+
+    void ListenServerWorker::ListenServerMainThread()
+    {
+        using namespace std::placeholders;
+        mSendData = std::bind(&ListenServerWorker::QueueResponseData, this, _1, _2, _3, _4);
+
+        if(listen(mListenSocket, SOMAXCONN) == SOCKET_ERROR || mSocketPoller.AddSocket(mListenSocket, SocketPollEvent_Read) == false)
+        {
+            StatusLogPost("Serv - Listen failed", StatusLogSeverity::StatusLogSeverity_Error);
+            bRunListenServer = false;
+        }
+
+        TimerHandle ServerStatusTimer = mTimerWheel.AddTimer(std::bind(StatusLogPost, "Serv-Listen - Running listen server", StatusLogSeverity::StatusLogSeverity_Log));
+        mTimerWheel.Arm(ServerStatusTimer, 500, 500);
+
+        // Tagged with the connection's generation so a socket finishing twice in a tick is only closed once
+        std::vector<std::pair<ConnectionId, bool>> SocketsFinishedReceiving;
+        auto OnReceiveFinished = [&] (SOCKET Socket, bool KeepSocketOpen) {SocketsFinishedReceiving.push_back({mSocketsReceivingData.GetId(Socket), KeepSocketOpen}); };
+
+        std::vector<SocketPollResult> PollResults;
+
+        while(bRunListenServer)
+        {
+            // Sleeps until a socket is ready, wakes at least every poll timeout to run timed functions. A task whose writes
+            // went straight out after it blocked has nothing left to wake it, it goes again without waiting
+            mSocketPoller.Wait(PollResults, HasDrainedWriters() ? 0 : ServerPollTimeoutMs);
+
+            for(const SocketPollResult& PollResult : PollResults)
+            {
+                if(PollResult.Socket == mListenSocket)
+                {
+                    AcceptConnections(OnReceiveFinished);
+                    continue;
+                }
+
+                // Room in the send buffer again, carry on with what the client wasn't ready for
+                if(PollResult.Events & SocketPollEvent_Write)
+                {
+                    SendDataTickInfo* SendTickInfo = mSocketsSendingData.Find(PollResult.Socket);
+                    if(SendTickInfo != nullptr && SendTickInfo->bAwaitingWritable)
+                    {
+                        FlushSendQueue(PollResult.Socket, *SendTickInfo);
+                    }
+                }
+
+                // Receive data
+                ReceiveDataTickInfo* ReceiveTickInfo = mSocketsReceivingData.Find(PollResult.Socket);
+                if(ReceiveTickInfo != nullptr && (PollResult.Events & (SocketPollEvent_Read | SocketPollEvent_Closed)))
+                {
+                    HandleSocketDataReceive(PollResult.Socket, *ReceiveTickInfo);
+                }
+            }
+
+            mTimerWheel.Advance(TimerWheel::Clock::now());
+            SendHandlerResponses(OnReceiveFinished);
+
+            // Responses must be out (or queued on the ring) before a finished socket closes. Tasks streaming a response
+            // get one go a loop, so a fast client can't keep the loop to itself
+            FlushQueuedSends();
+            if(ResumeDrainedWriters())
+            {
+                SendHandlerResponses(OnReceiveFinished);
+                FlushQueuedSends();
+            }
+            while(ResumeDrainedReceives())
+            {
+                SendHandlerResponses(OnReceiveFinished);
+                FlushQueuedSends();
+            }
+            ClearFinishedSockets(SocketsFinishedReceiving);
+            ReportContentInUse();
+        }
+
+        mTimerWheel.RemoveTimer(ServerStatusTimer);
+    }
+
+    void ListenServerWorker::ListenServerIoUringThread()
+    {
+        using namespace std::placeholders;
+        mSendData = std::bind(&ListenServerWorker::QueueResponseData, this, _1, _2, _3, _4);
+
+        if(listen(mListenSocket, SOMAXCONN) == SOCKET_ERROR)
+        {
+            StatusLogPost("Serv - Listen failed", StatusLogSeverity::StatusLogSeverity_Error);
+            bRunListenServer = false;
+        }
+        else if(mIoUringEngine.Initialise(mListenSocket) == false)
+        {
+            StatusLogPost("Serv - io_uring setup failed - Falling back to socket polling", StatusLogSeverity::StatusLogSeverity_Log);
+            bUseIoUring = false;
+            ListenServerMainThread();
+            return;
+        }
+
+        TimerHandle ServerStatusTimer = mTimerWheel.AddTimer(std::bind(StatusLogPost, "Serv-Listen - Running listen server", StatusLogSeverity::StatusLogSeverity_Log));
+        mTimerWheel.Arm(ServerStatusTimer, 500, 500);
+
+        // Tagged with the connection's generation so a socket finishing twice in a tick is only closed once
+        std::vector<std::pair<ConnectionId, bool>> SocketsFinishedReceiving;
+        auto OnReceiveFinished = [&] (SOCKET Socket, bool KeepSocketOpen) {SocketsFinishedReceiving.push_back({mSocketsReceivingData.GetId(Socket), KeepSocketOpen}); };
+
+        std::vector<IoUringCompletion> Completions;
+
+        while(bRunListenServer)
+        {
+            // Submits the sends, closes and re-arms queued last loop and waits for completions in one syscall
+            mIoUringEngine.SubmitAndWait(Completions, ServerPollTimeoutMs);
+
+            for(const IoUringCompletion& Completion : Completions)
+            {
+                if(Completion.Type == IoUringCompletionType::IoUringCompletionType_Accept)
+                {
+                    if(Completion.Socket == INVALID_SOCKET)
+                    {
+                        StatusLogPost("Serv - Listen - accept failed", StatusLogSeverity::StatusLogSeverity_Error);
+                        continue;
+                    }
+
+                    StatusLogPost("Serv-Listen - Accepted message - Proceeding to recieve data", StatusLogSeverity::StatusLogSeverity_Log);
+                    RegisterClientSocket(Completion.Socket, OnReceiveFinished);
+                    mIoUringEngine.ArmReceive(Completion.Socket);
+                    continue;
+                }
+
+                ReceiveDataTickInfo* ReceiveTickInfo = mSocketsReceivingData.Find(Completion.Socket);
+                if(ReceiveTickInfo == nullptr)
+                {
+                    continue;
+                }
+
+                if(Completion.Result > 0)
+                {
+                    // The provided buffer goes back to the ring, the connection's stream keeps the one copy it needs
+                    ReceiveTickInfo->ReceiveDataStream.StreamRequestData(Completion.Data, Completion.Result);
+                    ReceiveTickInfo->MessageRecievedCallback(Completion.Result);
+                }
+                else
+                {
+                    ReceiveTickInfo->ErrorCallback();
+                }
+            }
+
+            mTimerWheel.Advance(TimerWheel::Clock::now());
+            SendHandlerResponses(OnReceiveFinished);
+
+            // Responses must be out (or queued on the ring) before a finished socket closes. Tasks streaming a response
+            // get one go a loop, so a fast client can't keep the loop to itself
+            FlushQueuedSends();
+            if(ResumeDrainedWriters())
+            {
+                SendHandlerResponses(OnReceiveFinished);
+                FlushQueuedSends();
+            }
+            while(ResumeDrainedReceives())
+            {
+                SendHandlerResponses(OnReceiveFinished);
+                FlushQueuedSends();
+            }
+            ClearFinishedSockets(SocketsFinishedReceiving);
+            ReportContentInUse();
+        }
+
+        mTimerWheel.RemoveTimer(ServerStatusTimer);
+    }
+
+    void ListenServerWorker::AcceptConnections(const std::function<void(SOCKET, bool)>& OnReceiveFinished)
+    {
+        while(bRunListenServer)
+        {
+            SOCKET ClientSocket = accept(mListenSocket, NULL, NULL);
+            if(ClientSocket == INVALID_SOCKET)
+            {
+                if(IsSocketWouldBlockError(GetSocketError()) == false)
+                {
+                    StatusLogPost("Serv - Listen - accept failed", StatusLogSeverity::StatusLogSeverity_Error);
+                    bRunListenServer = false;
+                }
+                return;
+            }
+
+            if(SetSocketNonBlocking(ClientSocket) == false || mSocketPoller.AddSocket(ClientSocket, SocketPollEvent_Read) == false)
+            {
+                StatusLogPost("Serv - Listen - client socket setup failed", StatusLogSeverity::StatusLogSeverity_Error);
+                CloseSocket(ClientSocket);
+                continue;
+            }
+
+            StatusLogPost("Serv-Listen - Accepted message - Proceeding to recieve data", StatusLogSeverity::StatusLogSeverity_Log);
+            ReceiveDataTickInfo& ReceiveTickInfo = RegisterClientSocket(ClientSocket, OnReceiveFinished);
+
+            // Data may have landed before the socket was registered, edge triggering won't report it again
+            HandleSocketDataReceive(ClientSocket, ReceiveTickInfo);
+        }
+    }
+
+    ReceiveDataTickInfo& ListenServerWorker::RegisterClientSocket(SOCKET ClientSocket, const std::function<void(SOCKET, bool)>& OnReceiveFinished)
+    {
+        using namespace std::placeholders;
+
+        ReceiveDataTickInfo& ReceiveTickInfo = mSocketsReceivingData.Acquire(ClientSocket);
+        BuildReceiveTickInfo(ReceiveTickInfo, ClientSocket, std::bind(&ListenServerWorker::HandleServerRequest, this, _1, _2, _3), OnReceiveFinished, mServer.mUrlData, mSendData, mTimerWheel, mServer.mConfig);
+        return ReceiveTickInfo;
+    }
+
+    void ListenServerWorker::ClearFinishedSockets(std::vector<std::pair<ConnectionId, bool>>& SocketsFinishedReceiving)
+    {
+        for(auto SocketCloseDetails : SocketsFinishedReceiving)
+        {
+            SOCKET Socket = SocketCloseDetails.first.Socket;
+            bool KeepSocketAlive = SocketCloseDetails.second;
+
+            // A socket can finish more than once in a tick (eg error then timeout), the first removal makes the rest stale
+            ReceiveDataTickInfo* ReceiveTickInfo = mSocketsReceivingData.Find(SocketCloseDetails.first);
+            if(ReceiveTickInfo == nullptr)
+            {
+                continue;
+            }
+
+            RemoveReceiveTickInfo(SocketCloseDetails.first);
+
+            SendDataTickInfo* SendTickInfo = mSocketsSendingData.Find(Socket);
+            if(KeepSocketAlive)
+            {
+                // Handed off, the new owner sends directly (anything queued was drained before the hand off)
+                if(SendTickInfo != nullptr)
+                {
+                    mTimerWheel.RemoveTimer(SendTickInfo->SendTimeoutTimer);
+                    mSocketsSendingData.Remove(mSocketsSendingData.GetId(Socket));
+                }
+                if(bUseIoUring == false)
+                {
+                    mSocketPoller.RemoveSocket(Socket);
+                }
+                continue;
+            }
+
+            // Whatever the client hasn't taken yet goes out before the socket closes
+            if(SendTickInfo != nullptr && SendTickInfo->SendQueue.IsEmpty() == false)
+            {
+                SendTickInfo->bCloseWhenFlushed = true;
+                continue;
+            }
+
+            CloseConnection(Socket);
+        }
+        SocketsFinishedReceiving.clear();
+    }
+
+    bool ListenServerWorker::QueueResponseData(SOCKET ClientSocket, const char* Data, int DataLen, bool bPersistentData)
+    {
+        if(DataLen <= 0)
+        {
+            return true;
+        }
+
+        SendDataTickInfo& SendTickInfo = mSocketsSendingData.Acquire(ClientSocket);
+        if(SendTickInfo.SendTimeoutTimer.IsValid() == false)
+        {
+            SendTickInfo.SendTimeoutTimer = mTimerWheel.AddTimer([this, ClientSocket] () {
+                StatusLogPost("send - Timed out", StatusLogSeverity::StatusLogSeverity_Error);
+                AbortConnection(ClientSocket);
+                });
+        }
+
+        // A socket waiting on write readiness is flushed when it comes
+        if(SendTickInfo.SendQueue.IsEmpty() && SendTickInfo.bAwaitingWritable == false)
+        {
+            mSocketsToFlush.push_back(ClientSocket);
+        }
+        SendTickInfo.SendQueue.Push(Data, DataLen, bPersistentData);
+
+        // Hold back the connection's remaining requests until the client catches up
+        if(GetPendingSendBytes(ClientSocket) > mServer.mConfig.MaxPendingSendBytes)
+        {
+            ReceiveDataTickInfo* ReceiveTickInfo = mSocketsReceivingData.Find(ClientSocket);
+            if(ReceiveTickInfo != nullptr && ReceiveTickInfo->bReceivePaused == false)
+            {
+                ReceiveTickInfo->bReceivePaused = true;
+                mPausedReceives.push_back(mSocketsReceivingData.GetId(ClientSocket));
+            }
+        }
+        return true;
+    }
+
+    void ListenServerWorker::FlushQueuedSends()
+    {
+        for(SOCKET ClientSocket : mSocketsToFlush)
+        {
+            SendDataTickInfo* SendTickInfo = mSocketsSendingData.Find(ClientSocket);
+            if(SendTickInfo == nullptr)
+            {
+                continue;
+            }
+
+            if(bUseIoUring == false)
+            {
+                FlushSendQueue(ClientSocket, *SendTickInfo);
+                continue;
+            }
+
+            // The engine keeps a socket's sends in order and finishes short ones itself, hand it everything in as few sendmsgs as possible
+            constexpr int MaxBuffersPerSend = 64;
+            SocketSendBuffer SendBuffers[MaxBuffersPerSend];
+            while(SendTickInfo->SendQueue.IsEmpty() == false)
+            {
+                int NumBuffers = SendTickInfo->SendQueue.GatherBuffers(SendBuffers, MaxBuffersPerSend);
+                mIoUringEngine.QueueSend(ClientSocket, SendBuffers, NumBuffers);
+
+                size_t QueuedBytes = 0;
+                for(int i = 0; i < NumBuffers; i++)
+                {
+                    QueuedBytes += (size_t) SendBuffers[i].DataLen;
+                }
+                SendTickInfo->SendQueue.Consume(QueuedBytes);
+            }
+        }
+        mSocketsToFlush.clear();
+    }
+
+    void ListenServerWorker::FlushSendQueue(SOCKET ClientSocket, SendDataTickInfo& SendTickInfo)
+    {
+        SocketSendResult Result = SendTickInfo.SendQueue.Flush(ClientSocket);
+        if(Result == SocketSendResult::SocketSendResult_Error)
+        {
+            StatusLogPost("send - failed", StatusLogSeverity::StatusLogSeverity_Error);
+            AbortConnection(ClientSocket);
+            return;
+        }
+
+        if(Result == SocketSendResult::SocketSendResult_WouldBlock)
+        {
+            // The client has SendTimeoutMs from its last progress to take more
+            mTimerWheel.Arm(SendTickInfo.SendTimeoutTimer, SendTimeoutMs);
+            if(SendTickInfo.bAwaitingWritable == false)
+            {
+                SendTickInfo.bAwaitingWritable = true;
+                mSocketPoller.ModifySocket(ClientSocket, SocketPollEvent_Read | SocketPollEvent_Write);
+            }
+            return;
+        }
+
+        mTimerWheel.Cancel(SendTickInfo.SendTimeoutTimer);
+        if(SendTickInfo.bAwaitingWritable)
+        {
+            SendTickInfo.bAwaitingWritable = false;
+            mSocketPoller.ModifySocket(ClientSocket, SocketPollEvent_Read);
+        }
+
+        if(SendTickInfo.bCloseWhenFlushed)
+        {
+            CloseConnection(ClientSocket);
+        }
+    }
+
+    size_t ListenServerWorker::GetPendingSendBytes(SOCKET ClientSocket)
+    {
+        SendDataTickInfo* SendTickInfo = mSocketsSendingData.Find(ClientSocket);
+        size_t PendingBytes = (SendTickInfo != nullptr) ? SendTickInfo->SendQueue.GetQueuedBytes() : 0;
+        return PendingBytes + (bUseIoUring ? mIoUringEngine.GetPendingSendBytes(ClientSocket) : 0);
+    }
+
+    bool ListenServerWorker::ResumeDrainedReceives()
+    {
+        bool bResumedAny = false;
+        for(size_t i = 0; i < mPausedReceives.size();)
+        {
+            ConnectionId PausedId = mPausedReceives[i];
+            ReceiveDataTickInfo* ReceiveTickInfo = mSocketsReceivingData.Find(PausedId);
+            if(ReceiveTickInfo != nullptr && GetPendingSendBytes(PausedId.Socket) > mServer.mConfig.MaxPendingSendBytes)
+            {
+                i++;
+                continue;
+            }
+
+            mPausedReceives[i] = mPausedReceives.back();
+            mPausedReceives.pop_back();
+            if(ReceiveTickInfo == nullptr || ReceiveTickInfo->bReceiveFinished)
+            {
+                continue;
+            }
+
+            // Answer the requests that were held back, then read on from where the socket was left
+            ReceiveTickInfo->bReceivePaused = false;
+            bResumedAny = true;
+            if(ReceiveTickInfo->ReceiveDataStream.GetDataLen() > 0)
+            {
+                ReceiveTickInfo->MessageRecievedCallback(0);
+            }
+            else
+            {
+                mTimerWheel.Arm(ReceiveTickInfo->ReceiveTimeoutTimer, mServer.mConfig.KeepAliveIdleTimeoutMs);
+            }
+
+            // Edge triggering won't report data that arrived while paused again
+            if(bUseIoUring == false && ReceiveTickInfo->bReceivePaused == false && ReceiveTickInfo->bReceiveFinished == false)
+            {
+                HandleSocketDataReceive(PausedId.Socket, *ReceiveTickInfo);
+            }
+        }
+        return bResumedAny;
+    }
+
+    void ListenServerWorker::CloseConnection(SOCKET ClientSocket)
+    {
+        SendDataTickInfo* SendTickInfo = mSocketsSendingData.Find(ClientSocket);
+        if(SendTickInfo != nullptr)
+        {
+            mTimerWheel.RemoveTimer(SendTickInfo->SendTimeoutTimer);
+            mSocketsSendingData.Remove(mSocketsSendingData.GetId(ClientSocket));
+        }
+
+        if(bUseIoUring)
+        {
+            mIoUringEngine.QueueClose(ClientSocket);
+            return;
+        }
+
+        mSocketPoller.RemoveSocket(ClientSocket);
+        ShutdownSocketSend(ClientSocket);
+        CloseSocket(ClientSocket);
+    }
+
+    void ListenServerWorker::AbortConnection(SOCKET ClientSocket)
+    {
+        // Never called from inside a connection's receive callbacks, its record can go straight away
+        if(mSocketsReceivingData.Find(ClientSocket) != nullptr)
+        {
+            RemoveReceiveTickInfo(mSocketsReceivingData.GetId(ClientSocket));
+        }
+        CloseConnection(ClientSocket);
+    }
+
+    void ListenServerWorker::RemoveReceiveTickInfo(ConnectionId Id)
+    {
+        ReceiveDataTickInfo* ReceiveTickInfo = mSocketsReceivingData.Find(Id);
+        if(ReceiveTickInfo->bReadingBody && ReceiveTickInfo->BodyAbortedCallback)
+        {
+            ReceiveTickInfo->BodyAbortedCallback();
+        }
+
+        mTimerWheel.RemoveTimer(ReceiveTickInfo->ReceiveTimeoutTimer);
+        mTimerWheel.RemoveTimer(ReceiveTickInfo->AwaitingDataTimer);
+        mSocketsReceivingData.Remove(Id);
+    }
+
+    RequestConnectionAction ListenServerWorker::HandleServerRequest(SOCKET ClientSocket, ServerRequestMessage& RequestMessage, ConnectionPersistence Persistence)
+    {
+        const ServerRoute* Route = mServer.FindRoute(RequestMessage.mRequestType, RequestMessage.mUrl, RequestMessage.mUrlHash, RequestMessage.mRouteParams);
+        if(Route != nullptr && (Route->DynamicHandler || Route->DeferredHandler))
+        {
+            return HandleDynamicRequest(ClientSocket, RequestMessage, *Route, Persistence);
+        }
+        if(Route != nullptr && Route->CoroutineHandler)
+        {
+            return HandleCoroutineRequest(ClientSocket, RequestMessage, Route->CoroutineHandler, Persistence);
+        }
+
+        // Anything but a GET needs a handler for its url. Without one the body isn't read, so the connection can't be reused
+        if(RequestMessage.mRequestType != ServerRequestType::ServerRequestType_GET)
+        {
+            if(RequestMessage.mRequestType == ServerRequestType::ServerRequestType_Invalid || Route == nullptr)
+            {
+                SendServerStatusResponse(ClientSocket, "Response - failed: 501 Request Not Implemented", ServerResponseStatusCode::ServerResponseStatusCode_501, mServer.mUrlData, mSendData);
+                return RequestConnectionAction::RequestConnectionAction_Close;
+            }
+            return HandleRequestWithBody(ClientSocket, RequestMessage, Route->Handler, Persistence);
+        }
+
+        // Whatever's published right now, no lock. Its generation's pinned until the page has gone out of the socket
+        const ContentSnapshot& Content = mServer.mContent.GetSnapshot();
+        const ContentEntry* Entry = Content.Find(RequestMessage.mUrl, RequestMessage.mUrlHash, RequestMessage.mRouteParams);
+        if(Entry == nullptr)
+        {
+            SendServerStatusResponse(ClientSocket, "Response - failed: 404 Page Not Found\n", ServerResponseStatusCode::ServerResponseStatusCode_404, mServer.mUrlData, mSendData, Persistence);
+            return RequestConnectionAction::RequestConnectionAction_KeepAlive;
+        }
+
+        if(Entry->bWebSocket)
+        {
+            if(RequestMessage.CheckHeaderValue(HttpHeader::HttpHeader_Connection, "Upgrade") && RequestMessage.CheckHeaderValue(HttpHeader::HttpHeader_Upgrade, "websocket"))
+            {
+                StatusLogPost("Response - Success - Web socket upgrade requested", StatusLogSeverity::StatusLogSeverity_Log);
+                HandleWebSocketRequest(ClientSocket, RequestMessage, Entry->Url);
+                return RequestConnectionAction::RequestConnectionAction_HandedOff;
+            }
+
+            SendServerStatusResponse(ClientSocket, "Response - failed: 400 Web socket url without an upgrade", ServerResponseStatusCode::ServerResponseStatusCode_400, mServer.mUrlData, mSendData, Persistence);
+            return RequestConnectionAction::RequestConnectionAction_KeepAlive;
+        }
+
+        StatusLogPost("Response - Success - Proceeding to send reply", StatusLogSeverity::StatusLogSeverity_Log);
+
+        SendServerResponseMessage(ClientSocket, *Entry->Page, mSendData, Persistence);
+        mContentPins.emplace_back(ClientSocket, Content.GetGeneration());
+        return RequestConnectionAction::RequestConnectionAction_KeepAlive;
+    }
+
+    RequestConnectionAction ListenServerWorker::HandleRequestWithBody(SOCKET ClientSocket, const ServerRequestMessage& RequestMessage, const RequestHandler& Handler,
+        ConnectionPersistence Persistence)
+    {
+        // Handlers are registered before the server starts and never move, the callbacks below can hold on to this one
+        const uint64_t RequestId = mServer.mNextRequestId++;
+        if(Handler.OnRequestStart && Handler.OnRequestStart(RequestId, RequestMessage) == false)
+        {
+            SendServerStatusResponse(ClientSocket, "Response - failed: 403 Request refused by handler", ServerResponseStatusCode::ServerResponseStatusCode_403, mServer.mUrlData, mSendData);
+            return RequestConnectionAction::RequestConnectionAction_Close;
+        }
+
+        // Too big to spool is known up front when the length's given, a chunked body finds out as it goes
+        const ListenServerConfig& Config = mServer.mConfig;
+        if(Handler.OnBodySpooled && RequestMessage.GetContentLength() > Config.MaxSpooledBodyBytes)
+        {
+            if(Handler.OnRequestAborted) { Handler.OnRequestAborted(RequestId); }
+            SendServerStatusResponse(ClientSocket, "Response - failed: 413 Request body too large", ServerResponseStatusCode::ServerResponseStatusCode_413, mServer.mUrlData, mSendData);
+            return RequestConnectionAction::RequestConnectionAction_Close;
+        }
+
+        // A handler taking parts can only be given a multipart body
+        std::string_view ContentType;
+        std::string_view Boundary;
+        const bool bMultipartBody = Handler.OnPartStart && RequestMessage.mHeaders.Find(HttpHeader::HttpHeader_ContentType, ContentType) && MultipartParser::FindBoundary(ContentType, Boundary);
+        if(Handler.OnPartStart && bMultipartBody == false)
+        {
+            if(Handler.OnRequestAborted) { Handler.OnRequestAborted(RequestId); }
+            SendServerStatusResponse(ClientSocket, "Response - failed: 400 Expected a multipart body", ServerResponseStatusCode::ServerResponseStatusCode_400, mServer.mUrlData, mSendData);
+            return RequestConnectionAction::RequestConnectionAction_Close;
+        }
+
+        SendContinueIfExpected(ClientSocket, RequestMessage, mServer.mUrlData, mSendData);
+
+        ReceiveDataTickInfo* ReceiveTickInfo = mSocketsReceivingData.Find(ClientSocket);
+        std::shared_ptr<SpooledRequestBody> BodySpool;
+        std::shared_ptr<MultipartParser> BodyParts;
+        if(bMultipartBody)
+        {
+            BodyParts = std::make_shared<MultipartParser>();
+            BodyParts->Start(Boundary,
+                [&Handler, RequestId] (const MultipartPart& Part) { Handler.OnPartStart(RequestId, Part); return true; },
+                [&Handler, RequestId] (const char* Data, int DataLen) { if(Handler.OnPartData) { Handler.OnPartData(RequestId, Data, DataLen); } return true; },
+                [&Handler, RequestId] () { if(Handler.OnPartEnd) { Handler.OnPartEnd(RequestId); } return true; });
+            ReceiveTickInfo->BodyDataCallback = [BodyParts] (const char* Data, int DataLen) { return BodyParts->Feed(Data, DataLen); };
+        }
+        else if(Handler.OnBodySpooled)
+        {
+            BodySpool = std::make_shared<SpooledRequestBody>();
+            BodySpool->Start(Config.BodySpoolMemoryBytes, Config.MaxSpooledBodyBytes, Config.BodySpoolDirectory);
+            ReceiveTickInfo->BodyDataCallback = [BodySpool] (const char* Data, int DataLen) { return BodySpool->Append(Data, DataLen); };
+        }
+        else if(Handler.OnBodyData)
+        {
+            ReceiveTickInfo->BodyDataCallback = [&Handler, RequestId] (const char* Data, int DataLen) { Handler.OnBodyData(RequestId, Data, DataLen); return true; };
+        }
+
+        ReceiveTickInfo->BodyAbortedCallback = [&Handler, RequestId] () {
+            StatusLogPost("recv - Connection lost part way through a request body", StatusLogSeverity::StatusLogSeverity_Error);
+            if(Handler.OnRequestAborted) { Handler.OnRequestAborted(RequestId); }
+            };
+
+        ReceiveTickInfo->BodyFinishedCallback = [this, ClientSocket, &Handler, RequestId, Persistence, BodySpool, BodyParts] (RequestBodyState BodyState) {
+            // A multipart body that breaks off before its last boundary is as malformed as a bad chunk. The spool refuses
+            // the rest of a body once it's gone over the limit or couldn't be written
+            const bool bBodyMalformed = BodyState == RequestBodyState::RequestBodyState_Malformed || (BodyParts && BodyParts->IsComplete() == false);
+            const bool bSpoolFailed = BodySpool && (BodyState == RequestBodyState::RequestBodyState_Refused || BodySpool->Finish() == false);
+            if(bBodyMalformed || bSpoolFailed || (BodySpool == nullptr && Handler.OnRequestComplete == nullptr))
+            {
+                if(Handler.OnRequestAborted) { Handler.OnRequestAborted(RequestId); }
+                ServerResponseStatusCode StatusCode = ServerResponseStatusCode::ServerResponseStatusCode_500;
+                if(bBodyMalformed)
+                {
+                    StatusCode = ServerResponseStatusCode::ServerResponseStatusCode_400;
+                }
+                else if(bSpoolFailed && BodySpool->IsOverLimit())
+                {
+                    StatusCode = ServerResponseStatusCode::ServerResponseStatusCode_413;
+                }
+                SendServerStatusResponse(ClientSocket, "Response - failed: request body not handled", StatusCode, mServer.mUrlData, mSendData);
+                return RequestConnectionAction::RequestConnectionAction_Close;
+            }
+
+            // Built for this request alone, so it's queued as a copy rather than sent from persistent data
+            ServerResponseMessage ResponseMessage = BodySpool ? Handler.OnBodySpooled(RequestId, *BodySpool) : Handler.OnRequestComplete(RequestId);
+            if(ResponseMessage.mHeaders.Find(HttpHeader::HttpHeader_ContentLength) == nullptr)
+            {
+                ResponseMessage.mHeaders.Add("Content-Length", "0");
+            }
+            ResponseMessage.BuildMessage();
+
+            StatusLogPost("Response - Success - Request body handled", StatusLogSeverity::StatusLogSeverity_Log);
+            SendServerResponseMessage(ClientSocket, ResponseMessage, mSendData, Persistence, false);
+            return (Persistence == ConnectionPersistence::ConnectionPersistence_Close) ? RequestConnectionAction::RequestConnectionAction_Close : RequestConnectionAction::RequestConnectionAction_KeepAlive;
+            };
+
+        return RequestConnectionAction::RequestConnectionAction_AwaitingBody;
+    }
+
+    void ListenServerWorker::HandleWebSocketRequest(SOCKET ClientSocket, const ServerRequestMessage& RequestMessage, const std::string& WebSocketUrl)
+    {
+        using namespace std::placeholders;
+
+        // The web socket thread owns the socket from here, stop the engine reading from it and get the handshake out before the thread starts
+        if(bUseIoUring)
+        {
+            mIoUringEngine.StopReceive(ClientSocket);
+        }
+
+        // Anything answered before the upgrade on this connection goes out ahead of the handshake
+        SendDataTickInfo* SendTickInfo = mSocketsSendingData.Find(ClientSocket);
+        if(bUseIoUring)
+        {
+            FlushQueuedSends();
+        }
+        else if(SendTickInfo != nullptr)
+        {
+            // The web socket thread sends directly from here on, so wait out whatever the client hasn't taken yet
+            while(SendTickInfo->SendQueue.Flush(ClientSocket) == SocketSendResult::SocketSendResult_WouldBlock && WaitSocketWritable(ClientSocket, SendTimeoutMs)) {}
+            SendTickInfo->SendQueue.Clear();
+        }
+
+        ServerResponseMessage wsAcceptResponse = BuildWSHandshakeAcceptResponse(RequestMessage, mServer.mUrlData.find("websocket-success-base")->second);
+        SendServerResponseMessage(ClientSocket, wsAcceptResponse, DirectSendData, ConnectionPersistence::ConnectionPersistence_KeepAlive, false);
+
+        WebSocketHandle& wsHandle = mActiveWebSockets.Acquire(ClientSocket);
+        WebSocketSendDataFunc wsPushMessageFunction = std::bind(&WebSocketHandle::AddMessageToSendQueue, &wsHandle, _1, _2, _3);
+        
+        uint64_t wsClientId = (uint64_t) ClientSocket;
+        WebSocketReceiveDataCallBack wsReceiveDataCallback;
+        WebSocketClientJoinedCallback wsClientJoinedCallback;
+        {
+            // Workers share the web socket info, the api thread reads it to send
+            std::lock_guard<std::mutex> WebSocketsInfoLock(mServer.mWebSocketsInfoMutex);
+            WebSocketInfo& wsInfo = mServer.mWebSocketsInfo.find(WebSocketUrl)->second;
+            wsInfo.SendDataFunctions[wsClientId] = wsPushMessageFunction;
+            wsReceiveDataCallback = wsInfo.RecieveDataCallbackFunction;
+            wsClientJoinedCallback = wsInfo.ClientJoinedCallback;
+        }
+
+        wsHandle.StartWebSocketThread(ClientSocket, wsReceiveDataCallback);
+        wsClientJoinedCallback(WebSocketUrl, wsClientId);
+    }
+
+    RequestConnectionAction ListenServerWorker::HandleDynamicRequest(SOCKET ClientSocket, const ServerRequestMessage& RequestMessage, const ServerRoute& Route,
+        ConnectionPersistence Persistence)
+    {
+        std::shared_ptr<HandlerRequest> Request = std::make_shared<HandlerRequest>();
+        Request->RequestId = mServer.mNextRequestId++;
+        CopyHandlerRequest(RequestMessage, *Request);
+
+        if(RequestMessage.HasBody() == false)
+        {
+            StartDynamicRequest(ClientSocket, std::move(Request), Route, Persistence);
+            return RequestConnectionAction::RequestConnectionAction_AwaitingResponse;
+        }
+
+        // Spooled whole first, the handler only runs once there's all of it
+        const ListenServerConfig& Config = mServer.mConfig;
+        if(RequestMessage.GetContentLength() > Config.MaxSpooledBodyBytes)
+        {
+            SendServerStatusResponse(ClientSocket, "Response - failed: 413 Request body too large", ServerResponseStatusCode::ServerResponseStatusCode_413, mServer.mUrlData, mSendData);
+            return RequestConnectionAction::RequestConnectionAction_Close;
+        }
+
+        SendContinueIfExpected(ClientSocket, RequestMessage, mServer.mUrlData, mSendData);
+
+        Request->Body.Start(Config.BodySpoolMemoryBytes, Config.MaxSpooledBodyBytes, Config.BodySpoolDirectory);
+        ReceiveDataTickInfo* ReceiveTickInfo = mSocketsReceivingData.Find(ClientSocket);
+        ReceiveTickInfo->BodyDataCallback = [Request] (const char* Data, int DataLen) { return Request->Body.Append(Data, DataLen); };
+        ReceiveTickInfo->BodyAbortedCallback = [] () { StatusLogPost("recv - Connection lost part way through a request body", StatusLogSeverity::StatusLogSeverity_Error); };
+        ReceiveTickInfo->BodyFinishedCallback = [this, ClientSocket, Request, &Route, Persistence] (RequestBodyState BodyState) {
+            const bool bBodyMalformed = BodyState == RequestBodyState::RequestBodyState_Malformed;
+            if(bBodyMalformed || BodyState == RequestBodyState::RequestBodyState_Refused || Request->Body.Finish() == false)
+            {
+                ServerResponseStatusCode StatusCode = ServerResponseStatusCode::ServerResponseStatusCode_500;
+                if(bBodyMalformed)
+                {
+                    StatusCode = ServerResponseStatusCode::ServerResponseStatusCode_400;
+                }
+                else if(Request->Body.IsOverLimit())
+                {
+                    StatusCode = ServerResponseStatusCode::ServerResponseStatusCode_413;
+                }
+                SendServerStatusResponse(ClientSocket, "Response - failed: request body not read", StatusCode, mServer.mUrlData, mSendData);
+                return RequestConnectionAction::RequestConnectionAction_Close;
+            }
+
+            StartDynamicRequest(ClientSocket, Request, Route, Persistence);
+            return RequestConnectionAction::RequestConnectionAction_AwaitingResponse;
+            };
+
+        return RequestConnectionAction::RequestConnectionAction_AwaitingBody;
+    }
+
+    void ListenServerWorker::StartDynamicRequest(SOCKET ClientSocket, std::shared_ptr<HandlerRequest> Request, const ServerRoute& Route, ConnectionPersistence Persistence)
+    {
+        // Parked, whatever's pipelined behind the request waits in the receive stream for its response
+        ReceiveDataTickInfo* ReceiveTickInfo = mSocketsReceivingData.Find(ClientSocket);
+        ReceiveTickInfo->bReceivePaused = true;
+        ReceiveTickInfo->AwaitingResponseId = Request->RequestId;
+        const ConnectionId Connection = mSocketsReceivingData.GetId(ClientSocket);
+
+        // Called right here, the token answers the request from wherever the handler passes it on to
+        if(Route.DeferredHandler)
+        {
+            ResponseToken Token;
+            Token.mState = std::make_shared<DeferredResponseState>();
+            Token.mState->Target = mResponseTarget;
+            Token.mState->Connection = Connection;
+            Token.mState->RequestId = Request->RequestId;
+            Token.mState->Persistence = Persistence;
+            try
+            {
+                Route.DeferredHandler(*Request, Token);
+            }
+            catch(...)
+            {
+                LogHandlerException();
+                Token.Complete(BuildBasicStatusResponse(ServerResponseStatusCode::ServerResponseStatusCode_500));
+            }
+            return;
+        }
+
+        // Routes never move once the server's running, the job can hold on to the callback
+        const DynamicRequestCallback& Callback = Route.DynamicHandler;
+        mServer.mHandlerPool.QueueJob([Target = mResponseTarget, Connection, Request, &Callback, Persistence] () {
+            std::unique_ptr<ServerResponseMessage> Response;
+            try
+            {
+                Response = std::make_unique<ServerResponseMessage>(Callback(*Request));
+                FinishHandlerResponse(*Response);
+            }
+            catch(...)
+            {
+                LogHandlerException();
+                Response = std::make_unique<ServerResponseMessage>(BuildBasicStatusResponse(ServerResponseStatusCode::ServerResponseStatusCode_500));
+            }
+            Target->Post(Connection, Request->RequestId, std::move(Response), Persistence);
+            });
+    }
+
+    RequestConnectionAction ListenServerWorker::HandleCoroutineRequest(SOCKET ClientSocket, const ServerRequestMessage& RequestMessage, const CoroutineRequestCallback& Callback,
+        ConnectionPersistence Persistence)
+    {
+        // The task belongs to the connection, if the client goes first the task goes with it wherever it's suspended
+        ReceiveDataTickInfo* ReceiveTickInfo = mSocketsReceivingData.Find(ClientSocket);
+        ReceiveTickInfo->ActiveTask = std::make_unique<RequestContext>(*this, mSocketsReceivingData.GetId(ClientSocket), Persistence);
+        RequestContext& Context = *ReceiveTickInfo->ActiveTask;
+        Context.mRequest.RequestId = mServer.mNextRequestId++;
+        CopyHandlerRequest(RequestMessage, Context.mRequest);
+
+        const bool bHasBody = RequestMessage.HasBody();
+        if(bHasBody)
+        {
+            // Streamed to the task as it reads it, the connection's parked once it's all in if the task's still going
+            SendContinueIfExpected(ClientSocket, RequestMessage, mServer.mUrlData, mSendData);
+            Context.mBodyState = RequestBodyState::RequestBodyState_Reading;
+            ReceiveTickInfo->BodyDataCallback = [&Context] (const char* Data, int DataLen) { return Context.OnBodyData(Data, DataLen); };
+            ReceiveTickInfo->BodyAbortedCallback = [] () { StatusLogPost("recv - Connection lost part way through a request body", StatusLogSeverity::StatusLogSeverity_Error); };
+            ReceiveTickInfo->BodyFinishedCallback = [ReceiveTickInfo, &Context] (RequestBodyState BodyState) {
+                // A body that went wrong leaves nothing after it to trust
+                if(BodyState != RequestBodyState::RequestBodyState_Complete)
+                {
+                    Context.mPersistence = ConnectionPersistence::ConnectionPersistence_Close;
+                }
+                Context.OnBodyFinished(BodyState);
+
+                if(Context.bFinished)
+                {
+                    const bool bClose = Context.mPersistence == ConnectionPersistence::ConnectionPersistence_Close;
+                    ReceiveTickInfo->ActiveTask.reset();
+                    return bClose ? RequestConnectionAction::RequestConnectionAction_Close : RequestConnectionAction::RequestConnectionAction_KeepAlive;
+                }
+
+                ReceiveTickInfo->bReceivePaused = true;
+                ReceiveTickInfo->AwaitingResponseId = Context.mRequest.RequestId;
+                return RequestConnectionAction::RequestConnectionAction_AwaitingResponse;
+                };
+        }
+        else
+        {
+            // Parked before the task starts, it may well be done by the time it first suspends
+            ReceiveTickInfo->bReceivePaused = true;
+            ReceiveTickInfo->AwaitingResponseId = Context.mRequest.RequestId;
+        }
+
+        try
+        {
+            Context.mTask = Callback(Context);
+        }
+        catch(...)
+        {
+            LogHandlerException();
+        }
+        Context.Resume();
+
+        return bHasBody ? RequestConnectionAction::RequestConnectionAction_AwaitingBody : RequestConnectionAction::RequestConnectionAction_AwaitingResponse;
+    }
+
+    void ListenServerWorker::FinishRequestTask(RequestContext& Context)
+    {
+        Context.bFinished = true;
+        const SOCKET ClientSocket = Context.mConnection.Socket;
+
+        bool bThrew = false;
+        if(Context.mTask.mHandle && Context.mTask.mHandle.promise().Exception)
+        {
+            bThrew = true;
+            try
+            {
+                std::rethrow_exception(Context.mTask.mHandle.promise().Exception);
+            }
+            catch(...)
+            {
+                LogHandlerException();
+            }
+        }
+
+        // A response cut short can't be told apart from a whole one but by the connection closing
+        if(Context.bResponseStarted == false)
+        {
+            SendServerStatusResponse(ClientSocket, "Response - failed: 500 Coroutine handler finished without answering", ServerResponseStatusCode::ServerResponseStatusCode_500,
+                mServer.mUrlData, mSendData, Context.mPersistence);
+            Context.bResponseStarted = true;
+        }
+        else if(bThrew && Context.bStreaming)
+        {
+            Context.mPersistence = ConnectionPersistence::ConnectionPersistence_Close;
+        }
+        else if(Context.bStreaming)
+        {
+            static const char LastChunk[] = "0\r\n\r\n";
+            mSendData(ClientSocket, LastChunk, (int) sizeof(LastChunk) - 1, true);
+        }
+
+        // Any more of the body is read past and dropped
+        Context.mBodyBuffer = std::string();
+        if(Context.bBodyPaused)
+        {
+            Context.bBodyPaused = false;
+            mPausedReceives.push_back(Context.mConnection);
+        }
+
+        // Still reading the body, it's finished with that instead
+        ReceiveDataTickInfo* ReceiveTickInfo = mSocketsReceivingData.Find(Context.mConnection);
+        if(ReceiveTickInfo != nullptr && ReceiveTickInfo->AwaitingResponseId == Context.mRequest.RequestId)
+        {
+            CompleteResponse(Context.mConnection, Context.mRequest.RequestId, nullptr, Context.mPersistence);
+        }
+    }
+
+    void ListenServerWorker::CompleteResponse(ConnectionId Connection, uint64_t RequestId, std::unique_ptr<ServerResponseMessage> Response, ConnectionPersistence Persistence)
+    {
+        HandlerResponse Completed;
+        Completed.Connection = Connection;
+        Completed.RequestId = RequestId;
+        Completed.Response = std::move(Response);
+        Completed.Persistence = Persistence;
+        mHandlerResponses.Push(std::move(Completed));
+
+        // The loop sends what's completed on it before it next waits
+        if(std::this_thread::get_id() != mListenThread.get_id())
+        {
+            WakeLoop();
+        }
+    }
+
+    void ListenServerWorker::SendHandlerResponses(const std::function<void(SOCKET, bool)>& OnReceiveFinished)
+    {
+        HandlerResponse Response;
+        while(mHandlerResponses.Pop(Response))
+        {
+            // The client may have gone while its handler ran, the socket possibly reused since
+            ReceiveDataTickInfo* ReceiveTickInfo = mSocketsReceivingData.Find(Response.Connection);
+            if(ReceiveTickInfo == nullptr || ReceiveTickInfo->AwaitingResponseId != Response.RequestId || ReceiveTickInfo->bReceiveFinished)
+            {
+                continue;
+            }
+
+            const SOCKET ClientSocket = Response.Connection.Socket;
+            ReceiveTickInfo->AwaitingResponseId = 0;
+            ReceiveTickInfo->ActiveTask.reset();
+            if(Response.Response != nullptr)
+            {
+                StatusLogPost("Response - Success - Dynamic handler finished", StatusLogSeverity::StatusLogSeverity_Log);
+                SendServerResponseMessage(ClientSocket, *Response.Response, mSendData, Response.Persistence, false);
+            }
+
+            if(Response.Persistence == ConnectionPersistence::ConnectionPersistence_Close)
+            {
+                ReceiveTickInfo->bReceiveFinished = true;
+                OnReceiveFinished(ClientSocket, false);
+                continue;
+            }
+
+            // Still paused, the next request is picked up once this response has drained
+            mPausedReceives.push_back(Response.Connection);
+        }
+    }
+
+    bool ListenServerWorker::ResumeDrainedWriters()
+    {
+        bool bResumedAny = false;
+        for(size_t i = 0; i < mBlockedWriters.size();)
+        {
+            const ConnectionId WriterId = mBlockedWriters[i];
+            ReceiveDataTickInfo* ReceiveTickInfo = mSocketsReceivingData.Find(WriterId);
+            RequestContext* Task = (ReceiveTickInfo != nullptr) ? ReceiveTickInfo->ActiveTask.get() : nullptr;
+            const bool bWaiting = Task != nullptr && Task->mWait == RequestContext::TaskWait::TaskWait_Write;
+            if(bWaiting && GetPendingSendBytes(WriterId.Socket) > mServer.mConfig.MaxPendingSendBytes)
+            {
+                i++;
+                continue;
+            }
+
+            mBlockedWriters[i] = mBlockedWriters.back();
+            mBlockedWriters.pop_back();
+            if(bWaiting)
+            {
+                Task->Resume();
+                bResumedAny = true;
+            }
+        }
+        return bResumedAny;
+    }
+
+    bool ListenServerWorker::HasDrainedWriters()
+    {
+        for(const ConnectionId& WriterId : mBlockedWriters)
+        {
+            if(GetPendingSendBytes(WriterId.Socket) <= mServer.mConfig.MaxPendingSendBytes)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void ListenServerWorker::WakeLoop()
+    {
+        if(bUseIoUring)
+        {
+            mIoUringEngine.Wake();
+        }
+        else
+        {
+            mSocketPoller.Wake();
+        }
+    }
+
+    void ListenServerWorker::ReportContentInUse()
+    {
+        // Read before going through the pins, anything this loop looks at next is at least this new
+        uint64_t OldestInUse = mServer.mContent.GetGeneration();
+        for(size_t i = 0; i < mContentPins.size();)
+        {
+            if(GetPendingSendBytes(mContentPins[i].first) == 0)
+            {
+                mContentPins[i] = mContentPins.back();
+                mContentPins.pop_back();
+                continue;
+            }
+            OldestInUse = std::min(OldestInUse, mContentPins[i].second);
+            i++;
+        }
+        mContentReader->store(OldestInUse, std::memory_order_seq_cst);
+
+        // Commits free what they can, but they might have stopped while this worker held the last of it
+        if(mServer.mContent.HasRetired())
+        {
+            mServer.mContent.TryReclaim();
+        }
+    }
+
+#pragma endregion   //ListenServerWorker
+
+#pragma region HandlerRequest
+
+    std::string_view HandlerRequest::FindHeader(std::string_view Name) const
+    {
+        for(const auto& Header : Headers)
+        {
+            if(EqualsIgnoreCase(Header.first, Name))
+            {
+                return Header.second;
+            }
+        }
+        return {};
+    }
+
+    std::string_view HandlerRequest::FindParam(std::string_view Name) const
+    {
+        for(const auto& Param : Params)
+        {
+            if(Param.first == Name)
+            {
+                return Param.second;
+            }
+        }
+        return {};
+    }
+
+#pragma endregion   //HandlerRequest
+
+#pragma region RequestTask
+
+    RequestTask& RequestTask::operator=(RequestTask&& Other) noexcept
+    {
+        if(this != &Other)
+        {
+            if(mHandle)
+            {
+                mHandle.destroy();
+            }
+            mHandle = std::exchange(Other.mHandle, nullptr);
+        }
+        return *this;
+    }
+
+    RequestTask::~RequestTask()
+    {
+        if(mHandle)
+        {
+            mHandle.destroy();
+        }
+    }
+
+#pragma endregion   //RequestTask
+
+#pragma region RequestContext
+
+    RequestContext::RequestContext(ListenServerWorker& Worker, ConnectionId Connection, ConnectionPersistence InPersistence)
+        : mWorker(Worker), mConnection(Connection), mPersistence(InPersistence)
+    {
+    }
+
+    RequestContext::~RequestContext()
+    {
+        mWorker.mTimerWheel.RemoveTimer(mSleepTimer);
+    }
+
+    void RequestContext::SleepAwaiter::await_suspend(std::coroutine_handle<>)
+    {
+        TimerWheel& Timers = Context.mWorker.mTimerWheel;
+        if(Context.mSleepTimer.IsValid() == false)
+        {
+            RequestContext* SleepingContext = &Context;
+            Context.mSleepTimer = Timers.AddTimer([SleepingContext] () { SleepingContext->Resume(); });
+        }
+        Context.mWait = TaskWait::TaskWait_Sleep;
+        Timers.Arm(Context.mSleepTimer, DelayMs);
+    }
+
+    bool RequestContext::BodyAwaiter::await_ready() const noexcept
+    {
+        return Context.mBodyBuffer.empty() == false || Context.mBodyState != RequestBodyState::RequestBodyState_Reading;
+    }
+
+    void RequestContext::BodyAwaiter::await_suspend(std::coroutine_handle<>)
+    {
+        Context.mWait = TaskWait::TaskWait_Body;
+    }
+
+    std::string_view RequestContext::BodyAwaiter::await_resume()
+    {
+        // Swapped rather than copied, both buffers keep their room for the next lot
+        Context.mBodyChunk.clear();
+        Context.mBodyChunk.swap(Context.mBodyBuffer);
+
+        // Room for more now, receive picks up once the connection's sends allow
+        if(Context.bBodyPaused)
+        {
+            Context.bBodyPaused = false;
+            Context.mWorker.mPausedReceives.push_back(Context.mConnection);
+        }
+        return Context.mBodyChunk;
+    }
+
+    bool RequestContext::WriteAwaiter::await_ready() const noexcept
+    {
+        return Context.mWorker.GetPendingSendBytes(Context.mConnection.Socket) <= Context.mWorker.mServer.mConfig.MaxPendingSendBytes;
+    }
+
+    void RequestContext::WriteAwaiter::await_suspend(std::coroutine_handle<>)
+    {
+        Context.mWait = TaskWait::TaskWait_Write;
+        Context.mWorker.mBlockedWriters.push_back(Context.mConnection);
+    }
+
+    void RequestContext::Respond(ServerResponseMessage Response)
+    {
+        if(bResponseStarted)
+        {
+            StatusLogPost("Handler - Request already answered", StatusLogSeverity::StatusLogSeverity_Error);
+            return;
+        }
+
+        bResponseStarted = true;
+        FinishHandlerResponse(Response);
+        SendServerResponseMessage(mConnection.Socket, Response, mWorker.mSendData, mPersistence, false);
+    }
+
+    void RequestContext::StartResponse(ServerResponseMessage Head)
+    {
+        if(bResponseStarted)
+        {
+            StatusLogPost("Handler - Request already answered", StatusLogSeverity::StatusLogSeverity_Error);
+            return;
+        }
+
+        bResponseStarted = true;
+        bStreaming = true;
+        Head.mHeaders.Set("Transfer-Encoding", "chunked");
+        Head.BuildMessage();
+        const std::string& HeaderBlock = Head.GetHeaderBlock(mPersistence);
+        mWorker.mSendData(mConnection.Socket, HeaderBlock.data(), (int) HeaderBlock.size(), false);
+        if(Head.GetContentLength() > 0)
+        {
+            SendChunk(Head.GetContentData(), Head.GetContentLength());
+        }
+    }
+
+    RequestContext::WriteAwaiter RequestContext::Write(std::string_view Data)
+    {
+        if(bResponseStarted == false)
+        {
+            StartResponse(ServerResponseMessage(ServerResponseStatusCode::ServerResponseStatusCode_200));
+        }
+
+        // An empty chunk would end the body
+        if(bStreaming && Data.empty() == false)
+        {
+            SendChunk(Data.data(), (int) Data.size());
+        }
+        return { *this };
+    }
+
+    void RequestContext::Resume()
+    {
+        mWait = TaskWait::TaskWait_None;
+        if(mTask.mHandle && mTask.mHandle.done() == false)
+        {
+            mTask.mHandle.resume();
+        }
+        if((mTask.mHandle == nullptr || mTask.mHandle.done()) && bFinished == false)
+        {
+            mWorker.FinishRequestTask(*this);
+        }
+    }
+
+    bool RequestContext::OnBodyData(const char* Data, int DataLen)
+    {
+        // Answered already, the rest of the body's only read past
+        if(bFinished)
+        {
+            return true;
+        }
+
+        mBodyBuffer.append(Data, DataLen);
+        if(mWait == TaskWait::TaskWait_Body)
+        {
+            Resume();
+            return true;
+        }
+
+        // The task's busy and the body's piling up, hold receive back until it's read some
+        ReceiveDataTickInfo* ReceiveTickInfo = mWorker.mSocketsReceivingData.Find(mConnection);
+        if(mBodyBuffer.size() >= mWorker.mServer.mConfig.BodySpoolMemoryBytes && bBodyPaused == false && ReceiveTickInfo->bReceivePaused == false)
+        {
+            ReceiveTickInfo->bReceivePaused = true;
+            bBodyPaused = true;
+        }
+        return true;
+    }
+
+    void RequestContext::OnBodyFinished(RequestBodyState BodyState)
+    {
+        mBodyState = BodyState;
+
+        // Paused by the last of it, the connection's own callback decides what happens next
+        if(bBodyPaused)
+        {
+            bBodyPaused = false;
+            mWorker.mSocketsReceivingData.Find(mConnection)->bReceivePaused = false;
+        }
+
+        if(mWait == TaskWait::TaskWait_Body)
+        {
+            Resume();
+        }
+    }
+
+    bool RequestContext::SendChunk(const char* Data, int DataLen)
+    {
+        char ChunkSize[16];
+        const int ChunkSizeLen = snprintf(ChunkSize, sizeof(ChunkSize), "%x\r\n", DataLen);
+        return mWorker.mSendData(mConnection.Socket, ChunkSize, ChunkSizeLen, false) && mWorker.mSendData(mConnection.Socket, Data, DataLen, false)
+            && mWorker.mSendData(mConnection.Socket, "\r\n", 2, true);
+    }
+
+#pragma endregion   //RequestContext
+
+#pragma region ServerRequestMessage
+
+    void ServerRequestMessage::BuildFromDataStream(const SocketDataStream& DataStream)
+    {
+        ParseData(DataStream.GetLinearData(), DataStream.GetDataLen());
+    }
+
+    int ServerRequestMessage::ParseData(const char* Data, int DataLen)
+    {
+        // Cap on what gets buffered before the request can be answered, the body isn't buffered
+        constexpr int MaxRequestHeadLength = 64 * 1024;
+
+        while(mParsePhase == RequestParsePhase::RequestParsePhase_RequestLine || mParsePhase == RequestParsePhase::RequestParsePhase_Headers)
+        {
+            // One pass over the line's new bytes finds its end, delimiters and anything that shouldn't be there
+            const char* Line = Data + mLineStart;
+            ContinueHttpLineScan(Line, DataLen - mLineStart, mLineScan);
+            mParseOffset = mLineStart + mLineScan.ScannedLength;
+            if(mLineScan.IsComplete() == false)
+            {
+                if(mParseOffset > MaxRequestHeadLength)
+                {
+                    mParsePhase = RequestParsePhase::RequestParsePhase_Malformed;
+                }
+                break;
+            }
+
+            int LineLength = mLineScan.LineLength;
+            if(LineLength > 0 && Line[LineLength - 1] == '\r')
+            {
+                LineLength--;
+            }
+
+            // Control bytes (a bare CR included) aren't allowed anywhere in the head
+            if(mLineScan.FirstControl != -1 && mLineScan.FirstControl < LineLength)
+            {
+                mParsePhase = RequestParsePhase::RequestParsePhase_Malformed;
+            }
+            else if(mParsePhase == RequestParsePhase::RequestParsePhase_RequestLine)
+            {
+                // Stray blank lines before a request are allowed
+                if(LineLength > 0)
+                {
+                    mParsePhase = ParseRequestLine(Line, LineLength) ? RequestParsePhase::RequestParsePhase_Headers : RequestParsePhase::RequestParsePhase_Malformed;
+                }
+            }
+            else if(LineLength > 0)
+            {
+                if(ParseHeaderLine(Line, LineLength) == false)
+                {
+                    mParsePhase = RequestParsePhase::RequestParsePhase_Malformed;
+                }
+            }
+            else
+            {
+                // Blank line, end of the head. A body framed both ways could be read either way, so it's refused
+                mHeadLength = mParseOffset;
+                const bool bAmbiguousBody = bIsBodyChunked && mContentLength != -1;
+                mParsePhase = bAmbiguousBody ? RequestParsePhase::RequestParsePhase_Malformed : RequestParsePhase::RequestParsePhase_Complete;
+            }
+
+            if(mParseOffset > MaxRequestHeadLength && mParsePhase != RequestParsePhase::RequestParsePhase_Complete)
+            {
+                mParsePhase = RequestParsePhase::RequestParsePhase_Malformed;
+            }
+
+            mLineStart = mParseOffset;
+            mLineScan = HttpLineScan{};
+        }
+
+        // Data may have moved since the last call, the views follow it (only their lengths carry over)
+        mUrl = std::string_view(Data + mUrlOffset, mUrl.size());
+        mQuery = std::string_view(Data + mQueryOffset, mQuery.size());
+        mHeaders.Bind(Data);
+
+        bIsMessageMalformed = mParsePhase == RequestParsePhase::RequestParsePhase_Malformed;
+        bIsMessageComplete = mParsePhase == RequestParsePhase::RequestParsePhase_Complete;
+        return bIsMessageComplete ? mHeadLength : 0;
+    }
+
+    bool ServerRequestMessage::ParseRequestLine(const char* Line, int LineLength)
+    {
+        int HttpMajorVersion = 0;
+        if(ResolveServerRequestDetails(Line, LineLength, mLineScan, mRequestType, mUrl, mQuery, HttpMajorVersion, mHttpMinorVersion) == false)
+        {
+            return false;
+        }
+
+        // Only 1.0 and 1.1 are spoken, a well formed request for any other gets a 505 rather than a 400
+        if(HttpMajorVersion != 1 || mHttpMinorVersion > 1)
+        {
+            bIsVersionUnsupported = true;
+            return false;
+        }
+
+        // Hashed the once, both the static route table and the content store look it up by this
+        mUrlHash = StaticRouteHash::HashUrl(mRequestType, mUrl);
+
+        // Kept relative to the request's start, where it sits in memory can change between reads
+        mUrlOffset = mLineStart + (int) (mUrl.data() - Line);
+        mQueryOffset = mQuery.empty() ? mUrlOffset : mLineStart + (int) (mQuery.data() - Line);
+        return true;
+    }
+
+    bool ServerRequestMessage::ParseHeaderLine(const char* Line, int LineLength)
+    {
+        std::string_view Key;
+        std::string_view Value;
+        if(ResolveRequestHeader(Line, LineLength, mLineScan, Key, Value) == false)
+        {
+            return false;
+        }
+
+        const HttpHeader Header = FindHttpHeader(Key);
+        if(Header == HttpHeader::HttpHeader_ContentLength)
+        {
+            // Digits only, and short enough that it can't overflow
+            if(Value.empty() || Value.size() > 18 || std::all_of(Value.begin(), Value.end(), [] (char c) { return c >= '0' && c <= '9'; }) == false)
+            {
+                return false;
+            }
+
+            int64_t ContentLength = 0;
+            for(char c : Value)
+            {
+                ContentLength = ContentLength * 10 + (c - '0');
+            }
+
+            // Repeats are only allowed if they agree
+            if(mContentLength != -1 && mContentLength != ContentLength)
+            {
+                return false;
+            }
+            mContentLength = ContentLength;
+        }
+        else if(Header == HttpHeader::HttpHeader_TransferEncoding)
+        {
+            // Chunked is the only coding that gets undone, a body sent any other way can't be read
+            if(EqualsIgnoreCase(Value, "chunked") == false)
+            {
+                return false;
+            }
+            bIsBodyChunked = true;
+        }
+
+        const int KeyOffset = mLineStart + (int) (Key.data() - Line);
+        const int ValueOffset = mLineStart + (int) (Value.data() - Line);
+        mHeaders.Add(Header, KeyOffset, (int) Key.size(), ValueOffset, (int) Value.size());
+        return true;
+    }
+
+    ConnectionPersistence ServerRequestMessage::GetConnectionPersistence() const
+    {
+        std::string_view ConnectionValue;
+        const bool bHasConnection = mHeaders.Find(HttpHeader::HttpHeader_Connection, ConnectionValue);
+        if(bHasConnection && HasConnectionOption(ConnectionValue, "close"))
+        {
+            return ConnectionPersistence::ConnectionPersistence_Close;
+        }
+
+        // HTTP/1.0 closes after every response unless it asks otherwise
+        if(mHttpMinorVersion == 0)
+        {
+            return (bHasConnection && HasConnectionOption(ConnectionValue, "keep-alive")) ? ConnectionPersistence::ConnectionPersistence_KeepAliveAnnounced
+                : ConnectionPersistence::ConnectionPersistence_Close;
+        }
+        return ConnectionPersistence::ConnectionPersistence_KeepAlive;
+    }
+
+    bool ServerRequestMessage::CheckHeaderValue(HttpHeader InHeader, std::string_view InValue) const
+    {
+        std::string_view Value;
+        return mHeaders.Find(InHeader, Value) && Value == InValue;
+    }
+
+    bool ServerRequestMessage::CheckHeaderValue(std::string_view InHeader, std::string_view InValue) const
+    {
+        std::string_view Value;
+        return mHeaders.Find(InHeader, Value) && Value == InValue;
+    }
+
+    void ServerRequestMessage::DebugPrint()
+    {
+        std::cout << OutputServerTime_GetTime() << "Request data:\n\n";
+        std::cout << "--------------------REQUEST-START--------------------\n\n";
+        std::cout << ServerRequestTypeStrings.at(mRequestType) << " | " << mUrl << " | ?" << mQuery << "\n";
+
+        mHeaders.ForEach([] (std::string_view Key, std::string_view Value) {
+            std::cout << Key << " : " << Value << "\n";
+            });
+
+        std::cout << "---------------------REQUEST-END---------------------\n\n";
+    }
+
+#pragma endregion //ServerRequestMessage
+
+#pragma region ServerResponseMessage
+
+    ServerResponseMessage::ServerResponseMessage(ServerResponseStatusCode MessageStatus)
+        : mStatusCode(MessageStatus)
+    {
+        AddMessageHeaders(GenerateMetaDataMessageHeaders());  
+    }
+
+    void ServerResponseMessage::AddContent(std::vector<char> MessageContent, const std::string& ContentType)
+    {
+        mHeaders.Add("Content-Type", ContentType);
+        mHeaders.Add("Content-Length", std::to_string(MessageContent.size()));
+
+        mContent = std::make_shared<const std::vector<char>>(std::move(MessageContent));
+    }
+
+    void ServerResponseMessage::BuildMessage()
+    {
+        //TODO: could check if anything has changed since last build
+
+        assert(ValidResponseMessageData(*this, GetContentData(), GetContentLength()));
+
+        // Only the headers are serialised, the body stays where AddContent put it
+        ResponseHeaderList KeepAliveHeaders = mHeaders;
+        KeepAliveHeaders.Set("Connection", "keep-alive");
+        ResponseHeaderList CloseHeaders = mHeaders;
+        CloseHeaders.Set("Connection", "close");
+
+        const auto PrintHeaderBlock = [this] (std::string& HeaderBlock, const ResponseHeaderList& Headers)
+            {
+                int HeaderBlockLength = PrintnResponseMessageStatus(NULL, 0, mStatusCode) + PrintnResponseMessageHeaders(NULL, 0, Headers);
+                HeaderBlock.resize(HeaderBlockLength);
+
+                int HeaderBlockIndex = PrintnResponseMessageStatus(&HeaderBlock[0], HeaderBlockLength + 1, mStatusCode);
+                PrintnResponseMessageHeaders(&HeaderBlock[HeaderBlockIndex], HeaderBlockLength + 1 - HeaderBlockIndex, Headers);
+            };
+
+        PrintHeaderBlock(mHeaderBlock, mHeaders);
+        PrintHeaderBlock(mKeepAliveHeaderBlock, KeepAliveHeaders);
+        PrintHeaderBlock(mCloseHeaderBlock, CloseHeaders);
+    }
+
+    const std::string& ServerResponseMessage::GetHeaderBlock(ConnectionPersistence Persistence) const
+    {
+        switch(Persistence)
+        {
+            case ConnectionPersistence::ConnectionPersistence_KeepAliveAnnounced: return mKeepAliveHeaderBlock;
+            case ConnectionPersistence::ConnectionPersistence_Close: return mCloseHeaderBlock;
+            default: return mHeaderBlock;
+        }
+    }
 
     void ServerResponseMessage::AddMessageHeaders(const std::vector<std::pair<std::string, std::string>>& MessageHeaders)
     {
-        mHeaders.insert(MessageHeaders.begin(), MessageHeaders.end());
+        for(const auto& Header : MessageHeaders)
+        {
+            mHeaders.Add(Header.first, Header.second);
+        }
         BuildMessage();
     }
 
@@ -732,7 +2453,7 @@ namespace WebServer
     {
         std::cout << OutputServerTime_GetTime() << "Response data:\n\n";
         std::cout << "--------------------Response-START--------------------\n\n";
-        std::cout << mMessage << "\n\n";
+        std::cout << mHeaderBlock << "<" << GetContentLength() << " bytes of content>\n\n";
         std::cout << "---------------------Response-END---------------------\n\n";
     }
 
@@ -779,21 +2500,33 @@ namespace WebServer
 
         Message.GenerateMessage(messageBuffer, messageBufferSize);
 
-        int SendResult = send(mClientSocket, messageBuffer, messageBufferSize, 0);
-        if(SendResult == SOCKET_ERROR)
+        // The socket is non-blocking and this thread owns it, wait for the client to take each part rather than truncate the message
+        int BytesSent = 0;
+        while(BytesSent < messageBufferSize)
         {
-            std::cout << "Web-Socket send failed" << WSAGetLastError() << "\n";
+            int SendResult = SendSocketData(mClientSocket, messageBuffer + BytesSent, messageBufferSize - BytesSent);
+            if(SendResult != SOCKET_ERROR)
+            {
+                BytesSent += SendResult;
+            }
+            else if(IsSocketWouldBlockError(GetSocketError()) == false || WaitSocketWritable(mClientSocket, SendTimeoutMs) == false)
+            {
+                std::cout << "Web-Socket send failed" << GetSocketError() << "\n";
+                break;
+            }
         }
+        free(messageBuffer);
 
-        std::cout << "Web-Socket message sent - bytes: " << SendResult << "\n";
+        std::cout << "Web-Socket message sent - bytes: " << BytesSent << "\n";
     }
 
     void WebSocketHandle::WebSocketMainThread()
     {
-        auto ServerTime = std::chrono::system_clock::now();
+        // The web socket runs its own loop on this thread, 1ms ticks to keep queued sends prompt
+        TimerWheel Timers(1);
 
-        std::vector<TimedFunctionPair> TimedFunctions;
-        TimedFunctions.push_back(std::make_pair(MilliSecStopwatch{ServerTime, 250}, std::bind(StatusLogPost, "Web-Socket - Open for data", StatusLogSeverity::StatusLogSeverity_Log)));
+        TimerHandle OpenStatusTimer = Timers.AddTimer(std::bind(StatusLogPost, "Web-Socket - Open for data", StatusLogSeverity::StatusLogSeverity_Log));
+        Timers.Arm(OpenStatusTimer, 250, 250);
 
         const auto SendWSMessagesFunc = [&] ()
             {
@@ -803,11 +2536,22 @@ namespace WebServer
                     SendWebMessage(SendMessageItem);
                 }
             };
-        TimedFunctions.push_back(std::make_pair(MilliSecStopwatch{ServerTime, 1}, SendWSMessagesFunc));
+        TimerHandle SendMessagesTimer = Timers.AddTimer(SendWSMessagesFunc);
+        Timers.Arm(SendMessagesTimer, 1, 1);
+
+        const auto TimedOutCallback = [&] ()
+            {
+                StatusLogPost("Web-Socket - Timed out\n", StatusLogSeverity::StatusLogSeverity_Error);
+                bRunThread = false;
+            };
+        TimerHandle TimeoutTimer = Timers.AddTimer(TimedOutCallback);
+        Timers.Arm(TimeoutTimer, WebSocketTimeoutMs);
 
         WebSocketMessage PersistentWSMessage;
-        const auto MessageRecievedCallback = [&] (SocketDataStream&& DataStream)
+        const auto MessageRecievedCallback = [&] (const SocketDataStream& DataStream)
             {
+                Timers.Arm(TimeoutTimer, WebSocketTimeoutMs);
+
                 WSHandleMessageRecieved(DataStream, PersistentWSMessage);
                 if(PersistentWSMessage.bIsComplete)
                 {
@@ -816,10 +2560,9 @@ namespace WebServer
                 }
             };
 
-        TimedFunctionPair TimeOutFunctionPair = std::make_pair(MilliSecStopwatch{ServerTime, 600 * SecondsToMs}, std::bind(StatusLogPost, "Web-Socket - Timed out\n", StatusLogSeverity::StatusLogSeverity_Error));
-        const auto ErrorEncounteredCallback = [] () { std::cout << OutputServerTime_GetTime() << "Web-Socket - failed: " << WSAGetLastError() << "\n"; };
+        const auto ErrorEncounteredCallback = [] () { std::cout << OutputServerTime_GetTime() << "Web-Socket - failed: " << GetSocketError() << "\n"; };
 
-        ReceieveMessageLoop(mClientSocket, &bRunThread, TimedFunctions, MessageRecievedCallback, ErrorEncounteredCallback, TimeOutFunctionPair);
+        ReceieveMessageLoop(mClientSocket, &bRunThread, Timers, MessageRecievedCallback, ErrorEncounteredCallback);
 
         std::cout << "Websocket - Stopped receiving messages\n";
     }
@@ -873,7 +2616,7 @@ namespace WebServer
 
     void WebSocketMessage::BuildFromDataStream(const SocketDataStream& InDataStream)
     {
-        unsigned char* UData = (unsigned char*) InDataStream.mData;
+        const unsigned char* UData = (const unsigned char*) InDataStream.GetLinearData();
 
         bIsComplete = (UData[0] & 0b10000000) != 0;
         mOpCode = (WebSocketOpCode)(UData[0] & 0b00001111);
@@ -1,7 +1,22 @@
 #pragma once
 #include "Common.h"
-
-//TODO: Investigate UDP and POST
+#include "SocketPoller.h"
+#include "IoUringEngine.h"
+#include "ConnectionSlab.h"
+#include "TimerWheel.h"
+#include "SocketSendQueue.h"
+#include "HttpLineScanner.h"
+#include "HttpHeaders.h"
+#include "RequestBodyDecoder.h"
+#include "RequestBodySpool.h"
+#include "MultipartParser.h"
+#include "RequestRouter.h"
+#include "ContentStore.h"
+#include "StaticRouteTable.h"
+#include "RequestHandlerPool.h"
+#include "MpscQueue.h"
+
+//TODO: Investigate UDP
 
 namespace WebServer
 {
@@ -9,9 +24,13 @@ namespace WebServer
     class ServerResponseMessage;
     class WebSocketHandle;
     class WebSocketMessage;
+    class RequestContext;
 
     struct WebSocketInfo;
 
+    // Keyed by url, transparent so a request's url view can look itself up without building a string
+    typedef std::map<std::string, ServerResponseMessage, std::less<>> ServerUrlDataMap;
+
     enum class ServerRequestType
     {
         ServerRequestType_Invalid,
@@ -45,10 +64,12 @@ namespace WebServer
         ServerResponseStatusCode_403,
         ServerResponseStatusCode_404,
         ServerResponseStatusCode_408,
+        ServerResponseStatusCode_413,
         ServerResponseStatusCode_429,
         ServerResponseStatusCode_500,
         ServerResponseStatusCode_501,
         ServerResponseStatusCode_503,
+        ServerResponseStatusCode_505,
     };
 
     const std::map<ServerResponseStatusCode, std::string> ServerResponseStatusStrings =
@@ -63,13 +84,15 @@ namespace WebServer
         { ServerResponseStatusCode::ServerResponseStatusCode_403, "403 Forbidden" },
         { ServerResponseStatusCode::ServerResponseStatusCode_404, "404 Not Found" },
         { ServerResponseStatusCode::ServerResponseStatusCode_408, "408 Request Timeout" },
+        { ServerResponseStatusCode::ServerResponseStatusCode_413, "413 Content Too Large" },
         { ServerResponseStatusCode::ServerResponseStatusCode_429, "429 Too Many Requests" },
         { ServerResponseStatusCode::ServerResponseStatusCode_500, "500 Internal Server Error" },
         { ServerResponseStatusCode::ServerResponseStatusCode_501, "501 Not Implemented" },
         { ServerResponseStatusCode::ServerResponseStatusCode_503, "503 Service Unavailable" },
+        { ServerResponseStatusCode::ServerResponseStatusCode_505, "505 HTTP Version Not Supported" },
     };
 
-    WEBSERVERLIBRARY_API enum class WebSocketOpCode : uint16_t
+    WEBSERVERLIBRARY_API enum class WebSocketOpCode : int16_t
     {
         WebSocketOpCode_Invalid = -1,
         WebSocketOpCode_continuation = 0,
@@ -77,17 +100,128 @@ namespace WebServer
         WebSocketOpCode_binary = 2,
     };
 
-    typedef std::pair<MilliSecStopwatch, std::function<void()>> TimedFunctionPair;
-    
-    struct ReceiveDataTickInfo
+    enum class ListenServerIoMode
+    {
+        ListenServerIoMode_Auto,        // io_uring when the kernel supports it, otherwise socket polling
+        ListenServerIoMode_Poll,
+        ListenServerIoMode_IoUring,
+    };
+
+    // Socket, data, length, whether the data outlives the send (persistent url data) so async engines needn't copy it
+    typedef std::function<bool(SOCKET, const char*, int, bool)> SocketSendDataFunc;
+
+    // What happens to a connection once a request on it has been answered
+    enum class RequestConnectionAction
+    {
+        RequestConnectionAction_KeepAlive,
+        RequestConnectionAction_Close,
+        RequestConnectionAction_HandedOff,     // upgraded, another thread owns the socket now
+        RequestConnectionAction_AwaitingBody,  // answered once the request's body has been read
+        RequestConnectionAction_AwaitingResponse,  // answered later from off the loop, the connection's parked until then
+    };
+
+    // What a response tells the client about its connection. HTTP/1.1 connections stay open unless they're told otherwise,
+    // a 1.0 client that asked to keep its connection has to be told it's being kept
+    enum class ConnectionPersistence
+    {
+        ConnectionPersistence_KeepAlive,
+        ConnectionPersistence_KeepAliveAnnounced,  // "Connection: keep-alive", for HTTP/1.0
+        ConnectionPersistence_Close,               // "Connection: close", the last response on the connection
+    };
+
+    enum class RequestParsePhase
+    {
+        RequestParsePhase_RequestLine,
+        RequestParsePhase_Headers,
+        RequestParsePhase_Complete,
+        RequestParsePhase_Malformed,
+    };
+
+    class ServerRequestMessage
     {
-        std::vector<TimedFunctionPair> TimedFunctions;
-        TimedFunctionPair ReceiveTimeout;
+    public:
+        void BuildFromDataStream(const SocketDataStream& DataStream);
+
+        // Resumable, Data is everything received for this request so far (what was passed last time plus whatever's
+        // arrived since) and only the new bytes are examined. Returns the length of the request's head once it's complete,
+        // 0 until then, any body follows it and is read separately (see RequestBodyDecoder).
+        // The url, query and headers are views into Data, valid until it's next moved or consumed.
+        int ParseData(const char* Data, int DataLen);
+        bool CheckHeaderValue(HttpHeader InHeader, std::string_view InValue) const;
+        bool CheckHeaderValue(std::string_view InHeader, std::string_view InValue) const;
+
+        // How the body after the head is framed, there's none unless one of these says so
+        bool HasBody() const { return bIsBodyChunked || mContentLength > 0; }
+        bool IsBodyChunked() const { return bIsBodyChunked; }
+        int64_t GetContentLength() const { return mContentLength; }
+
+        // Whether the client wants its connection kept after this request, going by its version and Connection header
+        ConnectionPersistence GetConnectionPersistence() const;
+
+        void DebugPrint();
+
+        bool bIsMessageComplete = false;
+        bool bIsMessageMalformed = false;
+        bool bIsVersionUnsupported = false;     // malformed only in being a version other than 1.0 or 1.1
 
-        std::function<void(SocketDataStream&&)> MessageRecievedCallback;
+        ServerRequestType mRequestType = ServerRequestType::ServerRequestType_Invalid;
+        int mHttpMinorVersion = 1;      // HTTP/1.x
+        std::string_view mUrl;
+        uint64_t mUrlHash = 0;          // StaticRouteHash::HashUrl of the method and url, worked out once while parsing
+        std::string_view mQuery;
+        RequestHeaderList mHeaders;
+        RouteParams mRouteParams;       // filled in once the request's been routed
+
+    private:
+        bool ParseRequestLine(const char* Line, int LineLength);
+        bool ParseHeaderLine(const char* Line, int LineLength);
+
+        RequestParsePhase mParsePhase = RequestParsePhase::RequestParsePhase_RequestLine;
+        int mParseOffset = 0;       // bytes examined so far
+        int mLineStart = 0;         // start of the line still waiting on its '\n'
+        HttpLineScan mLineScan;     // what's been found in that line so far
+        int mHeadLength = 0;
+        int64_t mContentLength = -1;    // -1 without a Content-Length header
+        bool bIsBodyChunked = false;
+        int mUrlOffset = 0;
+        int mQueryOffset = 0;
+    };
+
+    struct ReceiveDataTickInfo
+    {
+        TimerHandle ReceiveTimeoutTimer;
+        TimerHandle AwaitingDataTimer;
+        int NumRequestsServed = 0;
+        bool bReceiveFinished = false;
+        bool bReceivePaused = false;       // send side backed up, requests wait in ReceiveDataStream until it drains
+        uint64_t AwaitingResponseId = 0;   // request a handler's still working on, receive is paused meanwhile. 0 when none
+        int ReadSize = 4 * 1024;           // adapts to how much each read brings in
+
+        // Bytes just received, already appended to ReceiveDataStream
+        std::function<void(int)> MessageRecievedCallback;
         std::function<void()> ErrorCallback;
 
         SocketDataStream ReceiveDataStream;
+        ServerRequestMessage PendingRequest;    // parsed as far as ReceiveDataStream goes, picks up where it left off
+
+        // The body following the request just answered, decoded straight out of ReceiveDataStream as it arrives.
+        // Without a data callback it's skipped over, so the connection can carry on past it
+        RequestBodyDecoder BodyDecoder;
+        bool bReadingBody = false;
+        RequestBodyDecoder::BodyDataFunc BodyDataCallback;
+        std::function<RequestConnectionAction(RequestBodyState)> BodyFinishedCallback;     // how the body ended
+        std::function<void()> BodyAbortedCallback;                          // the connection went first
+
+        // The coroutine handling the connection's current request, gone with the connection
+        std::unique_ptr<RequestContext> ActiveTask;
+    };
+
+    struct SendDataTickInfo
+    {
+        SocketSendQueue SendQueue;
+        TimerHandle SendTimeoutTimer;
+        bool bAwaitingWritable = false;     // send buffer full, watching for write readiness
+        bool bCloseWhenFlushed = false;
     };
 
     //TODO: add client ID to receive data
@@ -96,6 +230,124 @@ namespace WebServer
     typedef std::function<void(const char*, int, WebSocketOpCode)> WebSocketSendDataFunc;
     typedef std::function<void(std::string, uint64_t)> WebSocketClientJoinedCallback; // url, client id add to create web socket
 
+    // A request's body goes to its handler a piece at a time as it arrives, each request has an id tying its calls together.
+    // OnRequestStart sees the head and can turn the request away (403) before any of the body's read
+    typedef std::function<bool(uint64_t, const ServerRequestMessage&)> RequestStartCallback;     // request id, head (valid for the call)
+    typedef std::function<void(uint64_t, const char*, int)> RequestBodyDataCallback;            // request id, body data
+    typedef std::function<ServerResponseMessage(uint64_t)> RequestCompleteCallback;            // request id, returns the response
+    typedef std::function<void(uint64_t)> RequestAbortedCallback;                              // request id, body cut short or malformed
+
+    // Request id, the whole body (in memory or a temp file, see SpooledRequestBody), returns the response. The body can
+    // be moved out to keep it, otherwise it's gone once this returns
+    typedef std::function<ServerResponseMessage(uint64_t, SpooledRequestBody&)> RequestBodySpooledCallback;
+
+    // Multipart form posts split into their parts as they stream in. Request id, the part's headers (valid for the call)
+    typedef std::function<void(uint64_t, const MultipartPart&)> RequestPartStartCallback;
+    typedef std::function<void(uint64_t, const char*, int)> RequestPartDataCallback;             // request id, the part's data
+    typedef std::function<void(uint64_t)> RequestPartEndCallback;                                // request id
+
+    // The body is either streamed as it is (OnBodyData), streamed a part at a time (OnPartStart/Data/End, for
+    // multipart bodies only) or spooled and handed over whole (OnBodySpooled). The first two finish with OnRequestComplete
+    struct RequestHandler
+    {
+        RequestStartCallback OnRequestStart;
+        RequestBodyDataCallback OnBodyData;
+        RequestPartStartCallback OnPartStart;
+        RequestPartDataCallback OnPartData;
+        RequestPartEndCallback OnPartEnd;
+        RequestCompleteCallback OnRequestComplete;
+        RequestBodySpooledCallback OnBodySpooled;
+        RequestAbortedCallback OnRequestAborted;
+    };
+
+    // A request as a dynamic handler sees it, copied out of the connection so it can be worked on from any thread
+    struct HandlerRequest
+    {
+        // Empty if there isn't one by that name, headers are matched ignoring case
+        std::string_view FindHeader(std::string_view Name) const;
+        std::string_view FindParam(std::string_view Name) const;
+
+        uint64_t RequestId = 0;
+        ServerRequestType Method = ServerRequestType::ServerRequestType_Invalid;
+        std::string Url;
+        std::string Query;
+        std::vector<std::pair<std::string, std::string>> Headers;
+        std::vector<std::pair<std::string, std::string>> Params;    // route parameters, as in ServerRequestMessage::mRouteParams
+        SpooledRequestBody Body;        // read in full before the handler runs, empty without one
+    };
+
+    // Runs on the server's handler pool and returns the response. One that throws is answered with a 500
+    typedef std::function<ServerResponseMessage(HandlerRequest&)> DynamicRequestCallback;
+
+    struct DeferredResponseState;
+    struct HandlerResponseTarget;
+
+    // Answers a deferred request, from any thread and whenever the response is ready. Copies all answer the one request,
+    // the first Complete wins. A request whose tokens are all dropped without completing it gets a 500. Safe to keep past
+    // the server closing, it just has no one to answer any more
+    class ResponseToken
+    {
+    public:
+        // False if the request's already been answered or the server's closed
+        bool Complete(ServerResponseMessage Response);
+        bool IsCompleted() const;
+
+    private:
+        friend class ListenServerWorker;
+        std::shared_ptr<DeferredResponseState> mState;
+    };
+
+    // Runs on the connection's loop once the request's been read (body spooled as for a dynamic handler), and has to hand
+    // the work on rather than block. Move what's wanted out of the request, it's gone once this returns. One that throws
+    // before completing the token is answered with a 500
+    typedef std::function<void(HandlerRequest&, ResponseToken)> DeferredRequestCallback;
+
+    // What a coroutine request handler returns. Runs on the connection's loop, and while it's suspended the connection
+    // waits parked without holding a thread
+    class RequestTask
+    {
+    public:
+        struct promise_type
+        {
+            RequestTask get_return_object() { return RequestTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            std::suspend_always initial_suspend() noexcept { return {}; }      // started by the worker once it's stored
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { Exception = std::current_exception(); }
+
+            std::exception_ptr Exception;
+        };
+
+        RequestTask() = default;
+        RequestTask(RequestTask&& Other) noexcept : mHandle(std::exchange(Other.mHandle, nullptr)) {}
+        RequestTask& operator=(RequestTask&& Other) noexcept;
+        RequestTask(const RequestTask& Other) = delete;
+        ~RequestTask();
+
+    private:
+        friend class RequestContext;
+        friend class ListenServerWorker;
+
+        explicit RequestTask(std::coroutine_handle<promise_type> Handle) : mHandle(Handle) {}
+
+        std::coroutine_handle<promise_type> mHandle;
+    };
+
+    // The handler's a coroutine run on the connection's loop, see RequestContext for what it can wait on. Whatever the
+    // lambda captures has to last as long as its tasks, routes never go so captures of the route's own are fine
+    typedef std::function<RequestTask(RequestContext&)> CoroutineRequestCallback;
+
+    // What a url routes to, a handler for requests with a body or a dynamic handler. Pages and web sockets are looked up
+    // in the content store after these
+    struct ServerRoute
+    {
+        std::string Url;                                // as registered, parameters and all
+        RequestHandler Handler;
+        DynamicRequestCallback DynamicHandler;
+        DeferredRequestCallback DeferredHandler;
+        CoroutineRequestCallback CoroutineHandler;
+    };
+
     struct WebSocketInfo
     {
         WebSocketClientJoinedCallback ClientJoinedCallback;
@@ -103,84 +355,349 @@ namespace WebServer
         std::map<uint64_t, WebSocketSendDataFunc> SendDataFunctions;
     };
 
+    struct ListenServerConfig
+    {
+        ListenServerIoMode IoMode = ListenServerIoMode::ListenServerIoMode_Auto;
+
+        // Each worker has its own listen socket (SO_REUSEPORT), connection table and event loop thread
+        int NumWorkers = 1;
+
+        // Persistent connections close after sitting idle this long, or once they've served this many requests
+        int KeepAliveIdleTimeoutMs = 5000;
+        int MaxKeepAliveRequests = 1000;
+
+        // Once this much response data is waiting on a slow client, further pipelined requests on the connection
+        // wait for it to drain rather than queueing more
+        size_t MaxPendingSendBytes = 1024 * 1024;
+
+        // A spooled request body (RequestHandler::OnBodySpooled) keeps at most this much of itself in memory, past it the
+        // body goes to a temp file in BodySpoolDirectory (the system's if empty) a buffer's worth at a time.
+        // Bodies bigger than the limit are refused (413)
+        size_t BodySpoolMemoryBytes = 1024 * 1024;
+        int64_t MaxSpooledBodyBytes = 4LL * 1024 * 1024 * 1024;
+        std::string BodySpoolDirectory;
+
+        // Dynamic handlers run on this many threads shared by all the workers, started only if there are any
+        int NumHandlerThreads = 4;
+    };
+
+    class ListenServerWorker;
+
     class ListenServer
     {
     public:
-        ListenServer() = default;
+        ListenServer();
         ListenServer& operator=(ListenServer&& Other) = delete;
         ListenServer(const ListenServer& Other) = delete;
         ListenServer(ListenServer&& Other) = delete;
 
         ~ListenServer();
 
-        int Initialise(const char* PortNumber);
+        int Initialise(const char* PortNumber, const ListenServerConfig& Config = {});
         void AsyncStart();
         int CloseServer();
 
         //TODO: Add synchronous start functionality, will invlove a list of handles which will need checking
 
+        // Urls can have path parameters, "/users/:id" matches one segment and "/files/*path" the rest of the path.
+        // The request's mRouteParams has what they matched. Any thread, any time, uploading to a url again replaces its page
         void UploadData(const std::string& Url, std::vector<char> Data, const std::string& ContentType, std::vector<std::pair<std::string, std::string>> MessageHeaders);
 
+        // Adds the page to Batch instead, for CommitContent to publish along with the batch's other changes
+        void UploadData(ContentBatch& Batch, const std::string& Url, std::vector<char> Data, const std::string& ContentType, std::vector<std::pair<std::string, std::string>> MessageHeaders);
+        void RemoveData(const std::string& Url);
+
+        // Requests see every change in Batch or none of them. Any thread, while the server's running too
+        void CommitContent(ContentBatch Batch);
+
         void CreateWebSocket(const std::string& Url, WebSocketReceiveDataCallBack RecieveDataCallback, WebSocketClientJoinedCallback ClientJoinedCallback);
         void SendWebSocketMessage(const std::string& Url, uint64_t ClientId, const char* Content, int ContentLen, WebSocketOpCode OpCode);
 
+        // POST, PUT, PATCH and DELETE requests to Url go to Handler, register before starting the server
+        void CreateRequestHandler(const std::string& Url, RequestHandler Handler);
+
+        // Requests for Method on Url are answered by Callback on the handler pool, while the connection waits without
+        // holding up the rest of its worker. Any body is read (spooled as for OnBodySpooled) before the handler's called.
+        // Register before starting the server
+        void CreateDynamicHandler(ServerRequestType Method, const std::string& Url, DynamicRequestCallback Callback);
+
+        // Like a dynamic handler but nothing's run off the loop, Callback starts the work and hands its ResponseToken to
+        // whatever finishes it. Register before starting the server
+        void CreateDeferredHandler(ServerRequestType Method, const std::string& Url, DeferredRequestCallback Callback);
+
+        // Requests for Method on Url each start a coroutine on their connection's loop (see RequestContext), which can
+        // wait on timers, the request's body and its own response draining without holding a thread while it does.
+        // Register before starting the server
+        void CreateCoroutineHandler(ServerRequestType Method, const std::string& Url, CoroutineRequestCallback Callback);
+
+        // Routes declared at compile time (see StaticRouteTable), checked before any others. Set them before registering
+        // anything on their urls, which then go in the table rather than the router
+        void SetStaticRoutes(const StaticRouteLookup& StaticRoutes);
+
     private:
-        void ListenServerMainThread();
+        friend class ListenServerWorker;
+        friend class RequestContext;
 
-        void HandleServerRequest(SOCKET ClientSocket, ServerRequestMessage& RequestMessage);
-        void HandleWebSocketRequest(SOCKET ClientSocket, const ServerRequestMessage& RequestMessage);
+        bool AddRoute(ServerRequestType Method, const std::string& Url, ServerRoute Route);
+        const ServerRoute* FindRoute(ServerRequestType Method, std::string_view Url, uint64_t UrlHash, RouteParams& OutParams) const;
 
-        SOCKET mListenSocket = INVALID_SOCKET;
-        std::thread mListenThread;
-        std::atomic<bool> bRunListenServer = false;
+        // Before the workers, they report to it until they're gone
+        ContentStore mContent;
+
+        std::vector<std::unique_ptr<ListenServerWorker>> mWorkers;
+        ListenServerConfig mConfig;
 
-        std::map<SOCKET, ReceiveDataTickInfo> mSocketsReceivingData;
+        // Shared read-only by the workers while running, status pages and the like
+        ServerUrlDataMap mUrlData;
+        RequestRouter mRouter;              // method and url to an index into mRoutes
+        std::deque<ServerRoute> mRoutes;    // a deque so routes stay put as more are added
+        StaticRouteLookup mStaticRouteLookup;
+        std::vector<ServerRoute> mStaticRoutes;     // by index in the static table, empty Url until registered
+        std::atomic<uint64_t> mNextRequestId = 1;
 
-        std::map<std::string, ServerResponseMessage> mUrlData;
+        RequestHandlerPool mHandlerPool;
+        bool bHasDynamicHandlers = false;
 
-        std::map<SOCKET, WebSocketHandle> mActiveWebSockets;
-        std::map<std::string, WebSocketInfo> mWebSocketsInfo;
+        std::map<std::string, WebSocketInfo, std::less<>> mWebSocketsInfo;
+        std::mutex mWebSocketsInfoMutex;
     };
 
-    class ServerRequestMessage
+    // One event loop serving a port, a listen server runs one per configured worker
+    class ListenServerWorker
     {
     public:
-        void BuildFromDataStream(const SocketDataStream& DataStream);
-        bool CheckHeaderValue(const std::string& InHeader, const std::string& InValue);
+        ListenServerWorker(ListenServer& Server);
+        ListenServerWorker(const ListenServerWorker& Other) = delete;
+        ListenServerWorker& operator=(const ListenServerWorker& Other) = delete;
+        ~ListenServerWorker();
 
-        void DebugPrint();
+        int Initialise(const char* PortNumber, ListenServerIoMode IoMode, bool bReusePort);
+        void AsyncStart();
+        void Stop();
 
-        bool bIsMessageComplete = false;
+    private:
+        void ListenServerMainThread();
+        void ListenServerIoUringThread();
 
-        ServerRequestType mRequestType = ServerRequestType::ServerRequestType_Invalid;
-        std::string mUrl = "";
-        std::string mQuery = "";
-        std::map<std::string, std::string> mHeaders;
+        void AcceptConnections(const std::function<void(SOCKET, bool)>& OnReceiveFinished);
+        ReceiveDataTickInfo& RegisterClientSocket(SOCKET ClientSocket, const std::function<void(SOCKET, bool)>& OnReceiveFinished);
+        void ClearFinishedSockets(std::vector<std::pair<ConnectionId, bool>>& SocketsFinishedReceiving);
+
+        // Responses are queued per connection through mSendData and flushed once per loop, one vectored send per socket.
+        // Whatever the socket won't take waits for write readiness, finished connections close once it's all gone
+        bool QueueResponseData(SOCKET ClientSocket, const char* Data, int DataLen, bool bPersistentData);
+        void FlushQueuedSends();
+        void FlushSendQueue(SOCKET ClientSocket, SendDataTickInfo& SendTickInfo);
+        size_t GetPendingSendBytes(SOCKET ClientSocket);
+
+        // Picks up requests held back while a connection's send side was backed up, true if any were resumed
+        bool ResumeDrainedReceives();
+
+        void CloseConnection(SOCKET ClientSocket);
+        void AbortConnection(SOCKET ClientSocket);
+
+        // Drops a connection's receive side, telling the handler of a request whose body hadn't finished
+        void RemoveReceiveTickInfo(ConnectionId Id);
+
+        RequestConnectionAction HandleServerRequest(SOCKET ClientSocket, ServerRequestMessage& RequestMessage, ConnectionPersistence Persistence);
+        RequestConnectionAction HandleRequestWithBody(SOCKET ClientSocket, const ServerRequestMessage& RequestMessage, const RequestHandler& Handler, ConnectionPersistence Persistence);
+        void HandleWebSocketRequest(SOCKET ClientSocket, const ServerRequestMessage& RequestMessage, const std::string& WebSocketUrl);
+
+        // Parks the connection and hands the request to its dynamic or deferred handler, reading its body first if it has one
+        RequestConnectionAction HandleDynamicRequest(SOCKET ClientSocket, const ServerRequestMessage& RequestMessage, const ServerRoute& Route, ConnectionPersistence Persistence);
+        void StartDynamicRequest(SOCKET ClientSocket, std::shared_ptr<HandlerRequest> Request, const ServerRoute& Route, ConnectionPersistence Persistence);
+
+        // Parks the connection and starts the route's coroutine, which reads the body itself
+        RequestConnectionAction HandleCoroutineRequest(SOCKET ClientSocket, const ServerRequestMessage& RequestMessage, const CoroutineRequestCallback& Callback, ConnectionPersistence Persistence);
+        void FinishRequestTask(RequestContext& Context);
+
+        // Any thread, hands a parked request its response (built already) and wakes the loop to send it. A null response
+        // means it's been sent from the loop already
+        void CompleteResponse(ConnectionId Connection, uint64_t RequestId, std::unique_ptr<ServerResponseMessage> Response, ConnectionPersistence Persistence);
+
+        // Sends what handlers have finished, connections carry on with their next request once it's drained
+        void SendHandlerResponses(const std::function<void(SOCKET, bool)>& OnReceiveFinished);
+
+        // Resumes tasks waiting on their connection's response to drain, true if any were. Has only checks for one
+        bool ResumeDrainedWriters();
+        bool HasDrainedWriters();
+
+        // Any thread, wakes the loop from its wait
+        void WakeLoop();
+
+        // Once a loop, tells the content store the oldest snapshot this worker still has a page from in a send
+        void ReportContentInUse();
+
+        friend struct HandlerResponseTarget;
+        friend class RequestContext;
+
+        struct HandlerResponse
+        {
+            ConnectionId Connection;
+            uint64_t RequestId = 0;
+            std::unique_ptr<ServerResponseMessage> Response;
+            ConnectionPersistence Persistence = ConnectionPersistence::ConnectionPersistence_KeepAlive;
+        };
+
+        ListenServer& mServer;
+
+        SOCKET mListenSocket = INVALID_SOCKET;
+        SocketPoller mSocketPoller;
+        IoUringEngine mIoUringEngine;
+        bool bUseIoUring = false;
+        SocketSendDataFunc mSendData;
+
+        std::vector<SOCKET> mSocketsToFlush;
+        std::vector<ConnectionId> mPausedReceives;
+        std::vector<ConnectionId> mBlockedWriters;      // tasks waiting in RequestContext::Write
+        MpscQueue<HandlerResponse> mHandlerResponses;   // pushed by handlers from any thread
+        std::shared_ptr<HandlerResponseTarget> mResponseTarget;     // how they get here, cleared once the loop's stopped
+        std::thread mListenThread;
+        std::atomic<bool> bRunListenServer = false;
+
+        // Connection timeouts, consulted once per loop
+        TimerWheel mTimerWheel;
+
+        // Pages are sent straight from their snapshot, which is held (by generation) until the socket's sent everything
+        std::atomic<uint64_t>* mContentReader = nullptr;
+        std::vector<std::pair<SOCKET, uint64_t>> mContentPins;
+
+        ConnectionSlab<ReceiveDataTickInfo> mSocketsReceivingData;
+        ConnectionSlab<SendDataTickInfo> mSocketsSendingData;
+        ConnectionSlab<WebSocketHandle> mActiveWebSockets;
     };
 
     class ServerResponseMessage
     {
     public:
         ServerResponseMessage(ServerResponseStatusCode MessageStatus);
-        ServerResponseMessage(const ServerResponseMessage& Other);
-        ServerResponseMessage(ServerResponseMessage&& Other) noexcept;
-        ~ServerResponseMessage();
 
-        void AddContent(const std::vector<char>& MessageContent, const std::string& ContentType);
+        // Takes the body over, copies of the message share it rather than duplicating it
+        void AddContent(std::vector<char> MessageContent, const std::string& ContentType);
         void AddMessageHeaders(const std::vector<std::pair<std::string, std::string>>& MessageHeaders);
         void BuildMessage();
 
-        void DebugPrint();
+        // Status line and headers, sent ahead of the body as a separate buffer. With the Connection header the persistence
+        // calls for, if any
+        const std::string& GetHeaderBlock(ConnectionPersistence Persistence = ConnectionPersistence::ConnectionPersistence_KeepAlive) const;
+        const char* GetContentData() const { return mContent ? mContent->data() : nullptr; }
+        int GetContentLength() const { return mContent ? (int) mContent->size() : 0; }
 
-        const char* mMessage = nullptr;
-        int mMessageLength = 0;
+        void DebugPrint();
 
         ServerResponseStatusCode mStatusCode = ServerResponseStatusCode::ServerResponseStatusCode_Invalid;
-        std::map<std::string, std::string> mHeaders;
+        ResponseHeaderList mHeaders;
+
+    private:
+        std::string mHeaderBlock;
+        std::string mKeepAliveHeaderBlock;
+        std::string mCloseHeaderBlock;
+        std::shared_ptr<const std::vector<char>> mContent;
+    };
+
+    // A coroutine handler's request and connection, for the task's own use (on the loop). Anything it awaits resumes it
+    // on the loop too:
+    //
+    //     Server.CreateCoroutineHandler(ServerRequestType::ServerRequestType_POST, "/upload", [] (RequestContext& Context) -> RequestTask {
+    //         for(std::string_view Chunk = co_await Context.ReadBody(); Chunk.empty() == false; Chunk = co_await Context.ReadBody()) { ... }
+    //         co_await Context.Sleep(100);
+    //         Context.Respond(std::move(Response));
+    //     });
+    //
+    // The response goes whole with Respond, or streamed with StartResponse and then Write a piece at a time (chunked).
+    // The request's finished when the task is. One that finishes without answering or throws gets a 500, or has its
+    // connection closed if it had started streaming
+    class RequestContext
+    {
+    public:
+        RequestContext(ListenServerWorker& Worker, ConnectionId Connection, ConnectionPersistence Persistence);
+        RequestContext(const RequestContext& Other) = delete;
+        RequestContext& operator=(const RequestContext& Other) = delete;
+        ~RequestContext();
+
+        // Without its body, that comes through ReadBody
+        HandlerRequest& GetRequest() { return mRequest; }
+
+        struct SleepAwaiter
+        {
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<>);
+            void await_resume() const noexcept {}
+
+            RequestContext& Context;
+            int DelayMs = 0;
+        };
+
+        struct BodyAwaiter
+        {
+            bool await_ready() const noexcept;
+            void await_suspend(std::coroutine_handle<>);
+            std::string_view await_resume();
+
+            RequestContext& Context;
+        };
+
+        struct WriteAwaiter
+        {
+            bool await_ready() const noexcept;
+            void await_suspend(std::coroutine_handle<>);
+            void await_resume() const noexcept {}
+
+            RequestContext& Context;
+        };
+
+        // Resumes once DelayMs has gone, to the loop's timer tick
+        SleepAwaiter Sleep(int DelayMs) { return { *this, DelayMs }; }
+
+        // The body that's arrived since last time, waiting for some if there's none yet. Valid until the next ReadBody,
+        // empty once it's all been read (GetBodyState says how it ended)
+        BodyAwaiter ReadBody() { return { *this }; }
+        RequestBodyState GetBodyState() const { return mBodyState; }
+
+        void Respond(ServerResponseMessage Response);
+
+        // The head of a streamed response, any content it has goes as the first chunk
+        void StartResponse(ServerResponseMessage Head);
+
+        // Queues Data as the response's next chunk (after a 200 head if it wasn't started), resuming once the connection's
+        // back under its pending send limit
+        WriteAwaiter Write(std::string_view Data);
 
     private:
-        const char* mContentData = nullptr;
-        int mContentLength = 0;
+        friend class ListenServerWorker;
+
+        enum class TaskWait
+        {
+            TaskWait_None,
+            TaskWait_Sleep,
+            TaskWait_Body,
+            TaskWait_Write,
+        };
+
+        void Resume();
+        bool OnBodyData(const char* Data, int DataLen);
+        void OnBodyFinished(RequestBodyState BodyState);
+        bool SendChunk(const char* Data, int DataLen);
+
+        ListenServerWorker& mWorker;
+        ConnectionId mConnection;
+        HandlerRequest mRequest;
+        TaskWait mWait = TaskWait::TaskWait_None;
+        TimerHandle mSleepTimer;
+
+        // Body arriving while the task's busy builds up here, receive pauses once there's BodySpoolMemoryBytes of it
+        std::string mBodyBuffer;
+        std::string mBodyChunk;     // what the last ReadBody returned
+        RequestBodyState mBodyState = RequestBodyState::RequestBodyState_Complete;
+        bool bBodyPaused = false;
+
+        ConnectionPersistence mPersistence = ConnectionPersistence::ConnectionPersistence_KeepAlive;
+        bool bResponseStarted = false;
+        bool bStreaming = false;
+        bool bFinished = false;
+
+        // Last so the frame goes before anything it might still point at
+        RequestTask mTask;
     };
 
     class WebSocketMessage
@@ -5,19 +5,12 @@
 
 namespace WebServer
 {
-    int Initialise(WSADATA* WSAData)
+    int Initialise()
     {
         std::cout << "Initialising server\n";
 
-        // Initialise Winsock
-        int Result = WSAStartup(MAKEWORD(2, 2), WSAData);
-        if(Result != 0)
-        {
-            std::cout << "WSAStartup failed: " << Result << "\n";
-            return 1;
-        }
-
-        return 0;
+        // Initialise platform sockets (Winsock)
+        return SocketGlobalInit();
     }
 }
 
@@ -27,8 +20,7 @@ namespace WebServerAPI
 
     bool WebServerGlobalInit()
     {
-        WSADATA WSAData;
-        return WebServer::Initialise(&WSAData) == 0;
+        return WebServer::Initialise() == 0;
     }
 
     int StartSever(std::string Port)
@@ -69,4 +61,28 @@ namespace WebServerAPI
         WebServer::ListenServer& Server = ActiveServers.at(ServerID);
         Server.SendWebSocketMessage(Url, ClientId, Params.Content, Params.ContentLen, Params.OpCode);
     }
+
+    void InitRequestHandler(int ServerID, std::string Url, WebServer::RequestHandler Handler)
+    {
+        WebServer::ListenServer& Server = ActiveServers.at(ServerID);
+        Server.CreateRequestHandler(Url, std::move(Handler));
+    }
+
+    void InitDynamicHandler(int ServerID, WebServer::ServerRequestType Method, std::string Url, WebServer::DynamicRequestCallback Callback)
+    {
+        WebServer::ListenServer& Server = ActiveServers.at(ServerID);
+        Server.CreateDynamicHandler(Method, Url, std::move(Callback));
+    }
+
+    void InitDeferredHandler(int ServerID, WebServer::ServerRequestType Method, std::string Url, WebServer::DeferredRequestCallback Callback)
+    {
+        WebServer::ListenServer& Server = ActiveServers.at(ServerID);
+        Server.CreateDeferredHandler(Method, Url, std::move(Callback));
+    }
+
+    void InitCoroutineHandler(int ServerID, WebServer::ServerRequestType Method, std::string Url, WebServer::CoroutineRequestCallback Callback)
+    {
+        WebServer::ListenServer& Server = ActiveServers.at(ServerID);
+        Server.CreateCoroutineHandler(Method, Url, std::move(Callback));
+    }
 }
\ No newline at end of file
@@ -1,12 +1,6 @@
 #pragma once
 
-#ifdef MATHLIBRARY_EXPORTS
-#define WEBSERVERLIBRARY_API __declspec(dllexport)
-#else
-#define WEBSERVERLIBRARY_API __declspec(dllimport)
-#endif
-
-#include "WebServer.h";
+#include "WebServer.h"
 
 #include <string>
 #include <functional>
@@ -41,4 +35,9 @@ namespace WebServerAPI
 
     extern "C" WEBSERVERLIBRARY_API void InitWebSocket(int ServerID, std::string WebSocketURL, InitWebSocketParams Params);
     extern "C" WEBSERVERLIBRARY_API void SendWebSocketMessage(int ServerID, const std::string& Url, uint64_t ClientId, SendWebSocketMessageParams Params);
+
+    extern "C" WEBSERVERLIBRARY_API void InitRequestHandler(int ServerID, std::string Url, WebServer::RequestHandler Handler);
+    extern "C" WEBSERVERLIBRARY_API void InitDynamicHandler(int ServerID, WebServer::ServerRequestType Method, std::string Url, WebServer::DynamicRequestCallback Callback);
+    extern "C" WEBSERVERLIBRARY_API void InitDeferredHandler(int ServerID, WebServer::ServerRequestType Method, std::string Url, WebServer::DeferredRequestCallback Callback);
+    extern "C" WEBSERVERLIBRARY_API void InitCoroutineHandler(int ServerID, WebServer::ServerRequestType Method, std::string Url, WebServer::CoroutineRequestCallback Callback);
 }